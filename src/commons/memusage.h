@@ -0,0 +1,84 @@
+// Copyright (c) 2015 The Bitcoin Core developers
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef COMMONS_MEMUSAGE_H
+#define COMMONS_MEMUSAGE_H
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Estimates of the heap memory held by the STL containers, computed from their sizes without walking
+ * or serializing the items. The item's own heap memory must be added by the caller.
+ */
+namespace memusage {
+
+/** Heap memory of one malloc() call of the given size, glibc rounds it up to 16 bytes with 8 bytes overhead */
+static inline size_t MallocUsage(size_t alloc) {
+    if (alloc == 0)
+        return 0;
+
+    if (sizeof(void*) == 8)
+        return ((alloc + 31) >> 4) << 4;
+
+    return ((alloc + 15) >> 3) << 3;
+}
+
+/** Header of a red-black tree node: color, parent, left and right */
+static const size_t TREE_NODE_HEADER_SIZE = 4 * sizeof(void*);
+
+/** Shared control block of a std::make_shared<T>() allocation */
+static const size_t SHARED_PTR_CONTROL_SIZE = 2 * sizeof(void*);
+
+template <typename C>
+static inline size_t DynamicUsage(const std::basic_string<C> &s) {
+    // short strings are stored in the string object
+    if (s.capacity() < 16 / sizeof(C))
+        return 0;
+
+    return MallocUsage((s.capacity() + 1) * sizeof(C));
+}
+
+template <typename T, typename A>
+static inline size_t DynamicUsage(const std::vector<T, A> &v) {
+    return MallocUsage(v.capacity() * sizeof(T));
+}
+
+template <typename K, typename P, typename A>
+static inline size_t DynamicUsage(const std::set<K, P, A> &s) {
+    return MallocUsage(TREE_NODE_HEADER_SIZE + sizeof(K)) * s.size();
+}
+
+template <typename K, typename T, typename P, typename A>
+static inline size_t DynamicUsage(const std::map<K, T, P, A> &m) {
+    return MallocUsage(TREE_NODE_HEADER_SIZE + sizeof(std::pair<const K, T>)) * m.size();
+}
+
+template <typename K, typename T, typename H, typename E, typename A>
+static inline size_t DynamicUsage(const std::unordered_map<K, T, H, E, A> &m) {
+    // the node holds the next pointer, the item and the cached hash code
+    return MallocUsage(2 * sizeof(void*) + sizeof(std::pair<const K, T>)) * m.size() +
+           MallocUsage(sizeof(void*) * m.bucket_count());
+}
+
+/** Heap memory of one item added to a std::map<K, T>, not including the item's own heap memory */
+template <typename K, typename T>
+static inline size_t MapNodeUsage() {
+    return MallocUsage(TREE_NODE_HEADER_SIZE + sizeof(std::pair<const K, T>));
+}
+
+/** Heap memory of one item added to a std::unordered_map<K, T>, including its bucket at load factor 1 */
+template <typename K, typename T>
+static inline size_t HashNodeUsage() {
+    return MallocUsage(2 * sizeof(void*) + sizeof(std::pair<const K, T>)) + sizeof(void*);
+}
+
+}  // namespace memusage
+
+#endif  // COMMONS_MEMUSAGE_H
@@ -1517,6 +1517,55 @@ public:
     }
 };
 
+/** Read-only stream over a memory buffer it doesn't own, such as a memory mapped file.
+ *  Objects are deserialized straight from the buffer, it is not copied into the stream */
+class CMemReadStream
+{
+private:
+    const char* pBegin;
+    const char* pEnd;
+    const char* pCur;
+
+public:
+    int nType;
+    int nVersion;
+
+    CMemReadStream(const char* pBeginIn, const char* pEndIn, int nTypeIn, int nVersionIn) :
+        pBegin(pBeginIn), pEnd(pEndIn), pCur(pBeginIn), nType(nTypeIn), nVersion(nVersionIn) {
+    }
+
+    int GetType() const          { return nType; }
+    int GetVersion() const       { return nVersion; }
+    size_t size() const          { return pEnd - pCur; }
+    bool empty() const           { return pCur == pEnd; }
+    uint64_t GetPos() const      { return pCur - pBegin; }
+
+    CMemReadStream& read(char* pch, size_t nSize)
+    {
+        if (nSize > size())
+            throw ios_base::failure("CMemReadStream::read : end of data");
+        memcpy(pch, pCur, nSize);
+        pCur += nSize;
+        return (*this);
+    }
+
+    CMemReadStream& ignore(size_t nSize)
+    {
+        if (nSize > size())
+            throw ios_base::failure("CMemReadStream::ignore : end of data");
+        pCur += nSize;
+        return (*this);
+    }
+
+    template<typename T>
+    CMemReadStream& operator>>(T& obj)
+    {
+        // Unserialize from this stream
+        ::Unserialize(*this, obj, nType, nVersion);
+        return (*this);
+    }
+};
+
 class CNullObject {
 public:
     friend bool operator==(const CNullObject &a, const CNullObject &b) { return true; }
@@ -181,6 +181,17 @@ public:
     size_t operator()(const uint256& key) const { return key.GetCheapHash(); }
 };
 
+/** Hasher of the blobs holding a hash, such as uint256 and CKeyID, takes their first 8 bytes */
+class CBlobHasher {
+public:
+    template <unsigned int BITS>
+    size_t operator()(const base_blob<BITS>& key) const {
+        uint64_t result;
+        memcpy((void*)&result, (const void*)key.begin(), 8);
+        return result;
+    }
+};
+
 typedef std::unordered_set<uint256, CUint256Hasher> UnorderedHashSet;
 
 typedef uint256 TxID;
@@ -434,7 +434,7 @@ CBaseParams::CBaseParams() {
     fLogFailures            = false;
     nTxCacheHeight          = 500;
     nTimeBestReceived       = 0;
-    nCacheSize              = 300 << 10;  // 300K bytes
+    nCacheSize              = DEFAULT_DB_CACHE << 20;  // -dbcache
     nDefaultPort            = 0;
     fServer                 = 0;
     fServer                 = 0;
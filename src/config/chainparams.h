@@ -68,7 +68,7 @@ protected:
     mutable bool fLogFailures;
     mutable bool fGenReceipt;
     mutable int64_t nTimeBestReceived;
-    mutable uint32_t nCacheSize;
+    mutable uint64_t nCacheSize;
     mutable int32_t nTxCacheHeight;
     mutable int32_t nMaxForkTime;  // to limit the maximum fork time in seconds.
 
@@ -156,7 +156,7 @@ public:
     bool IsLogFailures() const { return fLogFailures; };
     bool IsGenReceipt() const { return fGenReceipt; };
     int64_t GetBestRecvTime() const { return nTimeBestReceived; }
-    uint32_t GetCacheSize() const { return nCacheSize; }
+    uint64_t GetCacheSize() const { return nCacheSize; }
     int32_t GetTxCacheHeight() const { return nTxCacheHeight; }
     void SetImporting(bool flag) const { fImporting = flag; }
     void SetReIndex(bool flag) const { fReindex = flag; }
@@ -164,6 +164,7 @@ public:
     void SetTxIndex(bool flag) const { fTxIndex = flag; }
     void SetLogFailures(bool flag) const { fLogFailures = flag; }
     void SetGenReceipt(bool flag) const { fGenReceipt = flag; }
+    void SetCacheSize(uint64_t size) const { nCacheSize = size; }
     void SetBestRecvTime(int64_t nTime) const { nTimeBestReceived = nTime; }
     int32_t GetMaxForkHeight(int32_t currBlockHeight) const;
     const MessageStartChars& MessageStart() const { return pchMessageStart; }
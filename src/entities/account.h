@@ -25,6 +25,7 @@
 using namespace json_spirit;
 
 class CAccountDBCache;
+class CDelegateDBCache;
 
 enum BalanceType : uint8_t {
     NULL_TYPE    = 0,  //!< invalid type
@@ -193,7 +194,16 @@ public:
     bool IsEmpty() const { return keyid.IsEmpty(); }
     void SetEmpty() { keyid.SetEmpty(); }  // TODO: need set other fields to empty()??
     string ToString() const;
+    // heap memory held by the account, for the db cache size
+    size_t GetDynamicMemSize() const {
+        size_t ret = regid.GetDynamicMemSize() + memusage::DynamicUsage(tokens);
+        for (const auto &item : tokens)
+            ret += memusage::DynamicUsage(item.first);
+        return ret;
+    }
     Object ToJsonObj() const;
+    // the json of the account in the chain state of the delegate cache at the height
+    Object ToJsonObj(CDelegateDBCache &delegateCache, int32_t height) const;
 
     void SetRegId(CRegID & regIdIn) { regid = regIdIn; }
 
@@ -7,6 +7,7 @@
 #ifndef ENTITIES_CONTRACT_H
 #define ENTITIES_CONTRACT_H
 
+#include "commons/memusage.h"
 #include "commons/serialize.h"
 #include "config/version.h"
 #include "commons/util/util.h"
@@ -103,6 +104,10 @@ public:
 
     bool IsEmpty() const { return vm_type == VMType::NULL_VM && code.empty() && memo.empty() && abi.empty(); }
 
+    size_t GetDynamicMemSize() const {
+        return memusage::DynamicUsage(code) + memusage::DynamicUsage(memo) + memusage::DynamicUsage(abi);
+    }
+
     void SetEmpty() {
         vm_type = VMType::NULL_VM;
         code.clear();
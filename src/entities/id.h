@@ -17,6 +17,7 @@
 #include "key.h"
 #include "commons/types.h"
 #include "commons/leb128.h"
+#include "commons/memusage.h"
 
 class CAccountDBCache;
 class CUserID;
@@ -75,6 +76,7 @@ public:
     void SetEmpty() { Clear(); }
     bool Clear();
     string ToString() const;
+    size_t GetDynamicMemSize() const { return memusage::DynamicUsage(vRegID); }
 
     IMPLEMENT_SERIALIZE(
         READWRITE(VARINT(height));
@@ -113,6 +115,7 @@ public:
     inline bool IsEmpty() const { return regid.IsEmpty(); }
     void SetEmpty() { regid.SetEmpty(); }
     string ToString() const { return regid.ToString(); }
+    size_t GetDynamicMemSize() const { return regid.GetDynamicMemSize(); }
 
 
     bool operator==(const CRegIDKey &other) const { return this->regid == other.regid; }
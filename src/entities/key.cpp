@@ -197,8 +197,11 @@ bool CPubKey::Verify(const uint256 &hash, const vector<uint8_t> &vchSig) const {
 
     secp256k1_pubkey pubkey;
     secp256k1_ecdsa_signature sig;
-    if (!secp256k1_ec_pubkey_parse(secp256k1_context_verify, &pubkey, vch, size())) {
-        return false;
+    if (!pubKeyCache.Get(*this, pubkey)) {
+        if (!secp256k1_ec_pubkey_parse(secp256k1_context_verify, &pubkey, vch, size())) {
+            return false;
+        }
+        pubKeyCache.Add(*this, pubkey);
     }
     if (!ecdsa_signature_parse_der_lax(secp256k1_context_verify, &sig, vchSig.data(), vchSig.size())) {
         return false;
@@ -378,6 +381,76 @@ CKeyID::CKeyID(const string &strAddress) : uint160() {
     }
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// class CPubKeyCache
+
+CPubKeyCache pubKeyCache;
+
+CPubKeyCache::CPubKeyCache() : nMaxShardEntries(0), nHits(0), nMisses(0), nEvictions(0) {
+    SetMaxSize(DEFAULT_PUBKEY_CACHE_SIZE << 20);
+}
+
+bool CPubKeyCache::Get(const CPubKey &pubKey, secp256k1_pubkey &parsedKey) {
+    CShard &shard = GetShard(pubKey);
+    {
+        std::unique_lock<std::mutex> lock(shard.mtx);
+        auto it = shard.mapEntries.find(pubKey);
+        if (it != shard.mapEntries.end()) {
+            shard.lruList.splice(shard.lruList.begin(), shard.lruList, it->second);
+            parsedKey = it->second->second;
+            ++nHits;
+            return true;
+        }
+    }
+
+    ++nMisses;
+    return false;
+}
+
+void CPubKeyCache::Add(const CPubKey &pubKey, const secp256k1_pubkey &parsedKey) {
+    const uint64_t nMaxEntries = nMaxShardEntries;
+    if (nMaxEntries == 0)
+        return;
+
+    CShard &shard = GetShard(pubKey);
+    std::unique_lock<std::mutex> lock(shard.mtx);
+    if (shard.mapEntries.count(pubKey))
+        return;
+
+    shard.lruList.emplace_front(pubKey, parsedKey);
+    shard.mapEntries[pubKey] = shard.lruList.begin();
+    Evict(shard, nMaxEntries);
+}
+
+void CPubKeyCache::SetMaxSize(uint64_t nMaxBytes) {
+    nMaxShardEntries = nMaxBytes / PUBKEY_CACHE_ENTRY_BYTES / SHARD_COUNT;
+    for (auto &shard : shards) {
+        std::unique_lock<std::mutex> lock(shard.mtx);
+        Evict(shard, nMaxShardEntries);
+    }
+}
+
+void CPubKeyCache::Evict(CShard &shard, uint64_t nMaxEntries) {
+    while (shard.lruList.size() > nMaxEntries) {
+        shard.mapEntries.erase(shard.lruList.back().first);
+        shard.lruList.pop_back();
+        ++nEvictions;
+    }
+}
+
+void CPubKeyCache::GetStats(CPubKeyCacheStats &stats) {
+    stats.entries = 0;
+    for (auto &shard : shards) {
+        std::unique_lock<std::mutex> lock(shard.mtx);
+        stats.entries += shard.mapEntries.size();
+    }
+    stats.bytes     = stats.entries * PUBKEY_CACHE_ENTRY_BYTES;
+    stats.max_bytes = nMaxShardEntries * PUBKEY_CACHE_ENTRY_BYTES * SHARD_COUNT;
+    stats.hits      = nHits;
+    stats.misses    = nMisses;
+    stats.evictions = nEvictions;
+}
+
 /* static */ int32_t ECCVerifyHandle::refcount = 0;
 
 ECCVerifyHandle::ECCVerifyHandle() {
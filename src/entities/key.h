@@ -16,6 +16,10 @@
 #include <secp256k1_recovery.h>
 #include <boost/variant.hpp>
 
+#include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
 #include <stdexcept>
 #include <vector>
 
@@ -412,6 +416,63 @@ public:
     IMPLEMENT_SERIALIZE(READWRITE(VARINT(nRequired)); READWRITE(pubKeys);)
 };
 
+struct CPubKeyCacheStats {
+    uint64_t entries   = 0;
+    uint64_t bytes     = 0;
+    uint64_t max_bytes = 0;
+    uint64_t hits      = 0;  //!< verifications using a parsed key
+    uint64_t misses    = 0;  //!< verifications parsing the key
+    uint64_t evictions = 0;
+};
+
+/** -pubkeycache default, in megabytes */
+static const int64_t DEFAULT_PUBKEY_CACHE_SIZE = 4;
+/** Approximate heap cost of one cached key: the map node with the key and the list iterator, the list node
+ *  with the key and the parsed key, and the malloc overhead of both */
+static const size_t PUBKEY_CACHE_ENTRY_BYTES = 2 * sizeof(CPubKey) + sizeof(secp256k1_pubkey) + 8 * sizeof(void *) + 32;
+
+/**
+ * Bounded LRU of the parsed public keys of CPubKey::Verify(). Parsing a compressed key takes a field square
+ * root, and the same account, miner and delegate keys are verified over and over. The keys are spread over
+ * SHARD_COUNT independently locked shards so that the signature check threads don't contend on one mutex.
+ */
+class CPubKeyCache {
+public:
+    static const uint32_t SHARD_COUNT = 16;
+
+private:
+    typedef std::pair<CPubKey, secp256k1_pubkey> Entry;
+
+    struct CShard {
+        std::mutex mtx;
+        std::list<Entry> lruList;  //!< most recently used first
+        std::map<CPubKey, std::list<Entry>::iterator> mapEntries;
+    };
+
+    CShard shards[SHARD_COUNT];
+    std::atomic<uint64_t> nMaxShardEntries;
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+    std::atomic<uint64_t> nEvictions;
+
+public:
+    CPubKeyCache();
+
+    bool Get(const CPubKey &pubKey, secp256k1_pubkey &parsedKey);
+    void Add(const CPubKey &pubKey, const secp256k1_pubkey &parsedKey);
+
+    /** Set the memory budget of the cache in bytes, 0 disables caching */
+    void SetMaxSize(uint64_t nMaxBytes);
+    void GetStats(CPubKeyCacheStats &stats);
+
+private:
+    // the shard is chosen by the last byte of the x coordinate, the first byte is the parity of y
+    CShard &GetShard(const CPubKey &pubKey) { return shards[pubKey[pubKey.size() - 1] % SHARD_COUNT]; }
+    void Evict(CShard &shard, uint64_t nMaxEntries);
+};
+
+extern CPubKeyCache pubKeyCache;
+
 /** Users of this module must hold an ECCVerifyHandle. The constructor and
  *  destructor of these are not allowed to run in parallel, though. */
 class ECCVerifyHandle {
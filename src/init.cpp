@@ -15,6 +15,7 @@
 
 #include "rpc/core/rpcserver.h"
 #include "vm/luavm/lua/lua.h"
+#include "vm/wasm/wasm_module_cache.hpp"
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
 #include "main.h"
@@ -24,7 +25,10 @@
 #include "persistence/accountdb.h"
 #include "persistence/txdb.h"
 #include "persistence/contractdb.h"
+#include "persistence/memcachesnapshot.h"
+#include "persistence/chainstatesnapshot.h"
 #include "tx/tx.h"
+#include "tx/txexecutor.h"
 #include "commons/util/util.h"
 #include "commons/util/time.h"
 #ifdef USE_UPNP
@@ -68,7 +72,6 @@ CWallet *pWalletMain;
 
 static std::unique_ptr<ECCVerifyHandle> globalVerifyHandle;
 
-extern void wasm_code_cache_free();
 
 #ifdef WIN32
 // Win32 LevelDB doesn't use filedescriptors, and the ones used for
@@ -142,6 +145,8 @@ void Shutdown() {
     StopNode();
     UnregisterNodeSignals(GetNodeSignals());
 
+    sigCheckQueue.Stop();
+
     {
         LOCK(cs_main);
 
@@ -151,7 +156,11 @@ void Shutdown() {
         }
 
         if (pCdMan != nullptr) {
-            pCdMan->Flush();
+            ResetChainStateSnapshot();
+            if (!pCdMan->Flush())
+                LogPrint(BCLog::ERROR, "Shutdown() : failed to write the chain state\n");
+            if (SysCfg().GetBoolArg("-memcachesnapshot", DEFAULT_MEMCACHE_SNAPSHOT))
+                WriteMemCacheSnapshot(*pCdMan);
             delete pCdMan;
             pCdMan = nullptr;
         }
@@ -212,11 +221,16 @@ string HelpMessage() {
     strUsage += "  -daemon                " + _("Run in the background as a daemon and accept commands") + "\n";
 #endif
     strUsage += "  -datadir=<dir>         " + _("Specify data directory") + "\n";
-    strUsage += "  -dbcache=<n>           " + strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), MIN_DB_CACHE, MAX_DB_CACHE, DEFAULT_DB_CACHE) + "\n";
+    strUsage += "  -dbcache=<n>           " + strprintf(_("Set the memory budget of the state database caches in megabytes, flushed to disk when exceeded (%d to %d, default: %d)"), MIN_DB_CACHE, MAX_DB_CACHE, DEFAULT_DB_CACHE) + "\n";
+    strUsage += "  -par=<n>               " + strprintf(_("Set the number of signature verification threads (-%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"), std::thread::hardware_concurrency(), MAX_SIGCHECK_THREADS, DEFAULT_SIGCHECK_THREADS) + "\n";
+    strUsage += "  -parallelexec=<n>      " + strprintf(_("Set the number of threads executing the coin transfer and DEX order txs of a block speculatively (0 to %d, 0 or 1 = serial, default: %d)"), MAX_PARALLEL_EXEC_THREADS, DEFAULT_PARALLEL_EXEC_THREADS) + "\n";
     strUsage += "  -loadblock=<file>      " + _("Imports blocks from external blk000??.dat file") + " " + _("on startup") + "\n";
     strUsage += "  -pid=<file>            " + _("Specify pid file (default: coin.pid)") + "\n";
     strUsage += "  -reindex               " + _("Rebuild block chain index from current blk000??.dat files") + " " + _("on startup") + "\n";
     strUsage += "  -txindex               " + _("Maintain a full transaction index (default: 0)") + "\n";
+    strUsage += "  -singlestatedb         " + strprintf(_("Keep all the state databases in one LevelDB and flush them in one atomic batch, changing it requires -reindex (default: %u)"), DEFAULT_SINGLE_STATE_DB) + "\n";
+    strUsage += "  -dbnegativecache=<n>   " + strprintf(_("Remember up to <n> keys found absent from the state databases per key prefix, 0 to disable (default: %u)"), DEFAULT_DB_NEGATIVE_CACHE_SIZE) + "\n";
+    strUsage += "  -dbbloomfilter=<prefix> " + _("Load an in-memory bloom filter of the keys of the state database key prefix at startup, about 20 bits per key, e.g. idac, tidx (can be specified multiple times)") + "\n";
     strUsage += "  -logfailures           " + _("Log failures into level db in detail (default: 0)") + "\n";
     strUsage += "  -genreceipt               " + _("Whether generate receipt(default: 0)") + "\n";
 
@@ -284,7 +298,12 @@ string HelpMessage() {
     strUsage += "  -logtimestamps         " + _("Prepend debug output with timestamp (default: 1)") + "\n";
     if (SysCfg().GetBoolArg("-help-debug", false)) {
         strUsage += "  -limitfreerelay=<n>    " + _("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default:15)") + "\n";
-        strUsage += "  -maxsigcachesize=<n>   " + _("Limit size of signature cache to <n> entries (default: 50000)") + "\n";
+        strUsage += "  -maxsigcachesize=<n>   " + strprintf(_("Limit size of signature cache to <n> megabytes (default: %d)"), DEFAULT_MAX_SIG_CACHE_SIZE) + "\n";
+        strUsage += "  -pubkeycache=<n>       " + strprintf(_("Limit size of the parsed public key cache of the signature verification to <n> megabytes (default: %d)"), DEFAULT_PUBKEY_CACHE_SIZE) + "\n";
+        strUsage += "  -blocksummarycache=<n> " + strprintf(_("Limit size of the recent block summary cache to <n> megabytes (default: %d)"), DEFAULT_BLOCK_SUMMARY_CACHE_SIZE) + "\n";
+        strUsage += "  -wasmmodulecache=<n>   " + strprintf(_("Limit size of the instantiated wasm contract cache to <n> megabytes (default: %d)"), wasm::default_wasm_module_cache_size) + "\n";
+        strUsage += "  -memcachesnapshot      " + strprintf(_("Write the snapshot of the recent tx and price caches with the chain state and load it on startup (default: %u)"), DEFAULT_MEMCACHE_SNAPSHOT) + "\n";
+        strUsage += "  -blockfilemmap=<n>     " + strprintf(_("Map up to <n> block and undo files into memory to read the historic blocks from, 0 reads them through stdio (default: %d)"), DEFAULT_BLOCK_FILE_MMAP) + "\n";
     }
     strUsage += "  -logprinttoconsole     " + _("Send trace/debug info to console instead of debug.log file") + "\n";
     if (SysCfg().GetBoolArg("-help-debug", false)) {
@@ -309,6 +328,8 @@ string HelpMessage() {
     strUsage += "  -rpcport=<port>        " + _("Listen for JSON-RPC connections on <port> (default: 8332 or testnet: 18332)") + "\n";
     strUsage += "  -rpcallowip=<ip>       " + _("Allow JSON-RPC connections from specified IP address") + "\n";
     strUsage += "  -rpcthreads=<n>        " + _("Set the number of threads to service RPC calls (default: 4)") + "\n";
+    strUsage += "  -rpcbatchthreads=<n>   " + strprintf(_("Max number of threads running the calls of a batch request (default: %d)"), DEFAULT_RPC_BATCH_THREADS) + "\n";
+    strUsage += "  -rpcbatchsize=<n>      " + strprintf(_("Max number of calls of a batch request, 0 for no limit (default: %d)"), DEFAULT_RPC_BATCH_SIZE) + "\n";
 
     strUsage += "\n" + _("RPC SSL options: (see the Coin Wiki for SSL setup instructions)") + "\n";
     strUsage += "  -rpcssl                                  " + _("Use OpenSSL (https) for JSON-RPC connections") + "\n";
@@ -389,6 +410,7 @@ void ThreadImport(vector<boost::filesystem::path> vImportFiles) {
  *  @pre Parameters should be parsed and config file should be read.
  */
 bool AppInit(boost::thread_group &threadGroup) {
+    int64_t nStartupTime = GetTimeMillis();
 #ifdef _MSC_VER
     // Turn off Microsoft heap dump noise
     _CrtSetReportMode(_CRT_WARN, _CRTDBG_MODE_FILE);
@@ -503,6 +525,15 @@ bool AppInit(boost::thread_group &threadGroup) {
     if (nFD - MIN_CORE_FILEDESCRIPTORS < nMaxConnections)
         nMaxConnections = nFD - MIN_CORE_FILEDESCRIPTORS;
 
+    // -par=0 means autodetect, and one thread means verifying signatures serially in CheckTx
+    int32_t nSigCheckThreads = SysCfg().GetArg("-par", DEFAULT_SIGCHECK_THREADS);
+    if (nSigCheckThreads <= 0)
+        nSigCheckThreads += (int32_t)std::thread::hardware_concurrency();
+    nSigCheckThreads = max(min(nSigCheckThreads, MAX_SIGCHECK_THREADS), 1);
+
+    nParallelExecThreads = max(min((int32_t)SysCfg().GetArg("-parallelexec", DEFAULT_PARALLEL_EXEC_THREADS),
+                                   MAX_PARALLEL_EXEC_THREADS), 0);
+
     SysCfg().SetBenchMark(SysCfg().GetBoolArg("-benchmark", false));
     mempool.SetSanityCheck(SysCfg().GetBoolArg("-checkmempool", RegTest()));
 
@@ -553,6 +584,30 @@ bool AppInit(boost::thread_group &threadGroup) {
     LogPrint(BCLog::INFO, "Default data directory %s\n", GetDefaultDataDir().string());
     LogPrint(BCLog::INFO, "Using data directory %s\n", strDataDir);
     LogPrint(BCLog::INFO, "Using at most %i connections (%i file descriptors available)\n", nMaxConnections, nFD);
+    LogPrint(BCLog::INFO, "Using %d threads for signature verification\n", nSigCheckThreads);
+    if (nParallelExecThreads > 1)
+        LogPrint(BCLog::INFO, "Using %d threads for parallel tx execution\n", nParallelExecThreads);
+
+    int64_t nSigCacheSize = max(SysCfg().GetArg("-maxsigcachesize", DEFAULT_MAX_SIG_CACHE_SIZE), (int64_t)0);
+    signatureCache.SetMaxSize((uint64_t)nSigCacheSize << 20);
+    LogPrint(BCLog::INFO, "Using %d MiB for signature cache\n", nSigCacheSize);
+
+    int64_t nPubKeyCacheSize = max(SysCfg().GetArg("-pubkeycache", DEFAULT_PUBKEY_CACHE_SIZE), (int64_t)0);
+    pubKeyCache.SetMaxSize((uint64_t)nPubKeyCacheSize << 20);
+
+    int64_t nBlockSummaryCacheSize = max(SysCfg().GetArg("-blocksummarycache", DEFAULT_BLOCK_SUMMARY_CACHE_SIZE), (int64_t)0);
+    blockSummaryCache.SetMaxSize((uint64_t)nBlockSummaryCacheSize << 20);
+
+    int64_t nWasmModuleCacheSize = max(SysCfg().GetArg("-wasmmodulecache", wasm::default_wasm_module_cache_size), (int64_t)0);
+    wasm_code_cache_set_max_size((uint64_t)nWasmModuleCacheSize << 20);
+
+    int64_t nBlockFileMappings = max(SysCfg().GetArg("-blockfilemmap", DEFAULT_BLOCK_FILE_MMAP), (int64_t)0);
+    diskFileMapper.SetMaxMappings(nBlockFileMappings);
+    if (nBlockFileMappings > 0)
+        LogPrint(BCLog::INFO, "Mapping at most %d block and undo files into memory\n", nBlockFileMappings);
+
+    // the thread calling CheckBlock() takes part in verifying, so start one worker less
+    sigCheckQueue.Start(nSigCheckThreads - 1);
 
     RegisterNodeSignals(GetNodeSignals());
 
@@ -669,6 +724,11 @@ bool AppInit(boost::thread_group &threadGroup) {
 
     SysCfg().SetGenReceipt(SysCfg().GetBoolArg("-genreceipt", false));
 
+    int64_t nDbCache = SysCfg().GetArg("-dbcache", DEFAULT_DB_CACHE);
+    nDbCache = min(max(nDbCache, MIN_DB_CACHE), MAX_DB_CACHE);
+    SysCfg().SetCacheSize((uint64_t)nDbCache << 20);
+    LogPrint(BCLog::INFO, "Using %d MiB for the state db caches\n", nDbCache);
+
     filesystem::path blocksDir = GetDataDir() / "blocks";
     if (!filesystem::exists(blocksDir)) {
         filesystem::create_directories(blocksDir);
@@ -700,6 +760,12 @@ bool AppInit(boost::thread_group &threadGroup) {
 
                 mempool.SetMemPoolCache();
 
+                // the blocks connected from now on change the order book in their flushes
+                if (!pCdMan->pDexCache->LoadOrderBook()) {
+                    strLoadError = _("Error loading dex order book");
+                    break;
+                }
+
                 if (!LoadBlockIndex()) {
                     strLoadError = _("Error loading block database");
                     break;
@@ -766,7 +832,7 @@ bool AppInit(boost::thread_group &threadGroup) {
     if (SysCfg().IsArgCount("-printblock")) {
         string strMatch = SysCfg().GetArg("-printblock", "");
         int32_t nFound      = 0;
-        for (map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
+        for (BlockMap::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
             uint256 hash = (*mi).first;
             if (strncmp(hash.ToString().c_str(), strMatch.c_str(), strMatch.size()) == 0) {
                 CBlockIndex *pIndex = (*mi).second;
@@ -788,21 +854,48 @@ bool AppInit(boost::thread_group &threadGroup) {
     if (!ActivateBestChain(state))
         return InitError("Failed to connect best block");
 
+    // the memory caches of the latest blocks are loaded from the snapshot taken with the chain state, only the
+    // blocks connected after the snapshot are read from disk. A snapshot off the active chain is not used.
+    nStart = GetTimeMillis();
+    CMemCacheSnapshot snapshot;
+    CBlockIndex *pSnapshotTip = nullptr;
+    if (SysCfg().GetBoolArg("-memcachesnapshot", DEFAULT_MEMCACHE_SNAPSHOT) && CMemCacheSnapshotDB().Read(snapshot)) {
+        auto it = mapBlockIndex.find(snapshot.tipHash);
+        if (it != mapBlockIndex.end() && chainActive.Contains(it->second) && it->second->height == snapshot.tipHeight)
+            pSnapshotTip = it->second;
+        else
+            LogPrint(BCLog::INFO, "The memory cache snapshot at block %s is not on the active chain, ignored\n",
+                     snapshot.tipHash.ToString());
+    }
+    LogPrint(BCLog::INFO, "Read the memory cache snapshot (%dms)\n", GetTimeMillis() - nStart);
+
     nStart                   = GetTimeMillis();
     CBlockIndex *pBlockIndex = chainActive.Tip();
     int32_t nCacheHeight     = SysCfg().GetTxCacheHeight();
     int32_t nCount           = 0;
     CBlock block;
-    while (pBlockIndex && nCacheHeight-- > 0) {
+    while (pBlockIndex && pBlockIndex != pSnapshotTip && nCacheHeight-- > 0) {
         if (!ReadBlockFromDisk(pBlockIndex, block))
             return InitError("Failed to read block from disk");
 
         if (!pCdMan->pTxCache->AddBlockTx(block))
             return InitError("Failed to add block to transaction memory cache");
 
+        blockSummaryCache.Add(pBlockIndex, block);
         pBlockIndex = pBlockIndex->pprev;
         ++nCount;
     }
+    // the rest of the blocks are in the snapshot
+    if (pBlockIndex != nullptr && pBlockIndex == pSnapshotTip) {
+        map<int32_t, vector<uint256>> blockTxids;
+        for (const auto &item : snapshot.blockTxids) {
+            if (item.first > pSnapshotTip->height - nCacheHeight)
+                blockTxids.insert(item);
+        }
+        pCdMan->pTxCache->AddBlockTxids(blockTxids);
+        LogPrint(BCLog::INFO, "Added %u blocks from the memory cache snapshot to transaction memory cache\n",
+                 blockTxids.size());
+    }
     LogPrint(BCLog::INFO, "Added the latest %d blocks to transaction memory cache (%dms)\n", nCount, GetTimeMillis() - nStart);
 
     nStart       = GetTimeMillis();
@@ -816,16 +909,27 @@ bool AppInit(boost::thread_group &threadGroup) {
             return InitError("Failed to read block from disk");
     }
 
-    while (pBlockIndex && nCacheHeight-- > 0) {
-        if (!ReadBlockFromDisk(pBlockIndex, block))
+    std::shared_ptr<const CBlockSummary> spBlock;
+    while (pBlockIndex && pBlockIndex != pSnapshotTip && nCacheHeight-- > 0) {
+        if (!blockSummaryCache.Get(pBlockIndex, spBlock))
             return InitError("Failed to read block from disk");
 
-        if (!pCdMan->pPpCache->AddPriceByBlock(block))
+        if (!pCdMan->pPpCache->AddPriceByBlock(*spBlock))
             return InitError("Failed to add block to price point memory cache");
 
         pBlockIndex = pBlockIndex->pprev;
         ++nCount;
     }
+    if (pBlockIndex != nullptr && pBlockIndex == pSnapshotTip) {
+        CoinPricePointMap blockPrices;
+        for (const auto &item : snapshot.blockPrices) {
+            const auto &mapBlockUserPrices = item.second.mapBlockUserPrices;
+            for (auto it = mapBlockUserPrices.upper_bound(pSnapshotTip->height - nCacheHeight);
+                 it != mapBlockUserPrices.end(); ++it)
+                blockPrices[item.first].mapBlockUserPrices.insert(*it);
+        }
+        pCdMan->pPpCache->AddBlockPrices(blockPrices);
+    }
     LogPrint(BCLog::INFO, "Added the latest %d blocks to price point memory cache (%dms)\n", nCount, GetTimeMillis() - nStart);
 
     vector<boost::filesystem::path> vImportFiles;
@@ -867,11 +971,13 @@ bool AppInit(boost::thread_group &threadGroup) {
         GenerateProduceBlockThread(SysCfg().GetBoolArg("-genblock", false), pWalletMain, SysCfg().GetArg("-genblocklimit", -1));
         pWalletMain->ResendWalletTransactions();
         threadGroup.create_thread(boost::bind(&ThreadFlushWalletDB, boost::ref(pWalletMain->strWalletFile)));
+        threadGroup.create_thread(boost::bind(&ThreadWalletSync, pWalletMain));
 
         //resend unconfirmed tx
         threadGroup.create_thread(boost::bind(&ThreadRelayTx, pWalletMain));
     }
 
+    LogPrint(BCLog::INFO, "Node started (%dms)\n", GetTimeMillis() - nStartupTime);
     return !fRequestShutdown;
 }
 
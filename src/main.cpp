@@ -17,6 +17,7 @@
 #include "miner/miner.h"
 #include "net.h"
 #include "tx/merkletx.h"
+#include "tx/mulsigtx.h"
 #include "commons/util/util.h"
 
 #include "commons/json/json_spirit_utils.h"
@@ -27,6 +28,9 @@
 #include "p2p/sendmessage.hpp"
 #include "chain/blockdelegates.h"
 #include "persistence/blockundo.h"
+#include "persistence/memcachesnapshot.h"
+#include "persistence/chainstatesnapshot.h"
+#include "tx/txexecutor.h"
 #include "tx/txserializer.h"
 
 #include <sstream>
@@ -35,6 +39,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <memory>
+#include <thread>
 
 using namespace json_spirit;
 using namespace std;
@@ -53,11 +58,16 @@ using namespace boost;
 CCacheDBManager *pCdMan = nullptr;
 CCriticalSection cs_main;
 CTxMemPool mempool;
-map<uint256, CBlockIndex *> mapBlockIndex;
+BlockMap mapBlockIndex;
+CCriticalSection cs_mapBlockIndex;
+CBlockIndexArena blockIndexArena;
 int32_t nSyncTipHeight = 0;
+int32_t nParallelExecThreads = DEFAULT_PARALLEL_EXEC_THREADS;
 string publicIp;
 map<uint256/* blockhash */, std::shared_ptr<CCacheWrapper>> mapForkCache;
 CSignatureCache signatureCache;
+CSigCheckQueue sigCheckQueue;
+CBlockSummaryCache blockSummaryCache;
 CChain chainActive;
 CChain chainMostWork;
 bool mining;        // could change from time to time due to vote change
@@ -272,15 +282,20 @@ bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, CBaseTx *pBas
         return state.DoS(0, ERRORMSG("AcceptToMemoryPool() : txid: %s is nonstandard transaction due to %s",
                         hash.GetHex(), reason), REJECT_NONSTANDARD, reason);
 
-    auto spCW = std::make_shared<CCacheWrapper>(mempool.cw.get());
-
     CBlockIndex *pTip =  chainActive.Tip();
     uint32_t fuelRate  = GetElementForBurn(pTip);
     uint32_t blockTime = pTip->GetBlockTime();
     uint32_t prevBlockTime = pTip->pprev != nullptr ? pTip->pprev->GetBlockTime() : pTip->GetBlockTime();
 
-    CTxExecuteContext context(chainActive.Height(), 0, fuelRate, blockTime, prevBlockTime, spCW.get(), &state);
-    if (!pBaseTx->CheckTx(context))
+    // CheckTx() runs on the mempool cache directly, whatever it may change is rolled back
+    bool checked;
+    {
+        CCacheSavepoint savepoint(*mempool.cw);
+        CTxExecuteContext context(chainActive.Height(), 0, fuelRate, blockTime, prevBlockTime, mempool.cw.get(), &state);
+        checked = pBaseTx->CheckTx(context);
+        savepoint.Rollback();
+    }
+    if (!checked)
         return ERRORMSG("AcceptToMemoryPool() : CheckTx failed, txid: %s", hash.GetHex());
 
     CTxMemPoolEntry entry(pBaseTx, GetTime(), chainActive.Height());
@@ -322,7 +337,7 @@ int32_t CMerkleTx::GetDepthInMainChainINTERNAL(CBlockIndex *&pindexRet) const {
     AssertLockHeld(cs_main);
 
     // Find the block it claims to be in
-    map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(blockHash);
+    BlockMap::iterator mi = mapBlockIndex.find(blockHash);
     if (mi == mapBlockIndex.end())
         return 0;
 
@@ -392,18 +407,8 @@ bool GetTransaction(std::shared_ptr<CBaseTx> &pBaseTx, const uint256 &hash, CBlo
 
         if (SysCfg().IsTxIndex()) {
             CDiskTxPos diskTxPos;
-            if (blockCache.ReadTxIndex(hash, diskTxPos)) {
-                CAutoFile file(OpenBlockFile(diskTxPos, true), SER_DISK, CLIENT_VERSION);
-                CBlockHeader header;
-                try {
-                    file >> header;
-                    fseek(file, diskTxPos.nTxOffset, SEEK_CUR);
-                    file >> pBaseTx;
-                } catch (std::exception &e) {
-                    return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
-                }
-                return true;
-            }
+            if (blockCache.ReadTxIndex(hash, diskTxPos))
+                return ReadTxFromDisk(diskTxPos, pBaseTx);
         }
     }
     return false;
@@ -644,7 +649,7 @@ bool ReconsiderBlock(CValidationState &state, CBlockIndex *pIndex) {
     AssertLockHeld(cs_main);
 
     // Remove the invalidity flag from this block and all its descendants.
-    map<uint256, CBlockIndex *>::const_iterator it = mapBlockIndex.begin();
+    BlockMap::const_iterator it = mapBlockIndex.begin();
     int32_t height                                    = pIndex->height;
     while (it != mapBlockIndex.end()) {
         if (it->second->nStatus & BLOCK_FAILED_MASK && it->second->GetAncestor(height) == pIndex) {
@@ -703,7 +708,7 @@ bool DisconnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CVal
     cw.blockCache.SetBestBlock(pIndex->pprev->GetBlockHash());
 
     // Delete the disconnected block's transactions from transaction memory cache.
-    if (!cw.txCache.RemoveBlockTx(block)) {
+    if (!cw.txCache.RemoveBlockTx(block.GetHeight())) {
         return state.Abort(_("DisconnectBlock() : failed to delete block from transaction memory cache"));
     }
 
@@ -715,12 +720,12 @@ bool DisconnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CVal
             pReLoadBlockIndex = pReLoadBlockIndex->pprev;
         }
 
-        CBlock reLoadblock;
-        if (!ReadBlockFromDisk(pReLoadBlockIndex, reLoadblock)) {
+        std::shared_ptr<const CBlockSummary> spReLoadBlock;
+        if (!blockSummaryCache.Get(pReLoadBlockIndex, spReLoadBlock)) {
             return state.Abort(_("DisconnectBlock() : failed to read block"));
         }
 
-        if (!cw.txCache.AddBlockTx(reLoadblock)) {
+        if (!cw.txCache.AddBlockTx(*spReLoadBlock)) {
             return state.Abort(_("DisconnectBlock() : failed to add block into transaction memory cache"));
         }
     }
@@ -1080,6 +1085,10 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
         uint32_t fuelRate     = block.GetFuelRate();
         uint64_t totalRunStep = 0;
 
+        uint32_t prevBlockTime = pIndex->pprev != nullptr ? pIndex->pprev->GetBlockTime() : pIndex->GetBlockTime();
+        CTxParallelExecutor txExecutor(block, pIndex->height, fuelRate, pIndex->nTime, prevBlockTime, cw,
+                                       nParallelExecThreads);
+
         for (int32_t index = 1; index < (int32_t)block.vptx.size(); ++index) {
             std::shared_ptr<CBaseTx> &pBaseTx = block.vptx[index];
             if (cw.txCache.HaveTx((pBaseTx->GetHash())))
@@ -1091,11 +1100,7 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
                                  pBaseTx->GetHash().GetHex()), REJECT_INVALID, "tx-invalid-height");
 
             pBaseTx->nFuelRate = fuelRate;
-            CTxUndoOpLogger opLogger(cw, pBaseTx->GetHash(), blockUndo);
-
-            uint32_t prevBlockTime = pIndex->pprev != nullptr ? pIndex->pprev->GetBlockTime() : pIndex->GetBlockTime();
-            CTxExecuteContext context(pIndex->height, index, fuelRate, pIndex->nTime, prevBlockTime, &cw, &state);
-            if (!pBaseTx->ExecuteTx(context)) {
+            if (!txExecutor.ExecuteTx(index, blockUndo, state)) {
                 pCdMan->pLogCache->SetExecuteFail(pIndex->height, pBaseTx->GetHash(), state.GetRejectCode(),
                                                   state.GetRejectReason());
                 return state.DoS(100, ERRORMSG("ConnectBlock() : txid=%s execute failed, in detail: %s",
@@ -1123,6 +1128,10 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
             LogPrint(BCLog::DEBUG, "total fuel fee:%d, tx fuel fee:%d runStep:%d fuelRate:%d txid:%s\n", totalFuel,
                      fuel, pBaseTx->nRunStep, fuelRate, pBaseTx->GetHash().GetHex());
         }
+
+        if (txExecutor.GetSpeculatedCount() > 0)
+            LogPrint(BCLog::DEBUG, "ConnectBlock() : block[%d] parallel txs=%u, re-executed=%u\n", pIndex->height,
+                     txExecutor.GetSpeculatedCount(), txExecutor.GetReexecutedCount());
     }
 
     // Verify total fuel
@@ -1204,16 +1213,18 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
         }
 
         if (nullptr != pMatureIndex) {
-            CBlock matureBlock;
-            if (!ReadBlockFromDisk(pMatureIndex, matureBlock)) {
+            std::shared_ptr<const CBlockSummary> spMatureBlock;
+            if (!blockSummaryCache.Get(pMatureIndex, spMatureBlock)) {
                 return state.Abort(_("ConnectBlock() : read mature block error"));
             }
 
+            // execute a copy, the cached reward tx is shared
+            std::shared_ptr<CBaseTx> pMatureRewardTx = spMatureBlock->pRewardTx->GetNewInstance();
             uint32_t prevBlockTime = pIndex->pprev != nullptr ? pIndex->pprev->GetBlockTime() : pIndex->GetBlockTime();
             CTxExecuteContext context(pIndex->height, -1, pIndex->nFuelRate, pIndex->nTime, prevBlockTime, &cw, &state);
             CTxUndoOpLogger rewardOpLogger(cw, block.vptx[0]->GetHash(), blockUndo);
-            if (!matureBlock.vptx[0]->ExecuteTx(context)) {
-                pCdMan->pLogCache->SetExecuteFail(pIndex->height, matureBlock.vptx[0]->GetHash(), state.GetRejectCode(),
+            if (!pMatureRewardTx->ExecuteTx(context)) {
+                pCdMan->pLogCache->SetExecuteFail(pIndex->height, pMatureRewardTx->GetHash(), state.GetRejectCode(),
                                                   state.GetRejectReason());
                 return state.DoS(100, ERRORMSG("ConnectBlock() : execute mature block reward tx error"));
             }
@@ -1260,12 +1271,8 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
             pDeleteBlockIndex = pDeleteBlockIndex->pprev;
         }
 
-        CBlock deleteBlock;
-        if (!ReadBlockFromDisk(pDeleteBlockIndex, deleteBlock)) {
-            return state.Abort(_("ConnectBlock() : failed to read block"));
-        }
-
-        if (!cw.txCache.RemoveBlockTx(deleteBlock)) {
+        // the txids are kept per height, no need to read the block
+        if (!cw.txCache.RemoveBlockTx(pDeleteBlockIndex->height)) {
             return state.Abort(_("ConnectBlock() : failed delete block from transaction memory cache"));
         }
     }
@@ -1281,12 +1288,8 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
             pDeleteBlockIndex = pDeleteBlockIndex->pprev;
         }
 
-        CBlock deleteBlock;
-        if (!ReadBlockFromDisk(pDeleteBlockIndex, deleteBlock)) {
-            return state.Abort(_("ConnectBlock() : failed to read block"));
-        }
-
-        if (!cw.ppCache.DeleteBlockFromCache(deleteBlock)) {
+        // only the height of the block is needed, no need to read it
+        if (!cw.ppCache.DeleteBlockFromCache(pDeleteBlockIndex->height)) {
             return state.Abort(_("ConnectBlock() : failed delete block from price point memory cache"));
         }
     }
@@ -1294,27 +1297,24 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
     // Set best block to current account cache.
     cw.blockCache.SetBestBlock(pIndex->GetBlockHash());
 
+    // Keep the summary of the block for the look-back reads of the following blocks
+    blockSummaryCache.Add(pIndex, block);
+
     return true;
 }
 
 // Update the on-disk chain state.
 bool static WriteChainState(CValidationState &state) {
     static int64_t nLastWrite = 0;
-    uint32_t cacheSize        =
-        pCdMan->pSysParamCache->GetCacheSize() +
-        pCdMan->pAccountCache->GetCacheSize() +
-        pCdMan->pAssetCache->GetCacheSize() +
-        pCdMan->pContractCache->GetCacheSize() +
-        pCdMan->pDelegateCache->GetCacheSize() +
-        pCdMan->pCdpCache->GetCacheSize() +
-        pCdMan->pClosedCdpCache->GetCacheSize() +
-        pCdMan->pDexCache->GetCacheSize() +
-        pCdMan->pBlockCache->GetCacheSize() +
-        pCdMan->pLogCache->GetCacheSize() +
-        pCdMan->pReceiptCache->GetCacheSize();
-
-    if (!IsInitialBlockDownload() || cacheSize > SysCfg().GetCacheSize() ||
-        GetTimeMicros() > nLastWrite + 60 * 1000000) {
+    // during IBD the caches are flushed when their heap memory exceeds the -dbcache budget, or once a minute
+    uint64_t cacheSize = pCdMan->GetCacheSize();
+    bool fOverBudget   = cacheSize > SysCfg().GetCacheSize();
+
+    if (!IsInitialBlockDownload() || fOverBudget || GetTimeMicros() > nLastWrite + 60 * 1000000) {
+        if (fOverBudget)
+            LogPrint(BCLog::CDB, "flush the db caches: %llu bytes used, budget %llu bytes\n", cacheSize,
+                     SysCfg().GetCacheSize());
+
         // Typical CCoins structures on disk are around 100 bytes in size.
         // Pushing a new one to the database can cause it to be written
         // twice (once in the log, and once in the tables). This is already
@@ -1325,9 +1325,28 @@ bool static WriteChainState(CValidationState &state) {
 
         FlushBlockFile();
         // pCdMan->pBlockCache->Sync();
-        pCdMan->Flush();
+        // a failed write leaves the dbs at the last flushed state, the node must not go on from the caches
+        bool fFlushed = false;
+        try {
+            fFlushed = pCdMan->Flush();
+        } catch (const leveldb_error &e) {
+            LogPrint(BCLog::ERROR, "WriteChainState() : %s\n", e.what());
+        }
+        if (!fFlushed) {
+            LogPrint(BCLog::ERROR, "WriteChainState() : failed to write the chain state\n");
+            return state.Error("failed to write the chain state");
+        }
+
         mapForkCache.clear();
         nLastWrite = GetTimeMicros();
+
+        // the snapshot is taken at the flushed best block, a failure only makes the next startup read the blocks
+        static int64_t nLastSnapshotWrite = 0;
+        if (SysCfg().GetBoolArg("-memcachesnapshot", DEFAULT_MEMCACHE_SNAPSHOT) &&
+            nLastWrite > nLastSnapshotWrite + MEMCACHE_SNAPSHOT_INTERVAL * 1000000) {
+            WriteMemCacheSnapshot(*pCdMan);
+            nLastSnapshotWrite = nLastWrite;
+        }
     }
     return true;
 }
@@ -1350,6 +1369,9 @@ void static UpdateTip(CBlockIndex *pIndexNew, const CBlock &block) {
              block.vptx.size(), chainActive.Tip()->nChainTx, chainActive.Tip()->nFuelRate,
              DateTimeStrFormat("%Y-%m-%d %H:%M:%S", chainActive.Tip()->GetBlockTime()));
 
+    // the read-only rpc calls read the snapshot of the new tip
+    UpdateChainStateSnapshot(pIndexNew, *pCdMan, fIsInitialDownload);
+
     // Check the version of the last 100 blocks to see if we need to upgrade:
     if (!fIsInitialDownload) {
         int32_t nUpgraded             = 0;
@@ -1383,8 +1405,13 @@ bool static DisconnectTip(CValidationState &state) {
         if (!DisconnectBlock(block, *spCW, pIndexDelete, state))
             return ERRORMSG("DisconnectTip() : DisconnectBlock %s failed", pIndexDelete->GetBlockHash().ToString());
 
-        // Need to re-sync all to global cache layer.
-        spCW->Flush();
+        // Need to re-sync all to global cache layer, the mempool revalidates the txs reading the flushed keys
+        CDBAccessSet blockWrites;
+        {
+            CDBFlushRecorder flushRecorder(blockWrites);
+            spCW->Flush();
+        }
+        mempool.AddBlockWrites(blockWrites);
 
         // Attention: need to reset the lastest block price median
         CBlockIndex *pPreBlockIndex = pIndexDelete->pprev;
@@ -1444,8 +1471,13 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pIndexNew) {
             mapBlockSource.erase(inv.hash);
         }
 
-        // Need to re-sync all to global cache layer.
-        spCW->Flush();
+        // Need to re-sync all to global cache layer, the mempool revalidates the txs reading the flushed keys
+        CDBAccessSet blockWrites;
+        {
+            CDBFlushRecorder flushRecorder(blockWrites);
+            spCW->Flush();
+        }
+        mempool.AddBlockWrites(blockWrites);
     }
 
     if (SysCfg().IsBenchmark())
@@ -1459,7 +1491,7 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pIndexNew) {
     UpdateTip(pIndexNew, block);
 
     for (auto &pTxItem : block.vptx) {
-        mempool.memPoolTxs.erase(pTxItem->GetHash());
+        mempool.RemoveConfirmed(pTxItem->GetHash());
     }
     return true;
 }
@@ -1634,17 +1666,21 @@ bool AddToBlockIndex(CBlock &block, CValidationState &state, const CDiskBlockPos
         return state.Invalid(ERRORMSG("AddToBlockIndex() : %s already exists", hash.ToString()), 0, "duplicate");
 
     // Construct new block index object
-    CBlockIndex *pIndexNew = new CBlockIndex(block);
+    CBlockIndex *pIndexNew = blockIndexArena.New(block);
 
     assert(pIndexNew);
     {
         LOCK(cs_nBlockSequenceId);
         pIndexNew->nSequenceId = nBlockSequenceId++;
     }
-    map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
+    BlockMap::iterator mi;
+    {
+        LOCK(cs_mapBlockIndex);
+        mi = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
+    }
     // LogPrint(BCLog::INFO, "in map hash:%s map size:%d\n", hash.GetHex(), mapBlockIndex.size());
     pIndexNew->pBlockHash                        = &((*mi).first);
-    map<uint256, CBlockIndex *>::iterator miPrev = mapBlockIndex.find(block.GetPrevBlockHash());
+    BlockMap::iterator miPrev = mapBlockIndex.find(block.GetPrevBlockHash());
     if (miPrev != mapBlockIndex.end()) {
         pIndexNew->pprev  = (*miPrev).second;
         pIndexNew->height = pIndexNew->pprev->height + 1;
@@ -1833,16 +1869,16 @@ bool ProcessForkedChain(const CBlock &block, CBlockIndex *pPreBlockIndex, CValid
     {
         // Set base to null and rebuild memory cache.
         CBlockIndex *pBlockIndex = mapBlockIndex[forkChainBestBlockHash];
-        CBlock block;
+        std::shared_ptr<const CBlockSummary> spBlock;
 
         // TODO: parameterize 11
         int32_t cacheHeight = 11;
         while (pBlockIndex && cacheHeight-- > 0) {
-            if (!ReadBlockFromDisk(pBlockIndex, block))
+            if (!blockSummaryCache.Get(pBlockIndex, spBlock))
                 return ERRORMSG("ProcessForkedChain() : failed to read block [%d]: %s", pBlockIndex->height,
                                 pBlockIndex->GetBlockHash().ToString());
 
-            if (!spCW->ppCache.AddPriceByBlock(block))
+            if (!spCW->ppCache.AddPriceByBlock(*spBlock))
                 return ERRORMSG("ProcessForkedChain() : failed to add block [%d]: %s to price point memory cache",
                                 pBlockIndex->height, pBlockIndex->GetBlockHash().ToString());
 
@@ -1886,6 +1922,44 @@ bool ProcessForkedChain(const CBlock &block, CBlockIndex *pPreBlockIndex, CValid
     return true;
 }
 
+/**
+ * Collect the (sighash, pubkey, signature) of every tx in the block and verify them on the
+ * sigcheck worker pool. It only warms up signatureCache; the result of each check is still
+ * decided by CheckTx, so txs whose signer can't be resolved here are just skipped.
+ */
+static void PreVerifyBlockSignatures(const CBlock &block, CCacheWrapper &cw) {
+    if (sigCheckQueue.GetThreadCount() <= 1 || block.vptx.size() <= 2)
+        return;
+
+    vector<CSigCheck> checks;
+    checks.reserve(block.vptx.size());
+
+    CAccount account;
+    for (const auto &pBaseTx : block.vptx) {
+        if (pBaseTx->IsBlockRewardTx() || pBaseTx->IsPriceMedianTx())
+            continue;
+
+        const uint256 sigHash = pBaseTx->GetHash();
+        if (pBaseTx->nTxType == UCOIN_TRANSFER_MTX) {
+            for (const auto &item : ((CMulsigTx *)pBaseTx.get())->signaturePairs) {
+                if (!item.signature.empty() && cw.accountCache.GetAccount(item.regid, account))
+                    checks.emplace_back(sigHash, account.owner_pubkey, item.signature);
+            }
+            continue;
+        }
+
+        if (pBaseTx->signature.empty())
+            continue;
+
+        if (pBaseTx->txUid.is<CPubKey>())
+            checks.emplace_back(sigHash, pBaseTx->txUid.get<CPubKey>(), pBaseTx->signature);
+        else if (pBaseTx->txUid.is<CRegID>() && cw.accountCache.GetAccount(pBaseTx->txUid, account))
+            checks.emplace_back(sigHash, account.owner_pubkey, pBaseTx->signature);
+    }
+
+    sigCheckQueue.Verify(checks, signatureCache);
+}
+
 bool CheckBlock(const CBlock &block, CValidationState &state, CCacheWrapper &cw, bool fCheckTx, bool fCheckMerkleRoot) {
     if (block.vptx.empty() || block.vptx.size() > MAX_BLOCK_SIZE ||
         ::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION) > MAX_BLOCK_SIZE)
@@ -1911,6 +1985,9 @@ bool CheckBlock(const CBlock &block, CValidationState &state, CCacheWrapper &cw,
     // recalculated many times during this block's validation.
     block.BuildMerkleTree();
 
+    if (fCheckTx)
+        PreVerifyBlockSignatures(block, cw);
+
     // Check for duplicate txids. This is caught by ConnectInputs(),
     // but catching it earlier avoids a potential DoS attack:
     set<uint256> uniqueTx;
@@ -1980,7 +2057,7 @@ bool AcceptBlock(CBlock &block, CValidationState &state, CDiskBlockPos *dbp, boo
     CBlockIndex *pPrevBlockIndex = nullptr;
     int32_t height = 0;
     if (block.GetHeight() != 0 || blockHash != SysCfg().GetGenesisBlockHash()) {
-        map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(block.GetPrevBlockHash());
+        BlockMap::iterator mi = mapBlockIndex.find(block.GetPrevBlockHash());
         if (mi == mapBlockIndex.end())
             return state.DoS(10, ERRORMSG("AcceptBlock() : prev block not found"), 0, "bad-prevblk");
 
@@ -2309,21 +2386,16 @@ bool CheckDiskSpace(uint64_t nAdditionalBytes) {
 }
 
 bool static LoadBlockIndexDB() {
-    if (!pCdMan->pBlockIndexDb->LoadBlockIndexes())
+    int64_t nStart = GetTimeMillis();
+    vector<CBlockIndex *> vSortedByHeight;
+    if (!pCdMan->pBlockIndexDb->LoadBlockIndexes(mapBlockIndex, blockIndexArena, vSortedByHeight,
+                                                 std::thread::hardware_concurrency()))
         return ERRORMSG("%s(), LoadBlockIndexes from db failed", __FUNCTION__);
 
     boost::this_thread::interruption_point();
 
     // Calculate nChainWork
-    vector<pair<int32_t, CBlockIndex *> > vSortedByHeight;
-    vSortedByHeight.reserve(mapBlockIndex.size());
-    for (const auto &item : mapBlockIndex) {
-        CBlockIndex *pIndex = item.second;
-        vSortedByHeight.push_back(make_pair(pIndex->height, pIndex));
-    }
-    sort(vSortedByHeight.begin(), vSortedByHeight.end());
-    for (const auto &item : vSortedByHeight) {
-        CBlockIndex *pIndex = item.second;
+    for (CBlockIndex *pIndex : vSortedByHeight) {
         pIndex->nChainWork  = pIndex->height;
         pIndex->nChainTx    = (pIndex->pprev ? pIndex->pprev->nChainTx : 0) + pIndex->nTx;
         if ((pIndex->nStatus & BLOCK_VALID_MASK) >= BLOCK_VALID_TRANSACTIONS && !(pIndex->nStatus & BLOCK_FAILED_MASK))
@@ -2334,6 +2406,8 @@ bool static LoadBlockIndexDB() {
         if (pIndex->pprev)
             pIndex->BuildSkip();
     }
+    LogPrint(BCLog::INFO, "LoadBlockIndexDB(): loaded %u block indexes (%dms)\n", vSortedByHeight.size(),
+             GetTimeMillis() - nStart);
 
     // Load block file info
     pCdMan->pBlockCache->ReadLastBlockFile(nLastBlockFile);
@@ -2463,7 +2537,10 @@ bool VerifyDB(int32_t nCheckLevel, int32_t nCheckDepth) {
 }
 
 void UnloadBlockIndex() {
-    mapBlockIndex.clear();
+    {
+        LOCK(cs_mapBlockIndex);
+        mapBlockIndex.clear();
+    }
     setBlockIndexValid.clear();
     chainActive.SetTip(nullptr);
     pIndexBestInvalid = nullptr;
@@ -2517,7 +2594,7 @@ void PrintBlockTree() {
     AssertLockHeld(cs_main);
     // pre-compute tree structure
     map<CBlockIndex *, vector<CBlockIndex *> > mapNext;
-    for (map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
+    for (BlockMap::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
         CBlockIndex *pIndex = (*mi).second;
         mapNext[pIndex->pprev].push_back(pIndex);
     }
@@ -2697,10 +2774,8 @@ class CMainCleanup {
     CMainCleanup() {}
     ~CMainCleanup() {
         // block headers
-        map<uint256, CBlockIndex *>::iterator it1 = mapBlockIndex.begin();
-        for (; it1 != mapBlockIndex.end(); it1++)
-            delete (*it1).second;
         mapBlockIndex.clear();
+        blockIndexArena.Clear();
 
         // orphan blocks
         map<uint256, COrphanBlock *>::iterator it2 = mapOrphanBlocks.begin();
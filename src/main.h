@@ -43,9 +43,18 @@ extern CCriticalSection cs_main;
 /** The currently-connected chain of blocks. */
 extern CChain chainActive;
 extern CSignatureCache signatureCache;
+extern CSigCheckQueue sigCheckQueue;
+/** Fork chain views by the hash of their tip block, see ProcessForkedChain() */
+extern map<uint256, std::shared_ptr<CCacheWrapper>> mapForkCache;
+/** Summaries of recently connected blocks, see ConnectBlock() */
+extern CBlockSummaryCache blockSummaryCache;
 
 extern CTxMemPool mempool;
-extern map<uint256, CBlockIndex *> mapBlockIndex;
+extern BlockMap mapBlockIndex;
+/** Guards the changes of mapBlockIndex against its readers not holding cs_main, see CChainStateReadView */
+extern CCriticalSection cs_mapBlockIndex;
+/** Storage of the indexes of mapBlockIndex */
+extern CBlockIndexArena blockIndexArena;
 extern uint64_t nLastBlockTx;
 extern uint64_t nLastBlockSize;
 extern const string strMessageMagic;
@@ -193,6 +202,7 @@ public:
 extern CChain chainMostWork;
 extern CCacheDBManager *pCdMan;
 extern int32_t nSyncTipHeight;
+extern int32_t nParallelExecThreads;
 extern std::tuple<bool, boost::thread *> RunCoin(int32_t argc, char *argv[]);
 extern string publicIp;
 
@@ -83,25 +83,8 @@ uint32_t GetElementForBurn(CBlockIndex *pIndex) {
 }
 
 // Sort transactions by priority and fee to decide priority orders to process transactions.
-void GetPriorityTx(int32_t height, set<TxPriority> &txPriorities, const int32_t nFuelRate) {
-    static TokenSymbol feeSymbol;
-    static uint64_t fee    = 0;
-    static uint32_t txSize = 0;
-    static double feePerKb = 0;
-    static double priority = 0;
-
-    for (map<uint256, CTxMemPoolEntry>::iterator mi = mempool.memPoolTxs.begin(); mi != mempool.memPoolTxs.end(); ++mi) {
-        CBaseTx *pBaseTx = mi->second.GetTransaction().get();
-        if (!pBaseTx->IsBlockRewardTx() && !pCdMan->pTxCache->HaveTx(pBaseTx->GetHash())) {
-            feeSymbol = std::get<0>(mi->second.GetFees());
-            fee       = std::get<1>(mi->second.GetFees());
-            txSize    = mi->second.GetTxSize();
-            feePerKb  = double(fee - pBaseTx->GetFuel(height, nFuelRate)) / txSize * 1000.0;
-            priority  = mi->second.GetPriority();
-
-            txPriorities.emplace(TxPriority(priority, feePerKb, mi->second.GetTransaction()));
-        }
-    }
+void GetPriorityTx(int32_t height, vector<TxPriority> &txPriorities, const int32_t nFuelRate) {
+    mempool.GetPriorityTxs(height, nFuelRate, txPriorities);
 }
 
 
@@ -314,7 +297,7 @@ static bool CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn, std::unique_
         uint64_t reward         = 0;
 
         // Calculate && sort transactions from memory pool.
-        set<TxPriority> txPriorities;
+        vector<TxPriority> txPriorities;
         GetPriorityTx(height, txPriorities, fuelRate);
 
         LogPrint(BCLog::MINER, "CreateNewBlockPreStableCoinRelease() : got %lu transaction(s) sorted by priority rules\n",
@@ -323,6 +306,8 @@ static bool CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn, std::unique_
         // Collect transactions into the block.
         for (auto itor = txPriorities.rbegin(); itor != txPriorities.rend(); ++itor) {
             CBaseTx *pBaseTx = itor->baseTx.get();
+            if (pCdMan->pTxCache->HaveTx(pBaseTx->GetHash()))
+                continue;
 
             uint32_t txSize = pBaseTx->GetSerializeSize(SER_NETWORK, PROTOCOL_VERSION);
             if (totalBlockSize + txSize >= nBlockMaxSize) {
@@ -331,19 +316,21 @@ static bool CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn, std::unique_
                 continue;
             }
 
-            auto spCW = std::make_shared<CCacheWrapper>(&cwIn);
+            // the tx is executed on cwIn directly and rolled back if it can't be packed
+            CCacheSavepoint savepoint(cwIn);
 
             try {
                 CValidationState state;
                 pBaseTx->nFuelRate = fuelRate;
                 uint32_t prevBlockTime = pIndexPrev->GetBlockTime();
-                CTxExecuteContext context(height, index + 1, fuelRate, blockTime, prevBlockTime, spCW.get(), &state, transaction_status_type::mining);
+                CTxExecuteContext context(height, index + 1, fuelRate, blockTime, prevBlockTime, &cwIn, &state, transaction_status_type::mining);
                 if (!pBaseTx->CheckTx(context) || !pBaseTx->ExecuteTx(context)) {
                     LogPrint(BCLog::MINER, "CreateNewBlockPreStableCoinRelease() : failed to pack transaction, txid: %s\n",
                             pBaseTx->GetHash().GetHex());
 
                     pCdMan->pLogCache->SetExecuteFail(height, pBaseTx->GetHash(), state.GetRejectCode(),
                                                       state.GetRejectReason());
+                    savepoint.Rollback();
                     continue;
                 }
 
@@ -351,15 +338,15 @@ static bool CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn, std::unique_
                 if (totalRunStep + pBaseTx->nRunStep >= MAX_BLOCK_RUN_STEP) {
                     LogPrint(BCLog::MINER, "CreateNewBlockPreStableCoinRelease() : exceed max block run steps, txid: %s\n",
                             pBaseTx->GetHash().GetHex());
+                    savepoint.Rollback();
                     continue;
                 }
             } catch (std::exception &e) {
                 LogPrint(BCLog::ERROR, "CreateNewBlockStableCoinRelease() : unexpected exception: %s\n", e.what());
+                savepoint.Rollback();
                 continue;
             }
 
-            spCW->Flush();
-
             auto fuel        = pBaseTx->GetFuel(height, fuelRate);
             auto fees_symbol = std::get<0>(pBaseTx->GetFees());
             auto fees        = std::get<1>(pBaseTx->GetFees());
@@ -446,11 +433,12 @@ static bool CreateNewBlockStableCoinRelease(int64_t startMiningMs, CCacheWrapper
         map<TokenSymbol, uint64_t> rewards = {{SYMB::WICC, 0}, {SYMB::WUSD, 0}};
 
         // Calculate && sort transactions from memory pool.
-        set<TxPriority> txPriorities;
+        vector<TxPriority> txPriorities;
         GetPriorityTx(height, txPriorities, fuelRate);
 
         // Push block price median transaction into queue.
-        txPriorities.emplace(TxPriority(PRICE_MEDIAN_TRANSACTION_PRIORITY, 0, std::make_shared<CBlockPriceMedianTx>(height)));
+        TxPriority priceMedianTx(PRICE_MEDIAN_TRANSACTION_PRIORITY, 0, std::make_shared<CBlockPriceMedianTx>(height));
+        txPriorities.insert(std::upper_bound(txPriorities.begin(), txPriorities.end(), priceMedianTx), priceMedianTx);
 
         LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : got %lu transaction(s) sorted by priority rules\n",
                  txPriorities.size());
@@ -465,6 +453,8 @@ static bool CreateNewBlockStableCoinRelease(int64_t startMiningMs, CCacheWrapper
             }
 
             CBaseTx *pBaseTx = itor->baseTx.get();
+            if (pCdMan->pTxCache->HaveTx(pBaseTx->GetHash()))
+                continue;
 
             uint32_t txSize = pBaseTx->GetSerializeSize(SER_NETWORK, PROTOCOL_VERSION);
             if (totalBlockSize + txSize >= nBlockMaxSize) {
@@ -473,7 +463,8 @@ static bool CreateNewBlockStableCoinRelease(int64_t startMiningMs, CCacheWrapper
                 continue;
             }
 
-            auto spCW = std::make_shared<CCacheWrapper>(&cwIn);
+            // the tx is executed on cwIn directly and rolled back if it can't be packed
+            CCacheSavepoint savepoint(cwIn);
 
             try {
                 CValidationState state;
@@ -485,23 +476,24 @@ static bool CreateNewBlockStableCoinRelease(int64_t startMiningMs, CCacheWrapper
                     CBlockPriceMedianTx *pPriceMedianTx = (CBlockPriceMedianTx *)itor->baseTx.get();
 
                     PriceMap medianPrices;
-                    if (!spCW->ppCache.CalcBlockMedianPrices(*spCW, height, medianPrices))
+                    if (!cwIn.ppCache.CalcBlockMedianPrices(cwIn, height, medianPrices))
                         return ERRORMSG("%s(), calculate block median prices error", __func__);
 
                     pPriceMedianTx->SetMedianPrices(medianPrices);
                 }
 
                 LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : begin to pack transaction: %s\n",
-                         pBaseTx->ToString(spCW->accountCache));
+                         pBaseTx->ToString(cwIn.accountCache));
 
                 uint32_t prevBlockTime = pIndexPrev->GetBlockTime();
-                CTxExecuteContext context(height, index + 1, fuelRate, blockTime, prevBlockTime, spCW.get(), &state, transaction_status_type::mining);
+                CTxExecuteContext context(height, index + 1, fuelRate, blockTime, prevBlockTime, &cwIn, &state, transaction_status_type::mining);
                 if (!pBaseTx->CheckTx(context) || !pBaseTx->ExecuteTx(context)) {
                     LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : failed to pack transaction: %s\n",
-                             pBaseTx->ToString(spCW->accountCache));
+                             pBaseTx->ToString(cwIn.accountCache));
 
                     pCdMan->pLogCache->SetExecuteFail(height, pBaseTx->GetHash(), state.GetRejectCode(),
                                                       state.GetRejectReason());
+                    savepoint.Rollback();
                     continue;
                 }
 
@@ -509,16 +501,15 @@ static bool CreateNewBlockStableCoinRelease(int64_t startMiningMs, CCacheWrapper
                 if (totalRunStep + pBaseTx->nRunStep >= MAX_BLOCK_RUN_STEP) {
                     LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : exceed max block run steps, txid: %s\n",
                             pBaseTx->GetHash().GetHex());
+                    savepoint.Rollback();
                     continue;
                 }
             } catch (std::exception &e) {
                 LogPrint(BCLog::ERROR, "CreateNewBlockStableCoinRelease() : unexpected exception: %s\n", e.what());
-
+                savepoint.Rollback();
                 continue;
             }
 
-            spCW->Flush();
-
             auto fuel        = pBaseTx->GetFuel(height, fuelRate);
             auto fees_symbol = std::get<0>(pBaseTx->GetFees());
             auto fees        = std::get<1>(pBaseTx->GetFees());
@@ -294,7 +294,7 @@ bool CAccountDBCache::Flush() {
     return true;
 }
 
-uint32_t CAccountDBCache::GetCacheSize() const {
+uint64_t CAccountDBCache::GetCacheSize() const {
     return accountCache.GetCacheSize() +
         regId2KeyIdCache.GetCacheSize() +
         nickId2KeyIdCache.GetCacheSize();
@@ -83,7 +83,7 @@ public:
     bool SetNickId(const CAccount account, const uint32_t height);
     bool GetNickIdHeight(uint64_t nickIdValue,uint32_t& regHeight) ;
 
-    uint32_t GetCacheSize() const;
+    uint64_t GetCacheSize() const;
     Object ToJsonObj(dbk::PrefixType prefix = dbk::EMPTY);
 
     void SetBaseViewPtr(CAccountDBCache *pBaseIn) {
@@ -115,7 +115,7 @@ public:
     // <prefix$NickID -> KeyID>
     CCompositeKVCache< dbk::NICKID_KEYID,         CVarIntValue<uint64_t>,      std::pair<CVarIntValue<uint32_t>,CKeyID>>   nickId2KeyIdCache;
     // <prefix$KeyID -> Account>
-    CCompositeKVCache< dbk::KEYID_ACCOUNT,        CKeyID,       CAccount>        accountCache;
+    CCompositeKVCache< dbk::KEYID_ACCOUNT,        CKeyID,       CAccount, CDBHashMap>  accountCache;
 
 };
 
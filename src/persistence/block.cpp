@@ -157,22 +157,44 @@ bool WriteBlockToDisk(CBlock &block, CDiskBlockPos &pos) {
     return true;
 }
 
-bool ReadBlockFromDisk(const CDiskBlockPos &pos, CBlock &block) {
-    block.SetNull();
+static void SkipBytes(CAutoFile &filein, uint32_t nSize) {
+    if (fseek(filein, nSize, SEEK_CUR))
+        throw ios_base::failure("SkipBytes : fseek failed");
+}
 
-    // Open history file to read
-    CAutoFile filein = CAutoFile(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (!filein)
-        return ERRORMSG("ReadBlockFromDisk : OpenBlockFile failed");
+static void SkipBytes(CMemReadStream &stream, uint32_t nSize) { stream.ignore(nSize); }
 
-    // Read block
+// run read(stream) on the block record at pos, from the mapping of the block file if it's mapped
+template <typename ReadFunc>
+static bool ReadBlockRecord(const CDiskBlockPos &pos, const ReadFunc &read) {
     try {
-        filein >> block;
+        std::shared_ptr<const CDiskFileMapping> spMapping;
+        const char *pRecord;
+        uint32_t nRecordSize;
+        if (diskFileMapper.GetRecord(pos, "blk", 0, spMapping, pRecord, nRecordSize)) {
+            CMemReadStream stream(pRecord, pRecord + nRecordSize, SER_DISK, CLIENT_VERSION);
+            return read(stream);
+        }
+
+        // Open history file to read
+        CAutoFile filein = CAutoFile(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+        if (!filein)
+            return ERRORMSG("ReadBlockRecord : OpenBlockFile failed, %s", pos.ToString());
+
+        return read(filein);
     } catch (std::exception &e) {
         return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
     }
+}
 
-    return true;
+bool ReadBlockFromDisk(const CDiskBlockPos &pos, CBlock &block) {
+    block.SetNull();
+
+    // Read block
+    return ReadBlockRecord(pos, [&](auto &stream) {
+        stream >> block;
+        return true;
+    });
 }
 
 bool ReadBlockFromDisk(const CBlockIndex *pIndex, CBlock &block) {
@@ -185,18 +207,140 @@ bool ReadBlockFromDisk(const CBlockIndex *pIndex, CBlock &block) {
     return true;
 }
 
+CBlockSummary::CBlockSummary(const CBlock &block) : height(block.GetHeight()) {
+    txids.reserve(block.vptx.size());
+    for (const auto &ptx : block.vptx)
+        txids.push_back(ptx->GetHash());
+
+    if (!block.vptx.empty())
+        pRewardTx = block.vptx[0]->GetNewInstance();
+
+    // the price feed txs are placed right after the reward tx, see CPricePointMemCache::AddPriceByBlock()
+    if (block.vptx.size() >= 3) {
+        for (uint32_t i = 1; i < block.vptx.size() && block.vptx[i]->IsPriceFeedTx(); ++i)
+            priceFeedTxs.push_back(block.vptx[i]->GetNewInstance());
+    }
+
+    memorySize = sizeof(CBlockSummary) + txids.capacity() * sizeof(uint256);
+    if (pRewardTx)
+        memorySize += pRewardTx->GetSerializeSize(SER_DISK, CLIENT_VERSION);
+    for (const auto &ptx : priceFeedTxs)
+        memorySize += ptx->GetSerializeSize(SER_DISK, CLIENT_VERSION);
+}
+
+size_t CBlockIndexArena::Size() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return chunks.empty() ? 0 : (chunks.size() - 1) * CHUNK_SIZE + nChunkUsed;
+}
+
+void CBlockIndexArena::Clear() {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (size_t i = 0; i < chunks.size(); i++) {
+        size_t count = (i + 1 == chunks.size()) ? nChunkUsed : CHUNK_SIZE;
+        for (size_t j = 0; j < count; j++)
+            reinterpret_cast<CBlockIndex *>(&chunks[i][j])->~CBlockIndex();
+    }
+    chunks.clear();
+    nChunkUsed = 0;
+}
+
+bool CBlockSummaryCache::Get(const CBlockIndex *pIndex, std::shared_ptr<const CBlockSummary> &spSummary) {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        auto it = mapEntries.find(pIndex);
+        if (it != mapEntries.end()) {
+            lruList.splice(lruList.begin(), lruList, it->second);
+            spSummary = it->second->second;
+            ++nHits;
+            return true;
+        }
+        ++nMisses;
+    }
+
+    CBlock block;
+    if (!ReadBlockFromDisk(pIndex, block))
+        return false;
+
+    auto spNewSummary = std::make_shared<const CBlockSummary>(block);
+    AddToCache(pIndex, spNewSummary);
+    spSummary = spNewSummary;
+    return true;
+}
+
+void CBlockSummaryCache::Add(const CBlockIndex *pIndex, const CBlock &block) {
+    AddToCache(pIndex, std::make_shared<const CBlockSummary>(block));
+}
+
+void CBlockSummaryCache::AddToCache(const CBlockIndex *pIndex, const std::shared_ptr<const CBlockSummary> &spSummary) {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    auto it = mapEntries.find(pIndex);
+    if (it != mapEntries.end()) {
+        nBytes -= it->second->second->GetMemorySize();
+        lruList.erase(it->second);
+        mapEntries.erase(it);
+    }
+
+    lruList.emplace_front(pIndex, spSummary);
+    mapEntries[pIndex] = lruList.begin();
+    nBytes += spSummary->GetMemorySize();
+
+    while (nBytes > nMaxBytes && !lruList.empty()) {
+        const Entry &last = lruList.back();
+        nBytes -= last.second->GetMemorySize();
+        mapEntries.erase(last.first);
+        lruList.pop_back();
+    }
+}
+
+void CBlockSummaryCache::SetMaxSize(uint64_t nMaxBytesIn) {
+    std::unique_lock<std::mutex> lock(mtx);
+    nMaxBytes = nMaxBytesIn;
+}
+
+void CBlockSummaryCache::GetStats(CBlockSummaryCacheStats &stats) {
+    std::unique_lock<std::mutex> lock(mtx);
+    stats.entries   = mapEntries.size();
+    stats.bytes     = nBytes;
+    stats.max_bytes = nMaxBytes;
+    stats.hits      = nHits;
+    stats.misses    = nMisses;
+}
+
+bool ReadTxFromDisk(const CDiskTxPos &pos, std::shared_ptr<CBaseTx> &pTx, CBlockHeader *pHeader) {
+    return ReadBlockRecord(pos, [&](auto &stream) {
+        CBlockHeader header;
+        stream >> header;
+        SkipBytes(stream, pos.nTxOffset);
+        stream >> pTx;
+        if (pHeader)
+            *pHeader = header;
+        return true;
+    });
+}
+
 bool ReadBaseTxFromDisk(const CTxCord txCord, std::shared_ptr<CBaseTx> &pTx) {
-    auto pBlock = std::make_shared<CBlock>();
     const CBlockIndex* pBlockIndex = chainActive[ txCord.GetHeight() ];
     if (pBlockIndex == nullptr) {
         return ERRORMSG("ReadBaseTxFromDisk error, the height(%d) is exceed current best block height", txCord.GetHeight());
     }
-    if (!ReadBlockFromDisk(pBlockIndex, *pBlock)) {
-        return ERRORMSG("ReadBaseTxFromDisk error, read the block at height(%d) failed!", txCord.GetHeight());
-    }
-    if (txCord.GetIndex() >= pBlock->vptx.size()) {
+    if (txCord.GetIndex() >= pBlockIndex->nTx) {
         return ERRORMSG("ReadBaseTxFromDisk error, the tx(%s) index exceed the tx count of block", txCord.ToString());
     }
-    pTx = pBlock->vptx.at(txCord.GetIndex())->GetNewInstance();
-    return true;
+
+    // the txs after the one at the index are not read, nor the ones before are kept
+    return ReadBlockRecord(pBlockIndex->GetBlockPos(), [&](auto &stream) {
+        CBlockHeader header;
+        stream >> header;
+        if (header.GetHash() != pBlockIndex->GetBlockHash())
+            return ERRORMSG("ReadBaseTxFromDisk error, the block at height(%d) doesn't match", txCord.GetHeight());
+
+        uint64_t txCount = ReadCompactSize(stream);
+        if (txCord.GetIndex() >= txCount)
+            return ERRORMSG("ReadBaseTxFromDisk error, the tx(%s) index exceed the tx count of block", txCord.ToString());
+
+        for (uint32_t i = 0; i <= txCord.GetIndex(); i++)
+            stream >> pTx;
+        return true;
+    });
 }
@@ -21,10 +21,16 @@
 
 
 #include <stdint.h>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 class CBlockDBCache;
 class CDiskBlockPos;
+struct CDiskTxPos;
 class CNode;
 
 enum BlockStatus {
@@ -377,6 +383,41 @@ public:
     const CBlockIndex *GetAncestor(int32_t heightIn) const;
 };
 
+typedef std::unordered_map<uint256, CBlockIndex *, CUint256Hasher> BlockMap;
+
+/**
+ * Storage of the block indexes, allocated in chunks rather than one by one on the heap. The indexes
+ * live as long as the arena, they are destroyed all at once by Clear().
+ */
+class CBlockIndexArena {
+private:
+    typedef typename std::aligned_storage<sizeof(CBlockIndex), alignof(CBlockIndex)>::type Slot;
+    static const size_t CHUNK_SIZE = 4096;
+
+    std::mutex mtx;
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    size_t nChunkUsed;  //!< constructed indexes of the last chunk
+
+public:
+    CBlockIndexArena() : nChunkUsed(0) {}
+    ~CBlockIndexArena() { Clear(); }
+
+    template <typename... Args>
+    CBlockIndex *New(Args &&... args) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (chunks.empty() || nChunkUsed == CHUNK_SIZE) {
+            chunks.emplace_back(new Slot[CHUNK_SIZE]);
+            nChunkUsed = 0;
+        }
+        CBlockIndex *pIndex = new (&chunks.back()[nChunkUsed]) CBlockIndex(std::forward<Args>(args)...);
+        nChunkUsed++;
+        return pIndex;
+    }
+
+    size_t Size();
+    void Clear();
+};
+
 
 /** Used to marshal pointers into hashes for db storage. */
 class CDiskBlockIndex : public CBlockIndex {
@@ -465,12 +506,75 @@ struct CBlockLocator {
     bool IsNull() { return vHave.empty(); }
 };
 
+/** Compact summary of a connected block: what ConnectBlock(), DisconnectBlock() and ProcessForkedChain()
+ *  need of the old blocks they look back at (txids, reward tx, price feed txs), without a full block */
+class CBlockSummary {
+public:
+    int32_t height;
+    vector<uint256> txids;
+    std::shared_ptr<CBaseTx> pRewardTx;
+    vector<std::shared_ptr<CBaseTx>> priceFeedTxs;
+
+    CBlockSummary(): height(0), memorySize(sizeof(CBlockSummary)) {}
+    explicit CBlockSummary(const CBlock &block);
+
+    uint64_t GetMemorySize() const { return memorySize; }
+
+private:
+    uint64_t memorySize;
+};
+
+struct CBlockSummaryCacheStats {
+    uint64_t entries   = 0;
+    uint64_t bytes     = 0;
+    uint64_t max_bytes = 0;
+    uint64_t hits      = 0;  //!< block reads saved
+    uint64_t misses    = 0;  //!< blocks read from disk
+};
+
+/** -blocksummarycache default, in megabytes */
+static const int64_t DEFAULT_BLOCK_SUMMARY_CACHE_SIZE = 32;
+
+/**
+ * Bounded LRU of block summaries keyed by block index. Recently connected blocks are added
+ * when they are connected, so the look-back reads of ConnectBlock() are served from memory.
+ */
+class CBlockSummaryCache {
+private:
+    typedef std::pair<const CBlockIndex *, std::shared_ptr<const CBlockSummary>> Entry;
+
+    std::mutex mtx;
+    std::list<Entry> lruList;  //!< most recently used first
+    std::unordered_map<const CBlockIndex *, std::list<Entry>::iterator> mapEntries;
+    uint64_t nBytes;
+    uint64_t nMaxBytes;
+    uint64_t nHits;
+    uint64_t nMisses;
+
+public:
+    CBlockSummaryCache() : nBytes(0), nMaxBytes(DEFAULT_BLOCK_SUMMARY_CACHE_SIZE << 20), nHits(0), nMisses(0) {}
+
+    /** Get the summary of the block, reading the block from disk on a miss */
+    bool Get(const CBlockIndex *pIndex, std::shared_ptr<const CBlockSummary> &spSummary);
+    void Add(const CBlockIndex *pIndex, const CBlock &block);
+
+    void SetMaxSize(uint64_t nMaxBytesIn);
+    void GetStats(CBlockSummaryCacheStats &stats);
+
+private:
+    void AddToCache(const CBlockIndex *pIndex, const std::shared_ptr<const CBlockSummary> &spSummary);
+};
+
 /** Functions for disk access for blocks */
 bool WriteBlockToDisk(CBlock &block, CDiskBlockPos &pos);
 bool ReadBlockFromDisk(const CDiskBlockPos &pos, CBlock &block);
 bool ReadBlockFromDisk(const CBlockIndex *pIndex, CBlock &block);
 
 
+/** Read the tx at the position saved by the tx index, and the header of its block if pHeader is not null.
+ *  Only the header and the tx are deserialized, not the rest of the block */
+bool ReadTxFromDisk(const CDiskTxPos &pos, std::shared_ptr<CBaseTx> &pTx, CBlockHeader *pHeader = nullptr);
+
 bool ReadBaseTxFromDisk(const CTxCord txCord, std::shared_ptr<CBaseTx> &pTx);
 
 template<typename TxType>
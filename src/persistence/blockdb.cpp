@@ -10,6 +10,8 @@
 #include "main.h"
 
 #include <stdint.h>
+#include <atomic>
+#include <thread>
 
 using namespace std;
 
@@ -22,55 +24,121 @@ bool CBlockIndexDB::EraseBlockIndex(const uint256 &blockHash) {
     return Erase(dbk::GenDbKey(dbk::BLOCK_INDEX, blockHash));
 }
 
-bool CBlockIndexDB::LoadBlockIndexes() {
-    leveldb::Iterator *pCursor = NewIterator();
+// run func(begin, end) over the ranges of [0, count) on nThreads threads, the calling thread included
+template <typename Func>
+static void ParallelFor(uint32_t nThreads, size_t count, const Func &func) {
+    static const size_t RANGE_SIZE = 256;
+    std::atomic<size_t> nNext(0);
+    auto worker = [&]() {
+        size_t begin;
+        while ((begin = nNext.fetch_add(RANGE_SIZE)) < count)
+            func(begin, std::min(begin + RANGE_SIZE, count));
+    };
+
+    std::vector<std::thread> workers;
+    size_t nWorkers = std::min<size_t>(nThreads, (count + RANGE_SIZE - 1) / RANGE_SIZE);
+    for (size_t i = 1; i < nWorkers; i++)
+        workers.emplace_back(worker);
+
+    worker();
+    for (auto &thread : workers)
+        thread.join();
+}
+
+bool CBlockIndexDB::LoadBlockIndexes(BlockMap &blockMap, CBlockIndexArena &arena,
+                                     vector<CBlockIndex *> &indexesByHeight, uint32_t nThreads) {
+    std::unique_ptr<leveldb::Iterator> pCursor(NewIterator());
     const std::string &prefix = dbk::GetKeyPrefix(dbk::BLOCK_INDEX);
 
     pCursor->Seek(prefix);
 
+    vector<string> values;
+    vector<CDiskBlockIndex> diskIndexes;
+    vector<uint256> blockHashes;
+    values.reserve(BLOCK_INDEX_LOAD_BATCH);
+
     // Load mapBlockIndex
-    while (pCursor->Valid()) {
+    bool fDone = false;
+    while (!fDone) {
         boost::this_thread::interruption_point();
-        try {
-            leveldb::Slice slKey = pCursor->key();
-            if (slKey.starts_with(prefix)) {
-                leveldb::Slice slValue = pCursor->value();
-                CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
-                CDiskBlockIndex diskIndex;
-                ssValue >> diskIndex;
-
-                // Construct block index object
-                CBlockIndex *pIndexNew    = InsertBlockIndex(diskIndex.GetBlockHash());
-                pIndexNew->pprev          = InsertBlockIndex(diskIndex.hashPrev);
-                pIndexNew->height         = diskIndex.height;
-                pIndexNew->nFile          = diskIndex.nFile;
-                pIndexNew->nDataPos       = diskIndex.nDataPos;
-                pIndexNew->nUndoPos       = diskIndex.nUndoPos;
-                pIndexNew->nVersion       = diskIndex.nVersion;
-                pIndexNew->merkleRootHash = diskIndex.merkleRootHash;
-                pIndexNew->hashPos        = diskIndex.hashPos;
-                pIndexNew->nTime          = diskIndex.nTime;
-                pIndexNew->nBits          = diskIndex.nBits;
-                pIndexNew->nNonce         = diskIndex.nNonce;
-                pIndexNew->nStatus        = diskIndex.nStatus;
-                pIndexNew->nTx            = diskIndex.nTx;
-                pIndexNew->nFuel          = diskIndex.nFuel;
-                pIndexNew->nFuelRate      = diskIndex.nFuelRate;
-                pIndexNew->vSignature     = diskIndex.vSignature;
-                pIndexNew->miner          = diskIndex.miner ;
-
-                if (!pIndexNew->CheckIndex())
-                    return ERRORMSG("LoadBlockIndex() : CheckIndex failed: %s", pIndexNew->ToString());
-
-                pCursor->Next();
-            } else {
-                break;  // if shutdown requested or finished loading block index
+
+        values.clear();
+        while (values.size() < BLOCK_INDEX_LOAD_BATCH) {
+            if (!pCursor->Valid() || !pCursor->key().starts_with(prefix)) {
+                fDone = true;
+                break;
             }
-        } catch (std::exception &e) {
-            return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+            leveldb::Slice slValue = pCursor->value();
+            values.emplace_back(slValue.data(), slValue.size());
+            pCursor->Next();
         }
+        if (!pCursor->status().ok())
+            return ERRORMSG("%s : Database read error - %s", __func__, pCursor->status().ToString());
+
+        // deserialize and hash the records of the batch in parallel, that's most of the loading time
+        diskIndexes.assign(values.size(), CDiskBlockIndex());
+        blockHashes.assign(values.size(), uint256());
+        std::atomic<bool> fError(false);
+        ParallelFor(std::max<uint32_t>(nThreads, 1), values.size(), [&](size_t begin, size_t end) {
+            try {
+                for (size_t i = begin; i < end; i++) {
+                    CDataStream ssValue(values[i].data(), values[i].data() + values[i].size(), SER_DISK,
+                                        CLIENT_VERSION);
+                    ssValue >> diskIndexes[i];
+                    blockHashes[i] = diskIndexes[i].GetBlockHash();
+                }
+            } catch (std::exception &e) {
+                LogPrint(BCLog::ERROR, "%s : Deserialize or I/O error - %s\n", __func__, e.what());
+                fError = true;
+            }
+        });
+        if (fError)
+            return ERRORMSG("%s : Deserialize block indexes failed", __func__);
+
+        for (size_t i = 0; i < diskIndexes.size(); i++) {
+            CDiskBlockIndex &diskIndex = diskIndexes[i];
+
+            // Construct block index object
+            CBlockIndex *pIndexNew    = InsertBlockIndex(blockMap, arena, blockHashes[i]);
+            pIndexNew->pprev          = InsertBlockIndex(blockMap, arena, diskIndex.hashPrev);
+            pIndexNew->height         = diskIndex.height;
+            pIndexNew->nFile          = diskIndex.nFile;
+            pIndexNew->nDataPos       = diskIndex.nDataPos;
+            pIndexNew->nUndoPos       = diskIndex.nUndoPos;
+            pIndexNew->nVersion       = diskIndex.nVersion;
+            pIndexNew->merkleRootHash = diskIndex.merkleRootHash;
+            pIndexNew->hashPos        = diskIndex.hashPos;
+            pIndexNew->nTime          = diskIndex.nTime;
+            pIndexNew->nBits          = diskIndex.nBits;
+            pIndexNew->nNonce         = diskIndex.nNonce;
+            pIndexNew->nStatus        = diskIndex.nStatus;
+            pIndexNew->nTx            = diskIndex.nTx;
+            pIndexNew->nFuel          = diskIndex.nFuel;
+            pIndexNew->nFuelRate      = diskIndex.nFuelRate;
+            pIndexNew->vSignature     = std::move(diskIndex.vSignature);
+            pIndexNew->miner          = diskIndex.miner ;
+
+            if (!pIndexNew->CheckIndex())
+                return ERRORMSG("LoadBlockIndex() : CheckIndex failed: %s", pIndexNew->ToString());
+        }
+    }
+
+    // order the indexes by height with a counting sort, the heights are dense
+    int32_t maxHeight = -1;
+    for (const auto &item : blockMap) {
+        if (item.second->height < 0)
+            return ERRORMSG("%s : invalid height of block index: %s", __func__, item.second->ToString());
+        maxHeight = std::max(maxHeight, item.second->height);
     }
-    delete pCursor;
+    vector<size_t> heightOffsets(maxHeight + 2, 0);
+    for (const auto &item : blockMap)
+        heightOffsets[item.second->height + 1]++;
+    for (size_t i = 1; i < heightOffsets.size(); i++)
+        heightOffsets[i] += heightOffsets[i - 1];
+
+    indexesByHeight.resize(blockMap.size());
+    for (const auto &item : blockMap)
+        indexesByHeight[heightOffsets[item.second->height]++] = item.second;
 
     return true;
 }
@@ -82,28 +150,26 @@ bool CBlockIndexDB::ReadBlockFileInfo(int32_t nFile, CBlockFileInfo &info) {
     return Read(dbk::GenDbKey(dbk::BLOCKFILE_NUM_INFO, nFile), info);
 }
 
-CBlockIndex *InsertBlockIndex(uint256 hash) {
+CBlockIndex *InsertBlockIndex(BlockMap &blockMap, CBlockIndexArena &arena, const uint256 &hash) {
     if (hash.IsNull())
         return nullptr;
 
     // Return existing
-    map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(hash);
-    if (mi != mapBlockIndex.end())
+    BlockMap::iterator mi = blockMap.find(hash);
+    if (mi != blockMap.end())
         return (*mi).second;
 
     // Create new
-    CBlockIndex *pIndexNew = new CBlockIndex();
-    if (!pIndexNew)
-        throw runtime_error("LoadBlockIndex() : new CBlockIndex failed");
-    mi                    = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
-    pIndexNew->pBlockHash = &((*mi).first);
+    CBlockIndex *pIndexNew = arena.New();
+    mi                     = blockMap.insert(make_pair(hash, pIndexNew)).first;
+    pIndexNew->pBlockHash  = &((*mi).first);
 
     return pIndexNew;
 }
 
 
 /************************* CBlockDBCache ****************************/
-uint32_t CBlockDBCache::GetCacheSize() const {
+uint64_t CBlockDBCache::GetCacheSize() const {
     return
         txDiskPosCache.GetCacheSize() +
         flagCache.GetCacheSize() +
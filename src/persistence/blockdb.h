@@ -16,6 +16,9 @@
 
 #include <map>
 
+/** Records of the block indexes read from the db and deserialized at a time, see LoadBlockIndexes() */
+static const size_t BLOCK_INDEX_LOAD_BATCH = 16384;
+
 /** Access to the block database (blocks/index/) */
 class CBlockIndexDB : public CLevelDBWrapper {
 private:
@@ -31,7 +34,12 @@ public:
 public:
     bool WriteBlockIndex(const CDiskBlockIndex &blockindex);
     bool EraseBlockIndex(const uint256 &blockHash);
-    bool LoadBlockIndexes();
+    /**
+     * Load all of the block indexes into blockMap, allocated from arena. The records are read in batches and
+     * deserialized on nThreads threads. indexesByHeight gets the loaded indexes in the order of height.
+     */
+    bool LoadBlockIndexes(BlockMap &blockMap, CBlockIndexArena &arena, vector<CBlockIndex *> &indexesByHeight,
+                          uint32_t nThreads);
 
     bool ReadBlockFileInfo(int32_t nFile, CBlockFileInfo &fileinfo);
     bool WriteBlockFileInfo(int32_t nFile, const CBlockFileInfo &fileinfo);
@@ -65,7 +73,7 @@ public:
 
 public:
     bool Flush();
-    uint32_t GetCacheSize() const;
+    uint64_t GetCacheSize() const;
 
     bool GetTxHashByAddress(const CKeyID &keyId, uint32_t height, map<string, string > &mapTxHash);
     bool SetTxHashByAddress(const CKeyID &keyId, uint32_t height, uint32_t index, const uint256 &txid);
@@ -128,7 +136,7 @@ public:
 /*  CCompositeKVCache      prefixType               key                     value                 variable               */
 /*  ----------------   -------------------------   -----------------------  ------------------   ------------------------ */
     // txId -> DiskTxPos
-    CCompositeKVCache< dbk::TXID_DISKINDEX,         uint256,                  CDiskTxPos >          txDiskPosCache;
+    CCompositeKVCache< dbk::TXID_DISKINDEX,         uint256,                  CDiskTxPos, CDBHashMap >  txDiskPosCache;
     // flag$name -> bool
     CCompositeKVCache< dbk::FLAG,                   string,                   bool>                 flagCache;
 
@@ -143,6 +151,6 @@ public:
 };
 
 /** Create a new block index entry for a given block hash */
-CBlockIndex * InsertBlockIndex(uint256 hash);
+CBlockIndex * InsertBlockIndex(BlockMap &blockMap, CBlockIndexArena &arena, const uint256 &hash);
 
 #endif  // PERSIST_BLOCKDB_H
\ No newline at end of file
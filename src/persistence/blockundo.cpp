@@ -57,18 +57,33 @@ bool CBlockUndo::WriteToDisk(CDiskBlockPos &pos, const uint256 &blockHash) {
 }
 
 bool CBlockUndo::ReadFromDisk(const CDiskBlockPos &pos, const uint256 &blockHash) {
-    // Open history file to read
-    CAutoFile filein = CAutoFile(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (!filein)
-        return ERRORMSG("CBlockUndo::ReadFromDisk : OpenBlockFile failed");
-
-    // Read block
     uint256 hashChecksum;
-    try {
-        filein >> *this;
-        filein >> hashChecksum;
-    } catch (std::exception &e) {
-        return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+
+    // Read from the mapping of the undo file if it's mapped, the checksum follows the undo data
+    std::shared_ptr<const CDiskFileMapping> spMapping;
+    const char *pRecord;
+    uint32_t nRecordSize;
+    if (diskFileMapper.GetRecord(pos, "rev", sizeof(hashChecksum), spMapping, pRecord, nRecordSize)) {
+        CMemReadStream stream(pRecord, pRecord + nRecordSize + sizeof(hashChecksum), SER_DISK, CLIENT_VERSION);
+        try {
+            stream >> *this;
+            stream >> hashChecksum;
+        } catch (std::exception &e) {
+            return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    } else {
+        // Open history file to read
+        CAutoFile filein = CAutoFile(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
+        if (!filein)
+            return ERRORMSG("CBlockUndo::ReadFromDisk : OpenBlockFile failed");
+
+        // Read block
+        try {
+            filein >> *this;
+            filein >> hashChecksum;
+        } catch (std::exception &e) {
+            return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
     }
 
     // Verify checksum
@@ -7,6 +7,12 @@
 #include "main.h"
 #include "logging.h"
 
+std::atomic<int64_t> CDBCacheSnapshotStats::layers(0);
+std::atomic<int64_t> CDBCacheSnapshotStats::entries(0);
+std::atomic<int64_t> CDBCacheSnapshotStats::bytes(0);
+std::atomic<int64_t> CDBSharedValueStats::allocs(0);
+std::atomic<int64_t> CDBSharedValueStats::shares(0);
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CCacheWrapper
 
@@ -72,6 +78,36 @@ void CCacheWrapper::CopyFrom(CCacheDBManager* pCdMan){
     sysGovernCache = *pCdMan->pSysGovernCache ;
 }
 
+void CCacheWrapper::CopyDbCachesFrom(CCacheDBManager* pCdMan) {
+    sysParamCache  = *pCdMan->pSysParamCache;
+    blockCache     = *pCdMan->pBlockCache;
+    accountCache   = *pCdMan->pAccountCache;
+    assetCache     = *pCdMan->pAssetCache;
+    contractCache  = *pCdMan->pContractCache;
+    delegateCache  = *pCdMan->pDelegateCache;
+    cdpCache       = *pCdMan->pCdpCache;
+    closedCdpCache = *pCdMan->pClosedCdpCache;
+    dexCache       = *pCdMan->pDexCache;
+    txReceiptCache = *pCdMan->pReceiptCache;
+    txUtxoCache    = *pCdMan->pUtxoCache;
+    sysGovernCache = *pCdMan->pSysGovernCache;
+}
+
+void CCacheWrapper::CopyDbCachesFrom(const CCacheWrapper &other) {
+    sysParamCache  = other.sysParamCache;
+    blockCache     = other.blockCache;
+    accountCache   = other.accountCache;
+    assetCache     = other.assetCache;
+    contractCache  = other.contractCache;
+    delegateCache  = other.delegateCache;
+    cdpCache       = other.cdpCache;
+    closedCdpCache = other.closedCdpCache;
+    dexCache       = other.dexCache;
+    txReceiptCache = other.txReceiptCache;
+    txUtxoCache    = other.txUtxoCache;
+    sysGovernCache = other.sysGovernCache;
+}
+
 CCacheWrapper& CCacheWrapper::operator=(CCacheWrapper& other) {
     if (this == &other)
         return *this;
@@ -112,6 +148,21 @@ void CCacheWrapper::Flush() {
     sysGovernCache.Flush();
 }
 
+uint64_t CCacheWrapper::GetCacheSize() const {
+    return sysParamCache.GetCacheSize() +
+        blockCache.GetCacheSize() +
+        accountCache.GetCacheSize() +
+        assetCache.GetCacheSize() +
+        contractCache.GetCacheSize() +
+        delegateCache.GetCacheSize() +
+        cdpCache.GetCacheSize() +
+        closedCdpCache.GetCacheSize() +
+        dexCache.GetCacheSize() +
+        txReceiptCache.GetCacheSize() +
+        txUtxoCache.GetCacheSize() +
+        sysGovernCache.GetCacheSize();
+}
+
 void CCacheWrapper::SetDbOpLogMap(CDBOpLogMap *pDbOpLogMap) {
     sysParamCache.SetDbOpLogMap(pDbOpLogMap);
     blockCache.SetDbOpLogMap(pDbOpLogMap);
@@ -144,55 +195,160 @@ UndoDataFuncMap CCacheWrapper::GetUndoDataFuncMap() {
     return undoDataFuncMap;
 }
 
+void CCacheWrapper::ApplyOpLogs(CDBOpLogMap &dbOpLogMap) {
+    // the undo functions only write the values back, they don't log
+    const UndoDataFuncMap &undoDataFuncMap = GetUndoDataFuncMap();
+    for (const auto &opLogPair : dbOpLogMap.GetMap()) {
+        dbk::PrefixType prefixType = dbk::ParseKeyPrefixType(opLogPair.first);
+        auto funcMapIt             = undoDataFuncMap.find(prefixType);
+        assert(funcMapIt != undoDataFuncMap.end());
+        funcMapIt->second(opLogPair.second);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CCacheSavepoint
+
+CCacheSavepoint::CCacheSavepoint(CCacheWrapper &cwIn) : cw(cwIn) {
+    cw.SetDbOpLogMap(&dbOpLogMap);
+}
+
+CCacheSavepoint::~CCacheSavepoint() {
+    cw.SetDbOpLogMap(nullptr);
+}
+
+void CCacheSavepoint::Rollback() {
+    if (dbOpLogMap.GetMap().empty())
+        return;
+
+    cw.ApplyOpLogs(dbOpLogMap);
+    dbOpLogMap.Clear();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CCacheDBManager
 
+// Both layouts of the state dbs can't be used at the same time, the dbs of the other layout are
+// stale and must be rebuilt with -reindex.
+static void CheckStateDbLayout(const boost::filesystem::path &dbDir, bool fSingleStateDb, bool fReIndex) {
+    vector<boost::filesystem::path> singleDbPaths = { dbDir / STATE_DB_NAME };
+    vector<boost::filesystem::path> multiDbPaths;
+    for (int32_t i = 0; i < DBNameType::DB_NAME_COUNT; i++)
+        multiDbPaths.push_back(dbDir / ::GetDbName((DBNameType)i));
+
+    const auto &usedPaths  = fSingleStateDb ? singleDbPaths : multiDbPaths;
+    const auto &otherPaths = fSingleStateDb ? multiDbPaths : singleDbPaths;
+    bool fOtherExists = false;
+    for (const auto &path : otherPaths) {
+        if (boost::filesystem::exists(path)) {
+            fOtherExists = true;
+            if (fReIndex) {
+                LogPrint(BCLog::INFO, "Removing the state db of the other layout %s\n", path.string());
+                boost::filesystem::remove_all(path);
+            }
+        }
+    }
+
+    if (!fReIndex && fOtherExists && !boost::filesystem::exists(usedPaths[0]))
+        throw runtime_error("the layout of the state dbs is changed by -singlestatedb, need to rebuild with -reindex");
+}
+
+CDBAccess* CCacheDBManager::NewDbAccess(const boost::filesystem::path &dbDir, DBNameType dbNameType, bool fReIndex) {
+    if (spStateDb)
+        return new CDBAccess(dbNameType, spStateDb);
+
+    return new CDBAccess(dbDir, dbNameType, false, fReIndex);
+}
+
+vector<CDBAccess*> CCacheDBManager::GetDbAccesses() const {
+    return { pSysParamDb, pAccountDb, pAssetDb, pContractDb, pDelegateDb, pCdpDb, pClosedCdpDb,
+             pDexDb, pBlockDb, pLogDb, pReceiptDb, pSysGovernDb, pUtxoDb };
+}
+
+void CCacheDBManager::TakeDbSnapshots(CLevelDBSnapshots &snapshots) const {
+    for (CDBAccess *pDbAccess : GetDbAccesses())
+        snapshots.Take(pDbAccess->GetDbPtr());
+}
+
+void CCacheDBManager::InitKeyFilters() {
+    int64_t nMaxNegativeKeys = SysCfg().GetArg("-dbnegativecache", DEFAULT_DB_NEGATIVE_CACHE_SIZE);
+    nMaxNegativeKeys = std::max<int64_t>(0, std::min<int64_t>(nMaxNegativeKeys, std::numeric_limits<uint32_t>::max()));
+    for (CDBAccess *pDbAccess : GetDbAccesses())
+        pDbAccess->SetMaxNegativeKeys(nMaxNegativeKeys);
+
+    for (const auto &prefix : SysCfg().GetMultiArgs("-dbbloomfilter")) {
+        dbk::PrefixType prefixType = dbk::ParseKeyPrefixType(prefix);
+        if (prefixType == dbk::EMPTY) {
+            LogPrint(BCLog::ERROR, "unknown key prefix of -dbbloomfilter: %s\n", prefix);
+            continue;
+        }
+
+        DBNameType dbNameType = dbk::GetDbNameEnumByPrefix(prefixType);
+        for (CDBAccess *pDbAccess : GetDbAccesses()) {
+            if (pDbAccess->GetDbNameType() == dbNameType)
+                pDbAccess->EnableBloomFilter(prefixType);
+        }
+    }
+}
+
 CCacheDBManager::CCacheDBManager(bool fReIndex, bool fMemory) {
     const boost::filesystem::path& dbDir = GetDataDir() / "blocks";
-    pSysParamDb     = new CDBAccess(dbDir, DBNameType::SYSPARAM, false, fReIndex);
+    bool fSingleStateDb = SysCfg().GetBoolArg("-singlestatedb", DEFAULT_SINGLE_STATE_DB);
+    CheckStateDbLayout(dbDir, fSingleStateDb, fReIndex);
+    if (fSingleStateDb) {
+        size_t nCacheSize = 0;
+        for (int32_t i = 0; i < DBNameType::DB_NAME_COUNT; i++)
+            nCacheSize += DBCacheSize[i];
+
+        spStateDb = std::make_shared<CLevelDBWrapper>(dbDir / STATE_DB_NAME, nCacheSize, false, fReIndex);
+    }
+
+    pSysParamDb     = NewDbAccess(dbDir, DBNameType::SYSPARAM, fReIndex);
     pSysParamCache  = new CSysParamDBCache(pSysParamDb);
 
-    pAccountDb      = new CDBAccess(dbDir, DBNameType::ACCOUNT, false, fReIndex);
+    pAccountDb      = NewDbAccess(dbDir, DBNameType::ACCOUNT, fReIndex);
     pAccountCache   = new CAccountDBCache(pAccountDb);
 
-    pAssetDb        = new CDBAccess(dbDir, DBNameType::ASSET, false, fReIndex);
+    pAssetDb        = NewDbAccess(dbDir, DBNameType::ASSET, fReIndex);
     pAssetCache     = new CAssetDBCache(pAssetDb);
 
-    pContractDb     = new CDBAccess(dbDir, DBNameType::CONTRACT, false, fReIndex);
+    pContractDb     = NewDbAccess(dbDir, DBNameType::CONTRACT, fReIndex);
     pContractCache  = new CContractDBCache(pContractDb);
 
-    pDelegateDb     = new CDBAccess(dbDir, DBNameType::DELEGATE, false, fReIndex);
+    pDelegateDb     = NewDbAccess(dbDir, DBNameType::DELEGATE, fReIndex);
     pDelegateCache  = new CDelegateDBCache(pDelegateDb);
 
-    pCdpDb          = new CDBAccess(dbDir, DBNameType::CDP, false, fReIndex);
+    pCdpDb          = NewDbAccess(dbDir, DBNameType::CDP, fReIndex);
     pCdpCache       = new CCdpDBCache(pCdpDb);
 
-    pClosedCdpDb    = new CDBAccess(dbDir, DBNameType::CLOSEDCDP, false, fReIndex);
+    pClosedCdpDb    = NewDbAccess(dbDir, DBNameType::CLOSEDCDP, fReIndex);
     pClosedCdpCache = new CClosedCdpDBCache(pClosedCdpDb);
 
-    pDexDb          = new CDBAccess(dbDir, DBNameType::DEX, false, fReIndex);
+    pDexDb          = NewDbAccess(dbDir, DBNameType::DEX, fReIndex);
     pDexCache       = new CDexDBCache(pDexDb);
 
     pBlockIndexDb   = new CBlockIndexDB(false, fReIndex);
 
-    pBlockDb        = new CDBAccess(dbDir, DBNameType::BLOCK, false, fReIndex);
+    pBlockDb        = NewDbAccess(dbDir, DBNameType::BLOCK, fReIndex);
     pBlockCache     = new CBlockDBCache(pBlockDb);
 
-    pLogDb          = new CDBAccess(dbDir, DBNameType::LOG, false, fReIndex);
+    pLogDb          = NewDbAccess(dbDir, DBNameType::LOG, fReIndex);
     pLogCache       = new CLogDBCache(pLogDb);
 
-    pReceiptDb      = new CDBAccess(dbDir, DBNameType::RECEIPT, false, fReIndex);
+    pReceiptDb      = NewDbAccess(dbDir, DBNameType::RECEIPT, fReIndex);
     pReceiptCache   = new CTxReceiptDBCache(pReceiptDb);
 
-    pUtxoDb         = new CDBAccess(dbDir, DBNameType::UTXO, false, fReIndex);
+    pUtxoDb         = NewDbAccess(dbDir, DBNameType::UTXO, fReIndex);
     pUtxoCache      = new CTxUTXODBCache(pUtxoDb);
 
-    pSysGovernDb    = new CDBAccess(dbDir, DBNameType::SYSGOVERN, false, fReIndex);
+    pSysGovernDb    = NewDbAccess(dbDir, DBNameType::SYSGOVERN, fReIndex);
     pSysGovernCache = new CSysGovernDBCache(pSysGovernDb);
 
     // memory-only cache
     pTxCache        = new CTxMemCache();
     pPpCache        = new CPricePointMemCache();
+
+    InitKeyFilters();
 }
 
 CCacheDBManager::~CCacheDBManager() {
@@ -231,6 +387,12 @@ CCacheDBManager::~CCacheDBManager() {
 }
 
 bool CCacheDBManager::Flush() {
+    // one synced write per leveldb instead of one per cache, atomic with -singlestatedb
+    CDBCommitBatch commitBatch;
+    for (CDBAccess *pDbAccess : GetDbAccesses()) {
+        if (pDbAccess) commitBatch.Add(pDbAccess);
+    }
+
     if (pSysParamCache) pSysParamCache->Flush();
 
     if (pAccountCache) pAccountCache->Flush();
@@ -265,5 +427,43 @@ bool CCacheDBManager::Flush() {
     // if (pPpCache)
     //     pPpCache->Flush();
 
-    return true;
+    return commitBatch.Commit();
+}
+
+uint64_t CCacheDBManager::GetCacheSize() const {
+    map<string, uint64_t> cacheSizes;
+    GetDbCacheSizes(cacheSizes);
+
+    uint64_t ret = 0;
+    for (const auto &item : cacheSizes)
+        ret += item.second;
+    return ret;
+}
+
+void CCacheDBManager::GetCacheSizes(map<string, uint64_t> &cacheSizes) const {
+    GetDbCacheSizes(cacheSizes);
+    cacheSizes["tx_cache"]                       = pTxCache->GetCacheSize();
+    cacheSizes["price_point_cache"]              = pPpCache->GetCacheSize();
+}
+
+void CCacheDBManager::GetDbCacheSizes(map<string, uint64_t> &cacheSizes) const {
+    cacheSizes[GetDbName(DBNameType::SYSPARAM)]  = pSysParamCache->GetCacheSize();
+    cacheSizes[GetDbName(DBNameType::ACCOUNT)]   = pAccountCache->GetCacheSize();
+    cacheSizes[GetDbName(DBNameType::ASSET)]     = pAssetCache->GetCacheSize();
+    cacheSizes[GetDbName(DBNameType::CONTRACT)]  = pContractCache->GetCacheSize();
+    cacheSizes[GetDbName(DBNameType::DELEGATE)]  = pDelegateCache->GetCacheSize();
+    cacheSizes[GetDbName(DBNameType::CDP)]       = pCdpCache->GetCacheSize();
+    cacheSizes[GetDbName(DBNameType::CLOSEDCDP)] = pClosedCdpCache->GetCacheSize();
+    cacheSizes[GetDbName(DBNameType::DEX)]       = pDexCache->GetCacheSize();
+    cacheSizes[GetDbName(DBNameType::BLOCK)]     = pBlockCache->GetCacheSize();
+    cacheSizes[GetDbName(DBNameType::LOG)]       = pLogCache->GetCacheSize();
+    cacheSizes[GetDbName(DBNameType::RECEIPT)]   = pReceiptCache->GetCacheSize();
+    cacheSizes[GetDbName(DBNameType::UTXO)]      = pUtxoCache->GetCacheSize();
+    cacheSizes[GetDbName(DBNameType::SYSGOVERN)] = pSysGovernCache->GetCacheSize();
+}
+
+void CCacheDBManager::GetKeyFilterStats(map<dbk::PrefixType, CDBKeyFilterStats> &stats) const {
+    for (CDBAccess *pDbAccess : GetDbAccesses()) {
+        if (pDbAccess) pDbAccess->GetKeyFilterStats(stats);
+    }
 }
@@ -24,6 +24,11 @@
 
 class CCacheDBManager;
 
+/** -singlestatedb default: keep all the state dbs in one leveldb */
+static const bool DEFAULT_SINGLE_STATE_DB = false;
+/** the leveldb of the state dbs with -singlestatedb */
+static const string STATE_DB_NAME = "state";
+
 class CCacheWrapper {
 public:
     CSysParamDBCache    sysParamCache;
@@ -52,10 +57,18 @@ public:
     CCacheWrapper& operator=(CCacheWrapper& other);
 
     void CopyFrom(CCacheDBManager* pCdMan);
+    // copy the db caches only, the memory caches txCache and ppCache are left empty
+    void CopyDbCachesFrom(CCacheDBManager* pCdMan);
+    void CopyDbCachesFrom(const CCacheWrapper &other);
 
     void Flush();
 
+    // the heap memory of the db caches, including the snapshot data shared with other copies
+    uint64_t GetCacheSize() const;
+
     UndoDataFuncMap GetUndoDataFuncMap();
+    // write the values of the op logs to the caches, each list of logs is applied from its last log
+    void ApplyOpLogs(CDBOpLogMap &dbOpLogMap);
 
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMap);
 private:
@@ -64,6 +77,31 @@ private:
 
 };
 
+/**
+ * Savepoint of the changes made to a cache wrapper, for executing a tx directly on the wrapper instead of
+ * on a child CCacheWrapper constructed and flushed per tx. The changes to the db caches are logged like
+ * the undo logs of a block, so a tx costs O(touched keys) and Rollback() undoes them from the logs. The
+ * memory caches txCache and ppCache are not logged, a tx to roll back must not have changed them, and the
+ * wrapper must not have another op log map set while the savepoint lives.
+ */
+class CCacheSavepoint {
+public:
+    CCacheSavepoint(CCacheWrapper &cwIn);
+    ~CCacheSavepoint();
+
+    /** Undo the changes made since the savepoint or the last rollback, logging goes on */
+    void Rollback();
+
+    CDBOpLogMap &GetDbOpLogMap() { return dbOpLogMap; }
+
+private:
+    CCacheWrapper &cw;
+    CDBOpLogMap dbOpLogMap;
+
+    CCacheSavepoint(const CCacheSavepoint&) = delete;
+    CCacheSavepoint& operator=(const CCacheSavepoint&) = delete;
+};
+
 class CCacheDBManager {
 public:
     CDBAccess           *pSysParamDb;
@@ -117,6 +155,27 @@ public:
     ~CCacheDBManager();
 
     bool Flush();
+
+    // the heap memory of the db caches, the -dbcache budget of WriteChainState(). The tx and price point
+    // memory caches are left out, Flush() does not shrink them, they are bounded by their block windows
+    uint64_t GetCacheSize() const;
+    // the heap memory of the caches by db name, including the tx and price point memory caches
+    void GetCacheSizes(map<string, uint64_t> &cacheSizes) const;
+    // the negative lookup and bloom filter counters of the key prefixes read from the dbs
+    void GetKeyFilterStats(map<dbk::PrefixType, CDBKeyFilterStats> &stats) const;
+    // take the leveldb snapshots of the state dbs, see CChainStateSnapshot
+    void TakeDbSnapshots(CLevelDBSnapshots &snapshots) const;
+
+private:
+    CDBAccess* NewDbAccess(const boost::filesystem::path &dbDir, DBNameType dbNameType, bool fReIndex);
+    vector<CDBAccess*> GetDbAccesses() const;
+    // the heap memory of the flushed db caches by db name
+    void GetDbCacheSizes(map<string, uint64_t> &cacheSizes) const;
+    // -dbnegativecache and -dbbloomfilter
+    void InitKeyFilters();
+
+private:
+    std::shared_ptr<CLevelDBWrapper> spStateDb; // -singlestatedb
 };  // CCacheDBManager
 
 #endif //PERSIST_CACHEWRAPPER_H
\ No newline at end of file
@@ -165,7 +165,7 @@ void CCdpDBCache::SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
     cdpRatioSortedCache.SetDbOpLogMap(pDbOpLogMapIn);
 }
 
-uint32_t CCdpDBCache::GetCacheSize() const {
+uint64_t CCdpDBCache::GetCacheSize() const {
     return cdpGlobalDataCache.GetCacheSize() + cdpCache.GetCacheSize() + userCdpCache.GetCacheSize() +
             cdpCoinPairsCache.GetCacheSize() + cdpRatioSortedCache.GetCacheSize();
 }
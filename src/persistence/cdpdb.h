@@ -62,7 +62,7 @@ public:
         cdpRatioSortedCache.RegisterUndoFunc(undoDataFuncMap);
     }
 
-    uint32_t GetCacheSize() const;
+    uint64_t GetCacheSize() const;
     bool Flush();
 private:
     bool SaveCDPToDB(const CUserCDP &cdp);
@@ -122,7 +122,7 @@ public:
         return closedTxCdpCache.GetData(closedCdpTxId, cdp);
     }
 
-    uint32_t GetCacheSize() const { return closedCdpTxCache.GetCacheSize() + closedTxCdpCache.GetCacheSize(); }
+    uint64_t GetCacheSize() const { return closedCdpTxCache.GetCacheSize() + closedTxCdpCache.GetCacheSize(); }
 
     void SetBaseViewPtr(CClosedCdpDBCache *pBaseIn) {
         closedCdpTxCache.SetBase(&pBaseIn->closedCdpTxCache);
@@ -0,0 +1,102 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chainstatesnapshot.h"
+
+#include "commons/util/time.h"
+#include "main.h"
+
+#include <atomic>
+#include <mutex>
+
+static std::mutex csPublishedSnapshot;
+static std::shared_ptr<const CChainStateSnapshot> spPublishedSnapshot;
+static std::atomic<uint64_t> nTipVersion{0};
+
+CChainStateSnapshot::CChainStateSnapshot(CBlockIndex *pTipIn, uint64_t versionIn, CCacheDBManager &cdMan)
+    : pTip(pTipIn), version(versionIn), nTime(GetTime()) {
+    AssertLockHeld(cs_main);
+    cdMan.TakeDbSnapshots(dbSnapshots);
+    cw.CopyDbCachesFrom(&cdMan);
+}
+
+static void PublishChainStateSnapshot(const std::shared_ptr<const CChainStateSnapshot> &spSnapshot) {
+    std::shared_ptr<const CChainStateSnapshot> spPrevSnapshot;
+    {
+        std::lock_guard<std::mutex> lock(csPublishedSnapshot);
+        spPrevSnapshot      = spPublishedSnapshot;
+        spPublishedSnapshot = spSnapshot;
+    }
+    // the previous snapshot is released out of the lock if it was the last reference
+}
+
+void UpdateChainStateSnapshot(CBlockIndex *pTip, CCacheDBManager &cdMan, bool fInitialDownload) {
+    AssertLockHeld(cs_main);
+    uint64_t version = ++nTipVersion;
+    if (!fInitialDownload)
+        PublishChainStateSnapshot(std::make_shared<const CChainStateSnapshot>(pTip, version, cdMan));
+}
+
+std::shared_ptr<const CChainStateSnapshot> GetChainStateSnapshot() {
+    auto IsCurrent = [](const std::shared_ptr<const CChainStateSnapshot> &spSnapshot) {
+        return spSnapshot && (spSnapshot->version == nTipVersion ||
+                              GetTime() - spSnapshot->nTime < CHAIN_STATE_SNAPSHOT_MAX_AGE);
+    };
+
+    std::shared_ptr<const CChainStateSnapshot> spSnapshot;
+    {
+        std::lock_guard<std::mutex> lock(csPublishedSnapshot);
+        spSnapshot = spPublishedSnapshot;
+    }
+    if (IsCurrent(spSnapshot))
+        return spSnapshot;
+
+    LOCK(cs_main);
+    {
+        // refreshed by another reader while waiting for cs_main
+        std::lock_guard<std::mutex> lock(csPublishedSnapshot);
+        spSnapshot = spPublishedSnapshot;
+    }
+    if (IsCurrent(spSnapshot))
+        return spSnapshot;
+    if (pCdMan == nullptr)
+        return nullptr;
+
+    spSnapshot = std::make_shared<const CChainStateSnapshot>(chainActive.Tip(), nTipVersion, *pCdMan);
+    PublishChainStateSnapshot(spSnapshot);
+    return spSnapshot;
+}
+
+void ResetChainStateSnapshot() {
+    PublishChainStateSnapshot(nullptr);
+}
+
+CChainStateReadView::CChainStateReadView(const std::shared_ptr<const CChainStateSnapshot> &spSnapshotIn)
+    : spSnapshot(spSnapshotIn), dbReader(&spSnapshotIn->dbSnapshots) {
+    cw.CopyDbCachesFrom(spSnapshot->cw);
+}
+
+int32_t CChainStateReadView::Height() const {
+    return spSnapshot->pTip != nullptr ? spSnapshot->pTip->height : -1;
+}
+
+CBlockIndex *CChainStateReadView::operator[](int32_t height) const {
+    if (height < 0 || height > Height())
+        return nullptr;
+    return spSnapshot->pTip->GetAncestor(height);
+}
+
+bool CChainStateReadView::Contains(const CBlockIndex *pIndex) const {
+    return pIndex != nullptr && (*this)[pIndex->height] == pIndex;
+}
+
+CBlockIndex *CChainStateReadView::Next(const CBlockIndex *pIndex) const {
+    return Contains(pIndex) ? (*this)[pIndex->height + 1] : nullptr;
+}
+
+CBlockIndex *CChainStateReadView::FindBlockIndex(const uint256 &hash) const {
+    LOCK(cs_mapBlockIndex);
+    auto it = mapBlockIndex.find(hash);
+    return it != mapBlockIndex.end() ? it->second : nullptr;
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PERSIST_CHAINSTATE_SNAPSHOT_H
+#define PERSIST_CHAINSTATE_SNAPSHOT_H
+
+#include "cachewrapper.h"
+#include "leveldbwrapper.h"
+
+#include <memory>
+
+class CBlockIndex;
+class uint256;
+
+/** Max age of a snapshot read while the tip snapshots are not published, in seconds */
+static const int64_t CHAIN_STATE_SNAPSHOT_MAX_AGE = 5;
+
+/**
+ * Immutable chain state at a tip: the tip index, the leveldb snapshots of the state dbs and a frozen
+ * copy-on-write copy of the node's db caches. The readers read it through CChainStateReadView without
+ * holding cs_main. The memory caches of the latest blocks (txCache, ppCache) are not in the snapshot.
+ */
+class CChainStateSnapshot {
+public:
+    CBlockIndex *pTip;
+    uint64_t version;   // the tip updates before the snapshot, increases with each published tip
+    int64_t nTime;
+    CLevelDBSnapshots dbSnapshots;
+    CCacheWrapper cw;
+
+    // take the snapshot of the node's caches, cs_main must be held
+    CChainStateSnapshot(CBlockIndex *pTipIn, uint64_t versionIn, CCacheDBManager &cdMan);
+
+private:
+    CChainStateSnapshot(const CChainStateSnapshot &) = delete;
+    CChainStateSnapshot &operator=(const CChainStateSnapshot &) = delete;
+};
+
+/**
+ * Called by UpdateTip() after ConnectTip() and DisconnectTip() flushed the chain state, cs_main must be held.
+ * Publishes the snapshot of the new tip, except in the initial block download, which leaves the refreshes
+ * to the readers, at most once per CHAIN_STATE_SNAPSHOT_MAX_AGE.
+ */
+void UpdateChainStateSnapshot(CBlockIndex *pTip, CCacheDBManager &cdMan, bool fInitialDownload);
+
+/** The latest snapshot, refreshed under cs_main if outdated. nullptr if the chain state is not loaded */
+std::shared_ptr<const CChainStateSnapshot> GetChainStateSnapshot();
+
+/** Release the published snapshot, before the state dbs are closed */
+void ResetChainStateSnapshot();
+
+/**
+ * Read view of a chain state snapshot, replacing chainActive and pCdMan for the readers not holding
+ * cs_main. The db reads of the thread see the snapshot while the view lives, and it must be destroyed
+ * by the thread that created it. cw is the view's own copy of the snapshot caches, it must not be flushed.
+ */
+class CChainStateReadView {
+public:
+    CChainStateReadView(const std::shared_ptr<const CChainStateSnapshot> &spSnapshotIn);
+
+    CBlockIndex *Tip() const { return spSnapshot->pTip; }
+    int32_t Height() const;
+    uint64_t GetVersion() const { return spSnapshot->version; }
+
+    // the block of the chain at the height, nullptr if beyond the tip
+    CBlockIndex *operator[](int32_t height) const;
+    bool Contains(const CBlockIndex *pIndex) const;
+    CBlockIndex *Next(const CBlockIndex *pIndex) const;
+    // the index of the block in mapBlockIndex, nullptr if not found
+    CBlockIndex *FindBlockIndex(const uint256 &hash) const;
+
+private:
+    std::shared_ptr<const CChainStateSnapshot> spSnapshot;
+    CLevelDBSnapshotReader dbReader;
+
+public:
+    CCacheWrapper cw;
+
+private:
+    CChainStateReadView(const CChainStateReadView &) = delete;
+    CChainStateReadView &operator=(const CChainStateReadView &) = delete;
+};
+
+#endif  // PERSIST_CHAINSTATE_SNAPSHOT_H
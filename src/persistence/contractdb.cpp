@@ -12,6 +12,7 @@
 #include "entities/key.h"
 #include "commons/uint256.h"
 #include "commons/util/util.h"
+#include "crypto/hash.h"
 #include "vm/luavm/luavmrunenv.h"
 
 #include <stdint.h>
@@ -35,15 +36,36 @@ bool CContractDBCache::SetContractAccount(const CRegID &contractRegId, const CAp
 
 /************************ contract in cache ******************************/
 bool CContractDBCache::GetContract(const CRegID &contractRegId, CUniversalContract &contract) {
-    return contractCache.GetData(contractRegId, contract);
+    CDBSharedValue<CUniversalContract> value;
+    if (!contractCache.GetData(contractRegId, value))
+        return false;
+
+    contract = value.Get();
+    return true;
+}
+
+bool CContractDBCache::GetContract(const CRegID &contractRegId, std::shared_ptr<const CUniversalContract> &spContract) {
+    CDBSharedValue<CUniversalContract> value;
+    if (!contractCache.GetData(contractRegId, value))
+        return false;
+
+    spContract = value.GetPtr();
+    return true;
 }
 
 bool CContractDBCache::GetContracts(map<CRegIDKey, CUniversalContract> &contracts) {
-    return contractCache.GetAllElements(contracts);
+    map<CRegIDKey, CDBSharedValue<CUniversalContract>> values;
+    if (!contractCache.GetAllElements(values))
+        return false;
+
+    for (const auto &item : values)
+        contracts.emplace(item.first, item.second.Get());
+    return true;
 }
 
 bool CContractDBCache::SaveContract(const CRegID &contractRegId, const CUniversalContract &contract) {
-    return contractCache.SetData(contractRegId, contract);
+    return contractCache.SetData(contractRegId, contract) &&
+           contractCodeHashCache.SetData(contractRegId, Hash(contract.code.begin(), contract.code.end()));
 }
 
 bool CContractDBCache::HaveContract(const CRegID &contractRegId) {
@@ -51,9 +73,23 @@ bool CContractDBCache::HaveContract(const CRegID &contractRegId) {
 }
 
 bool CContractDBCache::EraseContract(const CRegID &contractRegId) {
+    contractCodeHashCache.EraseData(contractRegId);
     return contractCache.EraseData(contractRegId);
 }
 
+bool CContractDBCache::GetContractCodeHash(const CRegID &contractRegId, uint256 &codeHash) {
+    if (contractCodeHashCache.GetData(contractRegId, codeHash))
+        return true;
+
+    // the contracts saved before the code hash was
+    std::shared_ptr<const CUniversalContract> spContract;
+    if (!GetContract(contractRegId, spContract))
+        return false;
+
+    codeHash = Hash(spContract->code.begin(), spContract->code.end());
+    return true;
+}
+
 /************************ contract data ******************************/
 bool CContractDBCache::GetContractData(const CRegID &contractRegId, const string &contractKey, string &contractData) {
     auto key = std::make_pair(CRegIDKey(contractRegId), contractKey);
@@ -89,14 +125,16 @@ bool CContractDBCache::Flush() {
     contractDataCache.Flush();
     contractAccountCache.Flush();
     contractTracesCache.Flush();
+    contractCodeHashCache.Flush();
 
     return true;
 }
 
-uint32_t CContractDBCache::GetCacheSize() const {
+uint64_t CContractDBCache::GetCacheSize() const {
     return contractCache.GetCacheSize() +
         contractDataCache.GetCacheSize() +
-        contractTracesCache.GetCacheSize();
+        contractTracesCache.GetCacheSize() +
+        contractCodeHashCache.GetCacheSize();
 }
 
 
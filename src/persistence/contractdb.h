@@ -68,7 +68,8 @@ public:
         contractCache(pDbAccess),
         contractDataCache(pDbAccess),
         contractAccountCache(pDbAccess),
-        contractTracesCache(pDbAccess) {
+        contractTracesCache(pDbAccess),
+        contractCodeHashCache(pDbAccess) {
         assert(pDbAccess->GetDbNameType() == DBNameType::CONTRACT);
     };
 
@@ -76,16 +77,21 @@ public:
         contractCache(pBaseIn->contractCache),
         contractDataCache(pBaseIn->contractDataCache),
         contractAccountCache(pBaseIn->contractAccountCache),
-        contractTracesCache(pBaseIn->contractTracesCache) {};
+        contractTracesCache(pBaseIn->contractTracesCache),
+        contractCodeHashCache(pBaseIn->contractCodeHashCache) {};
 
     bool GetContractAccount(const CRegID &contractRegId, const string &accountKey, CAppUserAccount &appAccOut);
     bool SetContractAccount(const CRegID &contractRegId, const CAppUserAccount &appAccIn);
 
     bool GetContract(const CRegID &contractRegId, CUniversalContract &contract);
+    // the contract shared with the cache, no copy of the code
+    bool GetContract(const CRegID &contractRegId, std::shared_ptr<const CUniversalContract> &spContract);
     bool GetContracts(map<CRegIDKey, CUniversalContract> &contracts);
     bool SaveContract(const CRegID &contractRegId, const CUniversalContract &contract);
     bool HaveContract(const CRegID &contractRegId);
     bool EraseContract(const CRegID &contractRegId);
+    // the hash of the contract code, saved with the contract so a contract call need not hash its code
+    bool GetContractCodeHash(const CRegID &contractRegId, uint256 &codeHash);
 
     bool GetContractData(const CRegID &contractRegId, const string &contractKey, string &contractData);
     bool SetContractData(const CRegID &contractRegId, const string &contractKey, const string &contractData);
@@ -96,13 +102,14 @@ public:
     bool SetContractTraces(const uint256 &txid, const string &contractTraces);
 
     bool Flush();
-    uint32_t GetCacheSize() const;
+    uint64_t GetCacheSize() const;
 
     void SetBaseViewPtr(CContractDBCache *pBaseIn) {
         contractCache.SetBase(&pBaseIn->contractCache);
         contractDataCache.SetBase(&pBaseIn->contractDataCache);
         contractAccountCache.SetBase(&pBaseIn->contractAccountCache);
         contractTracesCache.SetBase(&pBaseIn->contractTracesCache);
+        contractCodeHashCache.SetBase(&pBaseIn->contractCodeHashCache);
     };
 
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
@@ -110,6 +117,7 @@ public:
         contractDataCache.SetDbOpLogMap(pDbOpLogMapIn);
         contractAccountCache.SetDbOpLogMap(pDbOpLogMapIn);
         contractTracesCache.SetDbOpLogMap(pDbOpLogMapIn);
+        contractCodeHashCache.SetDbOpLogMap(pDbOpLogMapIn);
     }
 
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
@@ -117,6 +125,7 @@ public:
         contractDataCache.RegisterUndoFunc(undoDataFuncMap);
         contractAccountCache.RegisterUndoFunc(undoDataFuncMap);
         contractTracesCache.RegisterUndoFunc(undoDataFuncMap);
+        contractCodeHashCache.RegisterUndoFunc(undoDataFuncMap);
     }
 
     shared_ptr<CDBContractDataIterator> CreateContractDataIterator(const CRegID &contractRegid,
@@ -127,7 +136,7 @@ public:
 /*  ----------------   -------------------------   -----------------------  ------------------   ------------------------ */
     /////////// ContractDB
     // contract $RegIdKey -> Contract
-    CCompositeKVCache< dbk::CONTRACT_DEF,         CRegIDKey,                   CUniversalContract >   contractCache;
+    CCompositeKVCache< dbk::CONTRACT_DEF,         CRegIDKey,   CDBSharedValue<CUniversalContract> >   contractCache;
 
     // pair<contractRegId, contractKey> -> contractData
     DBContractDataCache contractDataCache;
@@ -135,6 +144,8 @@ public:
     CCompositeKVCache< dbk::CONTRACT_ACCOUNT,     pair<CRegIDKey, string>,     CAppUserAccount >      contractAccountCache;
     // txid -> contract_traces
     CCompositeKVCache< dbk::CONTRACT_TRACES,     uint256,                  string >      contractTracesCache;
+    // contract $RegIdKey -> hash of the contract code
+    CCompositeKVCache< dbk::CONTRACT_CODE_HASH,  CRegIDKey,                uint256 >     contractCodeHashCache;
 };
 
 #endif  // PERSIST_CONTRACTDB_H
\ No newline at end of file
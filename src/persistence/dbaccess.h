@@ -6,12 +6,20 @@
 #ifndef PERSIST_DB_ACCESS_H
 #define PERSIST_DB_ACCESS_H
 
+#include "commons/memusage.h"
 #include "commons/uint256.h"
 #include "dbconf.h"
+#include "dbkeyfilter.h"
 #include "leveldbwrapper.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <tuple>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 #include <optional>
 
@@ -99,6 +107,21 @@ namespace db_util {
     template<typename T> void SetEmpty(T& val);
     template<typename T> string ToString(const T& val);
 
+    /**
+     * Heap memory held by the value, not including sizeof(value). A common object type may implement
+     * GetDynamicMemSize(), a trivially copyable type has none, and the other types are estimated by
+     * their serialized size.
+     */
+    template<typename C> size_t GetDynamicMemSize(const basic_string<C> &val);
+    template<typename T, typename A> size_t GetDynamicMemSize(const vector<T, A> &val);
+    template<typename K, typename Pred, typename A> size_t GetDynamicMemSize(const set<K, Pred, A> &val);
+    template<typename K, typename T, typename Pred, typename A> size_t GetDynamicMemSize(const map<K, T, Pred, A> &val);
+    template<typename T> size_t GetDynamicMemSize(const std::optional<T> &val);
+    template<typename T> size_t GetDynamicMemSize(const std::shared_ptr<T> &val);
+    template<typename K, typename T> size_t GetDynamicMemSize(const std::pair<K, T> &val);
+    template<typename... Ts> size_t GetDynamicMemSize(const std::tuple<Ts...> &val);
+    template<typename T> size_t GetDynamicMemSize(const T &val);
+
     //optional
     template<typename T> bool IsEmpty(const std::optional<T> val) { return val == std::nullopt; }
     template<typename T> void SetEmpty(std::optional<T>& val) { val = std::nullopt; }
@@ -247,6 +270,78 @@ namespace db_util {
         return val.ToString();
     }
 
+    template<typename T, typename = void>
+    struct HasDynamicMemSize : std::false_type {};
+    template<typename T>
+    struct HasDynamicMemSize<T, std::void_t<decltype(std::declval<const T&>().GetDynamicMemSize())>> : std::true_type {};
+
+    // string
+    template<typename C> size_t GetDynamicMemSize(const basic_string<C> &val) {
+        return memusage::DynamicUsage(val);
+    }
+
+    // vector
+    template<typename T, typename A> size_t GetDynamicMemSize(const vector<T, A> &val) {
+        size_t ret = memusage::DynamicUsage(val);
+        if constexpr (!std::is_trivially_copyable<T>::value) {
+            for (const auto &item : val)
+                ret += GetDynamicMemSize(item);
+        }
+        return ret;
+    }
+
+    // set
+    template<typename K, typename Pred, typename A> size_t GetDynamicMemSize(const set<K, Pred, A> &val) {
+        size_t ret = memusage::DynamicUsage(val);
+        if constexpr (!std::is_trivially_copyable<K>::value) {
+            for (const auto &item : val)
+                ret += GetDynamicMemSize(item);
+        }
+        return ret;
+    }
+
+    // map
+    template<typename K, typename T, typename Pred, typename A> size_t GetDynamicMemSize(const map<K, T, Pred, A> &val) {
+        size_t ret = memusage::DynamicUsage(val);
+        if constexpr (!std::is_trivially_copyable<K>::value || !std::is_trivially_copyable<T>::value) {
+            for (const auto &item : val)
+                ret += GetDynamicMemSize(item.first) + GetDynamicMemSize(item.second);
+        }
+        return ret;
+    }
+
+    //optional
+    template<typename T> size_t GetDynamicMemSize(const std::optional<T> &val) {
+        return val ? GetDynamicMemSize(val.value()) : 0;
+    }
+
+    //shared_ptr, counted as owned by one holder
+    template<typename T> size_t GetDynamicMemSize(const std::shared_ptr<T> &val) {
+        if (val == nullptr)
+            return 0;
+        return memusage::MallocUsage(sizeof(T) + memusage::SHARED_PTR_CONTROL_SIZE) + GetDynamicMemSize(*val);
+    }
+
+    // 2 pair
+    template<typename K, typename T> size_t GetDynamicMemSize(const std::pair<K, T> &val) {
+        return GetDynamicMemSize(val.first) + GetDynamicMemSize(val.second);
+    }
+
+    // tuple
+    template<typename... Ts> size_t GetDynamicMemSize(const std::tuple<Ts...> &val) {
+        return std::apply([](const Ts&... items) { return (size_t(0) + ... + GetDynamicMemSize(items)); }, val);
+    }
+
+    // common Object Type
+    template<typename T> size_t GetDynamicMemSize(const T &val) {
+        if constexpr (HasDynamicMemSize<T>::value)
+            return val.GetDynamicMemSize();
+        else if constexpr (std::is_trivially_copyable<T>::value)
+            return 0;
+        else
+            return ::GetSerializeSize(val, SER_DISK, CLIENT_VERSION);
+    }
+
     template <typename ValueType>
     std::shared_ptr<ValueType> MakeEmptyValue() {
         auto value = std::make_shared<ValueType>();
@@ -268,19 +363,36 @@ class CDBAccess {
 public:
     CDBAccess(const boost::filesystem::path& dir, DBNameType dbNameTypeIn, bool fMemory, bool fWipe) :
               dbNameType(dbNameTypeIn),
-              db( dir / ::GetDbName(dbNameTypeIn), DBCacheSize[dbNameTypeIn], fMemory, fWipe ) {}
+              spDb(std::make_shared<CLevelDBWrapper>(dir / ::GetDbName(dbNameTypeIn), DBCacheSize[dbNameTypeIn], fMemory, fWipe)) {}
+
+    // share the leveldb with the other state dbs, the key prefixes of all the dbs are unique
+    CDBAccess(DBNameType dbNameTypeIn, const std::shared_ptr<CLevelDBWrapper> &spDbIn) :
+              dbNameType(dbNameTypeIn), spDb(spDbIn) {
+        assert(spDb);
+    }
 
-    int64_t GetDbCount() const { return db.GetDbCount(); }
+    int64_t GetDbCount() const { return spDb->GetDbCount(); }
     template<typename KeyType, typename ValueType>
     bool GetData(const dbk::PrefixType prefixType, const KeyType &key, ValueType &value) const {
         string keyStr = dbk::GenDbKey(prefixType, key);
-        return db.Read(keyStr, value);
+        // the filter knows the keys of the db now, not of the snapshot read by the thread
+        if (CLevelDBSnapshotReader::pSnapshots != nullptr)
+            return spDb->Read(keyStr, value);
+
+        uint64_t nReadEpoch;
+        if (keyFilter.IsAbsent(prefixType, keyStr, nReadEpoch))
+            return false;
+
+        // the keys in a pending commit batch are not in the db yet, the filter does not remember them as absent
+        bool found = spDb->Read(keyStr, value);
+        keyFilter.OnRead(prefixType, keyStr, found, nReadEpoch);
+        return found;
     }
 
     template<typename ValueType>
     bool GetData(const dbk::PrefixType prefixType, ValueType &value) const {
         const string prefix = dbk::GetKeyPrefix(prefixType);
-        return db.Read(prefix, value);
+        return spDb->Read(prefix, value);
     }
 
     template <typename KeyType>
@@ -447,26 +559,47 @@ public:
     template<typename KeyType, typename ValueType>
     bool HaveData(const dbk::PrefixType prefixType, const KeyType &key) const {
         string keyStr = dbk::GenDbKey(prefixType, key);
-        return db.Exists(keyStr);
+        if (CLevelDBSnapshotReader::pSnapshots != nullptr)
+            return spDb->Exists(keyStr);
+
+        uint64_t nReadEpoch;
+        if (keyFilter.IsAbsent(prefixType, keyStr, nReadEpoch))
+            return false;
+
+        bool found = spDb->Exists(keyStr);
+        keyFilter.OnRead(prefixType, keyStr, found, nReadEpoch);
+        return found;
     }
 
     template<typename KeyType, typename ValueType>
     void BatchWrite(const dbk::PrefixType prefixType, const map<KeyType, ValueType> &mapData) {
-        CLevelDBBatch batch;
-        for (auto item : mapData) {
-            string key = dbk::GenDbKey(prefixType, item.first);
-            if (db_util::IsEmpty(item.second)) {
-                batch.Erase(key);
-            } else {
-                batch.Write(key, item.second);
-            }
-        }
-        db.WriteBatch(batch, true);
+        BatchWriteItems(prefixType, mapData);
+    }
+
+    // the items are written in key order, leveldb inserts the sorted keys much faster
+    template<typename KeyType, typename ValueType, typename Hash>
+    void BatchWrite(const dbk::PrefixType prefixType, const unordered_map<KeyType, ValueType, Hash> &mapData) {
+        typedef typename unordered_map<KeyType, ValueType, Hash>::const_pointer ItemPtr;
+        vector<ItemPtr> items;
+        items.reserve(mapData.size());
+        for (const auto &item : mapData)
+            items.push_back(&item);
+        std::sort(items.begin(), items.end(), [](ItemPtr a, ItemPtr b) { return a->first < b->first; });
+
+        CDBKeyFilter::CWriteScope writeScope(keyFilter);
+        CLevelDBBatch localBatch;
+        CLevelDBBatch &batch = pCommitBatch != nullptr ? *pCommitBatch : localBatch;
+        for (const auto pItem : items)
+            BatchWriteItem(batch, prefixType, pItem->first, pItem->second);
+        if (pCommitBatch == nullptr)
+            spDb->WriteBatch(batch, true);
     }
 
     template<typename ValueType>
     void BatchWrite(const dbk::PrefixType prefixType, ValueType &value) {
-        CLevelDBBatch batch;
+        CDBKeyFilter::CWriteScope writeScope(keyFilter);
+        CLevelDBBatch localBatch;
+        CLevelDBBatch &batch = pCommitBatch != nullptr ? *pCommitBatch : localBatch;
         const string prefix = dbk::GetKeyPrefix(prefixType);
 
         if (db_util::IsEmpty(value)) {
@@ -474,28 +607,239 @@ public:
         } else {
             batch.Write(prefix, value);
         }
-        db.WriteBatch(batch, true);
+        if (pCommitBatch == nullptr)
+            spDb->WriteBatch(batch, true);
     }
 
+    // the writes go to the commit batch instead of the db if set, see CDBCommitBatch. Only the writer
+    // thread reads pCommitBatch, the readers learn of the pending batch from the key filter
+    void SetCommitBatch(CLevelDBBatch *pBatchIn) {
+        if (pCommitBatch == nullptr && pBatchIn != nullptr)
+            keyFilter.BeginWrite();
+        else if (pCommitBatch != nullptr && pBatchIn == nullptr)
+            keyFilter.EndWrite();
+        pCommitBatch = pBatchIn;
+    }
+
+    CLevelDBWrapper* GetDbPtr() const { return spDb.get(); }
+
     DBNameType GetDbNameType() const { return dbNameType; }
 
     std::shared_ptr<leveldb::Iterator> NewIterator() {
-        return std::shared_ptr<leveldb::Iterator>(db.NewIterator());
+        return std::shared_ptr<leveldb::Iterator>(spDb->NewIterator());
     }
+
+    void SetMaxNegativeKeys(uint32_t nMaxKeys) { keyFilter.SetMaxNegativeKeys(nMaxKeys); }
+    void EnableBloomFilter(const dbk::PrefixType prefixType) { keyFilter.EnableBloomFilter(prefixType, *spDb); }
+    void GetKeyFilterStats(map<dbk::PrefixType, CDBKeyFilterStats> &stats) const { keyFilter.GetStats(stats); }
+private:
+    template<typename MapType>
+    void BatchWriteItems(const dbk::PrefixType prefixType, const MapType &mapData) {
+        CDBKeyFilter::CWriteScope writeScope(keyFilter);
+        CLevelDBBatch localBatch;
+        CLevelDBBatch &batch = pCommitBatch != nullptr ? *pCommitBatch : localBatch;
+        for (const auto &item : mapData)
+            BatchWriteItem(batch, prefixType, item.first, item.second);
+        if (pCommitBatch == nullptr)
+            spDb->WriteBatch(batch, true);
+    }
+
+    template<typename KeyType, typename ValueType>
+    void BatchWriteItem(CLevelDBBatch &batch, const dbk::PrefixType prefixType, const KeyType &key,
+                        const ValueType &value) {
+        string keyStr = dbk::GenDbKey(prefixType, key);
+        if (db_util::IsEmpty(value)) {
+            batch.Erase(keyStr);
+        } else {
+            batch.Write(keyStr, value);
+            keyFilter.OnWrite(prefixType, keyStr);
+        }
+    }
+
 private:
     DBNameType dbNameType;
-    mutable CLevelDBWrapper db; // // TODO: remove the mutable declare
+    std::shared_ptr<CLevelDBWrapper> spDb;
+    CLevelDBBatch *pCommitBatch = nullptr;
+    // the negative lookups and bloom filters of the keys in the db, shared by all the caches on this db
+    mutable CDBKeyFilter keyFilter;
+};
+
+/**
+ * Collects the writes of the added dbs into one batch per leveldb and writes each batch with one
+ * synced write in Commit(). The dbs sharing one leveldb are committed atomically.
+ */
+class CDBCommitBatch {
+public:
+    ~CDBCommitBatch() { Detach(); }
+
+    void Add(CDBAccess *pDbAccess) {
+        assert(pDbAccess != nullptr);
+        pDbAccess->SetCommitBatch(&mapBatch[pDbAccess->GetDbPtr()]);
+        dbAccesses.push_back(pDbAccess);
+    }
+
+    bool Commit() {
+        // the dbs are detached after the write, their keys are pending in the key filters until then
+        for (auto &item : mapBatch) {
+            if (!item.first->WriteBatch(item.second, true))
+                return false;
+        }
+        Detach();
+        mapBatch.clear();
+        return true;
+    }
+
+    size_t GetBatchCount() const { return mapBatch.size(); }
+
+private:
+    void Detach() {
+        for (auto pDbAccess : dbAccesses)
+            pDbAccess->SetCommitBatch(nullptr);
+        dbAccesses.clear();
+    }
+
+private:
+    map<CLevelDBWrapper*, CLevelDBBatch> mapBatch;
+    vector<CDBAccess*> dbAccesses;
+};
+
+
+/** Counters of the snapshot layers shared by copies of CCompositeKVCache, see CCompositeKVCache::Freeze() */
+struct CDBCacheSnapshotStats {
+    static std::atomic<int64_t> layers;
+    static std::atomic<int64_t> entries;
+    static std::atomic<int64_t> bytes;
+};
+
+struct CDBSharedValueStats {
+    static std::atomic<int64_t> allocs;     // values allocated by a read from the db, a set or an undo
+    static std::atomic<int64_t> shares;     // copies of a value taking a reference instead of a deep copy
+};
+
+/**
+ * Immutable value of CCompositeKVCache shared by the cache layers, for the large values such as the
+ * contract code or the received votes of a candidate. The child caches take a reference to the value
+ * of the base cache on a read instead of a deep copy, and a new value is allocated by SetData() and
+ * EraseData() of the child (copy-on-write). It is serialized as T, the db and op log formats are kept.
+ */
+template<typename T>
+class CDBSharedValue {
+public:
+    CDBSharedValue(): sp(EmptyValue()) {}
+    CDBSharedValue(const T &value): sp(std::make_shared<const T>(value)) { CDBSharedValueStats::allocs++; }
+    CDBSharedValue(T &&value): sp(std::make_shared<const T>(std::move(value))) { CDBSharedValueStats::allocs++; }
+    CDBSharedValue(const CDBSharedValue &other): sp(other.sp) { CDBSharedValueStats::shares++; }
+    // the moved value keeps its reference, a value is never null
+    CDBSharedValue(CDBSharedValue &&other): sp(other.sp) {}
+
+    CDBSharedValue& operator=(const CDBSharedValue &other) {
+        sp = other.sp;
+        CDBSharedValueStats::shares++;
+        return *this;
+    }
+    CDBSharedValue& operator=(CDBSharedValue &&other) {
+        sp = other.sp;
+        return *this;
+    }
+
+    const T& Get() const { return *sp; }
+    const std::shared_ptr<const T>& GetPtr() const { return sp; }
+
+    bool IsEmpty() const { return db_util::IsEmpty(*sp); }
+    void SetEmpty() { sp = EmptyValue(); }
+    string ToString() const { return db_util::ToString(*sp); }
+
+    // every layer holding the value counts it, the flush of the caches is triggered no later than before
+    size_t GetDynamicMemSize() const {
+        return memusage::MallocUsage(sizeof(T) + memusage::SHARED_PTR_CONTROL_SIZE) + db_util::GetDynamicMemSize(*sp);
+    }
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const {
+        return ::GetSerializeSize(*sp, nType, nVersion);
+    }
+
+    template<typename Stream>
+    void Serialize(Stream &s, int nType, int nVersion) const {
+        ::Serialize(s, *sp, nType, nVersion);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream &s, int nType, int nVersion) {
+        auto spValue = std::make_shared<T>();
+        ::Unserialize(s, *spValue, nType, nVersion);
+        sp = spValue;
+        CDBSharedValueStats::allocs++;
+    }
+
+private:
+    // the empty values share one instance
+    static const std::shared_ptr<const T>& EmptyValue() {
+        static const std::shared_ptr<const T> spEmpty = std::make_shared<const T>(db_util::MakeEmpty<T>());
+        return spEmpty;
+    }
+
+    std::shared_ptr<const T> sp;
+};
+
+/** Max number of snapshot layers of a cache, a deeper chain is merged into one layer */
+static const uint32_t MAX_DB_CACHE_SNAPSHOT_DEPTH = 8;
+
+/**
+ * Container policies of CCompositeKVCache::mapData.
+ * CDBOrderedMap keeps the keys in order, required by the key range getters and the db iterators.
+ * CDBHashMap is for the caches only accessed by key whose keys are hashes, such as txid and keyid.
+ */
+struct CDBOrderedMap {
+    template<typename K, typename V> using Map = std::map<K, V>;
+    static const bool IS_ORDERED = true;
+
+    template<typename K, typename V>
+    static size_t NodeUsage() { return memusage::MapNodeUsage<K, V>(); }
+};
+
+struct CDBHashMap {
+    template<typename K, typename V> using Map = std::unordered_map<K, V, CBlobHasher>;
+    static const bool IS_ORDERED = false;
+
+    template<typename K, typename V>
+    static size_t NodeUsage() { return memusage::HashNodeUsage<K, V>(); }
 };
 
-template<int32_t PREFIX_TYPE_VALUE, typename __KeyType, typename __ValueType>
+/**
+ * Serializes the reads which fall through a cache to its shared base caches, as a read adds the found
+ * item to the map of every cache on the way. Only the worker threads of CTxParallelExecutor set the
+ * mutex, the views of the other threads never lock.
+ */
+class CDBBaseReadLock {
+public:
+    CDBBaseReadLock() { if (pMutex != nullptr) pMutex->lock(); }
+    ~CDBBaseReadLock() { if (pMutex != nullptr) pMutex->unlock(); }
+
+    static inline thread_local std::recursive_mutex *pMutex = nullptr;
+};
+
+/**
+ * Records the keys flushed by the caches of the thread as the writes of an access set while it lives.
+ * The keys read without being changed are flushed as well, the set is a superset of the changed keys.
+ */
+class CDBFlushRecorder {
+public:
+    CDBFlushRecorder(CDBAccessSet &writeSet) { pWriteSet = &writeSet; }
+    ~CDBFlushRecorder() { pWriteSet = nullptr; }
+
+    static inline thread_local CDBAccessSet *pWriteSet = nullptr;
+};
+
+template<int32_t PREFIX_TYPE_VALUE, typename __KeyType, typename __ValueType, typename __MapPolicy = CDBOrderedMap>
 class CCompositeKVCache {
 public:
     static const dbk::PrefixType PREFIX_TYPE = (dbk::PrefixType)PREFIX_TYPE_VALUE;
 public:
     typedef __KeyType   KeyType;
     typedef __ValueType ValueType;
-    typedef typename std::map<KeyType, ValueType> Map;
-    typedef typename std::map<KeyType, ValueType>::iterator Iterator;
+    typedef __MapPolicy MapPolicy;
+    typedef typename MapPolicy::template Map<KeyType, ValueType> Map;
+    typedef typename Map::iterator Iterator;
 
 public:
     /**
@@ -514,9 +858,32 @@ public:
         assert(pDbAccess->GetDbNameType() == GetDbNameEnumByPrefix(PREFIX_TYPE));
     };
 
+    CCompositeKVCache(const CCompositeKVCache &other) {
+        operator=(other);
+    }
+
+    /**
+     * Copy-on-write copy: the data of other is frozen into a snapshot layer shared by both caches,
+     * and each cache writes its changes to its own mapData. A copy costs O(changes), not O(cache size).
+     */
+    CCompositeKVCache& operator=(const CCompositeKVCache &other) {
+        if (this == &other)
+            return *this;
+
+        other.Freeze();
+        pBase        = other.pBase;
+        pDbAccess    = other.pDbAccess;
+        mapData.clear();
+        spSnapshot   = other.spSnapshot;
+        pDbOpLogMap  = other.pDbOpLogMap;
+        is_calc_size = other.is_calc_size;
+        size         = other.size;
+        return *this;
+    }
+
     void SetBase(CCompositeKVCache *pBaseIn) {
         assert(pDbAccess == nullptr);
-        assert(mapData.empty());
+        assert(mapData.empty() && !spSnapshot);
         pBase = pBaseIn;
     };
 
@@ -526,11 +893,14 @@ public:
 
     bool IsCalcSize() const { return is_calc_size; }
 
-    uint32_t GetCacheSize() const {
-        return size;
+    // heap memory used by the cache, only counted by the cache on the db, see IsCalcSize()
+    uint64_t GetCacheSize() const {
+        return size + (spSnapshot ? spSnapshot->totalSize : 0);
     }
 
     bool GetTopNElements(const uint32_t maxNum, set<KeyType> &keys) {
+        static_assert(MapPolicy::IS_ORDERED, "GetTopNElements() needs the ordered map");
+        AddRangeAccessLog();
         // 1. Get all candidate elements.
         set<KeyType> expiredKeys;
         set<KeyType> candidateKeys;
@@ -553,6 +923,8 @@ public:
 
     // map<string, ValueType>
     bool GetAllElements(const KeyType &endKey, Map &elements) {
+        static_assert(MapPolicy::IS_ORDERED, "GetAllElements() of a key range needs the ordered map");
+        AddRangeAccessLog();
         set<KeyType> expiredKeys;
         if (!GetAllElements(endKey, elements, expiredKeys)) {
             // TODO: log
@@ -563,6 +935,7 @@ public:
     }
 
     bool GetAllElements(map<KeyType, ValueType> &elements) {
+        AddRangeAccessLog();
         set<KeyType> expiredKeys;
         if (!GetAllElements(expiredKeys, elements)) {
             // TODO: log
@@ -576,9 +949,10 @@ public:
         if (db_util::IsEmpty(key)) {
             return false;
         }
-        auto it = GetDataIt(key);
-        if (it != mapData.end() && !db_util::IsEmpty(it->second)) {
-            value = it->second;
+        AddAccessLog(key, false);
+        const ValueType *pValue = FindData(key);
+        if (pValue != nullptr && !db_util::IsEmpty(*pValue)) {
+            value = *pValue;
             return true;
         }
         return false;
@@ -588,6 +962,7 @@ public:
         if (db_util::IsEmpty(key)) {
             return false;
         }
+        AddAccessLog(key, true);
         auto it = GetDataIt(key);
         if (it == mapData.end()) {
             auto pEmptyValue = db_util::MakeEmptyValue<ValueType>();
@@ -605,14 +980,16 @@ public:
         if (db_util::IsEmpty(key)) {
             return false;
         }
-        auto it = GetDataIt(key);
-        return it != mapData.end() && !db_util::IsEmpty(it->second);
+        AddAccessLog(key, false);
+        const ValueType *pValue = FindData(key);
+        return pValue != nullptr && !db_util::IsEmpty(*pValue);
     }
 
     bool EraseData(const KeyType &key) {
         if (db_util::IsEmpty(key)) {
             return false;
         }
+        AddAccessLog(key, true);
         Iterator it = GetDataIt(key);
         if (it != mapData.end() && !db_util::IsEmpty(it->second)) {
             DecDataSize(it->second);
@@ -625,15 +1002,22 @@ public:
 
     void Clear() {
         mapData.clear();
+        spSnapshot.reset();
         size = 0;
     }
 
     void Flush() {
         assert(pBase != nullptr || pDbAccess != nullptr);
+        Materialize();
+        if (CDBFlushRecorder::pWriteSet != nullptr) {
+            for (const auto &item : mapData)
+                CDBFlushRecorder::pWriteSet->AddWrite(PREFIX_TYPE, dbk::GenDbKey(PREFIX_TYPE, item.first));
+        }
+
         if (pBase != nullptr) {
             assert(pDbAccess == nullptr);
-            for (auto it : mapData) {
-                pBase->mapData[it.first] = it.second;
+            for (const auto &item : mapData) {
+                pBase->mapData[item.first] = item.second;
             }
         } else if (pDbAccess != nullptr) {
             assert(pBase == nullptr);
@@ -676,23 +1060,112 @@ public:
         return pRet;
     }
 
-    CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType>* GetBasePtr() { return pBase; }
+    CCompositeKVCache* GetBasePtr() { return pBase; }
 
-    map<KeyType, ValueType>& GetMapData() { return mapData; };
+    // the snapshot layers are merged into mapData first, so iterators see all the data of the cache
+    Map& GetMapData() { AddRangeAccessLog(); Materialize(); return mapData; };
 private:
+    /** Immutable data of a cache frozen by a copy, shared by the copies */
+    struct CSnapshotLayer {
+        Map data;
+        std::shared_ptr<const CSnapshotLayer> spPrev;   // older layer
+        uint32_t depth     = 1;
+        uint64_t dataSize  = 0;                         // size of data
+        uint64_t totalSize = 0;                         // size of data and of the older layers
+
+        CSnapshotLayer(Map &dataIn, uint64_t dataSizeIn, const std::shared_ptr<const CSnapshotLayer> &spPrevIn)
+            : spPrev(spPrevIn), dataSize(dataSizeIn) {
+            data.swap(dataIn);
+            depth     = spPrev ? spPrev->depth + 1 : 1;
+            totalSize = spPrev ? spPrev->totalSize + dataSize : dataSize;
+
+            CDBCacheSnapshotStats::layers++;
+            CDBCacheSnapshotStats::entries += data.size();
+            CDBCacheSnapshotStats::bytes += dataSize;
+        }
+
+        ~CSnapshotLayer() {
+            CDBCacheSnapshotStats::layers--;
+            CDBCacheSnapshotStats::entries -= data.size();
+            CDBCacheSnapshotStats::bytes -= dataSize;
+        }
+
+        const ValueType* Find(const KeyType &key) const {
+            for (const CSnapshotLayer *pLayer = this; pLayer != nullptr; pLayer = pLayer->spPrev.get()) {
+                auto it = pLayer->data.find(key);
+                if (it != pLayer->data.end())
+                    return &it->second;
+            }
+            return nullptr;
+        }
+
+        // merge the layers into dataOut, the existing items and the newer layers win
+        void MergeTo(Map &dataOut) const {
+            for (const CSnapshotLayer *pLayer = this; pLayer != nullptr; pLayer = pLayer->spPrev.get()) {
+                for (const auto &item : pLayer->data)
+                    dataOut.emplace(item.first, item.second);
+            }
+        }
+    };
+
+    void Freeze() const {
+        if (mapData.empty())
+            return;
+
+        spSnapshot = std::make_shared<const CSnapshotLayer>(mapData, size, spSnapshot);
+        size       = 0;
+        if (spSnapshot->depth > MAX_DB_CACHE_SNAPSHOT_DEPTH) {
+            Map mergedData;
+            spSnapshot->MergeTo(mergedData);
+            spSnapshot = std::make_shared<const CSnapshotLayer>(mergedData, spSnapshot->totalSize, nullptr);
+        }
+    }
+
+    // the shadowed items of the snapshot are still counted in size, it's only an estimate
+    void Materialize() const {
+        if (!spSnapshot)
+            return;
+
+        spSnapshot->MergeTo(mapData);
+        size += spSnapshot->totalSize;
+        spSnapshot.reset();
+    }
+
+    // find the data for reading, a snapshot item is not copied to mapData
+    const ValueType* FindData(const KeyType &key) const {
+        if (spSnapshot && mapData.count(key) == 0) {
+            const ValueType *pValue = spSnapshot->Find(key);
+            if (pValue != nullptr)
+                return pValue;
+        }
+
+        Iterator it = GetDataIt(key);
+        return it != mapData.end() ? &it->second : nullptr;
+    }
+
     Iterator GetDataIt(const KeyType &key) const {
         Iterator it = mapData.find(key);
         if (it != mapData.end()) {
             return it;
-        } else if (pBase != nullptr) {
+        }
+
+        if (spSnapshot) {
+            // copy the snapshot item to mapData before it may be changed
+            const ValueType *pValue = spSnapshot->Find(key);
+            if (pValue != nullptr)
+                return AddDataToMap(key, *pValue);
+        }
+
+        if (pBase != nullptr) {
             // find key-value at base cache
+            CDBBaseReadLock baseLock;
             auto baseIt = pBase->GetDataIt(key);
             if (baseIt != pBase->mapData.end()) {
                 // the found key-value add to current mapData
                 return AddDataToMap(key, baseIt->second);
             }
         } else if (pDbAccess != NULL) {
-            // TODO: need to save the empty value to mapData for search performance?
+            // the absent keys are remembered by the db access, see CDBKeyFilter
             auto pDbValue = db_util::MakeEmptyValue<ValueType>();
             if (pDbAccess->GetData(PREFIX_TYPE, key, *pDbValue)) {
                 return AddDataToMap(key, *pDbValue);
@@ -710,8 +1183,10 @@ private:
         return newRet.first;
     }
 
+    // the size is the heap memory of mapData: the map node holding the item and the heap memory of the item
     inline void IncDataSize(const KeyType &keyIn, const ValueType &valueIn) const {
         if (is_calc_size) {
+            size += MapPolicy::template NodeUsage<KeyType, ValueType>();
             size += CalcDataSize(keyIn);
             size += CalcDataSize(valueIn);
         }
@@ -724,7 +1199,7 @@ private:
 
     inline void DecDataSize(const ValueType &valueIn) const {
         if (is_calc_size) {
-            uint32_t sz = CalcDataSize(valueIn);
+            uint64_t sz = CalcDataSize(valueIn);
             size = size > sz ? size - sz : 0;
         }
     }
@@ -732,17 +1207,18 @@ private:
     inline void UpdateDataSize(const ValueType &oldValue, const ValueType &newVvalue) const {
         if (is_calc_size) {
             size += CalcDataSize(newVvalue);
-            uint32_t oldSz = CalcDataSize(oldValue);
+            uint64_t oldSz = CalcDataSize(oldValue);
             size = size > oldSz ? size - oldSz : 0;
         }
     }
 
     template <typename Data>
-    inline uint32_t CalcDataSize(const Data &d) const {
-        return ::GetSerializeSize(d, SER_DISK, CLIENT_VERSION);
+    inline uint64_t CalcDataSize(const Data &d) const {
+        return db_util::GetDynamicMemSize(d);
     }
 
     bool GetTopNElements(const uint32_t maxNum, set<KeyType> &expiredKeys, set<KeyType> &keys) {
+        Materialize();
         if (!mapData.empty()) {
             uint32_t count = 0;
             auto iter      = mapData.begin();
@@ -763,6 +1239,7 @@ private:
         }
 
         if (pBase != nullptr) {
+            CDBBaseReadLock baseLock;
             return pBase->GetTopNElements(maxNum, expiredKeys, keys);
         } else if (pDbAccess != nullptr) {
             return pDbAccess->GetTopNElements(maxNum, PREFIX_TYPE, expiredKeys, keys);
@@ -773,6 +1250,7 @@ private:
 
     // map<string, ValueType>
     bool GetAllElements(const KeyType &endKey, Map &mapDataOut, set<KeyType> &expiredKeys) {
+        Materialize();
         if (!mapData.empty()) {
             for (auto iter = mapData.begin(); iter != mapData.end() && iter->first < endKey; iter++) {
                 if (!expiredKeys.count(iter->first) && !mapDataOut.count(iter->first)) { // check not got
@@ -786,6 +1264,7 @@ private:
         }
 
         if (pBase != nullptr) {
+            CDBBaseReadLock baseLock;
             return pBase->GetAllElements(endKey, mapDataOut, expiredKeys);
         } else if (pDbAccess != nullptr) {
             return pDbAccess->GetAllElements(PREFIX_TYPE, endKey, mapDataOut, expiredKeys);
@@ -795,6 +1274,7 @@ private:
     }
 
     bool GetAllElements(set<KeyType> &expiredKeys, map<KeyType, ValueType> &elements) {
+        Materialize();
         if (!mapData.empty()) {
             for (auto iter : mapData) {
                 if (db_util::IsEmpty(iter.second)) {
@@ -810,6 +1290,7 @@ private:
         }
 
         if (pBase != nullptr) {
+            CDBBaseReadLock baseLock;
             return pBase->GetAllElements(expiredKeys, elements);
         } else if (pDbAccess != nullptr) {
             return pDbAccess->GetAllElements(PREFIX_TYPE, expiredKeys, elements);
@@ -830,16 +1311,43 @@ private:
                 dbOpLog.Set(key, oldValue);
             #endif
             pDbOpLogMap->AddOpLog(PREFIX_TYPE, dbOpLog);
+
+            CDBOpLogMap *pRedoLogMap = pDbOpLogMap->GetRedoLogMap();
+            if (pRedoLogMap != nullptr) {
+                CDbOpLog redoLog;
+                if (pNewValue != nullptr)
+                    redoLog.Set(key, *pNewValue);
+                else
+                    redoLog.Set(key, *db_util::MakeEmptyValue<ValueType>());
+                pRedoLogMap->AddOpLog(PREFIX_TYPE, redoLog);
+            }
         }
 
     }
+
+    // a written key is read as well, its old value goes to the op log
+    inline void AddAccessLog(const KeyType &key, bool isWrite) const {
+        if (pDbOpLogMap != nullptr && pDbOpLogMap->GetAccessSet() != nullptr) {
+            CDBAccessSet *pAccessSet = pDbOpLogMap->GetAccessSet();
+            string dbKey             = dbk::GenDbKey(PREFIX_TYPE, key);
+            pAccessSet->AddRead(PREFIX_TYPE, dbKey);
+            if (isWrite)
+                pAccessSet->AddWrite(PREFIX_TYPE, dbKey);
+        }
+    }
+
+    inline void AddRangeAccessLog() const {
+        if (pDbOpLogMap != nullptr && pDbOpLogMap->GetAccessSet() != nullptr)
+            pDbOpLogMap->GetAccessSet()->AddRangeRead(PREFIX_TYPE);
+    }
 private:
-    mutable CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType> *pBase = nullptr;
+    mutable CCompositeKVCache *pBase = nullptr;
     CDBAccess *pDbAccess = nullptr;
-    mutable map<KeyType, ValueType> mapData;
+    mutable Map mapData;
+    mutable std::shared_ptr<const CSnapshotLayer> spSnapshot;
     CDBOpLogMap *pDbOpLogMap = nullptr;
     bool is_calc_size = false;
-    mutable uint32_t size = 0;
+    mutable uint64_t size = 0;
 };
 
 
@@ -891,15 +1399,16 @@ public:
         pDbOpLogMap = pDbOpLogMapIn;
     }
 
-    uint32_t GetCacheSize() const {
+    uint64_t GetCacheSize() const {
         if (!ptrData) {
             return 0;
         }
 
-        return ::GetSerializeSize(*ptrData, SER_DISK, CLIENT_VERSION);
+        return db_util::GetDynamicMemSize(ptrData);
     }
 
     bool GetData(ValueType &value) const {
+        AddAccessLog(false);
         auto ptr = GetDataPtr();
         if (ptr && !db_util::IsEmpty(*ptr)) {
             value = *ptr;
@@ -909,23 +1418,27 @@ public:
     }
 
     bool SetData(const ValueType &value) {
-        if (!ptrData) {
+        AddAccessLog(true);
+        // load the value of the base first, it's the old value of the op log
+        if (!GetDataPtr()) {
             ptrData = db_util::MakeEmptyValue<ValueType>();
         }
-        AddOpLog(*ptrData);
+        AddOpLog(*ptrData, value);
         *ptrData = value;
         return true;
     }
 
     bool HaveData() const {
+        AddAccessLog(false);
         auto ptr = GetDataPtr();
         return ptr && !db_util::IsEmpty(*ptr);
     }
 
     bool EraseData() {
+        AddAccessLog(true);
         auto ptr = GetDataPtr();
         if (ptr && !db_util::IsEmpty(*ptr)) {
-            AddOpLog(*ptr);
+            AddOpLog(*ptr, *db_util::MakeEmptyValue<ValueType>());
             db_util::SetEmpty(*ptr);
         }
         return true;
@@ -938,6 +1451,9 @@ public:
     void Flush() {
         assert(pBase != nullptr || pDbAccess != nullptr);
         if (ptrData) {
+            if (CDBFlushRecorder::pWriteSet != nullptr)
+                CDBFlushRecorder::pWriteSet->AddWrite(PREFIX_TYPE, "");
+
             if (pBase != nullptr) {
                 assert(pDbAccess == nullptr);
                 pBase->ptrData = ptrData;
@@ -973,6 +1489,7 @@ public:
         if (ptrData) {
             return ptrData;
         } else if (pBase != nullptr){
+            CDBBaseReadLock baseLock;
             auto ptr = pBase->GetDataPtr();
             if (ptr) {
                 ptrData = std::make_shared<ValueType>(*ptr);
@@ -991,14 +1508,29 @@ public:
     }
 
 private:
-    inline void AddOpLog(const ValueType &oldValue) {
+    inline void AddOpLog(const ValueType &oldValue, const ValueType &newValue) {
         if (pDbOpLogMap != nullptr) {
             CDbOpLog dbOpLog;
             dbOpLog.Set(oldValue);
             pDbOpLogMap->AddOpLog(PREFIX_TYPE, dbOpLog);
+
+            CDBOpLogMap *pRedoLogMap = pDbOpLogMap->GetRedoLogMap();
+            if (pRedoLogMap != nullptr) {
+                CDbOpLog redoLog;
+                redoLog.Set(newValue);
+                pRedoLogMap->AddOpLog(PREFIX_TYPE, redoLog);
+            }
         }
 
     }
+
+    inline void AddAccessLog(bool isWrite) const {
+        if (pDbOpLogMap != nullptr && pDbOpLogMap->GetAccessSet() != nullptr) {
+            pDbOpLogMap->GetAccessSet()->AddRead(PREFIX_TYPE, "");
+            if (isWrite)
+                pDbOpLogMap->GetAccessSet()->AddWrite(PREFIX_TYPE, "");
+        }
+    }
 private:
     mutable CSimpleKVCache<PREFIX_TYPE, ValueType> *pBase;
     CDBAccess *pDbAccess;
@@ -0,0 +1,161 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "dbkeyfilter.h"
+#include "leveldbwrapper.h"
+#include "commons/util/time.h"
+#include "logging.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+
+static const uint64_t MIN_BLOOM_FILTER_CAPACITY = 1 << 16;
+
+static inline uint64_t MixHash(uint64_t x) {
+    // splitmix64 finalizer, makes the second hash independent enough from the first one
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+CDBBloomFilter::CDBBloomFilter(uint64_t nCapacityIn) {
+    nCapacity  = std::max(nCapacityIn, (uint64_t)1);
+    nBitCount  = ((nCapacity * DB_BLOOM_FILTER_BITS_PER_KEY + 63) / 64) * 64;
+    nHashFuncs = std::max<uint32_t>(1, (uint32_t)std::lround(DB_BLOOM_FILTER_BITS_PER_KEY * 0.69));
+    vBits.assign(nBitCount / 64, 0);
+}
+
+void CDBBloomFilter::Insert(const std::string &key) {
+    uint64_t h1 = std::hash<std::string>()(key);
+    uint64_t h2 = MixHash(h1) | 1;
+    for (uint32_t i = 0; i < nHashFuncs; i++) {
+        uint64_t bit = (h1 + i * h2) % nBitCount;
+        vBits[bit >> 6] |= (uint64_t)1 << (bit & 63);
+    }
+    nKeys++;
+}
+
+bool CDBBloomFilter::MayContain(const std::string &key) const {
+    uint64_t h1 = std::hash<std::string>()(key);
+    uint64_t h2 = MixHash(h1) | 1;
+    for (uint32_t i = 0; i < nHashFuncs; i++) {
+        uint64_t bit = (h1 + i * h2) % nBitCount;
+        if ((vBits[bit >> 6] & ((uint64_t)1 << (bit & 63))) == 0)
+            return false;
+    }
+    return true;
+}
+
+bool CDBKeyFilter::IsAbsent(const dbk::PrefixType prefixType, const std::string &key, uint64_t &nReadEpoch) {
+    std::lock_guard<std::mutex> lock(mtx);
+    nReadEpoch = nWriteEpoch;
+    auto it = filters.find(prefixType);
+    if (it == filters.end())
+        return false;
+
+    CPrefixFilter &filter = it->second;
+    if (filter.spBloom && !filter.spBloom->MayContain(key)) {
+        filter.stats.bloom_skips++;
+        return true;
+    }
+    if (filter.negativeKeys.count(key)) {
+        filter.stats.negative_hits++;
+        return true;
+    }
+    return false;
+}
+
+void CDBKeyFilter::OnRead(const dbk::PrefixType prefixType, const std::string &key, bool found, uint64_t nReadEpoch) {
+    std::lock_guard<std::mutex> lock(mtx);
+    CPrefixFilter &filter = filters[prefixType];
+    if (found) {
+        filter.stats.hits++;
+        return;
+    }
+
+    filter.stats.misses++;
+    // the key may be written by a pending write, or have been written while it was read
+    if (nPendingWrites > 0 || nReadEpoch != nWriteEpoch || nMaxNegativeKeys == 0)
+        return;
+
+    // forget all the absent keys at once when full, cheaper than an LRU and the hot keys come back soon
+    if (filter.negativeKeys.size() >= nMaxNegativeKeys)
+        filter.negativeKeys.clear();
+    filter.negativeKeys.insert(key);
+}
+
+void CDBKeyFilter::OnWrite(const dbk::PrefixType prefixType, const std::string &key) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = filters.find(prefixType);
+    if (it == filters.end())
+        return;
+
+    CPrefixFilter &filter = it->second;
+    filter.negativeKeys.erase(key);
+    if (filter.spBloom)
+        filter.spBloom->Insert(key);
+}
+
+void CDBKeyFilter::BeginWrite() {
+    std::lock_guard<std::mutex> lock(mtx);
+    nPendingWrites++;
+    nWriteEpoch++;
+}
+
+void CDBKeyFilter::EndWrite() {
+    std::lock_guard<std::mutex> lock(mtx);
+    assert(nPendingWrites > 0);
+    nPendingWrites--;
+    nWriteEpoch++;
+}
+
+void CDBKeyFilter::SetMaxNegativeKeys(uint32_t nMaxKeys) {
+    std::lock_guard<std::mutex> lock(mtx);
+    nMaxNegativeKeys = nMaxKeys;
+    for (auto &item : filters) {
+        if (item.second.negativeKeys.size() > nMaxNegativeKeys)
+            item.second.negativeKeys.clear();
+    }
+}
+
+void CDBKeyFilter::EnableBloomFilter(const dbk::PrefixType prefixType, CLevelDBWrapper &db) {
+    int64_t nStart       = GetTimeMillis();
+    const string &prefix = dbk::GetKeyPrefix(prefixType);
+    std::vector<std::string> keys;
+    std::unique_ptr<leveldb::Iterator> pCursor(db.NewIterator());
+    for (pCursor->Seek(prefix); pCursor->Valid(); pCursor->Next()) {
+        leveldb::Slice slKey = pCursor->key();
+        if (!slKey.starts_with(prefix))
+            break;
+        keys.emplace_back(slKey.data(), slKey.size());
+    }
+
+    // leave room for the keys written later, a filter filled over its capacity only gets less selective
+    auto spBloom = std::make_shared<CDBBloomFilter>(std::max<uint64_t>(keys.size() * 2, MIN_BLOOM_FILTER_CAPACITY));
+    for (const auto &key : keys)
+        spBloom->Insert(key);
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        CPrefixFilter &filter = filters[prefixType];
+        filter.spBloom = spBloom;
+        filter.negativeKeys.clear();
+    }
+
+    LogPrint(BCLog::CDB, "loaded bloom filter of prefix %s, keys=%u, size=%uKB, %dms\n", prefix, keys.size(),
+             spBloom->GetMemorySize() >> 10, GetTimeMillis() - nStart);
+}
+
+void CDBKeyFilter::GetStats(std::map<dbk::PrefixType, CDBKeyFilterStats> &stats) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (const auto &item : filters) {
+        CDBKeyFilterStats &prefixStats = stats[item.first];
+        prefixStats               = item.second.stats;
+        prefixStats.negative_keys = item.second.negativeKeys.size();
+        prefixStats.bloom_keys    = item.second.spBloom ? item.second.spBloom->GetKeyCount() : 0;
+    }
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PERSIST_DBKEYFILTER_H
+#define PERSIST_DBKEYFILTER_H
+
+#include "dbconf.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class CLevelDBWrapper;
+
+/** -dbnegativecache default: max number of absent keys remembered per key prefix, 0 to disable */
+static const uint32_t DEFAULT_DB_NEGATIVE_CACHE_SIZE = 10000;
+
+/** Bits per key of the bloom filters, about 1% false positives at the filter's capacity */
+static const uint32_t DB_BLOOM_FILTER_BITS_PER_KEY = 10;
+
+/** In-memory bloom filter of the keys of one prefix in the db */
+class CDBBloomFilter {
+public:
+    CDBBloomFilter(uint64_t nCapacityIn);
+
+    void Insert(const std::string &key);
+    bool MayContain(const std::string &key) const;
+
+    uint64_t GetCapacity() const { return nCapacity; }
+    uint64_t GetKeyCount() const { return nKeys; }
+    uint64_t GetMemorySize() const { return vBits.capacity() * sizeof(uint64_t); }
+
+private:
+    std::vector<uint64_t> vBits;
+    uint64_t nBitCount;
+    uint64_t nCapacity;
+    uint64_t nKeys = 0;
+    uint32_t nHashFuncs;
+};
+
+struct CDBKeyFilterStats {
+    uint64_t hits          = 0;    // the keys read from the db
+    uint64_t misses        = 0;    // the keys not found in the db
+    uint64_t negative_hits = 0;    // the keys found absent by the negative cache
+    uint64_t bloom_skips   = 0;    // the keys found absent by the bloom filter
+    uint64_t negative_keys = 0;    // the keys in the negative cache
+    uint64_t bloom_keys    = 0;    // the keys inserted in the bloom filter, 0 without the filter
+};
+
+/**
+ * Keeps the lookups of the keys known to be absent from a db away from leveldb: a bounded cache of the
+ * missed keys of each prefix, and an optional bloom filter of the prefix's keys loaded at startup. Both
+ * are updated by the writes of CDBAccess, the only writer of its prefixes.
+ *
+ * The readers may run concurrently with a write: a missed key is only remembered if no write was pending,
+ * began or ended while it was read, the write epoch taken by IsAbsent() is passed back to OnRead().
+ */
+class CDBKeyFilter {
+public:
+    CDBKeyFilter(): nMaxNegativeKeys(DEFAULT_DB_NEGATIVE_CACHE_SIZE) {}
+
+    // true if the key is surely not in the db, nReadEpoch is set to the write epoch for OnRead()
+    bool IsAbsent(const dbk::PrefixType prefixType, const std::string &key, uint64_t &nReadEpoch);
+    void OnRead(const dbk::PrefixType prefixType, const std::string &key, bool found, uint64_t nReadEpoch);
+    void OnWrite(const dbk::PrefixType prefixType, const std::string &key);
+
+    // the writes between BeginWrite() and EndWrite() are not all in the db yet, they may nest
+    void BeginWrite();
+    void EndWrite();
+
+    class CWriteScope {
+    public:
+        CWriteScope(CDBKeyFilter &filterIn): filter(filterIn) { filter.BeginWrite(); }
+        ~CWriteScope() { filter.EndWrite(); }
+    private:
+        CDBKeyFilter &filter;
+    };
+
+    void SetMaxNegativeKeys(uint32_t nMaxKeys);
+    // load the keys of the prefix from the db into a new bloom filter
+    void EnableBloomFilter(const dbk::PrefixType prefixType, CLevelDBWrapper &db);
+
+    void GetStats(std::map<dbk::PrefixType, CDBKeyFilterStats> &stats) const;
+
+private:
+    struct CPrefixFilter {
+        std::unordered_set<std::string> negativeKeys;
+        std::shared_ptr<CDBBloomFilter> spBloom;
+        CDBKeyFilterStats stats;
+    };
+
+    mutable std::mutex mtx;
+    std::map<dbk::PrefixType, CPrefixFilter> filters;
+    uint32_t nMaxNegativeKeys;
+    uint32_t nPendingWrites = 0;
+    uint64_t nWriteEpoch    = 0;    // increased by each BeginWrite() and EndWrite()
+};
+
+#endif  // PERSIST_DBKEYFILTER_H
@@ -122,11 +122,22 @@ bool CDelegateDBCache::SetCandidateVotes(const CRegID &regId,
 }
 
 bool CDelegateDBCache::GetCandidateVotes(const CRegID &regId, vector<CCandidateReceivedVote> &candidateVotes) {
-    return regId2VoteCache.GetData(regId, candidateVotes);
+    CDBSharedValue<vector<CCandidateReceivedVote>> value;
+    if (!regId2VoteCache.GetData(regId, value))
+        return false;
+
+    candidateVotes = value.Get();
+    return true;
 }
 
 bool CDelegateDBCache::GetVoterList(map<CRegIDKey, vector<CCandidateReceivedVote>> &regId2Vote) {
-    return regId2VoteCache.GetAllElements(regId2Vote);
+    map<CRegIDKey, CDBSharedValue<vector<CCandidateReceivedVote>>> values;
+    if (!regId2VoteCache.GetAllElements(values))
+        return false;
+
+    for (const auto &item : values)
+        regId2Vote.emplace(item.first, item.second.Get());
+    return true;
 }
 
 bool CDelegateDBCache::Flush() {
@@ -139,7 +150,7 @@ bool CDelegateDBCache::Flush() {
     return true;
 }
 
-uint32_t CDelegateDBCache::GetCacheSize() const {
+uint64_t CDelegateDBCache::GetCacheSize() const {
     return  voteRegIdCache.GetCacheSize() +
             regId2VoteCache.GetCacheSize() +
             last_vote_height_cache.GetCacheSize() +
@@ -60,7 +60,7 @@ public:
     bool GetVoterList(map<CRegIDKey, vector<CCandidateReceivedVote>> &regId2Vote);
 
     bool Flush();
-    uint32_t GetCacheSize() const;
+    uint64_t GetCacheSize() const;
     void Clear();
 
     void SetBaseViewPtr(CDelegateDBCache *pBaseIn) {
@@ -91,7 +91,7 @@ public:
 /*  -------------------- -------------- --------------------------  ----------------------- -------------- */
     // vote{(uint64t)MAX - $votedBcoins}{$RegId} -> 1
     CCompositeKVCache<dbk::VOTE,       std::pair<string, CRegIDKey>,  uint8_t>                voteRegIdCache;
-    CCompositeKVCache<dbk::REGID_VOTE, CRegIDKey,         vector<CCandidateReceivedVote>> regId2VoteCache;
+    CCompositeKVCache<dbk::REGID_VOTE, CRegIDKey,         CDBSharedValue<vector<CCandidateReceivedVote>>> regId2VoteCache;
 
     CSimpleKVCache<dbk::LAST_VOTE_HEIGHT, CVarIntValue<uint32_t>> last_vote_height_cache;
     CSimpleKVCache<dbk::PENDING_DELEGATES, PendingDelegates> pending_delegates_cache;
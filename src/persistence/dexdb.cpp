@@ -6,7 +6,9 @@
 #include "dexdb.h"
 #include "entities/account.h"
 #include "entities/asset.h"
+#include "dbiterator.h"
 #include "main.h"
+#include "chainstatesnapshot.h"
 #include <optional>
 #include <functional>
 
@@ -33,16 +35,17 @@ void DEX_DB::BlockOrdersToJson(const BlockOrders &orders, Object &obj) {
     obj.push_back(Pair("orders", array));
 }
 
-shared_ptr<string> DEX_DB::ParseLastPos(const string &lastPosInfo, DEXBlockOrdersCache::KeyType &lastKey) {
+shared_ptr<string> DEX_DB::ParseLastPos(const CChainStateReadView &view, const string &lastPosInfo,
+                                        DEXBlockOrdersCache::KeyType &lastKey) {
 
     CDataStream ds(lastPosInfo, SER_DISK, CLIENT_VERSION);
     uint256 lastBlockHash;
     ds >> lastBlockHash >> lastKey;
     uint32_t lastHeight = DEX_DB::GetHeight(lastKey);
-    CBlockIndex *pBlockIndex = chainActive[lastHeight];
+    CBlockIndex *pBlockIndex = view[lastHeight];
     if (pBlockIndex == nullptr)
         return make_shared<string>(strprintf("The last_pos_info is not contained in active chains,"
-            " last_height=%d, tip_height=%d", lastHeight, chainActive.Height()));
+            " last_height=%d, tip_height=%d", lastHeight, view.Height()));
     if (pBlockIndex->GetBlockHash() != lastBlockHash)
         return make_shared<string>(strprintf("The block of height in last_pos_info does not match with the active block,"
             " height=%d, last_block_hash=%s, cur_height_block_hash=%s",
@@ -50,12 +53,13 @@ shared_ptr<string> DEX_DB::ParseLastPos(const string &lastPosInfo, DEXBlockOrder
     return nullptr;
 }
 
-shared_ptr<string> DEX_DB::MakeLastPos(const DEXBlockOrdersCache::KeyType &lastKey, string &lastPosInfo) {
+shared_ptr<string> DEX_DB::MakeLastPos(const CChainStateReadView &view, const DEXBlockOrdersCache::KeyType &lastKey,
+                                       string &lastPosInfo) {
     uint32_t lastHeight = DEX_DB::GetHeight(lastKey);
-    CBlockIndex *pBlockIndex = chainActive[lastHeight];
+    CBlockIndex *pBlockIndex = view[lastHeight];
     if (pBlockIndex == nullptr)
         return make_shared<string>(strprintf("The block of lastKey is not contained in active chains,"
-            " last_height=%d, tip_height=%d", lastHeight, chainActive.Height()));
+            " last_height=%d, tip_height=%d", lastHeight, view.Height()));
 
     CDataStream ds(SER_DISK, CLIENT_VERSION);
     ds << pBlockIndex->GetBlockHash() << lastKey;
@@ -377,9 +381,125 @@ void CDEXSysOrdersGetter::ToJson(Object &obj) {
     DEX_DB::BlockOrdersToJson(orders, obj);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// class CDEXOrderBook
+
+void CDEXOrderBook::SetOrder(const uint256 &orderId, const CDEXOrderDetail &order) {
+    EraseOrder(orderId);
+    if (order.IsEmpty() || order.order_type != ORDER_LIMIT_PRICE || order.asset_amount <= order.total_deal_asset_amount)
+        return;
+
+    CBookOrder &bookOrder  = bookOrders[orderId];
+    bookOrder.trading_pair = CAssetTradingPair(order.asset_symbol, order.coin_symbol);
+    bookOrder.order_side   = order.order_side;
+    bookOrder.price        = order.price;
+    bookOrder.tx_cord      = order.tx_cord;
+    bookOrder.asset_amount = order.asset_amount - order.total_deal_asset_amount;
+
+    CPairBook &pairBook   = pairBooks[bookOrder.trading_pair];
+    CDEXPriceLevel &level = (order.order_side == ORDER_BUY ? pairBook.bids : pairBook.asks)[order.price];
+    level.asset_amount += bookOrder.asset_amount;
+    level.orders.emplace(order.tx_cord, orderId);
+}
+
+void CDEXOrderBook::EraseOrder(const uint256 &orderId) {
+    auto orderIt = bookOrders.find(orderId);
+    if (orderIt == bookOrders.end())
+        return;
+
+    const CBookOrder &bookOrder = orderIt->second;
+    auto pairIt                 = pairBooks.find(bookOrder.trading_pair);
+    assert(pairIt != pairBooks.end());
+    PriceLevels &levels = bookOrder.order_side == ORDER_BUY ? pairIt->second.bids : pairIt->second.asks;
+    auto levelIt        = levels.find(bookOrder.price);
+    assert(levelIt != levels.end());
+
+    levelIt->second.asset_amount -= bookOrder.asset_amount;
+    levelIt->second.orders.erase(make_pair(bookOrder.tx_cord, orderId));
+    if (levelIt->second.orders.empty())
+        levels.erase(levelIt);
+    if (pairIt->second.bids.empty() && pairIt->second.asks.empty())
+        pairBooks.erase(pairIt);
+
+    bookOrders.erase(orderIt);
+}
+
+void CDEXOrderBook::Clear() {
+    pairBooks.clear();
+    bookOrders.clear();
+}
+
+const CDEXOrderBook::CPairBook *CDEXOrderBook::GetPairBook(const CAssetTradingPair &tradingPair) const {
+    auto it = pairBooks.find(tradingPair);
+    return it != pairBooks.end() ? &it->second : nullptr;
+}
+
+template <typename LevelIt>
+static Array PriceLevelsToJson(LevelIt begin, LevelIt end, uint32_t maxDepth, bool withOrders) {
+    Array levelArray;
+    for (auto it = begin; it != end && levelArray.size() < maxDepth; it++) {
+        Object levelObj;
+        levelObj.push_back(Pair("price", it->first));
+        levelObj.push_back(Pair("asset_amount", it->second.asset_amount));
+        levelObj.push_back(Pair("order_count", (uint64_t)it->second.orders.size()));
+        if (withOrders) {
+            Array orderArray;
+            for (const auto &item : it->second.orders)
+                orderArray.push_back(item.second.ToString());
+            levelObj.push_back(Pair("orders", orderArray));
+        }
+        levelArray.push_back(levelObj);
+    }
+    return levelArray;
+}
+
+void CDEXOrderBook::ToJson(const CAssetTradingPair &tradingPair, uint32_t maxDepth, bool withOrders,
+                           Object &obj) const {
+    static const PriceLevels emptyLevels;
+    const CPairBook *pPairBook = GetPairBook(tradingPair);
+    const PriceLevels &bids    = pPairBook ? pPairBook->bids : emptyLevels;
+    const PriceLevels &asks    = pPairBook ? pPairBook->asks : emptyLevels;
+
+    obj.push_back(Pair("coin_symbol", tradingPair.quote_asset_symbol));
+    obj.push_back(Pair("asset_symbol", tradingPair.base_asset_symbol));
+    obj.push_back(Pair("bid_level_count", (uint64_t)bids.size()));
+    obj.push_back(Pair("ask_level_count", (uint64_t)asks.size()));
+    obj.push_back(Pair("bids", PriceLevelsToJson(bids.rbegin(), bids.rend(), maxDepth, withOrders)));
+    obj.push_back(Pair("asks", PriceLevelsToJson(asks.begin(), asks.end(), maxDepth, withOrders)));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // class CDexDBCache
 
+bool CDexDBCache::Flush() {
+    // the active orders flushed into the top level cache change its order book
+    if (pBaseCache != nullptr && pBaseCache->pBaseCache == nullptr) {
+        for (const auto &item : activeOrderCache.GetMapData())
+            pBaseCache->orderBook.SetOrder(item.first, item.second);
+    }
+
+    activeOrderCache.Flush();
+    blockOrdersCache.Flush();
+    operator_detail_cache.Flush(),
+    operator_owner_map_cache.Flush();
+    operator_last_id_cache.Flush();
+    operator_trade_pair_cache.Flush();
+    return true;
+}
+
+bool CDexDBCache::LoadOrderBook() {
+    assert(pBaseCache == nullptr && "only support top level cache");
+    int64_t nStart = GetTimeMillis();
+    orderBook.Clear();
+    CDBIterator<decltype(activeOrderCache)> dbIt(activeOrderCache);
+    for (dbIt.First(); dbIt.IsValid(); dbIt.Next())
+        orderBook.SetOrder(dbIt.GetKey(), dbIt.GetValue());
+
+    LogPrint(BCLog::INFO, "Loaded the dex order book, %u limit price orders of %u trading pairs (%dms)\n",
+             orderBook.GetOrderCount(), orderBook.GetPairCount(), GetTimeMillis() - nStart);
+    return true;
+}
+
 bool CDexDBCache::GetActiveOrder(const uint256 &orderId, CDEXOrderDetail &activeOrder) {
     return activeOrderCache.GetData(orderId, activeOrder);
 }
@@ -6,8 +6,10 @@
 #ifndef PERSIST_DEX_H
 #define PERSIST_DEX_H
 
+#include <map>
 #include <string>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "commons/serialize.h"
@@ -19,6 +21,8 @@
 
 using namespace std;
 
+class CChainStateReadView;
+
 /*       type               prefixType                   key                            value                type             */
 /*  ----------------   -------------------------  ---------------------------       ------------------   ------------------------ */
     /////////// DexDB
@@ -43,10 +47,12 @@ namespace DEX_DB {
         return std::get<2>(key);
     }
 
-    // return err str if err happens
-    shared_ptr<string> ParseLastPos(const string &lastPosInfo, DEXBlockOrdersCache::KeyType &lastKey);
+    // return err str if err happens, the block of the position must be in the chain of the view
+    shared_ptr<string> ParseLastPos(const CChainStateReadView &view, const string &lastPosInfo,
+                                    DEXBlockOrdersCache::KeyType &lastKey);
 
-    shared_ptr<string> MakeLastPos(const DEXBlockOrdersCache::KeyType &lastKey, string &lastPosInfo);
+    shared_ptr<string> MakeLastPos(const CChainStateReadView &view, const DEXBlockOrdersCache::KeyType &lastKey,
+                                   string &lastPosInfo);
 
     void OrderToJson(const uint256 &orderId, const dex::CDEXOrderDetail &order, Object &obj);
 
@@ -88,6 +94,55 @@ public:
     void ToJson(Object &obj);
 };
 
+// the active limit price orders at a price of the order book
+struct CDEXPriceLevel {
+    uint64_t asset_amount = 0;                  //!< the remaining asset amount of the orders
+    set<pair<CTxCord, uint256>> orders;         //!< tx cord, order id, in the order of the txs
+};
+
+/**
+ * In-memory order book of the active limit price orders of a top level dex cache: price levels per trading
+ * pair (asset, coin) and order side. The orders created, dealt or canceled by the txs and the ones rolled back
+ * by DisconnectBlock() follow the active orders flushed into the cache, the market price orders are not kept.
+ */
+class CDEXOrderBook {
+public:
+    typedef map<uint64_t, CDEXPriceLevel> PriceLevels;  // price -> level, the bids are read from the end
+
+    struct CPairBook {
+        PriceLevels bids;
+        PriceLevels asks;
+    };
+
+private:
+    // the order kept by the book, to find its level when it changes
+    struct CBookOrder {
+        CAssetTradingPair trading_pair;
+        dex::OrderSide order_side = dex::ORDER_BUY;
+        uint64_t price            = 0;
+        CTxCord tx_cord;
+        uint64_t asset_amount     = 0;
+    };
+
+    map<CAssetTradingPair, CPairBook> pairBooks;
+    unordered_map<uint256, CBookOrder, CUint256Hasher> bookOrders;
+
+public:
+    // set the active order of the id, an empty order or a market price order is removed from the book
+    void SetOrder(const uint256 &orderId, const dex::CDEXOrderDetail &order);
+    void Clear();
+
+    const CPairBook *GetPairBook(const CAssetTradingPair &tradingPair) const;
+    size_t GetOrderCount() const { return bookOrders.size(); }
+    size_t GetPairCount() const { return pairBooks.size(); }
+
+    // the levels of the pair closest to the spread, at most maxDepth of each side
+    void ToJson(const CAssetTradingPair &tradingPair, uint32_t maxDepth, bool withOrders, Object &obj) const;
+
+private:
+    void EraseOrder(const uint256 &orderId);
+};
+
 class CDexDBCache {
 public:
     CDexDBCache() {}
@@ -99,6 +154,19 @@ public:
           operator_trade_pair_cache(pDbAccess),
           operator_last_id_cache(pDbAccess) {};
 
+    // the copies share the data of the caches, not the order book of the top level cache, which is only
+    // kept by the node's cache
+    CDexDBCache(const CDexDBCache &other) { *this = other; }
+    CDexDBCache &operator=(const CDexDBCache &other) {
+        activeOrderCache          = other.activeOrderCache;
+        blockOrdersCache          = other.blockOrdersCache;
+        operator_detail_cache     = other.operator_detail_cache;
+        operator_owner_map_cache  = other.operator_owner_map_cache;
+        operator_trade_pair_cache = other.operator_trade_pair_cache;
+        operator_last_id_cache    = other.operator_last_id_cache;
+        pBaseCache                = other.pBaseCache;
+        return *this;
+    }
 
 public:
     bool GetActiveOrder(const uint256 &orderTxId, dex::CDEXOrderDetail& activeOrder);
@@ -116,17 +184,9 @@ public:
     bool UpdateDexOperator(const DexID &id, const DexOperatorDetail& old_detail,
         const DexOperatorDetail& detail);
 
-    bool Flush() {
-        activeOrderCache.Flush();
-        blockOrdersCache.Flush();
-        operator_detail_cache.Flush(),
-        operator_owner_map_cache.Flush();
-        operator_last_id_cache.Flush();
-        operator_trade_pair_cache.Flush();
-        return true;
-    }
+    bool Flush();
 
-    uint32_t GetCacheSize() const {
+    uint64_t GetCacheSize() const {
         return activeOrderCache.GetCacheSize() +
             blockOrdersCache.GetCacheSize() +
             operator_detail_cache.GetCacheSize() +
@@ -135,6 +195,7 @@ public:
             operator_trade_pair_cache.GetCacheSize();
     }
     void SetBaseViewPtr(CDexDBCache *pBaseIn) {
+        pBaseCache = pBaseIn;
         activeOrderCache.SetBase(&pBaseIn->activeOrderCache);
         blockOrdersCache.SetBase(&pBaseIn->blockOrdersCache);
         operator_detail_cache.SetBase(&pBaseIn->operator_detail_cache);
@@ -170,6 +231,13 @@ public:
         assert(blockOrdersCache.GetBasePtr() == nullptr && "only support top level cache");
         return make_shared<CDEXSysOrdersGetter>(blockOrdersCache);
     }
+
+    // load the order book of the top level cache from its active orders
+    bool LoadOrderBook();
+    const CDEXOrderBook &GetOrderBook() const {
+        assert(pBaseCache == nullptr && "only support top level cache");
+        return orderBook;
+    }
 private:
     DEXBlockOrdersCache::KeyType MakeBlockOrderKey(const uint256 &orderid, const dex::CDEXOrderDetail &activeOrder) {
         return make_tuple(CFixedUInt32(activeOrder.tx_cord.GetHeight()), (uint8_t)activeOrder.generate_type, orderid);
@@ -187,6 +255,9 @@ public:
 
     CSimpleKVCache<dbk::DEX_OPERATOR_LAST_ID, CVarIntValue<DexID>> operator_last_id_cache;
 
+private:
+    CDexDBCache *pBaseCache = nullptr;
+    CDEXOrderBook orderBook;    // only kept by the top level cache
 
 };
 
@@ -7,6 +7,15 @@
 #include "logging.h"
 #include "boost/filesystem.hpp"
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+CDiskFileMapper diskFileMapper;
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CBlockFileInfo
 
@@ -62,3 +71,106 @@ FILE *OpenDiskFile(const CDiskBlockPos &pos, const char *prefix, bool fReadOnly)
 FILE *OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly) {
     return OpenDiskFile(pos, "blk", fReadOnly);
 }
+
+////////////////////////////////////////////////////////////////////////////////
+// class CDiskFileMapper
+
+CDiskFileMapping::~CDiskFileMapping() {
+#ifndef WIN32
+    munmap((void *)pData, nSize);
+#endif
+}
+
+// map the whole file, nullptr if it can't be mapped
+static std::shared_ptr<const CDiskFileMapping> MapDiskFile(const boost::filesystem::path &path) {
+#ifdef WIN32
+    return nullptr;
+#else
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat st;
+    void *pData = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        pData = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pData == MAP_FAILED)
+        return nullptr;
+
+    return std::make_shared<CDiskFileMapping>((const char *)pData, (size_t)st.st_size);
+#endif
+}
+
+bool CDiskFileMapper::GetRecord(const CDiskBlockPos &pos, const char *prefix, uint32_t nTrailerSize,
+                                std::shared_ptr<const CDiskFileMapping> &spMapping, const char *&pRecord,
+                                uint32_t &nRecordSize) {
+    // the magic and the size of the record are written before it
+    if (!IsEnabled() || pos.IsNull() || pos.nPos < 8)
+        return false;
+
+    string fileName = strprintf("%s%05u.dat", prefix, pos.nFile);
+    spMapping       = GetMapping(fileName, pos.nPos);
+    if (spMapping) {
+        memcpy(&nRecordSize, spMapping->Data() + pos.nPos - sizeof(nRecordSize), sizeof(nRecordSize));
+        uint64_t nEnd = (uint64_t)pos.nPos + nRecordSize + nTrailerSize;
+        if (nEnd > spMapping->Size())
+            spMapping = GetMapping(fileName, nEnd);
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (!spMapping) {
+        nFallbacks++;
+        return false;
+    }
+
+    nHits++;
+    pRecord = spMapping->Data() + pos.nPos;
+    return true;
+}
+
+std::shared_ptr<const CDiskFileMapping> CDiskFileMapper::GetMapping(const string &fileName, uint64_t nMinSize) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = mapEntries.find(fileName);
+    if (it != mapEntries.end()) {
+        if (it->second->second->Size() >= nMinSize) {
+            lruList.splice(lruList.begin(), lruList, it->second);
+            return it->second->second;
+        }
+
+        // the file was appended after it was mapped
+        lruList.erase(it->second);
+        mapEntries.erase(it);
+    }
+
+    auto spMapping = MapDiskFile(GetDataDir() / "blocks" / fileName);
+    if (!spMapping || spMapping->Size() < nMinSize)
+        return nullptr;
+
+    nMaps++;
+    lruList.emplace_front(fileName, spMapping);
+    mapEntries[fileName] = lruList.begin();
+    while (mapEntries.size() > nMaxMappings) {
+        mapEntries.erase(lruList.back().first);
+        lruList.pop_back();
+    }
+    return spMapping;
+}
+
+void CDiskFileMapper::SetMaxMappings(size_t nMaxMappingsIn) {
+    std::lock_guard<std::mutex> lock(mtx);
+    nMaxMappings = nMaxMappingsIn;
+    while (mapEntries.size() > nMaxMappings) {
+        mapEntries.erase(lruList.back().first);
+        lruList.pop_back();
+    }
+}
+
+void CDiskFileMapper::GetStats(CDiskFileMapperStats &stats) {
+    std::lock_guard<std::mutex> lock(mtx);
+    stats.mappings     = mapEntries.size();
+    stats.max_mappings = nMaxMappings;
+    stats.hits         = nHits;
+    stats.maps         = nMaps;
+    stats.fallbacks    = nFallbacks;
+}
@@ -9,6 +9,12 @@
 #include "commons/util/util.h"
 #include "commons/serialize.h"
 
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
 struct CDiskBlockPos {
     int32_t nFile;
     uint32_t nPos;
@@ -124,4 +130,70 @@ FILE *OpenDiskFile(const CDiskBlockPos &pos, const char *prefix, bool fReadOnly)
 /** Open a block file (blk?????.dat) */
 FILE *OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 
+/** -blockfilemmap default, the number of mapped files, 0 reads the files through stdio */
+static const int64_t DEFAULT_BLOCK_FILE_MMAP = 0;
+
+/** Read-only memory mapping of a whole block or undo file */
+class CDiskFileMapping {
+private:
+    const char *pData;
+    size_t nSize;
+
+public:
+    CDiskFileMapping(const char *pDataIn, size_t nSizeIn) : pData(pDataIn), nSize(nSizeIn) {}
+    ~CDiskFileMapping();
+
+    const char *Data() const { return pData; }
+    size_t Size() const { return nSize; }
+};
+
+struct CDiskFileMapperStats {
+    uint64_t mappings     = 0;
+    uint64_t max_mappings = 0;
+    uint64_t hits         = 0;  //!< records read from a mapping
+    uint64_t maps         = 0;  //!< files mapped, or mapped again after they grew
+    uint64_t fallbacks    = 0;  //!< records read through stdio as they could not be mapped
+};
+
+/**
+ * LRU of the read-only mappings of the block (blk?????.dat) and undo (rev?????.dat) files. The block and undo
+ * records are deserialized straight from the mapped pages, instead of opening the file and copying the record
+ * through stdio on every read. A file appended after it was mapped is mapped again once a record beyond the
+ * mapping is read.
+ */
+class CDiskFileMapper {
+private:
+    typedef std::pair<std::string, std::shared_ptr<const CDiskFileMapping>> Entry;  // file name -> mapping
+
+    std::mutex mtx;
+    std::list<Entry> lruList;  //!< most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> mapEntries;
+    std::atomic<size_t> nMaxMappings;
+    uint64_t nHits;
+    uint64_t nMaps;
+    uint64_t nFallbacks;
+
+public:
+    CDiskFileMapper() : nMaxMappings(DEFAULT_BLOCK_FILE_MMAP), nHits(0), nMaps(0), nFallbacks(0) {}
+
+    bool IsEnabled() const { return nMaxMappings > 0; }
+
+    /**
+     * Get the record written at pos of the file by its prefix, with the size written before it plus nTrailerSize
+     * bytes. The record stays valid as long as spMapping is held. Returns false if it isn't mapped, the caller
+     * reads the file then.
+     */
+    bool GetRecord(const CDiskBlockPos &pos, const char *prefix, uint32_t nTrailerSize,
+                   std::shared_ptr<const CDiskFileMapping> &spMapping, const char *&pRecord, uint32_t &nRecordSize);
+
+    /** 0 disables the mappings and unmaps the files */
+    void SetMaxMappings(size_t nMaxMappingsIn);
+    void GetStats(CDiskFileMapperStats &stats);
+
+private:
+    std::shared_ptr<const CDiskFileMapping> GetMapping(const std::string &fileName, uint64_t nMinSize);
+};
+
+extern CDiskFileMapper diskFileMapper;
+
 #endif //PERSIST_DISK_H
\ No newline at end of file
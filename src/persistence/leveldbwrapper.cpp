@@ -40,6 +40,30 @@ std::string CDBOpLogMap::ToString() const {
     return str;
 }
 
+bool CDBAccessSet::HasReadConflict(const CDBAccessSet &other) const {
+    for (const auto &item : other.writeKeys) {
+        if (rangeReads.count(item.first))
+            return true;
+
+        auto it = readKeys.find(item.first);
+        if (it == readKeys.end())
+            continue;
+
+        const auto &smaller = it->second.size() < item.second.size() ? it->second : item.second;
+        const auto &larger  = it->second.size() < item.second.size() ? item.second : it->second;
+        for (const auto &key : smaller) {
+            if (larger.count(key))
+                return true;
+        }
+    }
+    return false;
+}
+
+void CDBAccessSet::MergeWrites(const CDBAccessSet &other) {
+    for (const auto &item : other.writeKeys)
+        writeKeys[item.first].insert(item.second.begin(), item.second.end());
+}
+
 static leveldb::Options GetOptions(size_t nCacheSize) {
     leveldb::Options options;
     options.block_cache       = leveldb::NewLRUCache(nCacheSize / 2);
@@ -85,6 +109,24 @@ CLevelDBWrapper::~CLevelDBWrapper() {
     options.env = nullptr;
 }
 
+CLevelDBSnapshots::~CLevelDBSnapshots() {
+    for (auto &item : snapshots)
+        item.first->ReleaseSnapshot(item.second);
+}
+
+void CLevelDBSnapshots::Take(CLevelDBWrapper *pDb) {
+    if (Get(pDb) == nullptr)
+        snapshots.emplace_back(pDb, pDb->NewSnapshot());
+}
+
+const leveldb::Snapshot *CLevelDBSnapshots::Get(const CLevelDBWrapper *pDb) const {
+    for (const auto &item : snapshots) {
+        if (item.first == pDb)
+            return item.second;
+    }
+    return nullptr;
+}
+
 bool CLevelDBWrapper::WriteBatch(CLevelDBBatch &batch, bool fSync) {
     leveldb::Status status = pdb->Write(fSync ? syncoptions : writeoptions, &batch.batch);
     ThrowError(status);
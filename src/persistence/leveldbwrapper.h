@@ -16,6 +16,11 @@
 #include <leveldb/db.h>
 #include <leveldb/write_batch.h>
 
+#include <set>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 using namespace json_spirit;
 
 class CDbOpLog {
@@ -84,6 +89,33 @@ public:
 
 typedef vector<CDbOpLog> CDbOpLogs;
 
+/**
+ * The db keys read and written by the caches logging to a CDBOpLogMap, used by CTxParallelExecutor to
+ * find the txs whose speculative execution read the writes of the txs committed before them. A range
+ * read of a prefix conflicts with any write to the prefix.
+ */
+class CDBAccessSet {
+public:
+    void AddRead(dbk::PrefixType prefixType, const string &key) { readKeys[prefixType].insert(key); }
+    void AddWrite(dbk::PrefixType prefixType, const string &key) { writeKeys[prefixType].insert(key); }
+    void AddRangeRead(dbk::PrefixType prefixType) { rangeReads.insert(prefixType); }
+
+    // true if this set read any key written by the writes of other
+    bool HasReadConflict(const CDBAccessSet &other) const;
+    void MergeWrites(const CDBAccessSet &other);
+
+    void Clear() {
+        readKeys.clear();
+        writeKeys.clear();
+        rangeReads.clear();
+    }
+
+private:
+    map<dbk::PrefixType, std::unordered_set<string>> readKeys;
+    map<dbk::PrefixType, std::unordered_set<string>> writeKeys;
+    std::set<dbk::PrefixType> rangeReads;
+};
+
 class CDBOpLogMap {
 public:
     map<string, CDbOpLogs>& GetMap() { return mapDbOpLogs; }
@@ -106,6 +138,13 @@ public:
 
     void Clear() { mapDbOpLogs.clear(); }
 
+    // the keys accessed by the caches logging to this map are recorded too when set, not serialized
+    void SetAccessSet(CDBAccessSet *pAccessSetIn) { pAccessSet = pAccessSetIn; }
+    CDBAccessSet* GetAccessSet() const { return pAccessSet; }
+    // the new values written by the caches logging to this map are logged to the redo map too when set
+    void SetRedoLogMap(CDBOpLogMap *pRedoLogMapIn) { pRedoLogMap = pRedoLogMapIn; }
+    CDBOpLogMap* GetRedoLogMap() const { return pRedoLogMap; }
+
     std::string ToString() const;
 public:
     IMPLEMENT_SERIALIZE(
@@ -113,6 +152,8 @@ public:
 	)
 private:
     mutable map<string, CDbOpLogs> mapDbOpLogs; // dbName -> dbOpLogs
+    CDBAccessSet *pAccessSet = nullptr;
+    CDBOpLogMap *pRedoLogMap = nullptr;
 };
 
 class leveldb_error : public runtime_error
@@ -147,6 +188,46 @@ public:
 
  };
 
+class CLevelDBWrapper;
+
+/** Leveldb snapshots of a set of dbs, taken together and released when destroyed */
+class CLevelDBSnapshots {
+public:
+    CLevelDBSnapshots() {}
+    ~CLevelDBSnapshots();
+
+    CLevelDBSnapshots(const CLevelDBSnapshots &) = delete;
+    CLevelDBSnapshots &operator=(const CLevelDBSnapshots &) = delete;
+
+    // take the snapshot of the db, once per db
+    void Take(CLevelDBWrapper *pDb);
+    // the snapshot of the db, nullptr if none was taken
+    const leveldb::Snapshot *Get(const CLevelDBWrapper *pDb) const;
+
+private:
+    std::vector<std::pair<CLevelDBWrapper *, const leveldb::Snapshot *>> snapshots;
+};
+
+/**
+ * Makes the db reads of the current thread read the snapshots while in scope: the reads and iterators of
+ * the dbs in the snapshots see the dbs as they were when the snapshots were taken.
+ */
+class CLevelDBSnapshotReader {
+public:
+    CLevelDBSnapshotReader(const CLevelDBSnapshots *pSnapshotsIn) : pPrevSnapshots(pSnapshots) {
+        pSnapshots = pSnapshotsIn;
+    }
+    ~CLevelDBSnapshotReader() { pSnapshots = pPrevSnapshots; }
+
+    CLevelDBSnapshotReader(const CLevelDBSnapshotReader &) = delete;
+    CLevelDBSnapshotReader &operator=(const CLevelDBSnapshotReader &) = delete;
+
+    static inline thread_local const CLevelDBSnapshots *pSnapshots = nullptr;
+
+private:
+    const CLevelDBSnapshots *pPrevSnapshots;
+};
+
 class CLevelDBWrapper {
 private:
     // custom environment this database is using (may be NULL in case of default environment)
@@ -170,6 +251,16 @@ private:
     // the database itself
     leveldb::DB *pdb;
 
+    // the read options of the current thread, with its snapshot of this db if any
+    const leveldb::ReadOptions &GetReadOptions(const leveldb::ReadOptions &options,
+                                               leveldb::ReadOptions &snapshotOptions) const {
+        if (CLevelDBSnapshotReader::pSnapshots == nullptr)
+            return options;
+        snapshotOptions          = options;
+        snapshotOptions.snapshot = CLevelDBSnapshotReader::pSnapshots->Get(this);
+        return snapshotOptions;
+    }
+
 public:
     CLevelDBWrapper(const boost::filesystem::path &path, size_t nCacheSize, bool fMemory = false, bool fWipe = false);
     ~CLevelDBWrapper();
@@ -179,7 +270,8 @@ public:
     	leveldb::Slice slKey(key);
 
         string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        leveldb::ReadOptions snapshotOptions;
+        leveldb::Status status = pdb->Get(GetReadOptions(readoptions, snapshotOptions), slKey, &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
                 return false;
@@ -205,7 +297,8 @@ public:
     bool Exists(const std::string &key) {
     	leveldb::Slice slKey(key);
         string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        leveldb::ReadOptions snapshotOptions;
+        leveldb::Status status = pdb->Get(GetReadOptions(readoptions, snapshotOptions), slKey, &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
                 return false;
@@ -235,8 +328,12 @@ public:
 
     // not exactly clean encapsulation, but it's easiest for now
     leveldb::Iterator *NewIterator() {
-        return pdb->NewIterator(iteroptions);
+        leveldb::ReadOptions snapshotOptions;
+        return pdb->NewIterator(GetReadOptions(iteroptions, snapshotOptions));
     }
+
+    const leveldb::Snapshot *NewSnapshot() { return pdb->GetSnapshot(); }
+    void ReleaseSnapshot(const leveldb::Snapshot *pSnapshot) { pdb->ReleaseSnapshot(pSnapshot); }
     int64_t GetDbCount();
    // Object ToJsonObj();
 };
@@ -32,7 +32,7 @@ public:
 
     void Flush();
 
-    uint32_t GetCacheSize() const { return executeFailCache.GetCacheSize(); }
+    uint64_t GetCacheSize() const { return executeFailCache.GetCacheSize(); }
 
     void SetBaseViewPtr(CLogDBCache *pBaseIn) { executeFailCache.SetBase(&pBaseIn->executeFailCache); }
 
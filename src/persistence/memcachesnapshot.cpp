@@ -0,0 +1,117 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "memcachesnapshot.h"
+
+#include "cachewrapper.h"
+#include "commons/random.h"
+#include "commons/util/util.h"
+#include "config/chainparams.h"
+#include "crypto/hash.h"
+#include "main.h"
+
+#include <boost/filesystem.hpp>
+
+bool CMemCacheSnapshot::Take(CCacheDBManager &cdMan) {
+    tipHash = cdMan.pBlockCache->GetBestBlockHash();
+    auto it = mapBlockIndex.find(tipHash);
+    if (it == mapBlockIndex.end())
+        return ERRORMSG("%s : best block %s not found", __func__, tipHash.ToString());
+
+    tipHeight = it->second->height;
+    blockTxids.clear();
+    blockPrices.clear();
+    cdMan.pTxCache->GetBlockTxids(tipHeight - SysCfg().GetTxCacheHeight() + 1, blockTxids);
+    // the price points of the latest 11 blocks, see ConnectBlock()
+    cdMan.pPpCache->GetBlockPrices(tipHeight - 11 + 1, blockPrices);
+    return true;
+}
+
+CMemCacheSnapshotDB::CMemCacheSnapshotDB() { pathSnapshot = GetDataDir() / "memcache.dat"; }
+
+bool CMemCacheSnapshotDB::Write(const CMemCacheSnapshot &snapshot) {
+    string tmpfn = strprintf("memcache.dat.%04x", GetRand(0x10000));
+
+    // serialize the snapshot, checksum data up to that point, then append csum
+    CDataStream ssSnapshot(SER_DISK, CLIENT_VERSION);
+    ssSnapshot << FLATDATA(SysCfg().MessageStart());
+    ssSnapshot << snapshot;
+    uint256 hash = Hash(ssSnapshot.begin(), ssSnapshot.end());
+    ssSnapshot << hash;
+
+    boost::filesystem::path pathTmp = GetDataDir() / tmpfn;
+    FILE* file                      = fopen(pathTmp.string().c_str(), "wb");
+    CAutoFile fileout               = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!fileout)
+        return ERRORMSG("%s : Failed to open file %s", __func__, pathTmp.string());
+
+    try {
+        fileout << ssSnapshot;
+    } catch (std::exception& e) {
+        return ERRORMSG("%s : Serialize or I/O error - %s", __func__, e.what());
+    }
+    FileCommit(fileout);
+    fileout.fclose();
+
+    // replace the existing memcache.dat, if any
+    if (!RenameOver(pathTmp, pathSnapshot))
+        return ERRORMSG("%s : Rename-into-place failed", __func__);
+
+    return true;
+}
+
+bool CMemCacheSnapshotDB::Read(CMemCacheSnapshot &snapshot) {
+    if (!boost::filesystem::exists(pathSnapshot))
+        return false;
+
+    FILE* file       = fopen(pathSnapshot.string().c_str(), "rb");
+    CAutoFile filein = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!filein)
+        return ERRORMSG("%s : Failed to open file %s", __func__, pathSnapshot.string());
+
+    int64_t dataSize = boost::filesystem::file_size(pathSnapshot) - sizeof(uint256);
+    if (dataSize < 0)
+        dataSize = 0;
+    vector<uint8_t> vchData;
+    vchData.resize(dataSize);
+    uint256 hashIn;
+
+    try {
+        filein.read((char*)vchData.data(), dataSize);
+        filein >> hashIn;
+    } catch (std::exception& e) {
+        return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+    filein.fclose();
+
+    CDataStream ssSnapshot(vchData, SER_DISK, CLIENT_VERSION);
+    uint256 hashTmp = Hash(ssSnapshot.begin(), ssSnapshot.end());
+    if (hashIn != hashTmp)
+        return ERRORMSG("%s : Checksum mismatch, data corrupted", __func__);
+
+    uint8_t pchMsgTmp[4];
+    try {
+        ssSnapshot >> FLATDATA(pchMsgTmp);
+        if (memcmp(pchMsgTmp, SysCfg().MessageStart(), sizeof(pchMsgTmp)))
+            return ERRORMSG("%s : Invalid network magic number", __func__);
+
+        ssSnapshot >> snapshot;
+    } catch (std::exception& e) {
+        return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+
+    return true;
+}
+
+bool WriteMemCacheSnapshot(CCacheDBManager &cdMan) {
+    int64_t nStart = GetTimeMillis();
+    CMemCacheSnapshot snapshot;
+    if (!snapshot.Take(cdMan) || !CMemCacheSnapshotDB().Write(snapshot))
+        return false;
+
+    LogPrint(BCLog::CDB, "write the memory cache snapshot at block [%d]: %s, %u blocks of txids, %u coin pairs of "
+             "prices (%dms)\n", snapshot.tipHeight, snapshot.tipHash.ToString(), snapshot.blockTxids.size(),
+             snapshot.blockPrices.size(), GetTimeMillis() - nStart);
+    return true;
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PERSIST_MEMCACHE_SNAPSHOT_H
+#define PERSIST_MEMCACHE_SNAPSHOT_H
+
+#include "commons/serialize.h"
+#include "commons/uint256.h"
+#include "pricefeeddb.h"
+
+#include <boost/filesystem/path.hpp>
+#include <map>
+#include <vector>
+
+using namespace std;
+
+class CCacheDBManager;
+
+/** -memcachesnapshot default */
+static const bool DEFAULT_MEMCACHE_SNAPSHOT = true;
+
+/** Min interval of the snapshot writes by the chain state flushes, in seconds */
+static const int64_t MEMCACHE_SNAPSHOT_INTERVAL = 60;
+
+/**
+ * Snapshot of the memory caches of the latest blocks, the txids of CTxMemCache and the price points of
+ * CPricePointMemCache, at the best block of the state db. The startup loads it instead of reading the
+ * latest blocks back from disk, and only reads the blocks connected after the snapshot.
+ */
+class CMemCacheSnapshot {
+public:
+    uint256 tipHash;
+    int32_t tipHeight = 0;
+    map<int32_t, vector<uint256>> blockTxids;   // height -> txids
+    CoinPricePointMap blockPrices;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(tipHash);
+        READWRITE(tipHeight);
+        READWRITE(blockTxids);
+        READWRITE(blockPrices);
+    )
+
+    // take the snapshot of the node's caches, their best block must be in mapBlockIndex
+    bool Take(CCacheDBManager &cdMan);
+};
+
+/** Access to the snapshot file (memcache.dat) */
+class CMemCacheSnapshotDB {
+private:
+    boost::filesystem::path pathSnapshot;
+
+public:
+    CMemCacheSnapshotDB();
+    bool Write(const CMemCacheSnapshot &snapshot);
+    bool Read(CMemCacheSnapshot &snapshot);
+};
+
+/** Write the snapshot of the node's memory caches, after their state db has been flushed */
+bool WriteMemCacheSnapshot(CCacheDBManager &cdMan);
+
+#endif  // PERSIST_MEMCACHE_SNAPSHOT_H
@@ -81,6 +81,15 @@ bool CPricePointMemCache::AddPriceByBlock(const CBlock &block) {
     return true;
 }
 
+bool CPricePointMemCache::AddPriceByBlock(const CBlockSummary &summary) {
+    for (const auto &pTx : summary.priceFeedTxs) {
+        CPriceFeedTx *priceFeedTx = (CPriceFeedTx *)pTx.get();
+        AddPrice(summary.height, priceFeedTx->txUid.get<CRegID>(), priceFeedTx->price_points);
+    }
+
+    return true;
+}
+
 bool CPricePointMemCache::DeleteBlockPricePoint(const int32_t blockHeight) {
     if (mapCoinPricePointCache.empty()) {
         // TODO: multi stable coin
@@ -97,6 +106,8 @@ bool CPricePointMemCache::DeleteBlockPricePoint(const int32_t blockHeight) {
 
 bool CPricePointMemCache::DeleteBlockFromCache(const CBlock &block) { return DeleteBlockPricePoint(block.GetHeight()); }
 
+bool CPricePointMemCache::DeleteBlockFromCache(const int32_t blockHeight) { return DeleteBlockPricePoint(blockHeight); }
+
 void CPricePointMemCache::BatchWrite(const CoinPricePointMap &mapCoinPricePointCacheIn) {
     for (const auto &item : mapCoinPricePointCacheIn) {
         // map<int32_t /* block height */, map<CRegID, uint64_t /* price */>>
@@ -127,6 +138,23 @@ void CPricePointMemCache::Flush() {
     mapCoinPricePointCache.clear();
 }
 
+void CPricePointMemCache::GetBlockPrices(const int32_t fromHeight, CoinPricePointMap &blockPrices) const {
+    for (const auto &item : mapCoinPricePointCache) {
+        const auto &mapBlockUserPrices = item.second.mapBlockUserPrices;
+        for (auto it = mapBlockUserPrices.lower_bound(fromHeight); it != mapBlockUserPrices.end(); ++it) {
+            if (!it->second.empty())
+                blockPrices[item.first].mapBlockUserPrices.insert(*it);
+        }
+    }
+}
+
+uint64_t CPricePointMemCache::GetCacheSize() const {
+    uint64_t ret = memusage::DynamicUsage(mapCoinPricePointCache) + db_util::GetDynamicMemSize(latest_median_prices);
+    for (const auto &item : mapCoinPricePointCache)
+        ret += db_util::GetDynamicMemSize(item.first) + db_util::GetDynamicMemSize(item.second.mapBlockUserPrices);
+    return ret;
+}
+
 bool CPricePointMemCache::GetBlockUserPrices(const CoinPricePair &coinPricePair, set<int32_t> &expired,
                                              BlockUserPriceMap &blockUserPrices) {
     const auto &iter = mapCoinPricePointCache.find(coinPricePair);
@@ -33,6 +33,10 @@ public:
     void DeleteUserPrice(const int32_t blockHeight);
     bool ExistBlockUserPrice(const int32_t blockHeight, const CRegID &regId);
 
+    IMPLEMENT_SERIALIZE(
+        READWRITE(mapBlockUserPrices);
+    )
+
 public:
     BlockUserPriceMap mapBlockUserPrices;
 };
@@ -46,14 +50,22 @@ public:
 public:
     bool AddPrice(const int32_t blockHeight, const CRegID &regId, const vector<CPricePoint> &pps);
     bool AddPriceByBlock(const CBlock &block);
+    bool AddPriceByBlock(const CBlockSummary &summary);
     // delete block price point by specific block height.
     bool DeleteBlockFromCache(const CBlock &block);
+    bool DeleteBlockFromCache(const int32_t blockHeight);
 
     bool CalcBlockMedianPrices(CCacheWrapper &cw, const int32_t blockHeight, PriceMap &medianPrices);
 
     void SetBaseViewPtr(CPricePointMemCache *pBaseIn);
     void Flush();
 
+    // the price points of the blocks from the height on, only for the cache without a base view
+    void GetBlockPrices(const int32_t fromHeight, CoinPricePointMap &blockPrices) const;
+    void AddBlockPrices(const CoinPricePointMap &blockPrices) { BatchWrite(blockPrices); }
+
+    uint64_t GetCacheSize() const;
+
 private:
     uint64_t GetMedianPrice(const int32_t blockHeight, const uint64_t slideWindow, const CoinPricePair &coinPricePair);
 
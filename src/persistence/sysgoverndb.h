@@ -34,7 +34,7 @@ public:
         return true;
     }
 
-    uint32_t GetCacheSize() const {
+    uint64_t GetCacheSize() const {
         return governersCache.GetCacheSize()
                + proposalsCache.GetCacheSize()
                + secondsCache.GetCacheSize();
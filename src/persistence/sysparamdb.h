@@ -95,7 +95,7 @@ public:
         return true;
     }
 
-    uint32_t GetCacheSize() const { return sysParamCache.GetCacheSize() + minerFeeCache.GetCacheSize(); }
+    uint64_t GetCacheSize() const { return sysParamCache.GetCacheSize() + minerFeeCache.GetCacheSize(); }
 
     void SetBaseViewPtr(CSysParamDBCache *pBaseIn) {
         sysParamCache.SetBase(&pBaseIn->sysParamCache);
@@ -15,52 +15,133 @@
 #include <algorithm>
 
 bool CTxMemCache::AddBlockTx(const CBlock &block) {
+    vector<uint256> blockTxids;
+    blockTxids.reserve(block.vptx.size());
     for (auto &ptx : block.vptx) {
-        txids.insert(ptx->GetHash());
+        blockTxids.push_back(ptx->GetHash());
     }
+
+    AddBlockTx(block.GetHeight(), blockTxids);
     return true;
 }
 
-bool CTxMemCache::RemoveBlockTx(const CBlock &block) {
-    for (auto &ptx : block.vptx) {
-        txids.erase(ptx->GetHash());
+bool CTxMemCache::AddBlockTx(const CBlockSummary &summary) {
+    AddBlockTx(summary.height, summary.txids);
+    return true;
+}
+
+void CTxMemCache::AddBlockTx(const int32_t blockHeight, const vector<uint256> &blockTxids) {
+    if (ring.empty()) {
+        int32_t cacheHeight = nCacheHeight > 0 ? nCacheHeight : SysCfg().GetTxCacheHeight();
+        // one more slot for the new block which is added before the oldest one is removed
+        ring.resize(std::max(cacheHeight, 0) + 1);
     }
+
+    // an expired block or a block at the same height is replaced
+    CBlockTxids &slot = ring[blockHeight % ring.size()];
+    EraseSlot(slot);
+
+    slot.height = blockHeight;
+    slot.txids  = blockTxids;
+    for (const auto &txid : slot.txids) {
+        txHeights[txid] = blockHeight;
+    }
+}
+
+bool CTxMemCache::RemoveBlockTx(const int32_t blockHeight) {
+    if (!ring.empty()) {
+        CBlockTxids &slot = ring[blockHeight % ring.size()];
+        if (slot.height == blockHeight)
+            EraseSlot(slot);
+    }
+
+    if (pBase != nullptr)
+        removedHeights.insert(blockHeight);
+
     return true;
 }
 
-bool CTxMemCache::HaveTx(const uint256 &txid) {
-    bool found = txids.count(txid) > 0;
-    if (found)
+void CTxMemCache::EraseSlot(CBlockTxids &slot) {
+    for (const auto &txid : slot.txids) {
+        auto it = txHeights.find(txid);
+        if (it != txHeights.end() && it->second == slot.height)
+            txHeights.erase(it);
+    }
+
+    // keep the capacity for the next block
+    slot.height = -1;
+    slot.txids.clear();
+}
+
+bool CTxMemCache::GetTxHeight(const uint256 &txid, int32_t &blockHeight) {
+    auto it = txHeights.find(txid);
+    if (it != txHeights.end()) {
+        blockHeight = it->second;
         return true;
-    else if (pBase == nullptr) {
+    }
+
+    if (pBase == nullptr || !pBase->GetTxHeight(txid, blockHeight))
         return false;
-    } else
-        return pBase->HaveTx(txid);
-}
 
-void CTxMemCache::BatchWrite(const UnorderedHashSet &txidsIn) {
-    txids.clear();
+    // the block of the tx has been removed in this view
+    return removedHeights.count(blockHeight) == 0;
+}
 
-    for (const auto &txid : txidsIn) {
-        txids.insert(txid);
-    }
+bool CTxMemCache::HaveTx(const uint256 &txid) {
+    int32_t blockHeight;
+    return GetTxHeight(txid, blockHeight);
 }
 
 void CTxMemCache::Flush() {
     assert(pBase);
 
-    pBase->BatchWrite(txids);
-    txids.clear();
+    // only the changes of this view are written, removed heights first as a block may be
+    // replaced at the same height
+    for (const auto blockHeight : removedHeights) {
+        pBase->RemoveBlockTx(blockHeight);
+    }
+
+    for (const auto &slot : ring) {
+        if (slot.height >= 0)
+            pBase->AddBlockTx(slot.height, slot.txids);
+    }
+
+    Clear();
 }
 
-void CTxMemCache::Clear() { txids.clear(); }
+void CTxMemCache::GetBlockTxids(const int32_t fromHeight, map<int32_t, vector<uint256>> &blockTxids) const {
+    for (const auto &slot : ring) {
+        if (slot.height >= 0 && slot.height >= fromHeight)
+            blockTxids[slot.height] = slot.txids;
+    }
+}
+
+void CTxMemCache::AddBlockTxids(const map<int32_t, vector<uint256>> &blockTxids) {
+    for (const auto &item : blockTxids) {
+        AddBlockTx(item.first, item.second);
+    }
+}
 
-uint64_t CTxMemCache::GetSize() { return txids.size(); }
+void CTxMemCache::Clear() {
+    ring.clear();
+    txHeights.clear();
+    removedHeights.clear();
+}
+
+uint64_t CTxMemCache::GetSize() { return txHeights.size(); }
+
+uint64_t CTxMemCache::GetCacheSize() const {
+    uint64_t ret = memusage::DynamicUsage(ring) + memusage::DynamicUsage(txHeights) +
+                   memusage::DynamicUsage(removedHeights);
+    for (const auto &slot : ring)
+        ret += memusage::DynamicUsage(slot.txids);
+    return ret;
+}
 
 Object CTxMemCache::ToJsonObj() const {
     Array txArray;
-    for (auto &txid : txids) {
-        txArray.push_back(txid.ToString());
+    for (auto &item : txHeights) {
+        txArray.push_back(item.first.ToString());
     }
 
     Object txCacheObj;
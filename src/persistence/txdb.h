@@ -15,36 +15,63 @@
 #include "block.h"
 
 #include <map>
+#include <set>
+#include <unordered_map>
 #include <vector>
 
 using namespace std;
 using namespace json_spirit;
 
+typedef std::unordered_map<uint256, int32_t, CUint256Hasher> TxHeightMap;  // txid -> block height
+
+/**
+ * Txids of the latest blocks, used to reject duplicated transactions.
+ *
+ * The txids are kept per block in a ring indexed by block height, plus a txid -> height index,
+ * so a block expires in O(block size) without reading it back. A cache with a base view only
+ * holds its changes (added blocks and removed heights), which Flush() applies to the base.
+ */
 class CTxMemCache {
 public:
-    CTxMemCache() : pBase(nullptr) {}
-    CTxMemCache(CTxMemCache *pBaseIn) : pBase(pBaseIn) {}
+    CTxMemCache() : nCacheHeight(0), pBase(nullptr) {}
+    CTxMemCache(CTxMemCache *pBaseIn) : nCacheHeight(0), pBase(pBaseIn) {}
 
 public:
     bool HaveTx(const uint256 &txid);
 
     bool AddBlockTx(const CBlock &block);
-    bool RemoveBlockTx(const CBlock &block);
+    bool AddBlockTx(const CBlockSummary &summary);
+    bool RemoveBlockTx(const int32_t blockHeight);
 
     void Clear();
     void SetBaseViewPtr(CTxMemCache *pBaseIn) { pBase = pBaseIn; }
+    // the number of blocks kept, SysCfg().GetTxCacheHeight() if not set
+    void SetCacheHeight(const int32_t cacheHeight) { nCacheHeight = cacheHeight; }
     void Flush();
 
+    // the txids of the blocks from the height on, only for the cache without a base view
+    void GetBlockTxids(const int32_t fromHeight, map<int32_t, vector<uint256>> &blockTxids) const;
+    void AddBlockTxids(const map<int32_t, vector<uint256>> &blockTxids);
+
     Object ToJsonObj() const;
     uint64_t GetSize();
+    uint64_t GetCacheSize() const;
 
 private:
-    bool HaveBlock(const uint256 &blockHash) const;
-    bool HaveBlock(const CBlock &block);
-    void BatchWrite(const UnorderedHashSet &mapBlockTxHashSetIn);
+    struct CBlockTxids {
+        int32_t height = -1;  // -1: empty slot
+        vector<uint256> txids;
+    };
+
+    void AddBlockTx(const int32_t blockHeight, const vector<uint256> &blockTxids);
+    void EraseSlot(CBlockTxids &slot);
+    bool GetTxHeight(const uint256 &txid, int32_t &blockHeight);
 
 private:
-    UnorderedHashSet txids;
+    int32_t nCacheHeight;
+    vector<CBlockTxids> ring;       // slot: height % ring.size(), allocated on first use
+    TxHeightMap txHeights;          // index of the txids in ring
+    set<int32_t> removedHeights;    // heights removed from the base, only used with a base view
     CTxMemCache *pBase;
 };
 
@@ -29,7 +29,7 @@ public:
 
     void Flush();
 
-    uint32_t GetCacheSize() const { return txReceiptCache.GetCacheSize(); }
+    uint64_t GetCacheSize() const { return txReceiptCache.GetCacheSize(); }
 
     void SetBaseViewPtr(CTxReceiptDBCache *pBaseIn) { txReceiptCache.SetBase(&pBaseIn->txReceiptCache); }
 
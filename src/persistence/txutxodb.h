@@ -30,7 +30,7 @@ public:
 
     void Flush();
 
-    uint32_t GetCacheSize() const { return txUtxoCache.GetCacheSize(); }
+    uint64_t GetCacheSize() const { return txUtxoCache.GetCacheSize(); }
 
     void SetBaseViewPtr(CTxUTXODBCache *pBaseIn) { txUtxoCache.SetBase(&pBaseIn->txUtxoCache); }
 
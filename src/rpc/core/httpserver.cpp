@@ -350,6 +350,13 @@ static bool HTTPBindAddresses(struct evhttp* http) {
     return !boundSockets.empty();
 }
 
+bool EnqueueHTTPWork(std::unique_ptr<HTTPClosure> closure) {
+    if (workQueue == nullptr || !workQueue->Enqueue(closure.get()))
+        return false;
+    closure.release();
+    return true;
+}
+
 /** Simple wrapper to set thread name and run work queue */
 static void HTTPWorkQueueRun(WorkQueue<HTTPClosure>* queue) {
     RenameThread("bitcoin-httpworker");
@@ -8,6 +8,7 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <memory>
 
 static const int32_t DEFAULT_HTTP_THREADS        = 4;
 static const int32_t DEFAULT_HTTP_WORKQUEUE      = 16;
@@ -125,6 +126,11 @@ public:
     virtual ~HTTPClosure() {}
 };
 
+/** Queue the closure to run on an HTTP worker thread.
+ * Returns false if the work queue is full or not created, the closure is then deleted.
+ */
+bool EnqueueHTTPWork(std::unique_ptr<HTTPClosure> closure);
+
 /** Event class. This can be used either as a cross-thread trigger or as a timer.
  */
 class HTTPEvent
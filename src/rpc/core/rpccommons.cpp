@@ -261,13 +261,11 @@ Object GetTxDetailJSON(const uint256& txid) {
         if (SysCfg().IsTxIndex()) {
             CDiskTxPos postx;
             if (pCdMan->pBlockCache->ReadTxIndex(txid, postx)) {
-                CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
                 CBlockHeader header;
+                if (!ReadTxFromDisk(postx, pBaseTx, &header))
+                    throw runtime_error(tfm::format("%s : read tx %s failed", __func__, txid.GetHex()).c_str());
 
                 try {
-                    file >> header;
-                    fseek(file, postx.nTxOffset, SEEK_CUR);
-                    file >> pBaseTx;
                     //obj = pBaseTx->IsMultiSignSupport()?pBaseTx->ToJsonMultiSign(*database):pBaseTx->ToJson(*pCdMan->pAccountCache);
                     obj = pBaseTx->ToJson(*pCdMan->pAccountCache);
 
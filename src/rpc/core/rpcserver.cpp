@@ -11,9 +11,13 @@
 #include "commons/util/util.h"
 #include "init.h"
 #include "main.h"
+#include "persistence/chainstatesnapshot.h"
 
 #include <boost/algorithm/string.hpp>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include "wallet/wallet.h"
 #include "commons/json/json_spirit_writer_template.h"
 #include "httpserver.h"
@@ -423,14 +427,104 @@ Object JSONRPCExecOne(const Value& req) {
     return rpc_result;
 }
 
+/** Calls of a batch request, shared by the threads running them */
+class CRPCBatch {
+public:
+    CRPCBatch(const Array &vReqIn) : vReq(vReqIn), replies(vReqIn.size()) {}
+
+    // run the calls not taken by the other threads yet, the requests are not read once all are done
+    void Run() {
+        size_t count = 0;
+        for (size_t i = nextIndex++; i < replies.size(); i = nextIndex++) {
+            replies[i] = JSONRPCExecOne(vReq[i]);
+            count++;
+        }
+        if (count > 0) {
+            std::lock_guard<std::mutex> lock(mtx);
+            doneCount += count;
+            if (doneCount == replies.size())
+                cond.notify_all();
+        }
+    }
+
+    void Wait() {
+        std::unique_lock<std::mutex> lock(mtx);
+        cond.wait(lock, [this]() { return doneCount == replies.size(); });
+    }
+
+    const vector<Object> &GetReplies() const { return replies; }
+
+private:
+    const Array &vReq;
+    vector<Object> replies;
+    std::atomic<size_t> nextIndex{0};
+    std::mutex mtx;
+    std::condition_variable cond;
+    size_t doneCount = 0;
+};
+
+/** Helper of a batch on an HTTP worker thread */
+class CRPCBatchWorkItem final : public HTTPClosure {
+public:
+    CRPCBatchWorkItem(const std::shared_ptr<CRPCBatch> &spBatchIn) : spBatch(spBatchIn) {}
+    void operator()() override { spBatch->Run(); }
+
+private:
+    std::shared_ptr<CRPCBatch> spBatch;
+};
+
 string JSONRPCExecBatch(const Array& vReq) {
-    Array ret;
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(vReq[reqIdx]));
+    int64_t maxSize = SysCfg().GetArg("-rpcbatchsize", DEFAULT_RPC_BATCH_SIZE);
+    if (maxSize > 0 && (int64_t)vReq.size() > maxSize)
+        throw JSONRPCError(RPC_INVALID_REQUEST, strprintf("Batch of %u calls exceeds the limit of %d calls, see "
+                                                          "-rpcbatchsize", vReq.size(), maxSize));
+
+    // the calls are taken by the helpers and this thread, which runs all of them if no helper gets a worker,
+    // so the batch never waits for a free worker thread
+    auto spBatch = std::make_shared<CRPCBatch>(vReq);
+    int64_t threads = std::min<int64_t>(SysCfg().GetArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS), vReq.size());
+    for (int64_t i = 1; i < threads; i++) {
+        if (!EnqueueHTTPWork(std::unique_ptr<HTTPClosure>(new CRPCBatchWorkItem(spBatch))))
+            break;
+    }
+    spBatch->Run();
+    spBatch->Wait();
 
+    Array ret(spBatch->GetReplies().begin(), spBatch->GetReplies().end());
     return write_string(Value(ret), false) + "\n";
 }
 
+static thread_local CChainStateReadView *pRPCChainView = nullptr;
+
+CChainStateReadView &GetRPCChainView() {
+    if (pRPCChainView == nullptr)
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "No chain state snapshot for the call");
+    return *pRPCChainView;
+}
+
+// run the readSnapshot call on the latest chain state snapshot, reports the height of the snapshot in the
+// object results
+static Value ExecuteOnSnapshot(const CRPCCommand *pcmd, const json_spirit::Array &params) {
+    auto spSnapshot = GetChainStateSnapshot();
+    if (!spSnapshot)
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Chain state not loaded");
+
+    CChainStateReadView view(spSnapshot);
+    pRPCChainView = &view;
+    Value result;
+    try {
+        result = pcmd->actor(params, false);
+    } catch (...) {
+        pRPCChainView = nullptr;
+        throw;
+    }
+    pRPCChainView = nullptr;
+
+    if (result.type() == obj_type)
+        result.get_obj().push_back(Pair("snapshot_height", view.Height()));
+    return result;
+}
+
 json_spirit::Value CRPCTable::execute(const string& strMethod,
                                       const json_spirit::Array& params) const {
     // Find method
@@ -470,7 +564,9 @@ json_spirit::Value CRPCTable::execute(const string& strMethod,
         // Execute
         Value result;
         {
-            if (pcmd->threadSafe)
+            if (pcmd->readSnapshot)
+                result = ExecuteOnSnapshot(pcmd, params);
+            else if (pcmd->threadSafe)
                 result = pcmd->actor(params, false);
             else if (!pWalletMain) {
                 LOCK(cs_main);
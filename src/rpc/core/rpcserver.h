@@ -22,6 +22,11 @@ using namespace std;
 using namespace json_spirit ;
 class CBlockIndex;
 
+/** -rpcbatchthreads default: max threads running the calls of a batch request, the request's own included */
+static const int32_t DEFAULT_RPC_BATCH_THREADS = 4;
+/** -rpcbatchsize default: max calls of a batch request, 0 for no limit */
+static const int32_t DEFAULT_RPC_BATCH_SIZE    = 1000;
+
 Value help(const Array& params, bool fHelp);
 Value stop(const Array& params, bool fHelp);
 
@@ -65,6 +70,7 @@ public:
     bool okSafeMode;
     bool threadSafe;
     bool reqWallet;
+    bool readSnapshot;  // read-only, runs without cs_main on the chain state snapshot, see GetRPCChainView()
 };
 
 /**
@@ -91,6 +97,13 @@ public:
 
 extern const CRPCTable tableRPC;
 
+class CChainStateReadView;
+/**
+ * The chain state view of the current readSnapshot call, instead of chainActive and pCdMan.
+ * Throws if the call is not run by CRPCTable::execute() as a readSnapshot call.
+ */
+CChainStateReadView &GetRPCChainView();
+
 //
 // Utilities: convert hex-encoded Values
 // (throws error if not hex).
@@ -110,6 +123,10 @@ extern string HelpExampleRpc(string methodname, string args);
 
 json_spirit::Object JSONRPCExecOne(const json_spirit::Value& req);
 
+/**
+ * Run the calls of the batch on up to -rpcbatchthreads HTTP worker threads, the replies are in the order
+ * of the calls. Throws if the batch has more than -rpcbatchsize calls.
+ */
 std::string JSONRPCExecBatch(const json_spirit::Array& vReq);
 
 /** Opaque base class for timers returned by NewTimerFunc.
@@ -90,6 +90,7 @@ extern Value submitdexsettletx(const Array& params, bool fHelp);
 
 extern Value getdexorder(const Array& params, bool fHelp);
 extern Value getdexorders(const Array& params, bool fHelp);
+extern Value getdexorderbook(const Array& params, bool fHelp);
 extern Value getdexsysorders(const Array& params, bool fHelp);
 extern Value getdexoperator(const Array& params, bool fHelp);
 extern Value getdexoperatorbyowner(const Array& params, bool fHelp);
@@ -175,6 +176,7 @@ extern Value getfcoingenesistxinfo(const json_spirit::Array& params, bool fHelp)
 extern Value getblockcount(const json_spirit::Array& params, bool fHelp);
 extern Value getdifficulty(const json_spirit::Array& params, bool fHelp);
 extern Value getrawmempool(const json_spirit::Array& params, bool fHelp);
+extern Value getmempoolinfo(const json_spirit::Array& params, bool fHelp);
 extern Value getblock(const json_spirit::Array& params, bool fHelp);
 extern Value verifychain(const json_spirit::Array& params, bool fHelp);
 extern Value getcontractregid(const json_spirit::Array& params, bool fHelp);
@@ -199,6 +201,7 @@ extern Value submitdexsettletx(const json_spirit::Array& params, bool fHelp);
 extern Value getdexorder(const json_spirit::Array& params, bool fHelp);
 extern Value getdexsysorders(const json_spirit::Array& params, bool fHelp);
 extern Value getdexorders(const json_spirit::Array& params, bool fHelp);
+extern Value getdexorderbook(const json_spirit::Array& params, bool fHelp);
 extern Value submitdexoperatorregtx(const json_spirit::Array& params, bool fHelp);
 extern Value submitdexoperatorupdatetx(const json_spirit::Array& params, bool fHelp);
 extern Value getdexoperator(const json_spirit::Array& params, bool fHelp);
@@ -236,5 +239,8 @@ extern Value getminminerfee(const Array& params, bool fHelp) ;
 
 // debug
 Value dumpdb(const Array& params, bool fHelp);
+Value getcachestats(const Array& params, bool fHelp);
+Value getforkcachestats(const Array& params, bool fHelp);
+Value getdbcachestats(const Array& params, bool fHelp);
 
 #endif /* RPC_API_H_ */
@@ -13,164 +13,169 @@
 //
 
 static const CRPCCommand vRPCCommands[] =
-{ //  name                      actor (function)         okSafeMode threadSafe reqWallet
-  //  ------------------------  -----------------------  ---------- ---------- ---------
+{ //  name                      actor (function)         okSafeMode threadSafe reqWallet readSnapshot
+  //  ------------------------  -----------------------  ---------- ---------- --------- ------------
     /* Overall control/query calls */
-    { "help",                           &help,                              true,      true,        false   },
-    { "getinfo",                        &getinfo,                           true,      false,       false   }, /* uses wallet if enabled */
-    { "stop",                           &stop,                              true,      true,        false   },
-    { "validateaddr",                   &validateaddr,                      true,      true,        false   },
-    { "createmulsig",                   &createmulsig,                      true,      true ,       false   },
+    { "help",                           &help,                              true,      true,        false,       false   },
+    { "getinfo",                        &getinfo,                           true,      false,       false,       false   }, /* uses wallet if enabled */
+    { "stop",                           &stop,                              true,      true,        false,       false   },
+    { "validateaddr",                   &validateaddr,                      true,      true,        false,       false   },
+    { "createmulsig",                   &createmulsig,                      true,      true ,       false,       false   },
 
     /* P2P networking */
-    { "getnetworkinfo",                 &getnetworkinfo,                    true,      false,       false   },
-    { "addnode",                        &addnode,                           true,      true,        false   },
-    { "getaddednodeinfo",               &getaddednodeinfo,                  true,      true,        false   },
-    { "getconnectioncount",             &getconnectioncount,                true,      false,       false   },
-    { "getnettotals",                   &getnettotals,                      true,      true,        false   },
-    { "getpeerinfo",                    &getpeerinfo,                       true,      false,       false   },
-    { "ping",                           &ping,                              true,      false,       false   },
-    { "getchaininfo",                   &getchaininfo,                      true,      false,       false   },
+    { "getnetworkinfo",                 &getnetworkinfo,                    true,      false,       false,       false   },
+    { "addnode",                        &addnode,                           true,      true,        false,       false   },
+    { "getaddednodeinfo",               &getaddednodeinfo,                  true,      true,        false,       false   },
+    { "getconnectioncount",             &getconnectioncount,                true,      false,       false,       false   },
+    { "getnettotals",                   &getnettotals,                      true,      true,        false,       false   },
+    { "getpeerinfo",                    &getpeerinfo,                       true,      false,       false,       false   },
+    { "ping",                           &ping,                              true,      false,       false,       false   },
+    { "getchaininfo",                   &getchaininfo,                      true,      false,       false,       false   },
 
     /* Block chain and UTXO */
-    { "getfcoingenesistxinfo",          &getfcoingenesistxinfo,             true,      true,        false   },
-    { "getblockcount",                  &getblockcount,                     true,      true,        false   },
-    { "getblock",                       &getblock,                          true,      false,       false   },
-    { "getrawmempool",                  &getrawmempool,                     true,      false,       false   },
-    { "verifychain",                    &verifychain,                       true,      false,       false   },
-    { "getblockundo",                   &getblockundo,                      true,      false,       false   },
-
-    { "gettotalcoins",                  &gettotalcoins,                     true,      false,       false   },
-    { "invalidateblock",                &invalidateblock,                   true,      true,        false   },
-    { "reconsiderblock",                &reconsiderblock,                   true,      true,        false   },
+    { "getfcoingenesistxinfo",          &getfcoingenesistxinfo,             true,      true,        false,       false   },
+    { "getblockcount",                  &getblockcount,                     true,      true,        false,       false   },
+    { "getblock",                       &getblock,                          true,      false,       false,       true    },
+    { "getrawmempool",                  &getrawmempool,                     true,      false,       false,       false   },
+    { "getmempoolinfo",                 &getmempoolinfo,                    true,      true,        false,       false   },
+    { "verifychain",                    &verifychain,                       true,      false,       false,       false   },
+    { "getblockundo",                   &getblockundo,                      true,      false,       false,       false   },
+
+    { "gettotalcoins",                  &gettotalcoins,                     true,      false,       false,       false   },
+    { "invalidateblock",                &invalidateblock,                   true,      true,        false,       false   },
+    { "reconsiderblock",                &reconsiderblock,                   true,      true,        false,       false   },
     /* Mining */
-    { "getmininginfo",                  &getmininginfo,                     true,      false,       false    },
-    { "submitblock",                    &submitblock,                       true,      false,       false    },
-    { "getminedblocks",                 &getminedblocks,                    true,      true,        false    },
-    { "getminerbyblocktime",            &getminerbyblocktime,               true,      true,        false    },
+    { "getmininginfo",                  &getmininginfo,                     true,      false,       false,       false   },
+    { "submitblock",                    &submitblock,                       true,      false,       false,       false   },
+    { "getminedblocks",                 &getminedblocks,                    true,      true,        false,       false   },
+    { "getminerbyblocktime",            &getminerbyblocktime,               true,      true,        false,       false   },
     /* Raw transactions */
-    { "genmulsigtx",                    &genmulsigtx,                       true,      false,       false   },
+    { "genmulsigtx",                    &genmulsigtx,                       true,      false,       false,       false   },
     /* uses wallet if enabled */
-    { "addmulsigaddr",                  &addmulsigaddr,                     false,     false,       true    },
-    { "getaccountinfo",                 &getaccountinfo,                    true,      false,       true    },
-    { "getnewaddr",                     &getnewaddr,                        false,     false,       true    },
-    { "gettxdetail",                    &gettxdetail,                       true,      false,       true    },
-    { "getclosedcdp",                   &getclosedcdp,                      true,      false,       true    },
-    { "getwalletinfo",                  &getwalletinfo,                     true,      false,       true    },
-
-    { "dumpprivkey",                    &dumpprivkey,                       false,     false,       true    },
-    { "importprivkey",                  &importprivkey,                     false,     false,       true    },
-    { "dropminermainkeys",                  &dropminermainkeys,                     false,     false,       true    },
-    { "dropprivkey",                    &dropprivkey,                       false,     false,       true    },
-    { "backupwallet",                   &backupwallet,                      false,     false,       true    },
-    { "dumpwallet",                     &dumpwallet,                        false,     false,       true    },
-    { "importwallet",                   &importwallet,                      false,     false,       true    },
-    { "encryptwallet",                  &encryptwallet,                     false,     false,       true    },
-    { "walletlock",                     &walletlock,                        false,     false,       true    },
-    { "walletpassphrasechange",         &walletpassphrasechange,            false,     false,       true    },
-    { "walletpassphrase",               &walletpassphrase,                  false,     false,       true    },
-
-    { "listaddr",                       &listaddr,                          true,      false,       true    },
-    { "listtx",                         &listtx,                            true,      false,       true    },
-    { "setgenerate",                    &setgenerate,                       true,      true,        false   },
-    { "listcontracts",                  &listcontracts,                     true,      false,       true    },
-    { "getcontractinfo",                &getcontractinfo,                   true,      false,       true    },
-    { "listtxcache",                    &listtxcache,                       true,      false,       true    },
-    { "getcontractdata",                &getcontractdata,                   true,      false,       true    },
-    { "signmessage",                    &signmessage,                       false,     false,       true    },
-    { "verifymessage",                  &verifymessage,                     true,      false,       false   },
-    { "getcoinunitinfo",                &getcoinunitinfo,                   true,      false,       false   },
-    { "getcontractassets",              &getcontractassets,                 true,      false,       true    },
-    { "listcontractassets",             &listcontractassets,                true,      false,       true    },
-    { "signtxraw",                      &signtxraw,                         true,      false,       true    },
-    { "getcontractaccountinfo",         &getcontractaccountinfo,            true,      false,       true    },
-    { "getsignature",                   &getsignature,                      true,      false,       true    },
-    { "listdelegates",                  &listdelegates,                     true,      false,       true    },
-    { "decodetxraw",                    &decodetxraw,                       true,       false,      false   },
-    { "decodemulsigscript",             &decodemulsigscript,                true,       false,      false   },
+    { "addmulsigaddr",                  &addmulsigaddr,                     false,     false,       true,        false   },
+    { "getaccountinfo",                 &getaccountinfo,                    true,      false,       true,        true    },
+    { "getnewaddr",                     &getnewaddr,                        false,     false,       true,        false   },
+    { "gettxdetail",                    &gettxdetail,                       true,      false,       true,        false   },
+    { "getclosedcdp",                   &getclosedcdp,                      true,      false,       true,        false   },
+    { "getwalletinfo",                  &getwalletinfo,                     true,      false,       true,        false   },
+
+    { "dumpprivkey",                    &dumpprivkey,                       false,     false,       true,        false   },
+    { "importprivkey",                  &importprivkey,                     false,     false,       true,        false   },
+    { "dropminermainkeys",                  &dropminermainkeys,                     false,     false,       true,        false   },
+    { "dropprivkey",                    &dropprivkey,                       false,     false,       true,        false   },
+    { "backupwallet",                   &backupwallet,                      false,     false,       true,        false   },
+    { "dumpwallet",                     &dumpwallet,                        false,     false,       true,        false   },
+    { "importwallet",                   &importwallet,                      false,     false,       true,        false   },
+    { "encryptwallet",                  &encryptwallet,                     false,     false,       true,        false   },
+    { "walletlock",                     &walletlock,                        false,     false,       true,        false   },
+    { "walletpassphrasechange",         &walletpassphrasechange,            false,     false,       true,        false   },
+    { "walletpassphrase",               &walletpassphrase,                  false,     false,       true,        false   },
+
+    { "listaddr",                       &listaddr,                          true,      false,       true,        false   },
+    { "listtx",                         &listtx,                            true,      false,       true,        false   },
+    { "setgenerate",                    &setgenerate,                       true,      true,        false,       false   },
+    { "listcontracts",                  &listcontracts,                     true,      false,       true,        false   },
+    { "getcontractinfo",                &getcontractinfo,                   true,      false,       true,        false   },
+    { "listtxcache",                    &listtxcache,                       true,      false,       true,        false   },
+    { "getcontractdata",                &getcontractdata,                   true,      false,       true,        false   },
+    { "signmessage",                    &signmessage,                       false,     false,       true,        false   },
+    { "verifymessage",                  &verifymessage,                     true,      false,       false,       false   },
+    { "getcoinunitinfo",                &getcoinunitinfo,                   true,      false,       false,       false   },
+    { "getcontractassets",              &getcontractassets,                 true,      false,       true,        false   },
+    { "listcontractassets",             &listcontractassets,                true,      false,       true,        false   },
+    { "signtxraw",                      &signtxraw,                         true,      false,       true,        false   },
+    { "getcontractaccountinfo",         &getcontractaccountinfo,            true,      false,       true,        false   },
+    { "getsignature",                   &getsignature,                      true,      false,       true,        false   },
+    { "listdelegates",                  &listdelegates,                     true,      false,       true,        false   },
+    { "decodetxraw",                    &decodetxraw,                       true,       false,      false,       false   },
+    { "decodemulsigscript",             &decodemulsigscript,                true,       false,      false,       false   },
     /* submit raw tx */
-    { "submittxraw",                    &submittxraw,                       true,       false,      false   },
+    { "submittxraw",                    &submittxraw,                       true,       false,      false,       false   },
     /* basic tx */
-    { "submitsendtx",                   &submitsendtx,                      false,      false,      true    },
-    { "submitcreateutxotx",             &submitcreateutxotx,                false,      false,      true    },
-    { "submitutxospendtx",              &submitutxospendtx,                 false,      false,      true    },
-    { "submitaccountregistertx",        &submitaccountregistertx,           false,      false,      true    },
-    { "submitnickidregistertx",         &submitnickidregistertx,            false,      false,      true    },
-
-    { "submitcontractdeploytx",         &submitcontractdeploytx,            false,      false,      true    },
-    { "submitcontractcalltx",           &submitcontractcalltx,              false,      false,      true    },
-    { "submitdelegatevotetx",           &submitdelegatevotetx,              false,      false,      true    },
-    { "submitucontractdeploytx",        &submitucontractdeploytx,           false,      false,      true    },
-    { "submitucontractcalltx",          &submitucontractcalltx,             false,      false,      true    },
-
-    { "submitparamgovernproposal",      &submitparamgovernproposal,         false,      false,      true    },
-    { "submitcdpparamgovernproposal",   &submitcdpparamgovernproposal,      false,      false,      true    },
-
-    { "submitgovernerupdateproposal",   &submitgovernerupdateproposal,      false,      false,      true    },
-    { "submitdexswitchproposal",        &submitdexswitchproposal,           false,      false,      true    },
-    { "submitminerfeeproposal",         &submitminerfeeproposal,            false,      false,      true    },
-
-    { "submitproposalapprovaltx",       &submitproposalapprovaltx,          false,      false,      true    },
+    { "submitsendtx",                   &submitsendtx,                      false,      false,      true,        false   },
+    { "submitcreateutxotx",             &submitcreateutxotx,                false,      false,      true,        false   },
+    { "submitutxospendtx",              &submitutxospendtx,                 false,      false,      true,        false   },
+    { "submitaccountregistertx",        &submitaccountregistertx,           false,      false,      true,        false   },
+    { "submitnickidregistertx",         &submitnickidregistertx,            false,      false,      true,        false   },
+
+    { "submitcontractdeploytx",         &submitcontractdeploytx,            false,      false,      true,        false   },
+    { "submitcontractcalltx",           &submitcontractcalltx,              false,      false,      true,        false   },
+    { "submitdelegatevotetx",           &submitdelegatevotetx,              false,      false,      true,        false   },
+    { "submitucontractdeploytx",        &submitucontractdeploytx,           false,      false,      true,        false   },
+    { "submitucontractcalltx",          &submitucontractcalltx,             false,      false,      true,        false   },
+
+    { "submitparamgovernproposal",      &submitparamgovernproposal,         false,      false,      true,        false   },
+    { "submitcdpparamgovernproposal",   &submitcdpparamgovernproposal,      false,      false,      true,        false   },
+
+    { "submitgovernerupdateproposal",   &submitgovernerupdateproposal,      false,      false,      true,        false   },
+    { "submitdexswitchproposal",        &submitdexswitchproposal,           false,      false,      true,        false   },
+    { "submitminerfeeproposal",         &submitminerfeeproposal,            false,      false,      true,        false   },
+
+    { "submitproposalapprovaltx",       &submitproposalapprovaltx,          false,      false,      true,        false   },
     /* for CDP */
-    { "submitpricefeedtx",              &submitpricefeedtx,                 false,      false,      true    },
-    { "submitcoinstaketx",              &submitcoinstaketx,                 false,      false,      true    },
-    { "submitcdpstaketx",               &submitcdpstaketx,                  false,      false,      true    },
-    { "submitcdpredeemtx",              &submitcdpredeemtx,                 false,      false,      true    },
-    { "submitcdpliquidatetx",           &submitcdpliquidatetx,              false,      false,      true    },
-    { "getscoininfo",                   &getscoininfo,                      true,       false,      false   },
-    { "getcdp",                         &getcdp,                            true,       false,      false   },
-    { "getusercdp",                     &getusercdp,                        true,       false,      false   },
-    { "getcdpcoinpairs",                &getcdpcoinpairs,                   true,       false,      false   },
-
-    { "getsysparam",                    &getsysparam,                       true,       false,      false   },
-    { "getcdpparam",                    &getcdpparam,                       true,       false,      false   },
-    { "getproposal",                    &getproposal,                       true,       false,      false   },
-    { "getminminerfee",                 &getminminerfee,                    true,       false,      false   },
+    { "submitpricefeedtx",              &submitpricefeedtx,                 false,      false,      true,        false   },
+    { "submitcoinstaketx",              &submitcoinstaketx,                 false,      false,      true,        false   },
+    { "submitcdpstaketx",               &submitcdpstaketx,                  false,      false,      true,        false   },
+    { "submitcdpredeemtx",              &submitcdpredeemtx,                 false,      false,      true,        false   },
+    { "submitcdpliquidatetx",           &submitcdpliquidatetx,              false,      false,      true,        false   },
+    { "getscoininfo",                   &getscoininfo,                      true,       false,      false,       false   },
+    { "getcdp",                         &getcdp,                            true,       false,      false,       true    },
+    { "getusercdp",                     &getusercdp,                        true,       false,      false,       true    },
+    { "getcdpcoinpairs",                &getcdpcoinpairs,                   true,       false,      false,       false   },
+
+    { "getsysparam",                    &getsysparam,                       true,       false,      false,       false   },
+    { "getcdpparam",                    &getcdpparam,                       true,       false,      false,       false   },
+    { "getproposal",                    &getproposal,                       true,       false,      false,       false   },
+    { "getminminerfee",                 &getminminerfee,                    true,       false,      false,       false   },
     /* for dex */
-    { "submitdexbuylimitordertx",       &submitdexbuylimitordertx,          false,      false,      false   },
-    { "submitdexselllimitordertx",      &submitdexselllimitordertx,         false,      false,      false   },
-    { "submitdexbuymarketordertx",      &submitdexbuymarketordertx,         false,      false,      false   },
-    { "submitdexsellmarketordertx",     &submitdexsellmarketordertx,        false,      false,      false   },
-    { "gendexoperatorordertx",          &gendexoperatorordertx,             false,      false,      false   },
-    { "submitdexsettletx",              &submitdexsettletx,                 false,      false,      false   },
-    { "submitdexcancelordertx",         &submitdexcancelordertx,            false,      false,      false   },
-    { "submitdexoperatorregtx",         &submitdexoperatorregtx,            false,      false,      false   },
-    { "submitdexoperatorupdatetx",      &submitdexoperatorupdatetx,         false,      false,      false   },
-    { "getdexorder",                    &getdexorder,                       true,       false,      false   },
-    { "getdexsysorders",                &getdexsysorders,                   true,       false,      false   },
-    { "getdexorders",                   &getdexorders,                      true,       false,      false   },
-    { "getdexoperator",                 &getdexoperator,                    true,       false,      false   },
-    { "getdexoperatorbyowner",          &getdexoperatorbyowner,             true,       false,      false   },
-    { "getdexorderfee",                 &getdexorderfee,                    true,       false,      false   },
+    { "submitdexbuylimitordertx",       &submitdexbuylimitordertx,          false,      false,      false,       false   },
+    { "submitdexselllimitordertx",      &submitdexselllimitordertx,         false,      false,      false,       false   },
+    { "submitdexbuymarketordertx",      &submitdexbuymarketordertx,         false,      false,      false,       false   },
+    { "submitdexsellmarketordertx",     &submitdexsellmarketordertx,        false,      false,      false,       false   },
+    { "gendexoperatorordertx",          &gendexoperatorordertx,             false,      false,      false,       false   },
+    { "submitdexsettletx",              &submitdexsettletx,                 false,      false,      false,       false   },
+    { "submitdexcancelordertx",         &submitdexcancelordertx,            false,      false,      false,       false   },
+    { "submitdexoperatorregtx",         &submitdexoperatorregtx,            false,      false,      false,       false   },
+    { "submitdexoperatorupdatetx",      &submitdexoperatorupdatetx,         false,      false,      false,       false   },
+    { "getdexorder",                    &getdexorder,                       true,       false,      false,       true    },
+    { "getdexsysorders",                &getdexsysorders,                   true,       false,      false,       true    },
+    { "getdexorders",                   &getdexorders,                      true,       false,      false,       true    },
+    { "getdexorderbook",                &getdexorderbook,                   true,       false,      false,       false   },
+    { "getdexoperator",                 &getdexoperator,                    true,       false,      false,       false   },
+    { "getdexoperatorbyowner",          &getdexoperatorbyowner,             true,       false,      false,       false   },
+    { "getdexorderfee",                 &getdexorderfee,                    true,       false,      false,       false   },
     /* for asset */
-    { "submitassetissuetx",             &submitassetissuetx,                false,      false,      false   },
-    { "submitassetupdatetx",            &submitassetupdatetx,               false,      false,      false   },
-    { "getasset",                       &getasset,                          true,       false,      false   },
-    { "getassets",                      &getassets,                         true,       false,      false   },
+    { "submitassetissuetx",             &submitassetissuetx,                false,      false,      false,       false   },
+    { "submitassetupdatetx",            &submitassetupdatetx,               false,      false,      false,       false   },
+    { "getasset",                       &getasset,                          true,       false,      false,       false   },
+    { "getassets",                      &getassets,                         true,       false,      false,       false   },
     /* for wasm */
-    { "submitwasmcontractdeploytx",     &submitwasmcontractdeploytx,        true,       false,      true    },
-    { "submitwasmcontractcalltx",       &submitwasmcontractcalltx,          true,       false,      true    },
-    { "gettablewasm",                   &gettablewasm,                      true,       false,      true    },
-    { "jsontobinwasm",                  &jsontobinwasm,                     true,       false,      true    },
-    { "bintojsonwasm",                  &bintojsonwasm,                     true,       false,      true    },
-    { "getcodewasm",                    &getcodewasm,                       true,       false,      true    },
-    { "getabiwasm",                     &getabiwasm,                        true,       false,      true    },
-    { "gettxtrace",                     &gettxtrace,                        true,       false,      true    },
-    { "abidefjsontobinwasm",            &abidefjsontobinwasm,               true,       false,      true    },
+    { "submitwasmcontractdeploytx",     &submitwasmcontractdeploytx,        true,       false,      true,        false   },
+    { "submitwasmcontractcalltx",       &submitwasmcontractcalltx,          true,       false,      true,        false   },
+    { "gettablewasm",                   &gettablewasm,                      true,       false,      true,        false   },
+    { "jsontobinwasm",                  &jsontobinwasm,                     true,       false,      true,        false   },
+    { "bintojsonwasm",                  &bintojsonwasm,                     true,       false,      true,        false   },
+    { "getcodewasm",                    &getcodewasm,                       true,       false,      true,        false   },
+    { "getabiwasm",                     &getabiwasm,                        true,       false,      true,        false   },
+    { "gettxtrace",                     &gettxtrace,                        true,       false,      true,        false   },
+    { "abidefjsontobinwasm",            &abidefjsontobinwasm,               true,       false,      true,        false   },
     /* for test code */
-    { "disconnectblock",                &disconnectblock,                   true,       false,      true    },
-    { "reloadtxcache",                  &reloadtxcache,                     true,       false,      true    },
-    { "getcontractregid",               &getcontractregid,                  true,       false,      false   },
-    { "saveblocktofile",                &saveblocktofile,                   true,       false,      true    },
-    { "gethash",                        &gethash,                           true,       false,      true    },
-    { "startcommontpstest",             &startcommontpstest,                true,       true,       false   },
-    { "startcontracttpstest",           &startcontracttpstest,              true,       true,       false   },
-    { "getblockfailures",               &getblockfailures,                  true,       false,      false   },
+    { "disconnectblock",                &disconnectblock,                   true,       false,      true,        false   },
+    { "reloadtxcache",                  &reloadtxcache,                     true,       false,      true,        false   },
+    { "getcontractregid",               &getcontractregid,                  true,       false,      false,       false   },
+    { "saveblocktofile",                &saveblocktofile,                   true,       false,      true,        false   },
+    { "gethash",                        &gethash,                           true,       false,      true,        false   },
+    { "startcommontpstest",             &startcommontpstest,                true,       true,       false,       false   },
+    { "startcontracttpstest",           &startcontracttpstest,              true,       true,       false,       false   },
+    { "getblockfailures",               &getblockfailures,                  true,       false,      false,       false   },
     /* vm functions work in vm simulator */
-    { "vmexecutescript",                &vmexecutescript,                   true,       true,       true    },
+    { "vmexecutescript",                &vmexecutescript,                   true,       true,       true,        false   },
 
     /* debug */
-    { "dumpdb",                         &dumpdb,                            true,       true,       true    },
+    { "dumpdb",                         &dumpdb,                            true,       true,       true,        false   },
+    { "getcachestats",                  &getcachestats,                     true,       true,       false,       false   },
+    { "getforkcachestats",              &getforkcachestats,                 true,       true,       false,       false   },
+    { "getdbcachestats",                &getdbcachestats,                   true,       true,       false,       false   },
 };
 
 #endif //RPC_APICONF_H_
\ No newline at end of file
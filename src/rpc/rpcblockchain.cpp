@@ -20,20 +20,20 @@
 #include "tx/coinrewardtx.h"
 #include "wallet/wallet.h"
 #include "persistence/blockundo.h"
+#include "persistence/chainstatesnapshot.h"
 
 using namespace json_spirit;
 using namespace std;
 
 class CBaseCoinTransferTx;
 
-Object BlockToJSON(const CBlock& block, const CBlockIndex* pBlockIndex) {
+Object BlockToJSON(const CBlock& block, const CBlockIndex* pBlockIndex, const CChainStateReadView &view) {
     Object result;
     result.push_back(Pair("block_hash",     block.GetHash().GetHex()));
     result.push_back(Pair("block_miner",    block.vptx[0]->txUid.ToString()));
 
-    CMerkleTx txGen(block.vptx[0]);
-    txGen.SetMerkleBranch(&block);
-    result.push_back(Pair("confirmations",  (int32_t)txGen.GetDepthInMainChain()));
+    int32_t confirmations = view.Contains(pBlockIndex) ? view.Height() - pBlockIndex->height + 1 : 0;
+    result.push_back(Pair("confirmations",  confirmations));
     result.push_back(Pair("size",           (int32_t)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION)));
     result.push_back(Pair("height",         (int32_t)block.GetHeight()));
     result.push_back(Pair("version",        block.GetVersion()));
@@ -48,7 +48,7 @@ Object BlockToJSON(const CBlock& block, const CBlockIndex* pBlockIndex) {
 
     if (pBlockIndex->pprev)
         result.push_back(Pair("previous_block_hash", pBlockIndex->pprev->GetBlockHash().GetHex()));
-    CBlockIndex* pNext = chainActive.Next(pBlockIndex);
+    CBlockIndex* pNext = view.Next(pBlockIndex);
     if (pNext)
         result.push_back(Pair("next_block_hash", pNext->GetBlockHash().GetHex()));
 
@@ -170,6 +170,40 @@ Value getrawmempool(const Array& params, bool fHelp)
     }
 }
 
+Value getmempoolinfo(const Array& params, bool fHelp)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getmempoolinfo\n"
+            "\nReturns the size of the memory pool and the cost of its revalidation after the chain tip changed.\n"
+            "\nArguments:\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"size\": n,                      (numeric) the number of transactions in the memory pool\n"
+            "  \"revalidations\": n,             (numeric) the revalidations of the memory pool since the start\n"
+            "  \"revalidation_total_ms\": n,     (numeric) the time of all the revalidations in milliseconds\n"
+            "  \"last_revalidation_ms\": n,      (numeric) the time of the last revalidation in milliseconds\n"
+            "  \"last_carried\": n,              (numeric) the transactions of the last revalidation carried over\n"
+            "                                          without execution, as they read none of the changed states\n"
+            "  \"last_reexecuted\": n,           (numeric) the transactions executed again\n"
+            "  \"last_removed\": n               (numeric) the transactions found invalid and removed\n"
+            "}\n"
+            "\nExamples\n" +
+            HelpExampleCli("getmempoolinfo", "") + "\nAs json rpc\n" + HelpExampleRpc("getmempoolinfo", ""));
+
+    CTxMemPoolRevalidateStats stats = mempool.GetRevalidateStats();
+
+    Object obj;
+    obj.push_back(Pair("size",                  mempool.Size()));
+    obj.push_back(Pair("revalidations",         stats.count));
+    obj.push_back(Pair("revalidation_total_ms", stats.total_micros * 0.001));
+    obj.push_back(Pair("last_revalidation_ms",  stats.last_micros * 0.001));
+    obj.push_back(Pair("last_carried",          (int64_t)stats.last_carried));
+    obj.push_back(Pair("last_reexecuted",       (int64_t)stats.last_reexecuted));
+    obj.push_back(Pair("last_removed",          (int64_t)stats.last_removed));
+    return obj;
+}
+
 Value getblock(const Array& params, bool fHelp) {
     if (fHelp || params.size() < 1 || params.size() > 2) {
         throw runtime_error(
@@ -209,28 +243,25 @@ Value getblock(const Array& params, bool fHelp) {
 
     // RPCTypeCheck(params, boost::assign::list_of(str_type)(bool_type)); disable this to allow either string or int argument
 
-    std::string strHash;
+    const CChainStateReadView &view = GetRPCChainView();
+    CBlockIndex* pBlockIndex;
     if (int_type == params[0].type()) {
         int height = params[0].get_int();
-        if (height < 0 || height > chainActive.Height())
+        if (height < 0 || height > view.Height())
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range.");
 
-        CBlockIndex* pBlockIndex = chainActive[height];
-        strHash                  = pBlockIndex->GetBlockHash().GetHex();
+        pBlockIndex = view[height];
     } else {
-        strHash = params[0].get_str();
+        pBlockIndex = view.FindBlockIndex(uint256S(params[0].get_str()));
+        if (pBlockIndex == nullptr)
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
     }
-    uint256 hash(uint256S(strHash));
 
     bool fVerbose = true;
     if (params.size() > 1)
         fVerbose = params[1].get_bool();
 
-    if (mapBlockIndex.count(hash) == 0)
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
-
     CBlock block;
-    CBlockIndex* pBlockIndex = mapBlockIndex[hash];
     if (!ReadBlockFromDisk(pBlockIndex, block)) {
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
     }
@@ -242,7 +273,7 @@ Value getblock(const Array& params, bool fHelp) {
         return strHex;
     }
 
-    return BlockToJSON(block, pBlockIndex);
+    return BlockToJSON(block, pBlockIndex, view);
 }
 
 Value verifychain(const Array& params, bool fHelp) {
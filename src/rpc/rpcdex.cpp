@@ -12,6 +12,7 @@
 #include "commons/util/util.h"
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
+#include "persistence/chainstatesnapshot.h"
 #include "tx/dextx.h"
 #include "tx/dexoperatortx.h"
 
@@ -667,9 +668,8 @@ Value getdexorder(const Array& params, bool fHelp) {
     }
     const uint256 &orderId = RPC_PARAM::GetTxid(params[0], "order_id");
 
-    auto pDexCache = pCdMan->pDexCache;
     CDEXOrderDetail orderDetail;
-    if (!pDexCache->GetActiveOrder(orderId, orderDetail))
+    if (!GetRPCChainView().cw.dexCache.GetActiveOrder(orderId, orderDetail))
         throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("The order not exists or inactive! order_id=%s", orderId.ToString()));
 
     Object obj;
@@ -694,7 +694,8 @@ extern Value getdexsysorders(const Array& params, bool fHelp) {
         );
     }
 
-    int64_t tipHeight = chainActive.Height();
+    CChainStateReadView &view = GetRPCChainView();
+    int64_t tipHeight = view.Height();
     int64_t height    = tipHeight;
     if (params.size() > 0)
         height = params[0].get_int64();
@@ -703,7 +704,7 @@ extern Value getdexsysorders(const Array& params, bool fHelp) {
         throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("height=%d must >= 0 and <= tip_height=%d", height, tipHeight));
     }
 
-    auto pGetter = pCdMan->pDexCache->CreateSysOrdersGetter();
+    auto pGetter = view.cw.dexCache.CreateSysOrdersGetter();
     if (!pGetter->Execute(height)) {
         throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("get system-generated orders error! height=%d", height));
     }
@@ -739,7 +740,8 @@ extern Value getdexorders(const Array& params, bool fHelp) {
         );
     }
 
-    int64_t tipHeight = chainActive.Height();
+    CChainStateReadView &view = GetRPCChainView();
+    int64_t tipHeight = view.Height();
     int64_t beginHeight = 0;
     if (params.size() > 0)
         beginHeight = params[0].get_int64();
@@ -766,7 +768,7 @@ extern Value getdexorders(const Array& params, bool fHelp) {
     DEXBlockOrdersCache::KeyType lastKey;
     if (params.size() > 3) {
         string lastPosInfo = RPC_PARAM::GetBinStrFromHex(params[3], "last_pos_info");
-        auto err = DEX_DB::ParseLastPos(lastPosInfo, lastKey);
+        auto err = DEX_DB::ParseLastPos(view, lastPosInfo, lastKey);
         if (err)
             throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("Invalid last_pos_info! %s", *err));
         uint32_t lastHeight = DEX_DB::GetHeight(lastKey);
@@ -777,7 +779,7 @@ extern Value getdexorders(const Array& params, bool fHelp) {
                                          beginHeight, endHeight));
     }
 
-    auto pGetter = pCdMan->pDexCache->CreateOrdersGetter();
+    auto pGetter = view.cw.dexCache.CreateOrdersGetter();
     if (!pGetter->Execute(beginHeight, endHeight, maxCount, lastKey)) {
         throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("get all active orders error! begin_height=%d, end_height=%d",
             beginHeight, endHeight));
@@ -785,7 +787,7 @@ extern Value getdexorders(const Array& params, bool fHelp) {
 
     string newLastPosInfo;
     if (pGetter->has_more) {
-        auto err = DEX_DB::MakeLastPos(pGetter->last_key, newLastPosInfo);
+        auto err = DEX_DB::MakeLastPos(view, pGetter->last_key, newLastPosInfo);
         if (err)
             throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("Make new last_pos_info error! %s", *err));
     }
@@ -799,6 +801,50 @@ extern Value getdexorders(const Array& params, bool fHelp) {
 }
 
 
+extern Value getdexorderbook(const Array& params, bool fHelp) {
+     if (fHelp || params.size() < 2 || params.size() > 4) {
+        throw runtime_error(
+            "getdexorderbook \"coin_symbol\" \"asset_symbol\" [\"depth\"] [\"with_orders\"]\n"
+            "\nget the price levels of the dex active limit price orders of the trading pair.\n"
+            "\nArguments:\n"
+            "1.\"coin_symbol\":   (string, required) the coin symbol of the orders, E.g WUSD\n"
+            "2.\"asset_symbol\":  (string, required) the asset symbol of the orders, E.g WICC\n"
+            "3.\"depth\":         (numeric, optional) the max price level count of each side, default is 20, max is 1000\n"
+            "4.\"with_orders\":   (bool, optional) list the order ids of each price level, default is false\n"
+            "\nResult:\n"
+            "\"coin_symbol\"      (string) the coin symbol.\n"
+            "\"asset_symbol\"     (string) the asset symbol.\n"
+            "\"bid_level_count\"  (numeric) the price level count of the buy orders.\n"
+            "\"ask_level_count\"  (numeric) the price level count of the sell orders.\n"
+            "\"bids\"             (array) the buy price levels from the highest price, with the remaining asset amount\n"
+            "                     and the count of their orders.\n"
+            "\"asks\"             (array) the sell price levels from the lowest price.\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdexorderbook", "\"WUSD\" \"WICC\" 20 true")
+            + "\nAs json rpc call\n"
+            + HelpExampleRpc("getdexorderbook", "\"WUSD\", \"WICC\", 20, true")
+        );
+    }
+
+    const TokenSymbol& coinSymbol  = RPC_PARAM::GetOrderCoinSymbol(params[0]);
+    const TokenSymbol& assetSymbol = RPC_PARAM::GetOrderAssetSymbol(params[1]);
+
+    int64_t depth = 20;
+    if (params.size() > 2) {
+        depth = params[2].get_int64();
+        if (depth <= 0 || depth > 1000)
+            throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("depth=%d must > 0 and <= 1000", depth));
+    }
+
+    bool withOrders = false;
+    if (params.size() > 3)
+        withOrders = params[3].get_bool();
+
+    Object obj;
+    pCdMan->pDexCache->GetOrderBook().ToJson(CAssetTradingPair(assetSymbol, coinSymbol), depth, withOrders, obj);
+    return obj;
+}
+
 void checkAccountRegId(const CUserID uid , const string field){
 
     if(!uid.is<CRegID>() || !uid.get<CRegID>().IsMature(chainActive.Height())){
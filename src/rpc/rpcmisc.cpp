@@ -12,6 +12,7 @@
 #include "rpc/core/rpccommons.h"
 #include "rpc/core/rpcserver.h"
 #include "commons/util/util.h"
+#include "vm/wasm/wasm_module_cache.hpp"
 
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
@@ -226,6 +227,7 @@ Value verifymessage(const Array& params, bool fHelp) {
     DEFINE( CONTRACT_DATA,        pContractCache,  contractDataCache) \
     DEFINE( CONTRACT_ACCOUNT,     pContractCache,  contractAccountCache) \
     DEFINE( CONTRACT_TRACES,      pContractCache,  contractTracesCache) \
+    DEFINE( CONTRACT_CODE_HASH,   pContractCache,  contractCodeHashCache) \
     /**** delegate db                                                                      */ \
     DEFINE( VOTE,                 pDelegateCache,  voteRegIdCache) \
     DEFINE( LAST_VOTE_HEIGHT,     pDelegateCache,  last_vote_height_cache) \
@@ -257,12 +259,21 @@ Value verifymessage(const Array& params, bool fHelp) {
     DEFINE( TX_UTXO,              pUtxoCache,   txUtxoCache)
 
 
-template<int32_t PREFIX_TYPE, typename KeyType, typename ValueType>
-string DbCacheToString(CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType> &cache) {
+template<int32_t PREFIX_TYPE, typename KeyType, typename ValueType, typename MapPolicy>
+string DbCacheToString(CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType, MapPolicy> &cache) {
     string str;
-    CDBIterator< CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType> > it(cache);
-    for(it.First(); it.IsValid(); it.Next()) {
-        str += strprintf("%s={%s},\n", db_util::ToString(it.GetKey()), db_util::ToString(it.GetValue()));
+    if constexpr (MapPolicy::IS_ORDERED) {
+        CDBIterator< CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType, MapPolicy> > it(cache);
+        for(it.First(); it.IsValid(); it.Next()) {
+            str += strprintf("%s={%s},\n", db_util::ToString(it.GetKey()), db_util::ToString(it.GetValue()));
+        }
+    } else {
+        // the hash map can't be iterated in the key order of the db, get all of the elements at once
+        map<KeyType, ValueType> elements;
+        cache.GetAllElements(elements);
+        for (const auto &item : elements) {
+            str += strprintf("%s={%s},\n", db_util::ToString(item.first), db_util::ToString(item.second));
+        }
     }
     return strprintf("-->%s, data={%s}\n", GetKeyPrefix(cache.PREFIX_TYPE), str);
 }
@@ -355,3 +366,240 @@ Value dumpdb(const Array& params, bool fHelp) {
 
     return Object();
 }
+
+Value getcachestats(const Array& params, bool fHelp) {
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getcachestats\n"
+            "\nget the memory usage and hit statistics of the node's in-memory caches\n"
+            "\nArguments:\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"sig_cache\": {                (object) the signature verification cache\n"
+            "    \"shards\": n,                (numeric) the number of independently locked shards\n"
+            "    \"entries\": n,               (numeric) the number of cached signatures\n"
+            "    \"bytes\": n,                 (numeric) the estimated memory used by the entries\n"
+            "    \"max_bytes\": n,             (numeric) the memory budget, see -maxsigcachesize\n"
+            "    \"hits\": n,                  (numeric) the number of lookups found in the cache\n"
+            "    \"misses\": n,                (numeric) the number of lookups not found in the cache\n"
+            "    \"evictions\": n              (numeric) the number of entries evicted\n"
+            "  },\n"
+            "  \"pubkey_cache\": {             (object) the parsed public keys of the signature verification\n"
+            "    \"shards\": n,                (numeric) the number of independently locked shards\n"
+            "    \"entries\": n,               (numeric) the number of parsed keys\n"
+            "    \"bytes\": n,                 (numeric) the estimated memory used by the entries\n"
+            "    \"max_bytes\": n,             (numeric) the memory budget, see -pubkeycache\n"
+            "    \"hits\": n,                  (numeric) the number of verifications using a parsed key\n"
+            "    \"misses\": n,                (numeric) the number of verifications parsing the key\n"
+            "    \"evictions\": n              (numeric) the number of keys evicted\n"
+            "  },\n"
+            "  \"block_summary_cache\": {      (object) the recent block summaries read back by ConnectBlock\n"
+            "    \"entries\": n,               (numeric) the number of cached block summaries\n"
+            "    \"bytes\": n,                 (numeric) the estimated memory used by the entries\n"
+            "    \"max_bytes\": n,             (numeric) the memory budget, see -blocksummarycache\n"
+            "    \"hits\": n,                  (numeric) the number of block reads saved\n"
+            "    \"misses\": n                 (numeric) the number of blocks read from disk\n"
+            "  },\n"
+            "  \"wasm_module_cache\": {        (object) the instantiated wasm contracts, keyed by code hash\n"
+            "    \"entries\": n,               (numeric) the number of instantiated modules\n"
+            "    \"bytes\": n,                 (numeric) the memory held by the modules and their compiled code\n"
+            "    \"max_bytes\": n,             (numeric) the memory budget, see -wasmmodulecache\n"
+            "    \"hits\": n,                  (numeric) the number of calls running an instantiated module\n"
+            "    \"misses\": n,                (numeric) the number of calls reading and instantiating the code\n"
+            "    \"evictions\": n              (numeric) the number of modules evicted\n"
+            "  },\n"
+            "  \"block_file_mappings\": {      (object) the block and undo files mapped into memory\n"
+            "    \"mappings\": n,              (numeric) the number of mapped files\n"
+            "    \"max_mappings\": n,          (numeric) the max number of mapped files, see -blockfilemmap\n"
+            "    \"hits\": n,                  (numeric) the number of blocks and undo data read from a mapping\n"
+            "    \"maps\": n,                  (numeric) the number of files mapped, or mapped again as they grew\n"
+            "    \"fallbacks\": n              (numeric) the number of blocks and undo data read through stdio\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getcachestats", "") + "\nAs json rpc\n" + HelpExampleRpc("getcachestats", "")
+        );
+
+    CSignatureCacheStats sigStats;
+    signatureCache.GetStats(sigStats);
+
+    Object sigCacheObj;
+    sigCacheObj.push_back(Pair("shards",        (int64_t)CSignatureCache::SHARD_COUNT));
+    sigCacheObj.push_back(Pair("entries",       sigStats.entries));
+    sigCacheObj.push_back(Pair("bytes",         sigStats.bytes));
+    sigCacheObj.push_back(Pair("max_bytes",     sigStats.max_bytes));
+    sigCacheObj.push_back(Pair("hits",          sigStats.hits));
+    sigCacheObj.push_back(Pair("misses",        sigStats.misses));
+    sigCacheObj.push_back(Pair("evictions",     sigStats.evictions));
+
+    CPubKeyCacheStats pubKeyStats;
+    pubKeyCache.GetStats(pubKeyStats);
+
+    Object pubKeyCacheObj;
+    pubKeyCacheObj.push_back(Pair("shards",     (int64_t)CPubKeyCache::SHARD_COUNT));
+    pubKeyCacheObj.push_back(Pair("entries",    pubKeyStats.entries));
+    pubKeyCacheObj.push_back(Pair("bytes",      pubKeyStats.bytes));
+    pubKeyCacheObj.push_back(Pair("max_bytes",  pubKeyStats.max_bytes));
+    pubKeyCacheObj.push_back(Pair("hits",       pubKeyStats.hits));
+    pubKeyCacheObj.push_back(Pair("misses",     pubKeyStats.misses));
+    pubKeyCacheObj.push_back(Pair("evictions",  pubKeyStats.evictions));
+
+    CBlockSummaryCacheStats blockStats;
+    blockSummaryCache.GetStats(blockStats);
+
+    Object blockCacheObj;
+    blockCacheObj.push_back(Pair("entries",     blockStats.entries));
+    blockCacheObj.push_back(Pair("bytes",       blockStats.bytes));
+    blockCacheObj.push_back(Pair("max_bytes",   blockStats.max_bytes));
+    blockCacheObj.push_back(Pair("hits",        blockStats.hits));
+    blockCacheObj.push_back(Pair("misses",      blockStats.misses));
+
+    wasm::wasm_module_cache_stats wasmStats;
+    wasm_code_cache_get_stats(wasmStats);
+
+    Object wasmCacheObj;
+    wasmCacheObj.push_back(Pair("entries",      wasmStats.entries));
+    wasmCacheObj.push_back(Pair("bytes",        wasmStats.bytes));
+    wasmCacheObj.push_back(Pair("max_bytes",    wasmStats.max_bytes));
+    wasmCacheObj.push_back(Pair("hits",         wasmStats.hits));
+    wasmCacheObj.push_back(Pair("misses",       wasmStats.misses));
+    wasmCacheObj.push_back(Pair("evictions",    wasmStats.evictions));
+
+    CDiskFileMapperStats mapperStats;
+    diskFileMapper.GetStats(mapperStats);
+
+    Object mapperObj;
+    mapperObj.push_back(Pair("mappings",        mapperStats.mappings));
+    mapperObj.push_back(Pair("max_mappings",    mapperStats.max_mappings));
+    mapperObj.push_back(Pair("hits",            mapperStats.hits));
+    mapperObj.push_back(Pair("maps",            mapperStats.maps));
+    mapperObj.push_back(Pair("fallbacks",       mapperStats.fallbacks));
+
+    Object obj;
+    obj.push_back(Pair("sig_cache", sigCacheObj));
+    obj.push_back(Pair("pubkey_cache", pubKeyCacheObj));
+    obj.push_back(Pair("block_summary_cache", blockCacheObj));
+    obj.push_back(Pair("wasm_module_cache", wasmCacheObj));
+    obj.push_back(Pair("block_file_mappings", mapperObj));
+    return obj;
+}
+
+Value getforkcachestats(const Array& params, bool fHelp) {
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getforkcachestats\n"
+            "\nget the memory used by the cached fork chain views\n"
+            "\nArguments:\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"fork_views\": [                 (array) the cached fork chain views\n"
+            "    {\n"
+            "      \"tip_hash\": \"hash\",          (string) the tip block hash of the fork view\n"
+            "      \"tip_height\": n,             (numeric) the tip block height of the fork view\n"
+            "      \"cache_size\": n              (numeric) the heap memory of the view's db caches, including the shared snapshot\n"
+            "    }\n"
+            "  ],\n"
+            "  \"snapshot_layers\": n,          (numeric) the number of copy-on-write snapshot layers alive\n"
+            "  \"snapshot_entries\": n,         (numeric) the number of items in the snapshot layers\n"
+            "  \"snapshot_bytes\": n            (numeric) the heap memory of the snapshot layers, shared by the views and the node's caches\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getforkcachestats", "") + "\nAs json rpc\n" + HelpExampleRpc("getforkcachestats", "")
+        );
+
+    LOCK(cs_main);
+
+    Array forkViews;
+    for (const auto &item : mapForkCache) {
+        auto it = mapBlockIndex.find(item.first);
+        Object forkView;
+        forkView.push_back(Pair("tip_hash",     item.first.GetHex()));
+        forkView.push_back(Pair("tip_height",   it != mapBlockIndex.end() ? it->second->height : -1));
+        forkView.push_back(Pair("cache_size",   (int64_t)item.second->GetCacheSize()));
+        forkViews.push_back(forkView);
+    }
+
+    Object obj;
+    obj.push_back(Pair("fork_views",        forkViews));
+    obj.push_back(Pair("snapshot_layers",   (int64_t)CDBCacheSnapshotStats::layers));
+    obj.push_back(Pair("snapshot_entries",  (int64_t)CDBCacheSnapshotStats::entries));
+    obj.push_back(Pair("snapshot_bytes",    (int64_t)CDBCacheSnapshotStats::bytes));
+    return obj;
+}
+
+Value getdbcachestats(const Array& params, bool fHelp) {
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getdbcachestats\n"
+            "\nget the heap memory used by the node's state db caches, which are flushed to disk when they exceed -dbcache\n"
+            "\nArguments:\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"budget\": n,                   (numeric) the memory budget of the caches in bytes, see -dbcache\n"
+            "  \"total\": n,                    (numeric) the heap memory used by the caches in bytes\n"
+            "  \"dbs\": {                       (object) the heap memory used by the caches of each db in bytes\n"
+            "    \"account\": n,\n"
+            "    ...\n"
+            "    \"tx_cache\": n,               (numeric) the txids of the recent blocks\n"
+            "    \"price_point_cache\": n       (numeric) the price points of the recent blocks\n"
+            "  },\n"
+            "  \"key_filters\": {               (object) the lookups of the keys missed by the caches, by key prefix\n"
+            "    \"idac\": {\n"
+            "      \"hits\": n,                 (numeric) the keys read from the db\n"
+            "      \"misses\": n,               (numeric) the keys not found in the db\n"
+            "      \"negative_hits\": n,        (numeric) the keys found absent by the negative cache, see -dbnegativecache\n"
+            "      \"bloom_skips\": n,          (numeric) the keys found absent by the bloom filter, see -dbbloomfilter\n"
+            "      \"negative_keys\": n,        (numeric) the keys in the negative cache\n"
+            "      \"bloom_keys\": n            (numeric) the keys in the bloom filter\n"
+            "    },\n"
+            "    ...\n"
+            "  },\n"
+            "  \"shared_values\": {             (object) the large values shared by the cache layers, such as the contracts\n"
+            "    \"allocs\": n,                 (numeric) the values allocated since the start, by a db read, a set or an undo\n"
+            "    \"shares\": n                  (numeric) the copies of a value by reference instead of a deep copy\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdbcachestats", "") + "\nAs json rpc\n" + HelpExampleRpc("getdbcachestats", "")
+        );
+
+    LOCK(cs_main);
+
+    map<string, uint64_t> cacheSizes;
+    pCdMan->GetCacheSizes(cacheSizes);
+
+    uint64_t total = 0;
+    Object dbs;
+    for (const auto &item : cacheSizes) {
+        dbs.push_back(Pair(item.first, item.second));
+        total += item.second;
+    }
+
+    map<dbk::PrefixType, CDBKeyFilterStats> filterStats;
+    pCdMan->GetKeyFilterStats(filterStats);
+
+    Object keyFilters;
+    for (const auto &item : filterStats) {
+        const CDBKeyFilterStats &stats = item.second;
+        Object prefixObj;
+        prefixObj.push_back(Pair("hits",            stats.hits));
+        prefixObj.push_back(Pair("misses",          stats.misses));
+        prefixObj.push_back(Pair("negative_hits",   stats.negative_hits));
+        prefixObj.push_back(Pair("bloom_skips",     stats.bloom_skips));
+        prefixObj.push_back(Pair("negative_keys",   stats.negative_keys));
+        prefixObj.push_back(Pair("bloom_keys",      stats.bloom_keys));
+        keyFilters.push_back(Pair(dbk::GetKeyPrefix(item.first), prefixObj));
+    }
+
+    Object sharedValues;
+    sharedValues.push_back(Pair("allocs",   (int64_t)CDBSharedValueStats::allocs));
+    sharedValues.push_back(Pair("shares",   (int64_t)CDBSharedValueStats::shares));
+
+    Object obj;
+    obj.push_back(Pair("budget",        SysCfg().GetCacheSize()));
+    obj.push_back(Pair("total",         total));
+    obj.push_back(Pair("dbs",           dbs));
+    obj.push_back(Pair("key_filters",   keyFilters));
+    obj.push_back(Pair("shared_values", sharedValues));
+    return obj;
+}
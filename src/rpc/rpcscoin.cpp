@@ -13,6 +13,7 @@
 #include "commons/util/util.h"
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
+#include "persistence/chainstatesnapshot.h"
 #include "tx/cdptx.h"
 #include "tx/pricefeedtx.h"
 #include "tx/assettx.h"
@@ -411,17 +412,18 @@ Value getusercdp(const Array& params, bool fHelp){
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid addr");
     }
 
+    CCacheWrapper &cw = GetRPCChainView().cw;
     CAccount account;
-    if (!pCdMan->pAccountCache->GetAccount(*pUserId, account)) {
+    if (!cw.accountCache.GetAccount(*pUserId, account)) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("The account not exists! userId=%s", pUserId->ToString()));
     }
 
-    uint64_t bcoinMedianPrice = pCdMan->pBlockCache->GetMedianPrice(CoinPricePair(SYMB::WICC, SYMB::USD));
+    uint64_t bcoinMedianPrice = cw.blockCache.GetMedianPrice(CoinPricePair(SYMB::WICC, SYMB::USD));
 
     Object obj;
     Array cdps;
     vector<CUserCDP> userCdps;
-    if (pCdMan->pCdpCache->GetCDPList(account.regid, userCdps)) {
+    if (cw.cdpCache.GetCDPList(account.regid, userCdps)) {
         for (auto& cdp : userCdps) {
             cdps.push_back(cdp.ToJson(bcoinMedianPrice));
         }
@@ -447,11 +449,12 @@ Value getcdp(const Array& params, bool fHelp){
         );
     }
 
-    uint64_t bcoinMedianPrice = pCdMan->pBlockCache->GetMedianPrice(CoinPricePair(SYMB::WICC, SYMB::USD));
+    CCacheWrapper &cw         = GetRPCChainView().cw;
+    uint64_t bcoinMedianPrice = cw.blockCache.GetMedianPrice(CoinPricePair(SYMB::WICC, SYMB::USD));
 
     uint256 cdpTxId(uint256S(params[0].get_str()));
     CUserCDP cdp;
-    if (!pCdMan->pCdpCache->GetCDP(cdpTxId, cdp)) {
+    if (!cw.cdpCache.GetCDP(cdpTxId, cdp)) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("CDP (%s) does not exist!", cdpTxId.GetHex()));
     }
 
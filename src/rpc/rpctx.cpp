@@ -14,6 +14,7 @@
 #include "wallet/walletdb.h"
 #include "persistence/blockdb.h"
 #include "persistence/txdb.h"
+#include "persistence/chainstatesnapshot.h"
 #include "config/configuration.h"
 #include "miner/miner.h"
 #include "main.h"
@@ -814,8 +815,10 @@ Value getaccountinfo(const Array& params, bool fHelp) {
     Object obj;
     bool found = false;
 
+    CChainStateReadView &view = GetRPCChainView();
+    CCacheWrapper &cw         = view.cw;
     CAccount account;
-    if (pCdMan->pAccountCache->GetAccount(userId, account)) {
+    if (cw.accountCache.GetAccount(userId, account)) {
         if (!account.owner_pubkey.IsValid()) {
             CPubKey pubKey;
             CPubKey minerPubKey;
@@ -828,7 +831,7 @@ Value getaccountinfo(const Array& params, bool fHelp) {
                 }
             }
         }
-        obj = account.ToJsonObj();
+        obj = account.ToJsonObj(cw.delegateCache, view.Height());
         obj.push_back(Pair("position", "inblock"));
 
         found = true;
@@ -842,7 +845,7 @@ Value getaccountinfo(const Array& params, bool fHelp) {
             if (minerPubKey != pubKey) {
                 account.miner_pubkey = minerPubKey;
             }
-            obj = account.ToJsonObj();
+            obj = account.ToJsonObj(cw.delegateCache, view.Height());
             obj.push_back(Pair("position", "inwallet"));
 
             found = true;
@@ -851,11 +854,10 @@ Value getaccountinfo(const Array& params, bool fHelp) {
 
     if (found) {
         // TODO: multi stable coin
-        uint64_t bcoinMedianPrice =
-            pCdMan->pBlockCache->GetMedianPrice(CoinPricePair(SYMB::WICC, SYMB::USD));
+        uint64_t bcoinMedianPrice = cw.blockCache.GetMedianPrice(CoinPricePair(SYMB::WICC, SYMB::USD));
         Array cdps;
         vector<CUserCDP> userCdps;
-        if (pCdMan->pCdpCache->GetCDPList(account.regid, userCdps)) {
+        if (cw.cdpCache.GetCDPList(account.regid, userCdps)) {
             for (auto& cdp : userCdps) {
                 cdps.push_back(cdp.ToJson(bcoinMedianPrice));
             }
@@ -885,6 +887,7 @@ static Value TestDisconnectBlock(int32_t number) {
                 return false;
             if (!pCdMan->pBlockIndexDb->EraseBlockIndex(pTipIndex->GetBlockHash()))
                 return false;
+            LOCK(cs_mapBlockIndex);
             mapBlockIndex.erase(pTipIndex->GetBlockHash());
         } while (--number);
     }
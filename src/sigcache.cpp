@@ -6,10 +6,35 @@
 
 #include "sigcache.h"
 
+CSignatureCache::CSignatureCache() : nMaxBytes(0), nMaxGenerationEntries(0), nHits(0), nMisses(0), nEvictions(0) {
+    // salted so that the shard and bucket of an entry can't be predicted by peers
+    salt = GetRandHash();
+    SetMaxSize(DEFAULT_MAX_SIG_CACHE_SIZE << 20);
+}
+
+void CSignatureCache::SetMaxSize(uint64_t nMaxBytesIn) {
+    nMaxBytes             = nMaxBytesIn;
+    nMaxGenerationEntries = nMaxBytesIn / SIG_CACHE_ENTRY_BYTES / SHARD_COUNT / 2;
+}
+
+void CSignatureCache::GetStats(CSignatureCacheStats &stats) {
+    stats.entries = 0;
+    for (auto &shard : shards) {
+        std::unique_lock<std::mutex> lock(shard.mtx);
+        stats.entries += shard.setValid[0].size() + shard.setValid[1].size();
+    }
+    stats.bytes     = stats.entries * SIG_CACHE_ENTRY_BYTES;
+    stats.max_bytes = nMaxBytes;
+    stats.hits      = nHits;
+    stats.misses    = nMisses;
+    stats.evictions = nEvictions;
+}
+
 void CSignatureCache::ComputeEntry(uint256& entry, const uint256& sigHash,
                                    const std::vector<unsigned char>& vchSig,
                                    const CPubKey& pubKey) {
     CSHA256()
+        .Write(salt.begin(), 32)
         .Write(sigHash.begin(), 32)
         .Write(&pubKey[0], pubKey.size())
         .Write(&vchSig[0], vchSig.size())
@@ -20,31 +45,137 @@ bool CSignatureCache::Get(const uint256& sigHash, const std::vector<unsigned cha
                           const CPubKey& pubKey) {
     uint256 entry;
     ComputeEntry(entry, sigHash, vchSig, pubKey);
-    std::unique_lock<std::mutex> lock(mtx);
-    return setValid.count(entry);
+
+    CShard &shard = GetShard(entry);
+    {
+        std::unique_lock<std::mutex> lock(shard.mtx);
+        if (shard.setValid[shard.current].count(entry) || shard.setValid[shard.current ^ 1].count(entry)) {
+            ++nHits;
+            return true;
+        }
+    }
+
+    ++nMisses;
+    return false;
 }
 
 void CSignatureCache::Set(const uint256& sigHash, const std::vector<unsigned char>& vchSig,
                           const CPubKey& pubKey) {
-    static int64_t nMaxCacheSize = SysCfg().GetArg("-maxsigcachesize", 50000);
-    if (nMaxCacheSize <= 0) return;
+    const uint64_t nMaxEntries = nMaxGenerationEntries;
+    if (nMaxEntries == 0) return;
 
     uint256 entry;
     ComputeEntry(entry, sigHash, vchSig, pubKey);
 
+    CShard &shard = GetShard(entry);
+    std::unique_lock<std::mutex> lock(shard.mtx);
+
+    if (shard.setValid[shard.current].size() >= nMaxEntries) {
+        // Drop the previous generation as a whole and start a new one. The erased
+        // entries are the oldest ones of the shard, and since the shard is chosen by
+        // a salted hash, peers can't aim at evicting particular signatures.
+        UnorderedHashSet &previous = shard.setValid[shard.current ^ 1];
+        nEvictions += previous.size();
+        previous.clear();
+        shard.current ^= 1;
+    }
+
+    shard.setValid[shard.current].insert(entry);
+}
+
+void CSigCheckQueue::Start(int32_t nThreads) {
     std::unique_lock<std::mutex> lock(mtx);
+    if (running) return;
+
+    running = true;
+    for (int32_t i = 0; i < nThreads; i++)
+        workers.emplace_back(&CSigCheckQueue::ThreadWorker, this);
+}
+
+void CSigCheckQueue::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (!running) return;
+
+        running = false;
+        condWorker.notify_all();
+    }
 
-    while (static_cast<int64_t>(setValid.size()) > nMaxCacheSize) {
-        // Evict a random entry. Random because that helps
-        // foil would-be DoS attackers who might try to pre-generate
-        // and re-use a set of valid signatures just-slightly-greater
-        // than our cache size.
-        UnorderedHashSet::size_type s       = GetRand(setValid.bucket_count());
-        UnorderedHashSet::local_iterator it = setValid.begin(s);
-        if (it != setValid.end(s)) {
-            setValid.erase(*it);
+    for (auto &worker : workers)
+        worker.join();
+
+    workers.clear();
+}
+
+void CSigCheckQueue::ProcessChecks(const std::vector<CSigCheck> &checks, CSignatureCache &cache) {
+    size_t i;
+    while ((i = nNextCheck.fetch_add(1)) < checks.size()) {
+        const CSigCheck &check = checks[i];
+        if (cache.Get(check.sigHash, check.vchSig, check.pubKey))
+            continue;
+
+        if (check.pubKey.Verify(check.sigHash, check.vchSig))
+            cache.Set(check.sigHash, check.vchSig, check.pubKey);
+    }
+}
+
+void CSigCheckQueue::ThreadWorker() {
+    RenameThread("coin-sigcheck");
+
+    uint64_t nLastBatchId = 0;
+    while (true) {
+        const std::vector<CSigCheck> *pBatch = nullptr;
+        CSignatureCache *pBatchCache         = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            while (running && nBatchId == nLastBatchId)
+                condWorker.wait(lock);
+
+            // a pending batch is always finished, Verify() is waiting for it
+            if (nBatchId == nLastBatchId) break;
+
+            nLastBatchId = nBatchId;
+            pBatch       = pChecks;
+            pBatchCache  = pCache;
         }
+
+        ProcessChecks(*pBatch, *pBatchCache);
+
+        std::unique_lock<std::mutex> lock(mtx);
+        if (++nIdleWorkers == nBatchWorkers)
+            condMaster.notify_one();
+    }
+}
+
+void CSigCheckQueue::Verify(const std::vector<CSigCheck> &checks, CSignatureCache &cache) {
+    if (checks.empty()) return;
+
+    std::unique_lock<std::mutex> batchLock(mtxBatch);
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (!running || workers.empty() || checks.size() == 1) {
+            lock.unlock();
+            nNextCheck = 0;
+            ProcessChecks(checks, cache);
+            return;
+        }
+
+        pChecks       = &checks;
+        pCache        = &cache;
+        nNextCheck    = 0;
+        nIdleWorkers  = 0;
+        nBatchWorkers = workers.size();
+        ++nBatchId;
+        condWorker.notify_all();
     }
 
-    setValid.insert(entry);
+    ProcessChecks(checks, cache);
+
+    // wait for all workers to finish their in-flight checks before the batch goes out of scope
+    std::unique_lock<std::mutex> lock(mtx);
+    while (nIdleWorkers < nBatchWorkers)
+        condMaster.wait(lock);
+
+    pChecks = nullptr;
+    pCache  = nullptr;
 }
@@ -7,7 +7,10 @@
 #ifndef COIN_SIGCACHE_H
 #define COIN_SIGCACHE_H
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 #include "config/chainparams.h"
@@ -17,20 +20,60 @@
 #include "commons/uint256.h"
 #include "commons/util/util.h"
 
+/** -maxsigcachesize default, in megabytes */
+static const int64_t DEFAULT_MAX_SIG_CACHE_SIZE = 32;
+/** Approximate heap cost of one cached entry: the uint256, node link and cached hash, malloc
+ *  overhead and one bucket pointer of the unordered_set */
+static const size_t SIG_CACHE_ENTRY_BYTES = sizeof(uint256) + 2 * sizeof(void*) + 16 + sizeof(void*);
+
+struct CSignatureCacheStats {
+    uint64_t entries   = 0;
+    uint64_t bytes     = 0;
+    uint64_t max_bytes = 0;
+    uint64_t hits      = 0;
+    uint64_t misses    = 0;
+    uint64_t evictions = 0;
+};
+
 /**
  * Valid signature cache, to avoid doing expensive ECDSA signature checking
  * twice for every transaction (once when accepted into memory pool, and
  * again when accepted into the block chain)
+ *
+ * The entries are spread over SHARD_COUNT independently locked shards so that
+ * RPC submission, P2P relay and block validation don't contend on one mutex.
+ * Each shard keeps two generations of entries; once the current generation is
+ * full the previous one is dropped as a whole and the generations are rotated,
+ * so the memory stays within the byte budget without per-entry eviction work.
  */
 class CSignatureCache {
+public:
+    static const uint32_t SHARD_COUNT = 16;
+
 private:
-    //! Entries are SHA256(signature hash || public key || signature):
-    UnorderedHashSet setValid;
-    std::mutex mtx;
+    struct CShard {
+        std::mutex mtx;
+        //! Entries are SHA256(salt || signature hash || public key || signature):
+        UnorderedHashSet setValid[2];
+        uint32_t current = 0;  //!< index of the current generation in setValid
+    };
+
+    CShard shards[SHARD_COUNT];
+    uint256 salt;
+    std::atomic<uint64_t> nMaxBytes;
+    std::atomic<uint64_t> nMaxGenerationEntries;  //!< per shard and per generation
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+    std::atomic<uint64_t> nEvictions;
 
 public:
-    CSignatureCache() {}
+    CSignatureCache();
     ~CSignatureCache() {}
+
+    /** Set the memory budget of the cache in bytes, 0 disables caching */
+    void SetMaxSize(uint64_t nMaxBytesIn);
+    void GetStats(CSignatureCacheStats &stats);
+
     bool Get(const uint256& sigHash, const std::vector<unsigned char>& vchSig,
              const CPubKey& pubKey);
     void Set(const uint256& sigHash, const std::vector<unsigned char>& vchSig,
@@ -39,6 +82,66 @@ public:
 private:
     void ComputeEntry(uint256& entry, const uint256& sigHash,
                       const std::vector<unsigned char>& vchSig, const CPubKey& pubKey);
+    CShard& GetShard(const uint256& entry) { return shards[*entry.begin() % SHARD_COUNT]; }
+};
+
+/** -par default (number of signature verification threads, 0 = auto) */
+static const int32_t DEFAULT_SIGCHECK_THREADS = 0;
+/** Maximum number of signature verification threads */
+static const int32_t MAX_SIGCHECK_THREADS = 16;
+
+/** A pending signature check: (signature hash, public key, signature) */
+struct CSigCheck {
+    uint256 sigHash;
+    CPubKey pubKey;
+    std::vector<unsigned char> vchSig;
+
+    CSigCheck() {}
+    CSigCheck(const uint256 &sigHashIn, const CPubKey &pubKeyIn, const std::vector<unsigned char> &vchSigIn)
+        : sigHash(sigHashIn), pubKey(pubKeyIn), vchSig(vchSigIn) {}
+};
+
+/**
+ * Worker pool which verifies a batch of signatures in parallel ahead of the serial
+ * CheckTx pass. Valid signatures are stored in the signature cache so the later
+ * VerifySignature() calls become cache hits; invalid ones are simply left out and
+ * get rejected again (with the proper DoS state) by CheckTx.
+ */
+class CSigCheckQueue {
+private:
+    std::mutex mtx;
+    std::condition_variable condWorker;
+    std::condition_variable condMaster;
+    std::vector<std::thread> workers;
+    bool running;
+
+    //! the batch being verified, guarded by mtx and only valid while nBatchId is current
+    const std::vector<CSigCheck> *pChecks;
+    CSignatureCache *pCache;
+    std::atomic<size_t> nNextCheck;
+    uint64_t nBatchId;
+    int32_t nIdleWorkers;
+    int32_t nBatchWorkers;
+
+    //! serializes Verify() callers, one batch at a time
+    std::mutex mtxBatch;
+
+public:
+    CSigCheckQueue() : running(false), pChecks(nullptr), pCache(nullptr), nNextCheck(0), nBatchId(0), nIdleWorkers(0),
+                       nBatchWorkers(0) {}
+    ~CSigCheckQueue() { Stop(); }
+
+    /** Start nThreads worker threads, the calling thread of Verify() always takes part as well */
+    void Start(int32_t nThreads);
+    void Stop();
+    int32_t GetThreadCount() { return workers.size() + 1; }
+
+    /** Verify all checks and store the valid ones into cache, returns when the whole batch is done */
+    void Verify(const std::vector<CSigCheck> &checks, CSignatureCache &cache);
+
+private:
+    void ThreadWorker();
+    void ProcessChecks(const std::vector<CSigCheck> &checks, CSignatureCache &cache);
 };
 
 #endif  // COIN_SIGCACHE_H
\ No newline at end of file
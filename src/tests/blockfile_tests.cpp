@@ -0,0 +1,182 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "persistence/block.h"
+#include "persistence/disk.h"
+#include "tx/blockrewardtx.h"
+#include "tx/cointransfertx.h"
+#include "commons/util/time.h"
+#include "main.h"
+
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const int32_t SCRATCH_FILE     = 99999;  // block file number of the tests, removed when done
+static const int32_t BLOCK_HEIGHT     = 1000;
+static const uint32_t BLOCK_TXS       = 2000;
+static const uint32_t BENCH_READS     = 200;
+static const uint32_t SERVE_BLOCKS    = 100;    // historic blocks served by the mmap bench
+static const uint32_t SERVE_BLOCK_TXS = 200;
+static const uint32_t SERVE_READS     = 10000;
+
+// blocks of transfers appended to the scratch block file, with the positions of the txs of the first one as the
+// tx index saves them in ConnectBlock()
+struct CBlockFileTestEnv {
+    vector<CBlock> blocks;
+    vector<CDiskBlockPos> blockPos;
+    vector<CDiskTxPos> txPos;
+    uint32_t nFileSize = 0;
+
+    CBlockFileTestEnv(uint32_t blockCount, uint32_t txCount) {
+        for (uint32_t i = 0; i < blockCount; i++)
+            AppendBlock(txCount);
+
+        CDiskTxPos pos(blockPos[0], GetSizeOfCompactSize(blocks[0].vptx.size()));
+        for (const auto &pTx : blocks[0].vptx) {
+            txPos.push_back(pos);
+            pos.nTxOffset += ::GetSerializeSize(pTx, SER_DISK, CLIENT_VERSION);
+        }
+    }
+
+    ~CBlockFileTestEnv() {
+        boost::filesystem::remove(GetDataDir() / "blocks" / strprintf("blk%05u.dat", SCRATCH_FILE));
+    }
+
+    void AppendBlock(uint32_t txCount) {
+        CBlock block;
+        block.SetHeight(BLOCK_HEIGHT + blocks.size());
+        block.vptx.push_back(std::make_shared<CBlockRewardTx>());
+        for (uint32_t i = 1; i < txCount; i++)
+            block.vptx.push_back(std::make_shared<CCoinTransferTx>(CRegID(1, i), CRegID(1, i + 1), BLOCK_HEIGHT,
+                                                                   SYMB::WICC, COIN + blocks.size(), SYMB::WICC,
+                                                                   10000, std::to_string(i)));
+        block.SetMerkleRootHash(block.BuildMerkleTree());
+
+        CDiskBlockPos pos(SCRATCH_FILE, nFileSize);
+        BOOST_REQUIRE(WriteBlockToDisk(block, pos));
+        nFileSize = pos.nPos + ::GetSerializeSize(block, SER_DISK, CLIENT_VERSION);
+
+        blocks.push_back(block);
+        blockPos.push_back(pos);
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(blockfile_tests)
+
+BOOST_AUTO_TEST_CASE(blockfile_read_tx_test)
+{
+    CBlockFileTestEnv env(1, BLOCK_TXS);
+    const CBlock &block = env.blocks[0];
+    for (uint32_t i = 0; i < BLOCK_TXS; i += 97) {
+        std::shared_ptr<CBaseTx> pTx;
+        CBlockHeader header;
+        BOOST_REQUIRE(ReadTxFromDisk(env.txPos[i], pTx, &header));
+        BOOST_CHECK(pTx->GetHash() == block.vptx[i]->GetHash());
+        BOOST_CHECK(header.GetHash() == block.GetHash());
+    }
+
+    // the last tx, without the header
+    std::shared_ptr<CBaseTx> pTx;
+    BOOST_REQUIRE(ReadTxFromDisk(env.txPos.back(), pTx));
+    BOOST_CHECK(pTx->GetHash() == block.vptx.back()->GetHash());
+}
+
+// the tx lookups of gettxdetail: the tx read at its position against the whole block read
+BOOST_AUTO_TEST_CASE(blockfile_read_tx_bench)
+{
+    CBlockFileTestEnv env(1, BLOCK_TXS);
+    const CBlock &block = env.blocks[0];
+
+    int64_t nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < BENCH_READS; i++) {
+        uint32_t index = (i * 7919) % BLOCK_TXS;
+        CBlock blockRead;
+        BOOST_REQUIRE(ReadBlockFromDisk(env.blockPos[0], blockRead));
+        BOOST_CHECK(blockRead.vptx[index]->GetHash() == block.vptx[index]->GetHash());
+    }
+    int64_t nBlockRead = GetTimeMicros() - nStart;
+
+    nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < BENCH_READS; i++) {
+        uint32_t index = (i * 7919) % BLOCK_TXS;
+        std::shared_ptr<CBaseTx> pTx;
+        CBlockHeader header;
+        BOOST_REQUIRE(ReadTxFromDisk(env.txPos[index], pTx, &header));
+        BOOST_CHECK(pTx->GetHash() == block.vptx[index]->GetHash());
+    }
+    int64_t nTxRead = GetTimeMicros() - nStart;
+
+    BOOST_TEST_MESSAGE(strprintf("blockfile read tx bench: txs=%u, reads=%u, block=%.1fus/read, tx=%.1fus/read",
+                                 BLOCK_TXS, BENCH_READS, nBlockRead / (double)BENCH_READS,
+                                 nTxRead / (double)BENCH_READS));
+}
+
+// the blocks read from the mapped file are the ones read through stdio, a file appended is mapped again
+BOOST_AUTO_TEST_CASE(blockfile_mmap_test)
+{
+    CBlockFileTestEnv env(3, BLOCK_TXS / 10);
+    diskFileMapper.SetMaxMappings(4);
+
+    CDiskFileMapperStats stats, newStats;
+    diskFileMapper.GetStats(stats);
+    for (uint32_t i = 0; i < env.blocks.size(); i++) {
+        CBlock block;
+        BOOST_REQUIRE(ReadBlockFromDisk(env.blockPos[i], block));
+        BOOST_CHECK(block.GetHash() == env.blocks[i].GetHash());
+        BOOST_CHECK(block.BuildMerkleTree() == env.blocks[i].GetMerkleRootHash());
+    }
+
+    std::shared_ptr<CBaseTx> pTx;
+    CBlockHeader header;
+    BOOST_REQUIRE(ReadTxFromDisk(env.txPos.back(), pTx, &header));
+    BOOST_CHECK(pTx->GetHash() == env.blocks[0].vptx.back()->GetHash());
+    BOOST_CHECK(header.GetHash() == env.blocks[0].GetHash());
+
+    diskFileMapper.GetStats(newStats);
+    BOOST_CHECK_EQUAL(newStats.hits, stats.hits + 4);
+    BOOST_CHECK_EQUAL(newStats.maps, stats.maps + 1);
+    BOOST_CHECK_EQUAL(newStats.fallbacks, stats.fallbacks);
+
+    env.AppendBlock(BLOCK_TXS / 10);
+    CBlock block;
+    BOOST_REQUIRE(ReadBlockFromDisk(env.blockPos.back(), block));
+    BOOST_CHECK(block.GetHash() == env.blocks.back().GetHash());
+    diskFileMapper.GetStats(stats);
+    BOOST_CHECK_EQUAL(stats.maps, newStats.maps + 1);
+    BOOST_CHECK_EQUAL(stats.mappings, 1U);
+
+    diskFileMapper.SetMaxMappings(0);
+    diskFileMapper.GetStats(stats);
+    BOOST_CHECK_EQUAL(stats.mappings, 0U);
+}
+
+// peers served historic blocks, read through stdio and from the mapped file
+BOOST_AUTO_TEST_CASE(blockfile_mmap_bench)
+{
+    CBlockFileTestEnv env(SERVE_BLOCKS, SERVE_BLOCK_TXS);
+
+    int64_t nMicros[2];
+    for (int32_t mapped = 0; mapped < 2; mapped++) {
+        diskFileMapper.SetMaxMappings(mapped ? 4 : 0);
+        int64_t nStart = GetTimeMicros();
+        for (uint32_t i = 0; i < SERVE_READS; i++) {
+            uint32_t index = (i * 7919) % SERVE_BLOCKS;
+            CBlock block;
+            BOOST_REQUIRE(ReadBlockFromDisk(env.blockPos[index], block));
+            BOOST_CHECK_EQUAL(block.vptx.size(), SERVE_BLOCK_TXS);
+        }
+        nMicros[mapped] = GetTimeMicros() - nStart;
+    }
+    diskFileMapper.SetMaxMappings(0);
+
+    BOOST_TEST_MESSAGE(strprintf("blockfile mmap bench: blocks=%u, txs=%u, reads=%u, stdio=%.2fms (%.0f blocks/s), "
+                                 "mmap=%.2fms (%.0f blocks/s)", SERVE_BLOCKS, SERVE_BLOCK_TXS, SERVE_READS,
+                                 nMicros[0] * 0.001, SERVE_READS * 1e6 / nMicros[0], nMicros[1] * 0.001,
+                                 SERVE_READS * 1e6 / nMicros[1]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
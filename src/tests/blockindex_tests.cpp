@@ -0,0 +1,179 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "persistence/blockdb.h"
+#include "commons/util/time.h"
+
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const uint32_t TEST_BLOCKS  = 10000;
+static const uint32_t FORK_BLOCKS  = 10;        // a side branch forked at the middle of the chain
+static const uint32_t BENCH_BLOCKS = 20000000;  // needs ~20GB, run with --run_test=blockindex_tests/blockindex_load_bench
+static const uint32_t LOAD_THREADS = 4;
+
+// write a synthetic chain of block indexes to the db, returns the hash of its tip
+static uint256 WriteChain(CBlockIndexDB &db, uint32_t blockCount, uint32_t forkCount) {
+    uint256 prevHash, forkHash, tipHash;
+    CLevelDBBatch batch;
+    for (uint32_t i = 0; i < blockCount + forkCount; i++) {
+        bool fFork = i >= blockCount;
+        CDiskBlockIndex diskIndex;
+        diskIndex.height         = fFork ? blockCount / 2 + (i - blockCount) + 1 : i;
+        diskIndex.nStatus        = BLOCK_VALID_TRANSACTIONS | BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO;
+        diskIndex.nTx            = 1 + i % 100;
+        diskIndex.nFile          = i / 10000;
+        diskIndex.nDataPos       = i * 100;
+        diskIndex.nUndoPos       = i * 10;
+        diskIndex.nVersion       = 1;
+        diskIndex.hashPrev       = (fFork && i == blockCount) ? forkHash : prevHash;
+        diskIndex.merkleRootHash = ArithToUint256(arith_uint256(i + 1));
+        diskIndex.nTime          = 1570000000 + i * 3;
+        diskIndex.nNonce         = i;
+        diskIndex.nFuelRate      = 100;
+        diskIndex.vSignature.assign(72, (uint8_t)i);
+        diskIndex.miner          = CRegID(1 + i % 11, 1);
+
+        prevHash = diskIndex.GetBlockHash();
+        if (!fFork && diskIndex.height == (int32_t)blockCount / 2)
+            forkHash = prevHash;
+        if (i + 1 == blockCount)
+            tipHash = prevHash;
+
+        batch.Write(dbk::GenDbKey(dbk::BLOCK_INDEX, prevHash), diskIndex);
+        if ((i + 1) % 100000 == 0) {
+            db.WriteBatch(batch);
+            batch = CLevelDBBatch();
+        }
+    }
+    db.WriteBatch(batch);
+    return tipHash;
+}
+
+// the loading before the arena and the parallel deserialization: an ordered map, an allocation per index
+// and a sort by height
+static void LoadSerial(CBlockIndexDB &db, map<uint256, CBlockIndex *> &blockMap,
+                       vector<pair<int32_t, CBlockIndex *>> &sortedByHeight) {
+    auto insert = [&](const uint256 &hash) -> CBlockIndex * {
+        if (hash.IsNull())
+            return nullptr;
+        auto it = blockMap.find(hash);
+        if (it != blockMap.end())
+            return it->second;
+        it = blockMap.emplace(hash, new CBlockIndex()).first;
+        it->second->pBlockHash = &it->first;
+        return it->second;
+    };
+
+    unique_ptr<leveldb::Iterator> pCursor(db.NewIterator());
+    const string &prefix = dbk::GetKeyPrefix(dbk::BLOCK_INDEX);
+    for (pCursor->Seek(prefix); pCursor->Valid() && pCursor->key().starts_with(prefix); pCursor->Next()) {
+        leveldb::Slice slValue = pCursor->value();
+        CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+        CDiskBlockIndex diskIndex;
+        ssValue >> diskIndex;
+
+        CBlockIndex *pIndex = insert(diskIndex.GetBlockHash());
+        const uint256 *pBlockHash = pIndex->pBlockHash;
+        *pIndex            = diskIndex;
+        pIndex->pBlockHash = pBlockHash;
+        pIndex->pprev      = insert(diskIndex.hashPrev);
+    }
+
+    for (const auto &item : blockMap)
+        sortedByHeight.push_back(make_pair(item.second->height, item.second));
+    sort(sortedByHeight.begin(), sortedByHeight.end());
+}
+
+BOOST_AUTO_TEST_SUITE(blockindex_tests)
+
+BOOST_AUTO_TEST_CASE(blockindex_load_test)
+{
+    CBlockIndexDB db(true, true);
+    uint256 tipHash = WriteChain(db, TEST_BLOCKS, FORK_BLOCKS);
+
+    BlockMap blockMap;
+    CBlockIndexArena arena;
+    vector<CBlockIndex *> indexesByHeight;
+    BOOST_CHECK(db.LoadBlockIndexes(blockMap, arena, indexesByHeight, LOAD_THREADS));
+    BOOST_CHECK_EQUAL(blockMap.size(), TEST_BLOCKS + FORK_BLOCKS);
+    BOOST_CHECK_EQUAL(arena.Size(), blockMap.size());
+    BOOST_CHECK_EQUAL(indexesByHeight.size(), blockMap.size());
+
+    for (size_t i = 1; i < indexesByHeight.size(); i++)
+        BOOST_CHECK(indexesByHeight[i - 1]->height <= indexesByHeight[i]->height);
+
+    for (const auto &item : blockMap) {
+        const CBlockIndex *pIndex = item.second;
+        BOOST_CHECK(pIndex->GetBlockHash() == item.first);
+        BOOST_CHECK_EQUAL(pIndex->nTx, 1 + pIndex->nNonce % 100);
+        BOOST_CHECK_EQUAL(pIndex->vSignature.size(), 72U);
+        if (pIndex->height == 0)
+            BOOST_CHECK(pIndex->pprev == nullptr);
+        else
+            BOOST_CHECK(pIndex->pprev != nullptr && pIndex->pprev->height == pIndex->height - 1);
+    }
+
+    // the chain is walked back from the tip to the genesis block
+    auto it = blockMap.find(tipHash);
+    BOOST_REQUIRE(it != blockMap.end());
+    uint32_t count = 0;
+    for (const CBlockIndex *pIndex = it->second; pIndex; pIndex = pIndex->pprev)
+        count++;
+    BOOST_CHECK_EQUAL(count, TEST_BLOCKS);
+
+    // a single thread loads the same indexes
+    BlockMap serialMap;
+    CBlockIndexArena serialArena;
+    vector<CBlockIndex *> serialByHeight;
+    BOOST_CHECK(db.LoadBlockIndexes(serialMap, serialArena, serialByHeight, 1));
+    BOOST_CHECK_EQUAL(serialMap.size(), blockMap.size());
+    for (const auto &item : serialMap) {
+        auto blockIt = blockMap.find(item.first);
+        BOOST_REQUIRE(blockIt != blockMap.end());
+        BOOST_CHECK_EQUAL(item.second->height, blockIt->second->height);
+        BOOST_CHECK((item.second->pprev == nullptr) == (blockIt->second->pprev == nullptr));
+        if (item.second->pprev)
+            BOOST_CHECK(item.second->pprev->GetBlockHash() == blockIt->second->pprev->GetBlockHash());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(blockindex_load_bench, *boost::unit_test::disabled())
+{
+    CBlockIndexDB db(true, true);
+    int64_t nStart = GetTimeMillis();
+    WriteChain(db, BENCH_BLOCKS, 0);
+    int64_t nWrite = GetTimeMillis() - nStart;
+
+    int64_t nSerial;
+    {
+        nStart = GetTimeMillis();
+        map<uint256, CBlockIndex *> blockMap;
+        vector<pair<int32_t, CBlockIndex *>> sortedByHeight;
+        LoadSerial(db, blockMap, sortedByHeight);
+        nSerial = GetTimeMillis() - nStart;
+        BOOST_CHECK_EQUAL(sortedByHeight.size(), BENCH_BLOCKS);
+
+        for (const auto &item : blockMap)
+            delete item.second;
+    }
+
+    uint32_t nThreads = max(std::thread::hardware_concurrency(), 1U);
+    nStart = GetTimeMillis();
+    BlockMap blockMap;
+    CBlockIndexArena arena;
+    vector<CBlockIndex *> indexesByHeight;
+    BOOST_CHECK(db.LoadBlockIndexes(blockMap, arena, indexesByHeight, nThreads));
+    int64_t nLoad = GetTimeMillis() - nStart;
+    BOOST_CHECK_EQUAL(indexesByHeight.size(), BENCH_BLOCKS);
+
+    BOOST_TEST_MESSAGE(strprintf("blockindex load bench: blocks=%u, threads=%u, write=%dms, serial=%dms, load=%dms",
+                                 BENCH_BLOCKS, nThreads, nWrite, nSerial, nLoad));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,262 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "tx/cointransfertx.h"
+#include "persistence/cachewrapper.h"
+#include "crypto/hash.h"
+#include "commons/util/time.h"
+#include "main.h"
+
+#include <algorithm>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const int32_t BLOCK_HEIGHT  = 1000;
+static const uint32_t FUEL_RATE    = 100;
+static const uint32_t BLOCK_TIME   = 1570000000;
+static const uint32_t ACCOUNT_NUM  = 2000;
+static const uint64_t INIT_BALANCE = 1000 * COIN;
+
+static CKeyID MakeKeyId(uint32_t index) { return CKeyID(Hash160(std::to_string(index))); }
+
+static void InitAccounts(CCacheWrapper &cw) {
+    for (uint32_t i = 0; i < ACCOUNT_NUM; i++) {
+        CAccount account(MakeKeyId(i));
+        account.regid = CRegID(1, i + 1);
+        account.OperateBalance(SYMB::WICC, BalanceOpType::ADD_FREE, INIT_BALANCE);
+        BOOST_REQUIRE(cw.accountCache.SaveAccount(account));
+    }
+}
+
+// every 5th tx transfers more than the sender has and fails to be packed
+static void MakeTxs(vector<std::shared_ptr<CBaseTx>> &txs, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t from   = (i * 7) % ACCOUNT_NUM;
+        uint32_t to     = (i * 13 + 1) % ACCOUNT_NUM;
+        uint64_t amount = (i % 5 == 4) ? 2 * INIT_BALANCE : COIN;
+        txs.push_back(std::make_shared<CCoinTransferTx>(CRegID(1, from + 1), CRegID(1, to + 1), BLOCK_HEIGHT,
+                                                        SYMB::WICC, amount, SYMB::WICC, 10000, std::to_string(i)));
+        txs.back()->nFuelRate = FUEL_RATE;
+    }
+}
+
+static bool ExecuteTx(CBaseTx &tx, CCacheWrapper &cw, int32_t index) {
+    CValidationState state;
+    CTxExecuteContext context(BLOCK_HEIGHT, index, FUEL_RATE, BLOCK_TIME, BLOCK_TIME, &cw, &state,
+                              transaction_status_type::mining);
+    return tx.ExecuteTx(context);
+}
+
+// the packing loop of the miner before the savepoint, a child cache wrapper constructed and flushed per tx
+static uint32_t PackWithChildCache(const vector<std::shared_ptr<CBaseTx>> &txs, CCacheWrapper &cw) {
+    uint32_t packed = 0;
+    for (uint32_t i = 0; i < txs.size(); i++) {
+        auto spCW = std::make_shared<CCacheWrapper>(&cw);
+        if (!ExecuteTx(*txs[i], *spCW, i + 1))
+            continue;
+
+        spCW->Flush();
+        packed++;
+    }
+    return packed;
+}
+
+static uint32_t PackWithSavepoint(const vector<std::shared_ptr<CBaseTx>> &txs, CCacheWrapper &cw) {
+    uint32_t packed = 0;
+    for (uint32_t i = 0; i < txs.size(); i++) {
+        CCacheSavepoint savepoint(cw);
+        if (!ExecuteTx(*txs[i], cw, i + 1)) {
+            savepoint.Rollback();
+            continue;
+        }
+        packed++;
+    }
+    return packed;
+}
+
+template <typename T>
+static string Serialize(const T &obj) {
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << obj;
+    return ss.str();
+}
+
+static void CheckSameAccounts(CCacheWrapper &cw1, CCacheWrapper &cw2) {
+    for (uint32_t i = 0; i < ACCOUNT_NUM; i++) {
+        CAccount account1, account2;
+        BOOST_CHECK(cw1.accountCache.GetAccount(MakeKeyId(i), account1));
+        BOOST_CHECK(cw2.accountCache.GetAccount(MakeKeyId(i), account2));
+        BOOST_CHECK(Serialize(account1) == Serialize(account2));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(cachewrapper_tests)
+
+BOOST_AUTO_TEST_CASE(cachewrapper_savepoint_test)
+{
+    CCacheWrapper base;
+    InitAccounts(base);
+    uint256 bestBlock = uint256S("0x1234");
+    BOOST_CHECK(base.blockCache.SetBestBlock(bestBlock));
+
+    CCacheWrapper cw(&base);
+    CCacheWrapper expected(&base);
+    vector<std::shared_ptr<CBaseTx>> txs;
+    MakeTxs(txs, 5);
+    BOOST_CHECK(ExecuteTx(*txs[0], cw, 1));
+    BOOST_CHECK(ExecuteTx(*txs[0], expected, 1));
+
+    {
+        CCacheSavepoint savepoint(cw);
+        // a new account, a changed one and a simple value set without reading it first
+        CAccount account(MakeKeyId(ACCOUNT_NUM));
+        account.regid = CRegID(1, ACCOUNT_NUM + 1);
+        BOOST_CHECK(cw.accountCache.SaveAccount(account));
+        BOOST_CHECK(ExecuteTx(*txs[1], cw, 2));
+        BOOST_CHECK(cw.blockCache.SetBestBlock(uint256S("0x5678")));
+        savepoint.Rollback();
+
+        BOOST_CHECK(!cw.accountCache.HaveAccount(MakeKeyId(ACCOUNT_NUM)));
+        BOOST_CHECK(cw.blockCache.GetBestBlockHash() == bestBlock);
+        CheckSameAccounts(cw, expected);
+
+        // logging goes on after a rollback, the later tx is kept
+        BOOST_CHECK(ExecuteTx(*txs[2], cw, 2));
+        BOOST_CHECK(ExecuteTx(*txs[2], expected, 2));
+    }
+
+    // the failed tx leaves no trace
+    {
+        CCacheSavepoint savepoint(cw);
+        BOOST_CHECK(!ExecuteTx(*txs[4], cw, 3));
+        savepoint.Rollback();
+    }
+    CheckSameAccounts(cw, expected);
+}
+
+BOOST_AUTO_TEST_CASE(cachewrapper_packing_bench)
+{
+    CCacheWrapper base;
+    InitAccounts(base);
+
+    vector<std::shared_ptr<CBaseTx>> txs;
+    MakeTxs(txs, 5000);
+
+    CCacheWrapper childCw(&base);
+    int64_t nStart  = GetTimeMicros();
+    uint32_t packed = PackWithChildCache(txs, childCw);
+    int64_t nChild  = GetTimeMicros() - nStart;
+
+    CCacheWrapper savepointCw(&base);
+    nStart = GetTimeMicros();
+    BOOST_CHECK_EQUAL(PackWithSavepoint(txs, savepointCw), packed);
+    int64_t nSavepoint = GetTimeMicros() - nStart;
+
+    BOOST_CHECK_EQUAL(packed, txs.size() - txs.size() / 5);
+    CheckSameAccounts(childCw, savepointCw);
+
+    BOOST_TEST_MESSAGE(strprintf("cachewrapper packing bench: txs=%u, packed=%u, child cache=%.2fms, "
+                                 "savepoint=%.2fms", txs.size(), packed, nChild * 0.001, nSavepoint * 0.001));
+}
+
+struct CExecLog {
+    CDBAccessSet accessSet;
+    CDBOpLogMap redoLogMap;
+};
+
+// execute the tx recording the keys it accessed and the values it wrote, as the mempool does
+static bool ExecuteTxWithLog(CBaseTx &tx, CCacheWrapper &cw, int32_t index, CExecLog &execLog) {
+    CCacheSavepoint savepoint(cw);
+    savepoint.GetDbOpLogMap().SetAccessSet(&execLog.accessSet);
+    savepoint.GetDbOpLogMap().SetRedoLogMap(&execLog.redoLogMap);
+    if (!ExecuteTx(tx, cw, index)) {
+        savepoint.Rollback();
+        return false;
+    }
+
+    for (auto &item : execLog.redoLogMap.GetMap())
+        std::reverse(item.second.begin(), item.second.end());
+    return true;
+}
+
+// revalidate the txs on a new view of base after the block writes, carrying over the txs which read none of
+// the changed keys, returns the number of the txs executed again
+static uint32_t Revalidate(const vector<std::shared_ptr<CBaseTx>> &txs, vector<CExecLog> &execLogs,
+                           const CDBAccessSet &blockWrites, CCacheWrapper &cw) {
+    CDBAccessSet changed;
+    changed.MergeWrites(blockWrites);
+    uint32_t reexecuted = 0;
+    for (uint32_t i = 0; i < txs.size(); i++) {
+        if (!execLogs[i].accessSet.HasReadConflict(changed)) {
+            cw.ApplyOpLogs(execLogs[i].redoLogMap);
+            continue;
+        }
+
+        changed.MergeWrites(execLogs[i].accessSet);
+        execLogs[i] = CExecLog();
+        BOOST_CHECK(ExecuteTxWithLog(*txs[i], cw, i + 1, execLogs[i]));
+        changed.MergeWrites(execLogs[i].accessSet);
+        reexecuted++;
+    }
+    return reexecuted;
+}
+
+BOOST_AUTO_TEST_CASE(cachewrapper_revalidate_bench)
+{
+    CCacheWrapper base;
+    InitAccounts(base);
+
+    // the pool: transfers between pairs of the first half of the accounts, then the transfers back
+    vector<std::shared_ptr<CBaseTx>> txs;
+    for (uint32_t i = 0; i < ACCOUNT_NUM / 2; i++) {
+        uint32_t pair = i % (ACCOUNT_NUM / 4);
+        uint32_t from = (i < ACCOUNT_NUM / 4) ? 2 * pair : 2 * pair + 1;
+        uint32_t to   = (i < ACCOUNT_NUM / 4) ? 2 * pair + 1 : 2 * pair;
+        txs.push_back(std::make_shared<CCoinTransferTx>(CRegID(1, from + 1), CRegID(1, to + 1), BLOCK_HEIGHT,
+                                                        SYMB::WICC, COIN, SYMB::WICC, 10000, std::to_string(i)));
+        txs.back()->nFuelRate = FUEL_RATE;
+    }
+
+    CCacheWrapper poolCw(&base);
+    vector<CExecLog> execLogs(txs.size());
+    for (uint32_t i = 0; i < txs.size(); i++)
+        BOOST_CHECK(ExecuteTxWithLog(*txs[i], poolCw, i + 1, execLogs[i]));
+
+    // a block changing a few accounts read by the pool and many accounts out of it
+    CDBAccessSet blockWrites;
+    {
+        CCacheWrapper blockCw(&base);
+        for (uint32_t i = 0; i < ACCOUNT_NUM; i += (i < ACCOUNT_NUM / 2 ? 97 : 1)) {
+            CAccount account;
+            BOOST_CHECK(blockCw.accountCache.GetAccount(MakeKeyId(i), account));
+            account.OperateBalance(SYMB::WICC, BalanceOpType::ADD_FREE, COIN);
+            BOOST_CHECK(blockCw.accountCache.SaveAccount(account));
+        }
+
+        CDBFlushRecorder flushRecorder(blockWrites);
+        blockCw.Flush();
+    }
+
+    // the full revalidation executes every tx again on a new view
+    CCacheWrapper fullCw(&base);
+    int64_t nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < txs.size(); i++)
+        BOOST_CHECK(ExecuteTx(*txs[i], fullCw, i + 1));
+    int64_t nFull = GetTimeMicros() - nStart;
+
+    CCacheWrapper incrementalCw(&base);
+    nStart              = GetTimeMicros();
+    uint32_t reexecuted = Revalidate(txs, execLogs, blockWrites, incrementalCw);
+    int64_t nIncremental = GetTimeMicros() - nStart;
+
+    BOOST_CHECK(reexecuted > 0 && reexecuted < txs.size());
+    CheckSameAccounts(fullCw, incrementalCw);
+
+    BOOST_TEST_MESSAGE(strprintf("cachewrapper revalidate bench: txs=%u, re-executed=%u, full=%.2fms, "
+                                 "incremental=%.2fms", txs.size(), reexecuted, nFull * 0.001, nIncremental * 0.001));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
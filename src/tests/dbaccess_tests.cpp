@@ -7,8 +7,13 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include <boost/test/unit_test.hpp>
 #include "persistence/dbaccess.h"
+#include "persistence/dbiterator.h"
+#include "commons/random.h"
 
 using namespace std;
 
@@ -60,6 +65,234 @@ BOOST_AUTO_TEST_CASE(dbaccess_test)
 
 }
 
+BOOST_AUTO_TEST_CASE(dbaccess_commit_batch_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    auto spStateDb = make_shared<CLevelDBWrapper>(db_dir / "state", 1 << 20, false, isWipe);
+    auto pAccountDb = make_shared<CDBAccess>(DBNameType::ACCOUNT, spStateDb);
+    auto pBlockDb = make_shared<CDBAccess>(DBNameType::BLOCK, spStateDb);
+    auto pDexDb = make_shared<CDBAccess>(db_dir, DBNameType::DEX, false, isWipe);
+
+    CDBCommitBatch commitBatch;
+    commitBatch.Add(pAccountDb.get());
+    commitBatch.Add(pBlockDb.get());
+    commitBatch.Add(pDexDb.get());
+    BOOST_CHECK(commitBatch.GetBatchCount() == 2);
+
+    pAccountDb->BatchWrite<string, string>(prefix, {{"regid-1", "keyid-1"}});
+    pBlockDb->BatchWrite<string, string>(prefix, {{"regid-2", "keyid-2"}});
+    pDexDb->BatchWrite<string, string>(prefix, {{"regid-3", "keyid-3"}});
+
+    // nothing is written before commit
+    string value;
+    BOOST_CHECK(!pAccountDb->GetData(prefix, string("regid-1"), value));
+    BOOST_CHECK(!pDexDb->GetData(prefix, string("regid-3"), value));
+
+    BOOST_CHECK(commitBatch.Commit());
+    BOOST_CHECK(pBlockDb->GetData(prefix, string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(pAccountDb->GetData(prefix, string("regid-2"), value) && value == "keyid-2");
+    BOOST_CHECK(pDexDb->GetData(prefix, string("regid-3"), value) && value == "keyid-3");
+
+    // writes go to the db directly after commit
+    pDexDb->BatchWrite<string, string>(prefix, {{"regid-4", "keyid-4"}});
+    BOOST_CHECK(pDexDb->GetData(prefix, string("regid-4"), value) && value == "keyid-4");
+}
+
+BOOST_AUTO_TEST_CASE(dbaccess_key_filter_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    auto pDBAccess = make_shared<CDBAccess>(db_dir, DBNameType::ACCOUNT, false, isWipe);
+    map<dbk::PrefixType, CDBKeyFilterStats> stats;
+    string value;
+
+    // the second lookup of an absent key does not reach the db
+    BOOST_CHECK(!pDBAccess->GetData(prefix, string("regid-1"), value));
+    BOOST_CHECK(!pDBAccess->GetData(prefix, string("regid-1"), value));
+    pDBAccess->GetKeyFilterStats(stats);
+    BOOST_CHECK_EQUAL(stats[prefix].misses, 1U);
+    BOOST_CHECK_EQUAL(stats[prefix].negative_hits, 1U);
+    BOOST_CHECK_EQUAL(stats[prefix].negative_keys, 1U);
+
+    // a write forgets the absent key
+    pDBAccess->BatchWrite<string, string>(prefix, {{"regid-1", "keyid-1"}});
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("regid-1"), value) && value == "keyid-1");
+    pDBAccess->GetKeyFilterStats(stats);
+    BOOST_CHECK_EQUAL(stats[prefix].hits, 1U);
+    BOOST_CHECK_EQUAL(stats[prefix].negative_keys, 0U);
+
+    // the negative cache is bounded
+    pDBAccess->SetMaxNegativeKeys(4);
+    for (uint32_t i = 0; i < 10; i++)
+        BOOST_CHECK(!pDBAccess->GetData(prefix, "absent-" + std::to_string(i), value));
+    pDBAccess->GetKeyFilterStats(stats);
+    BOOST_CHECK(stats[prefix].negative_keys <= 4U);
+
+    // the bloom filter skips the absent keys and keeps the written ones
+    pDBAccess->SetMaxNegativeKeys(0);
+    pDBAccess->EnableBloomFilter(prefix);
+    pDBAccess->BatchWrite<string, string>(prefix, {{"regid-2", "keyid-2"}});
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("regid-2"), value) && value == "keyid-2");
+    for (uint32_t i = 0; i < 1000; i++)
+        BOOST_CHECK(!pDBAccess->GetData(prefix, "absent-" + std::to_string(i), value));
+    pDBAccess->GetKeyFilterStats(stats);
+    BOOST_CHECK_EQUAL(stats[prefix].bloom_keys, 2U);
+    BOOST_CHECK(stats[prefix].bloom_skips > 950U);
+    BOOST_CHECK_EQUAL(stats[prefix].negative_keys, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(dbaccess_key_filter_concurrent_write_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    CDBKeyFilter keyFilter;
+    uint64_t nReadEpoch;
+
+    // a key missed before a write of it ended is not remembered as absent
+    BOOST_CHECK(!keyFilter.IsAbsent(prefix, "regid-1", nReadEpoch));
+    keyFilter.BeginWrite();
+    keyFilter.OnWrite(prefix, "regid-1");
+    keyFilter.EndWrite();
+    keyFilter.OnRead(prefix, "regid-1", false, nReadEpoch);
+    BOOST_CHECK(!keyFilter.IsAbsent(prefix, "regid-1", nReadEpoch));
+
+    // nor a key missed while a write is pending
+    keyFilter.BeginWrite();
+    BOOST_CHECK(!keyFilter.IsAbsent(prefix, "regid-2", nReadEpoch));
+    keyFilter.OnRead(prefix, "regid-2", false, nReadEpoch);
+    keyFilter.EndWrite();
+    BOOST_CHECK(!keyFilter.IsAbsent(prefix, "regid-2", nReadEpoch));
+
+    BOOST_CHECK(!keyFilter.IsAbsent(prefix, "regid-3", nReadEpoch));
+    keyFilter.OnRead(prefix, "regid-3", false, nReadEpoch);
+    BOOST_CHECK(keyFilter.IsAbsent(prefix, "regid-3", nReadEpoch));
+
+    // the readers miss the keys committed by the writer thread while they read, none stays absent
+    auto pDBAccess = make_shared<CDBAccess>(db_dir, DBNameType::ACCOUNT, false, isWipe);
+    const uint32_t nKeys = 2000;
+    std::atomic<bool> fDone{false};
+    vector<std::thread> readers;
+    for (uint32_t t = 0; t < 4; t++) {
+        readers.emplace_back([&, t]() {
+            string value;
+            for (uint32_t i = t; !fDone; i = (i + 7) % nKeys)
+                pDBAccess->GetData(prefix, "regid-" + std::to_string(i), value);
+        });
+    }
+    for (uint32_t i = 0; i < nKeys; i++) {
+        CDBCommitBatch commitBatch;
+        commitBatch.Add(pDBAccess.get());
+        pDBAccess->BatchWrite<string, string>(prefix, {{"regid-" + std::to_string(i), "keyid"}});
+        BOOST_CHECK(commitBatch.Commit());
+    }
+    fDone = true;
+    for (auto &reader : readers)
+        reader.join();
+
+    string value;
+    uint32_t nFound = 0;
+    for (uint32_t i = 0; i < nKeys; i++)
+        nFound += pDBAccess->GetData(prefix, "regid-" + std::to_string(i), value);
+    BOOST_CHECK_EQUAL(nFound, nKeys);
+}
+
+BOOST_AUTO_TEST_CASE(dbaccess_snapshot_read_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    auto pDBAccess = make_shared<CDBAccess>(db_dir, DBNameType::ACCOUNT, false, isWipe);
+    CCompositeKVCache<prefix, string, string> dbCache(pDBAccess.get());
+    dbCache.SetData("regid-1", "keyid-1");
+    dbCache.Flush();
+
+    // the snapshot of a chain state: the db snapshot and the frozen copy of the cache
+    CLevelDBSnapshots snapshots;
+    snapshots.Take(pDBAccess->GetDbPtr());
+    dbCache.SetData("regid-3", "keyid-3");
+    CCompositeKVCache<prefix, string, string> snapshotCache;
+    snapshotCache = dbCache;
+
+    // the chain state goes on
+    dbCache.SetData("regid-1", "keyid-1b");
+    dbCache.SetData("regid-2", "keyid-2");
+    dbCache.Flush();
+
+    string value;
+    {
+        CLevelDBSnapshotReader reader(&snapshots);
+        CCompositeKVCache<prefix, string, string> readCache;
+        readCache = snapshotCache;
+        BOOST_CHECK(readCache.GetData(string("regid-1"), value) && value == "keyid-1");
+        BOOST_CHECK(readCache.GetData(string("regid-3"), value) && value == "keyid-3");
+        BOOST_CHECK(!readCache.GetData(string("regid-2"), value));
+        BOOST_CHECK(!pDBAccess->GetData(prefix, string("regid-3"), value));
+
+        uint32_t count = 0;
+        CDBIterator<decltype(readCache)> dbIt(readCache);
+        for (dbIt.First(); dbIt.IsValid(); dbIt.Next())
+            count++;
+        BOOST_CHECK_EQUAL(count, 2U);
+    }
+
+    // the keys missed in the snapshot are not remembered as absent from the db
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("regid-2"), value) && value == "keyid-2");
+    BOOST_CHECK(dbCache.GetData(string("regid-1"), value) && value == "keyid-1b");
+}
+
+// flush latency of the state dbs: one synced write per cache (the old flush), one per leveldb,
+// and one for all with -singlestatedb
+BOOST_AUTO_TEST_CASE(dbaccess_flush_bench)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    const uint32_t CACHES_PER_DB = 3;
+
+    for (const auto &round : vector<pair<uint32_t, uint32_t>>{ {100, 20}, {5000, 2} }) {
+        const uint32_t nEntries = round.first, nFlushes = round.second;
+        vector<map<string, string>> cacheData;
+        for (uint32_t i = 0; i < DBNameType::DB_NAME_COUNT * CACHES_PER_DB; i++) {
+            map<string, string> data;
+            for (uint32_t j = 0; j < nEntries; j++)
+                data[strprintf("cache%u-key%u", i, j)] = strprintf("value%u", j);
+            cacheData.push_back(data);
+        }
+
+        for (int32_t mode = 0; mode < 3; mode++) {
+            boost::filesystem::path dir = db_dir / strprintf("flush_bench_%d", mode);
+            vector<shared_ptr<CDBAccess>> dbs;
+            shared_ptr<CLevelDBWrapper> spStateDb;
+            if (mode == 2)
+                spStateDb = make_shared<CLevelDBWrapper>(dir / "state", 8 << 20, false, isWipe);
+            for (int32_t i = 0; i < DBNameType::DB_NAME_COUNT; i++) {
+                if (spStateDb)
+                    dbs.push_back(make_shared<CDBAccess>((DBNameType)i, spStateDb));
+                else
+                    dbs.push_back(make_shared<CDBAccess>(dir, (DBNameType)i, false, isWipe));
+            }
+
+            int64_t nStart = GetTimeMicros();
+            for (uint32_t n = 0; n < nFlushes; n++) {
+                CDBCommitBatch commitBatch;
+                if (mode > 0) {
+                    for (auto &spDb : dbs)
+                        commitBatch.Add(spDb.get());
+                }
+                for (uint32_t i = 0; i < cacheData.size(); i++)
+                    dbs[i / CACHES_PER_DB]->BatchWrite<string, string>(prefix, cacheData[i]);
+                BOOST_CHECK(commitBatch.Commit());
+            }
+            int64_t nElapsed = std::max<int64_t>(GetTimeMicros() - nStart, 1);
+
+            BOOST_TEST_MESSAGE(strprintf("flush bench: %s, %u entries/flush, %.2fms/flush, %.0f entries/s",
+                mode == 0 ? "write per cache" : (mode == 1 ? "batch per db   " : "single db      "),
+                nEntries * cacheData.size(), nElapsed * 0.001 / nFlushes,
+                nEntries * cacheData.size() * nFlushes * 1000000.0 / nElapsed));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -144,16 +377,16 @@ BOOST_AUTO_TEST_CASE(dbcache_scalar_value_Level3_test)
     BOOST_CHECK( value1 == "keyid-1" );
 }
 
-template <typename T>
-static uint32_t GetSerSize(const T &t) {
-    return ::GetSerializeSize(t, SER_DISK, CLIENT_VERSION);
+template <typename K, typename T>
+static uint64_t GetMemSize(const K &key, const T &value) {
+    return memusage::MapNodeUsage<K, T>() + db_util::GetDynamicMemSize(key) + db_util::GetDynamicMemSize(value);
 }
 
 template <typename CacheType>
-static uint32_t GetCacheSerializeSize(CacheType &cache) {
-    uint32_t ret = 0;
-    for (auto item : cache.GetMapData())
-        ret += GetSerSize(item);
+static uint64_t GetCacheMemSize(CacheType &cache) {
+    uint64_t ret = 0;
+    for (const auto &item : cache.GetMapData())
+        ret += GetMemSize(item.first, item.second);
     return ret;
 }
 
@@ -166,19 +399,474 @@ BOOST_AUTO_TEST_CASE(dbcache_cache_size_test)
 
     auto pDBCache = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
     pDBCache->SetData("regid-1", "keyid-1");
-    BOOST_CHECK(pDBCache->GetCacheSize() == GetSerSize(make_pair<string, string>("regid-1", "keyid-1")));
+    BOOST_CHECK(pDBCache->GetCacheSize() == GetMemSize(string("regid-1"), string("keyid-1")));
     pDBCache->SetData("regid-2", "keyid-2");
     pDBCache->SetData("regid-3", "keyid-3");
-    BOOST_CHECK(pDBCache->GetCacheSize() == GetCacheSerializeSize(*pDBCache));
+    BOOST_CHECK(pDBCache->GetCacheSize() == GetCacheMemSize(*pDBCache));
     pDBCache->Flush();
     BOOST_CHECK(pDBCache->GetCacheSize() == 0);
-    BOOST_CHECK(GetCacheSerializeSize(*pDBCache) == 0);
+    BOOST_CHECK(GetCacheMemSize(*pDBCache) == 0);
 
     auto pDBCache2 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache.get());
     string value1;
     BOOST_CHECK(pDBCache2->GetData(string("regid-1"), value1));
-    BOOST_CHECK(pDBCache->GetCacheSize() == GetSerSize(make_pair<string, string>("regid-1", "keyid-1")));
+    BOOST_CHECK(pDBCache->GetCacheSize() == GetMemSize(string("regid-1"), string("keyid-1")));
     BOOST_CHECK(!pDBCache2->IsCalcSize() && pDBCache2->GetCacheSize() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(dbcache_memory_size_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::ACCOUNT, false, isWipe);
+
+    // short strings live in the string object, long ones on the heap
+    BOOST_CHECK(db_util::GetDynamicMemSize(string("short")) == 0);
+    BOOST_CHECK(db_util::GetDynamicMemSize(string(100, 'x')) >= 101);
+    BOOST_CHECK(db_util::GetDynamicMemSize(uint256()) == 0);
+
+    typedef map<string, vector<uint64_t>> ValueType;
+    auto pDBCache = make_shared< CCompositeKVCache<prefix, string, ValueType> >(pDBAccess.get());
+    ValueType value1 = { {"token-1", vector<uint64_t>(10, 1)}, {string(40, 't'), vector<uint64_t>(100, 2)} };
+    pDBCache->SetData("regid-1", value1);
+    BOOST_CHECK(pDBCache->GetCacheSize() == GetMemSize(string("regid-1"), value1));
+    BOOST_CHECK(pDBCache->GetCacheSize() > ::GetSerializeSize(value1, SER_DISK, CLIENT_VERSION));
+
+    // updates and erases change the size by the delta of the value
+    ValueType value2 = value1;
+    value2["token-2"] = vector<uint64_t>(1000, 3);
+    pDBCache->SetData("regid-1", value2);
+    pDBCache->SetData("regid-2", value1);
+    BOOST_CHECK(pDBCache->GetCacheSize() == GetCacheMemSize(*pDBCache));
+    pDBCache->EraseData("regid-1");
+    BOOST_CHECK(pDBCache->GetCacheSize() == GetCacheMemSize(*pDBCache));
+    BOOST_CHECK(pDBCache->GetCacheSize() == GetMemSize(string("regid-1"), ValueType()) + GetMemSize(string("regid-2"), value1));
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_copy_on_write_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::ACCOUNT, false, isWipe);
+
+    typedef CCompositeKVCache<prefix, string, string> CacheType;
+    auto pDBCache = make_shared<CacheType>(pDBAccess.get());
+    pDBCache->SetData("regid-1", "keyid-1");
+    pDBCache->SetData("regid-2", "keyid-2");
+    uint32_t cacheSize = pDBCache->GetCacheSize();
+    int64_t snapshotLayers = CDBCacheSnapshotStats::layers;
+
+    // the copy shares the data as a snapshot, nothing is copied
+    CacheType forkCache = *pDBCache;
+    BOOST_CHECK(CDBCacheSnapshotStats::layers == snapshotLayers + 1);
+    BOOST_CHECK(forkCache.GetCacheSize() == cacheSize && pDBCache->GetCacheSize() == cacheSize);
+
+    // changes of one cache are not seen by the other
+    forkCache.SetData("regid-1", "keyid-fork");
+    forkCache.EraseData("regid-2");
+    pDBCache->SetData("regid-3", "keyid-3");
+
+    string value;
+    BOOST_CHECK(pDBCache->GetData(string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(pDBCache->GetData(string("regid-2"), value) && value == "keyid-2");
+    BOOST_CHECK(forkCache.GetData(string("regid-1"), value) && value == "keyid-fork");
+    BOOST_CHECK(!forkCache.HaveData(string("regid-2")));
+    BOOST_CHECK(!forkCache.HaveData(string("regid-3")));
+
+    // iterating and flushing see the snapshot data
+    BOOST_CHECK(pDBCache->GetMapData().size() == 3);
+    pDBCache->Flush();
+    BOOST_CHECK(pDBCache->GetCacheSize() == 0);
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("regid-2"), value) && value == "keyid-2");
+    BOOST_CHECK(forkCache.GetData(string("regid-1"), value) && value == "keyid-fork");
+
+    forkCache.Clear();
+    BOOST_CHECK(CDBCacheSnapshotStats::layers == snapshotLayers);
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_hash_map_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::TXID_DISKINDEX;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::BLOCK, false, isWipe);
+
+    typedef CCompositeKVCache<prefix, uint256, uint64_t, CDBHashMap> CacheType;
+    vector<uint256> keys;
+    for (uint32_t i = 0; i < 10; i++)
+        keys.push_back(GetRandHash());
+
+    CacheType dbCache(pDBAccess.get());
+    for (uint32_t i = 0; i < keys.size(); i++)
+        dbCache.SetData(keys[i], i + 1);
+    BOOST_CHECK(dbCache.GetCacheSize() == keys.size() * (memusage::HashNodeUsage<uint256, uint64_t>()));
+    dbCache.Flush();
+
+    CacheType childCache(&dbCache);
+    uint64_t value;
+    BOOST_CHECK(childCache.GetData(keys[3], value) && value == 4);
+    childCache.SetData(keys[3], 100);
+    childCache.EraseData(keys[4]);
+
+    // a copy shares the data as a snapshot
+    CacheType forkCache = childCache;
+    forkCache.SetData(keys[5], 200);
+    BOOST_CHECK(childCache.GetData(keys[5], value) && value == 6);
+
+    childCache.Flush();
+    BOOST_CHECK(dbCache.GetData(keys[3], value) && value == 100);
+    BOOST_CHECK(!dbCache.HaveData(keys[4]));
+    dbCache.Flush();
+    BOOST_CHECK(pDBAccess->GetData(prefix, keys[3], value) && value == 100);
+    BOOST_CHECK(!pDBAccess->GetData(prefix, keys[4], value));
+    BOOST_CHECK(forkCache.GetData(keys[5], value) && value == 200);
+
+    map<uint256, uint64_t> elements;
+    BOOST_CHECK(dbCache.GetAllElements(elements));
+    BOOST_CHECK(elements.size() == keys.size() - 1);
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_access_set_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::TXID_DISKINDEX;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::BLOCK, false, isWipe);
+
+    typedef CCompositeKVCache<prefix, uint256, uint64_t, CDBHashMap> CacheType;
+    const uint32_t viewNum = 4, viewKeys = 16;
+    vector<uint256> keys;
+    CacheType dbCache(pDBAccess.get());
+    for (uint32_t i = 0; i < viewNum * viewKeys; i++) {
+        keys.push_back(GetRandHash());
+        dbCache.SetData(keys[i], i + 1);
+    }
+    dbCache.Flush();
+
+    // the views read their own keys through the shared base cache at the same time, and write the first one
+    CacheType baseCache(&dbCache);
+    vector<shared_ptr<CacheType>> views;
+    vector<CDBOpLogMap> opLogMaps(viewNum);
+    vector<CDBAccessSet> accessSets(viewNum);
+    std::recursive_mutex baseReadMutex;
+    std::atomic<uint32_t> nReadErrors(0);
+    vector<std::thread> threads;
+    for (uint32_t v = 0; v < viewNum; v++) {
+        views.push_back(make_shared<CacheType>(&baseCache));
+        opLogMaps[v].SetAccessSet(&accessSets[v]);
+        views[v]->SetDbOpLogMap(&opLogMaps[v]);
+    }
+    for (uint32_t v = 0; v < viewNum; v++) {
+        threads.emplace_back([&, v]() {
+            CDBBaseReadLock::pMutex = &baseReadMutex;
+            uint64_t value;
+            for (uint32_t i = v * viewKeys; i < (v + 1) * viewKeys; i++) {
+                if (!views[v]->GetData(keys[i], value) || value != i + 1)
+                    nReadErrors++;
+            }
+            views[v]->SetData(keys[v * viewKeys], 1000 + v);
+            CDBBaseReadLock::pMutex = nullptr;
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+
+    BOOST_CHECK_EQUAL(nReadErrors.load(), 0U);
+    BOOST_CHECK_EQUAL(baseCache.GetMapData().size(), keys.size());
+    BOOST_CHECK_EQUAL(opLogMaps[0].GetDbOpLogsPtr(prefix)->size(), 1U);
+
+    // disjoint keys don't conflict, a read of a written key or a range read does
+    CDBAccessSet committedWrites;
+    committedWrites.MergeWrites(accessSets[0]);
+    for (uint32_t v = 1; v < viewNum; v++)
+        BOOST_CHECK(!accessSets[v].HasReadConflict(committedWrites));
+
+    CDBOpLogMap opLogMap;
+    CDBAccessSet accessSet;
+    opLogMap.SetAccessSet(&accessSet);
+    CacheType readerView(&baseCache);
+    readerView.SetDbOpLogMap(&opLogMap);
+    uint64_t value;
+    BOOST_CHECK(readerView.GetData(keys[1], value));
+    BOOST_CHECK(!accessSet.HasReadConflict(committedWrites));
+    BOOST_CHECK(readerView.HaveData(keys[0]));
+    BOOST_CHECK(accessSet.HasReadConflict(committedWrites));
+
+    accessSet.Clear();
+    map<uint256, uint64_t> elements;
+    BOOST_CHECK(readerView.GetAllElements(elements));
+    BOOST_CHECK(accessSet.HasReadConflict(committedWrites));
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_concurrent_sysparam_read_test)
+{
+    // the parallel tx workers all miss the same sysparam key, through their views of the block's cache and
+    // in the global cache directly as GetTxMinFee() does, the reads reaching the shared caches take the lock
+    const bool isWipe = true;
+    auto pDBAccess = make_shared<CDBAccess>(db_dir, DBNameType::SYSPARAM, false, isWipe);
+    CSysParamDBCache globalCache(pDBAccess.get());
+    BOOST_REQUIRE(globalCache.SetMinerFee(BCOIN_TRANSFER_TX, SYMB::WICC, 12345));
+    globalCache.Flush();
+
+    const uint32_t nThreads = 8;
+    for (uint32_t round = 0; round < 200; round++) {
+        CSysParamDBCache blockCache;
+        blockCache.SetBaseViewPtr(&globalCache);
+
+        std::recursive_mutex baseReadMutex;
+        std::atomic<uint32_t> nFound(0);
+        vector<std::thread> workers;
+        for (uint32_t t = 0; t < nThreads; t++) {
+            workers.emplace_back([&, t]() {
+                CDBBaseReadLock::pMutex = &baseReadMutex;
+                uint64_t fee = 0;
+                bool found;
+                if (t % 2 == 0) {
+                    CSysParamDBCache txCache;
+                    txCache.SetBaseViewPtr(&blockCache);
+                    found = txCache.GetMinerFee(BCOIN_TRANSFER_TX, SYMB::WICC, fee);
+                } else {
+                    CDBBaseReadLock baseLock;
+                    found = globalCache.GetMinerFee(BCOIN_TRANSFER_TX, SYMB::WICC, fee);
+                }
+                if (found && fee == 12345)
+                    nFound++;
+                CDBBaseReadLock::pMutex = nullptr;
+            });
+        }
+        for (auto &worker : workers)
+            worker.join();
+
+        BOOST_CHECK_EQUAL(nFound.load(), nThreads);
+        // forget the read fee, the next round misses it again
+        globalCache.Flush();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_redo_log_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::TXID_DISKINDEX;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::BLOCK, false, isWipe);
+
+    typedef CCompositeKVCache<prefix, uint256, uint64_t, CDBHashMap> CacheType;
+    vector<uint256> keys;
+    CacheType dbCache(pDBAccess.get());
+    for (uint32_t i = 0; i < 4; i++) {
+        keys.push_back(GetRandHash());
+        dbCache.SetData(keys[i], i + 1);
+    }
+    dbCache.Flush();
+
+    // the redo logs have the new values, the last write of a key is logged last
+    CacheType view(&dbCache);
+    CDBOpLogMap opLogMap, redoLogMap;
+    opLogMap.SetRedoLogMap(&redoLogMap);
+    view.SetDbOpLogMap(&opLogMap);
+    view.SetData(keys[0], 100);
+    view.SetData(keys[0], 101);
+    view.EraseData(keys[1]);
+    view.SetData(keys[2], 102);
+    BOOST_CHECK_EQUAL(redoLogMap.GetDbOpLogsPtr(prefix)->size(), 4U);
+
+    // the undo function applies the logs from the last one
+    auto &redoLogs = redoLogMap.GetMap().begin()->second;
+    std::reverse(redoLogs.begin(), redoLogs.end());
+    CacheType redoView(&dbCache);
+    redoView.UndoDataList(redoLogs);
+    uint64_t value;
+    BOOST_CHECK(redoView.GetData(keys[0], value) && value == 101);
+    BOOST_CHECK(!redoView.HaveData(keys[1]));
+    BOOST_CHECK(redoView.GetData(keys[2], value) && value == 102);
+    BOOST_CHECK(redoView.GetData(keys[3], value) && value == 4);
+
+    // the flushed keys are recorded, the read ones included
+    CDBAccessSet flushedKeys, readKeys;
+    readKeys.AddRead(prefix, dbk::GenDbKey(prefix, keys[3]));
+    {
+        CDBFlushRecorder flushRecorder(flushedKeys);
+        redoView.Flush();
+    }
+    BOOST_CHECK(readKeys.HasReadConflict(flushedKeys));
+    view.Flush();
+    BOOST_CHECK(dbCache.GetData(keys[0], value) && value == 101);
+}
+
+// a large value counting its deep copies, as the contract code
+struct CBlobValue {
+    static uint64_t copies;
+    string data;
+
+    CBlobValue() {}
+    explicit CBlobValue(const string &dataIn): data(dataIn) {}
+    CBlobValue(const CBlobValue &other): data(other.data) { copies++; }
+    CBlobValue& operator=(const CBlobValue &other) { data = other.data; copies++; return *this; }
+
+    bool IsEmpty() const { return data.empty(); }
+    void SetEmpty() { data.clear(); }
+    string ToString() const { return strprintf("size=%u", data.size()); }
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(data);
+    )
+};
+uint64_t CBlobValue::copies = 0;
+
+BOOST_AUTO_TEST_CASE(dbcache_shared_value_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::CONTRACT_DEF;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::CONTRACT, false, isWipe);
+
+    typedef CCompositeKVCache<prefix, string, CDBSharedValue<CBlobValue>> CacheType;
+    CacheType dbCache(pDBAccess.get());
+    BOOST_CHECK(dbCache.SetData("contract-1", CBlobValue(string(1024, 'a'))));
+    dbCache.Flush();
+
+    // the value is saved in the format of the wrapped type
+    CBlobValue blob;
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("contract-1"), blob) && blob.data == string(1024, 'a'));
+
+    // the nested caches share the value read from the db
+    CacheType blockCache(&dbCache);
+    CacheType txCache(&blockCache);
+    CDBSharedValue<CBlobValue> value, blockValue;
+    BOOST_CHECK(txCache.GetData(string("contract-1"), value) && value.Get().data == string(1024, 'a'));
+    BOOST_CHECK(blockCache.GetData(string("contract-1"), blockValue));
+    BOOST_CHECK(value.GetPtr() == blockValue.GetPtr());
+
+    // a change of the child is copied on write, the base keeps its value
+    CDBOpLogMap dbOpLogMap;
+    txCache.SetDbOpLogMap(&dbOpLogMap);
+    BOOST_CHECK(txCache.SetData("contract-1", CBlobValue(string(1024, 'b'))));
+    BOOST_CHECK(txCache.GetData(string("contract-1"), value) && value.Get().data == string(1024, 'b'));
+    BOOST_CHECK(blockCache.GetData(string("contract-1"), blockValue) && blockValue.Get().data == string(1024, 'a'));
+    BOOST_CHECK(txCache.EraseData("contract-1"));
+    BOOST_CHECK(!txCache.HaveData(string("contract-1")));
+    BOOST_CHECK(blockCache.HaveData(string("contract-1")));
+
+    // the undo restores the value of the op log
+    txCache.UndoDataList(*dbOpLogMap.GetDbOpLogsPtr(prefix));
+    BOOST_CHECK(txCache.GetData(string("contract-1"), value) && value.Get().data == string(1024, 'a'));
+
+    BOOST_CHECK(txCache.SetData("contract-1", CBlobValue(string(1024, 'c'))));
+    txCache.Flush();
+    blockCache.Flush();
+    dbCache.Flush();
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("contract-1"), blob) && blob.data == string(1024, 'c'));
+}
+
+// reads of a contract by every tx of a block through the nested caches of the tx, as the contract invoke txs
+template <typename CacheType, typename ValueType>
+static void BenchBlockContractReads(CDBAccess *pDbAccess, const string &name) {
+    const uint32_t TX_COUNT = 1000, TX_LEVELS = 2, CODE_SIZE = 64 * 1024;
+
+    CacheType dbCache(pDbAccess);
+    dbCache.SetData("contract-1", CBlobValue(string(CODE_SIZE, 'a')));
+    dbCache.Flush();
+
+    uint64_t copies = CBlobValue::copies;
+    int64_t allocs  = CDBSharedValueStats::allocs;
+    int64_t nStart  = GetTimeMicros();
+
+    CacheType blockCache(&dbCache);
+    for (uint32_t i = 0; i < TX_COUNT; i++) {
+        vector<shared_ptr<CacheType>> txCaches;
+        txCaches.push_back(make_shared<CacheType>(&blockCache));
+        for (uint32_t level = 1; level < TX_LEVELS; level++)
+            txCaches.push_back(make_shared<CacheType>(txCaches.back().get()));
+
+        ValueType value;
+        BOOST_CHECK(txCaches.back()->GetData(string("contract-1"), value));
+        for (auto it = txCaches.rbegin(); it != txCaches.rend(); it++)
+            (*it)->Flush();
+    }
+    int64_t nElapse = GetTimeMicros() - nStart;
+
+    copies = CBlobValue::copies - copies;
+    allocs = CDBSharedValueStats::allocs - allocs;
+    BOOST_TEST_MESSAGE(strprintf("dbcache shared value bench: %s, txs=%u, tx levels=%u, code=%u bytes, "
+                                 "deep copies=%llu, shared allocs=%lld, copied=%.2fMB, time=%.2fms", name, TX_COUNT,
+                                 TX_LEVELS, CODE_SIZE, copies, allocs, copies * CODE_SIZE / 1048576.0,
+                                 nElapse * 0.001));
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_shared_value_bench)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::CONTRACT_DEF;
+
+    uint64_t copies = CBlobValue::copies;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir / "copied", DBNameType::CONTRACT, false, isWipe);
+    BenchBlockContractReads<CCompositeKVCache<prefix, string, CBlobValue>, CBlobValue>(pDBAccess.get(), "copied");
+    uint64_t copiedCopies = CBlobValue::copies - copies;
+
+    copies = CBlobValue::copies;
+    pDBAccess = make_shared<CDBAccess>(db_dir / "shared", DBNameType::CONTRACT, false, isWipe);
+    BenchBlockContractReads<CCompositeKVCache<prefix, string, CDBSharedValue<CBlobValue>>,
+                            CDBSharedValue<CBlobValue>>(pDBAccess.get(), "shared");
+    uint64_t sharedCopies = CBlobValue::copies - copies;
+
+    // only the value set by the bench is copied, the reads share the value read from the db
+    BOOST_CHECK(sharedCopies == 1);
+    BOOST_CHECK(copiedCopies > sharedCopies);
+}
+
+// GetData/SetData/Flush of a view over a cache on the db, as ConnectBlock() uses the tx disk pos cache
+template <typename CacheType>
+static void BenchDBCache(CDBAccess *pDbAccess, const vector<uint256> &keys, const string &name) {
+    uint64_t value = 0;
+    CacheType dbCache(pDbAccess);
+    int64_t nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < keys.size(); i++)
+        dbCache.SetData(keys[i], i + 1);
+    int64_t nSet = GetTimeMicros() - nStart;
+
+    CacheType childCache(&dbCache);
+    nStart = GetTimeMicros();
+    uint64_t nFound = 0;
+    for (const auto &key : keys)
+        nFound += childCache.GetData(key, value);
+    int64_t nGet = GetTimeMicros() - nStart;
+    BOOST_CHECK(nFound == keys.size());
+
+    nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < keys.size(); i += 2)
+        childCache.SetData(keys[i], i);
+    childCache.Flush();
+    int64_t nFlushView = GetTimeMicros() - nStart;
+
+    nStart = GetTimeMicros();
+    dbCache.Flush();
+    int64_t nFlushDb = GetTimeMicros() - nStart;
+
+    BOOST_TEST_MESSAGE(strprintf("dbcache bench: %s, entries=%u, set=%.3fus, get=%.3fus, flush view=%.2fms, "
+                                 "flush db=%.2fms", name, keys.size(), nSet / (double)keys.size(),
+                                 nGet / (double)keys.size(), nFlushView * 0.001, nFlushDb * 0.001));
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_map_policy_bench)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::TXID_DISKINDEX;
+
+    for (uint32_t count : {100000, 1000000}) {
+        vector<uint256> keys(count);
+        for (auto &key : keys)
+            key = GetRandHash();
+
+        shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+            db_dir / "ordered", DBNameType::BLOCK, false, isWipe);
+        BenchDBCache<CCompositeKVCache<prefix, uint256, uint64_t, CDBOrderedMap>>(pDBAccess.get(), keys, "ordered map");
+
+        pDBAccess = make_shared<CDBAccess>(db_dir / "hash", DBNameType::BLOCK, false, isWipe);
+        BenchDBCache<CCompositeKVCache<prefix, uint256, uint64_t, CDBHashMap>>(pDBAccess.get(), keys, "hash map   ");
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
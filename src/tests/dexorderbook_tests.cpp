@@ -0,0 +1,214 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "persistence/dexdb.h"
+#include "commons/util/time.h"
+#include "crypto/hash.h"
+#include "main.h"
+
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace dex;
+
+static const uint64_t BASE_PRICE    = 100000000;
+static const uint32_t PRICE_LEVELS  = 1000;     // price levels of each side
+static const uint32_t BENCH_ORDERS  = 100000;   // active orders of the bench
+static const uint32_t BLOCK_ORDERS  = 1000;     // orders created by a block when the bench fills the book
+static const uint32_t BENCH_BLOCKS  = 100;      // blocks of the bench after the book is filled
+static const uint32_t BLOCK_CHANGES = 500;      // orders dealt, canceled and created by each of them
+
+static uint256 MakeOrderId(uint32_t index) { return Hash(std::to_string(index)); }
+
+static CDEXOrderDetail MakeLimitOrder(OrderSide side, uint64_t price, uint64_t assetAmount, uint32_t height,
+                                      uint16_t index) {
+    CDEXOrderDetail order;
+    order.generate_type = USER_GEN_ORDER;
+    order.order_type    = ORDER_LIMIT_PRICE;
+    order.order_side    = side;
+    order.coin_symbol   = SYMB::WUSD;
+    order.asset_symbol  = SYMB::WICC;
+    order.asset_amount  = assetAmount;
+    order.coin_amount   = assetAmount;
+    order.price         = price;
+    order.tx_cord       = CTxCord(height, index);
+    return order;
+}
+
+// the orders of the bench alternate the sides, the buy prices are below the sell prices
+static CDEXOrderDetail MakeBenchOrder(uint32_t i) {
+    OrderSide side = i % 2 ? ORDER_SELL : ORDER_BUY;
+    uint64_t price = side == ORDER_BUY ? BASE_PRICE - 1 - (i / 2) % PRICE_LEVELS
+                                       : BASE_PRICE + 1 + (i / 2) % PRICE_LEVELS;
+    return MakeLimitOrder(side, price, (1 + i % 100) * COIN, 1000 + i / BLOCK_ORDERS, i % BLOCK_ORDERS);
+}
+
+// write the old values of the logged active orders back, what DisconnectBlock() does
+static void UndoOrders(CDexDBCache &dexCache, CDBOpLogMap &dbOpLogMap) {
+    UndoDataFuncMap undoDataFuncMap;
+    dexCache.RegisterUndoFunc(undoDataFuncMap);
+    for (const auto &opLogPair : dbOpLogMap.GetMap())
+        undoDataFuncMap[dbk::ParseKeyPrefixType(opLogPair.first)](opLogPair.second);
+}
+
+static const CDEXPriceLevel *FindLevel(const CDexDBCache &dexCache, OrderSide side, uint64_t price) {
+    const CDEXOrderBook::CPairBook *pPairBook =
+        dexCache.GetOrderBook().GetPairBook(CAssetTradingPair(SYMB::WICC, SYMB::WUSD));
+    if (pPairBook == nullptr)
+        return nullptr;
+    const CDEXOrderBook::PriceLevels &levels = side == ORDER_BUY ? pPairBook->bids : pPairBook->asks;
+    auto it = levels.find(price);
+    return it != levels.end() ? &it->second : nullptr;
+}
+
+BOOST_AUTO_TEST_SUITE(dexorderbook_tests)
+
+BOOST_AUTO_TEST_CASE(dexorderbook_test)
+{
+    auto pDexDb = make_shared<CDBAccess>(GetDataDir(), DBNameType::DEX, true, true);
+    CDexDBCache dexCache(pDexDb.get());
+    BOOST_CHECK(dexCache.LoadOrderBook());
+    BOOST_CHECK_EQUAL(dexCache.GetOrderBook().GetOrderCount(), 0U);
+
+    // the block creating the orders, a market price order is not kept by the book
+    CDEXOrderDetail buyOrder1 = MakeLimitOrder(ORDER_BUY, BASE_PRICE, 10 * COIN, 100, 1);
+    CDEXOrderDetail buyOrder2 = MakeLimitOrder(ORDER_BUY, BASE_PRICE, 20 * COIN, 100, 2);
+    CDEXOrderDetail sellOrder = MakeLimitOrder(ORDER_SELL, BASE_PRICE + 1, 5 * COIN, 100, 3);
+    CDEXOrderDetail marketOrder = MakeLimitOrder(ORDER_SELL, 0, 5 * COIN, 100, 4);
+    marketOrder.order_type = ORDER_MARKET_PRICE;
+    {
+        CDexDBCache blockCache;
+        blockCache.SetBaseViewPtr(&dexCache);
+        BOOST_CHECK(blockCache.CreateActiveOrder(MakeOrderId(1), buyOrder1));
+        BOOST_CHECK(blockCache.CreateActiveOrder(MakeOrderId(2), buyOrder2));
+        BOOST_CHECK(blockCache.CreateActiveOrder(MakeOrderId(3), sellOrder));
+        BOOST_CHECK(blockCache.CreateActiveOrder(MakeOrderId(4), marketOrder));
+        BOOST_CHECK_EQUAL(dexCache.GetOrderBook().GetOrderCount(), 0U);
+        blockCache.Flush();
+    }
+    BOOST_CHECK_EQUAL(dexCache.GetOrderBook().GetOrderCount(), 3U);
+    const CDEXPriceLevel *pLevel = FindLevel(dexCache, ORDER_BUY, BASE_PRICE);
+    BOOST_REQUIRE(pLevel != nullptr);
+    BOOST_CHECK_EQUAL(pLevel->asset_amount, 30 * COIN);
+    BOOST_REQUIRE_EQUAL(pLevel->orders.size(), 2U);
+    BOOST_CHECK(pLevel->orders.begin()->second == MakeOrderId(1));
+
+    // the book loaded from the db is the one followed by the flushes
+    dexCache.Flush();
+    CDexDBCache loadedCache(pDexDb.get());
+    BOOST_CHECK(loadedCache.LoadOrderBook());
+    BOOST_CHECK_EQUAL(loadedCache.GetOrderBook().GetOrderCount(), 3U);
+    pLevel = FindLevel(loadedCache, ORDER_SELL, BASE_PRICE + 1);
+    BOOST_REQUIRE(pLevel != nullptr);
+    BOOST_CHECK_EQUAL(pLevel->asset_amount, 5 * COIN);
+
+    // the block settling the sell order with a part of the first buy order and canceling the second one
+    CDBOpLogMap dbOpLogMap;
+    {
+        CDexDBCache blockCache;
+        blockCache.SetBaseViewPtr(&dexCache);
+        blockCache.SetDbOpLogMap(&dbOpLogMap);
+        CDEXOrderDetail dealtOrder = buyOrder1;
+        dealtOrder.total_deal_asset_amount = 5 * COIN;
+        BOOST_CHECK(blockCache.UpdateActiveOrder(MakeOrderId(1), dealtOrder));
+        BOOST_CHECK(blockCache.EraseActiveOrder(MakeOrderId(3), sellOrder));
+        BOOST_CHECK(blockCache.EraseActiveOrder(MakeOrderId(2), buyOrder2));
+        blockCache.Flush();
+    }
+    BOOST_CHECK_EQUAL(dexCache.GetOrderBook().GetOrderCount(), 1U);
+    BOOST_CHECK(FindLevel(dexCache, ORDER_SELL, BASE_PRICE + 1) == nullptr);
+    pLevel = FindLevel(dexCache, ORDER_BUY, BASE_PRICE);
+    BOOST_REQUIRE(pLevel != nullptr);
+    BOOST_CHECK_EQUAL(pLevel->asset_amount, 5 * COIN);
+    BOOST_CHECK_EQUAL(pLevel->orders.size(), 1U);
+
+    // the block disconnected
+    {
+        CDexDBCache blockCache;
+        blockCache.SetBaseViewPtr(&dexCache);
+        UndoOrders(blockCache, dbOpLogMap);
+        blockCache.Flush();
+    }
+    BOOST_CHECK_EQUAL(dexCache.GetOrderBook().GetOrderCount(), 3U);
+    pLevel = FindLevel(dexCache, ORDER_BUY, BASE_PRICE);
+    BOOST_REQUIRE(pLevel != nullptr);
+    BOOST_CHECK_EQUAL(pLevel->asset_amount, 30 * COIN);
+    BOOST_CHECK_EQUAL(pLevel->orders.size(), 2U);
+
+    // the depth limits the levels of each side
+    Object obj;
+    dexCache.GetOrderBook().ToJson(CAssetTradingPair(SYMB::WICC, SYMB::WUSD), 1, true, obj);
+    const Array &bids = find_value(obj, "bids").get_array();
+    BOOST_REQUIRE_EQUAL(bids.size(), 1U);
+    BOOST_CHECK_EQUAL(find_value(bids[0].get_obj(), "orders").get_array().size(), 2U);
+    BOOST_CHECK_EQUAL(find_value(obj, "asks").get_array().size(), 1U);
+}
+
+// the book followed through the block flushes at 100k active orders, against the book rebuilt from all of the
+// active orders, what an operator did by paging through getdexorders every block
+BOOST_AUTO_TEST_CASE(dexorderbook_bench)
+{
+    auto pDexDb = make_shared<CDBAccess>(GetDataDir(), DBNameType::DEX, true, true);
+    CDexDBCache dexCache(pDexDb.get());
+    BOOST_CHECK(dexCache.LoadOrderBook());
+
+    int64_t nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < BENCH_ORDERS; i += BLOCK_ORDERS) {
+        CDexDBCache blockCache;
+        blockCache.SetBaseViewPtr(&dexCache);
+        for (uint32_t j = i; j < i + BLOCK_ORDERS; j++)
+            BOOST_CHECK(blockCache.CreateActiveOrder(MakeOrderId(j), MakeBenchOrder(j)));
+        blockCache.Flush();
+    }
+    dexCache.Flush();
+    int64_t nFill = GetTimeMicros() - nStart;
+    BOOST_CHECK_EQUAL(dexCache.GetOrderBook().GetOrderCount(), BENCH_ORDERS);
+
+    // each block deals a part of some orders, cancels others and creates new ones
+    uint32_t nextOrder = BENCH_ORDERS;
+    int64_t nBlocks = 0;
+    for (uint32_t b = 0; b < BENCH_BLOCKS; b++) {
+        CDexDBCache blockCache;
+        blockCache.SetBaseViewPtr(&dexCache);
+        uint32_t first = nextOrder - BENCH_ORDERS;
+        for (uint32_t j = 0; j < BLOCK_CHANGES; j++) {
+            CDEXOrderDetail order;
+            BOOST_REQUIRE(blockCache.GetActiveOrder(MakeOrderId(first + j), order));
+            BOOST_CHECK(blockCache.EraseActiveOrder(MakeOrderId(first + j), order));
+            BOOST_CHECK(blockCache.CreateActiveOrder(MakeOrderId(nextOrder), MakeBenchOrder(nextOrder)));
+            nextOrder++;
+
+            uint32_t dealt = first + BLOCK_CHANGES + j * 97 % (BENCH_ORDERS - BLOCK_CHANGES);
+            BOOST_REQUIRE(blockCache.GetActiveOrder(MakeOrderId(dealt), order));
+            order.total_deal_asset_amount += (order.asset_amount - order.total_deal_asset_amount) / 2;
+            BOOST_CHECK(blockCache.UpdateActiveOrder(MakeOrderId(dealt), order));
+        }
+
+        nStart = GetTimeMicros();
+        blockCache.Flush();
+        nBlocks += GetTimeMicros() - nStart;
+    }
+    BOOST_CHECK_EQUAL(dexCache.GetOrderBook().GetOrderCount(), BENCH_ORDERS);
+
+    dexCache.Flush();
+    nStart = GetTimeMicros();
+    CDexDBCache loadedCache(pDexDb.get());
+    BOOST_CHECK(loadedCache.LoadOrderBook());
+    int64_t nRebuild = GetTimeMicros() - nStart;
+    BOOST_CHECK_EQUAL(loadedCache.GetOrderBook().GetOrderCount(), BENCH_ORDERS);
+
+    nStart = GetTimeMicros();
+    Object obj;
+    dexCache.GetOrderBook().ToJson(CAssetTradingPair(SYMB::WICC, SYMB::WUSD), 20, true, obj);
+    int64_t nQuery = GetTimeMicros() - nStart;
+    BOOST_CHECK_EQUAL(find_value(obj, "bids").get_array().size(), 20U);
+
+    BOOST_TEST_MESSAGE(strprintf("dexorderbook bench: orders=%u, fill=%.2fms, blocks=%u, changes=%u/block, "
+                                 "block flush=%.1fus, rebuild=%.2fms, depth 20=%dus", BENCH_ORDERS, nFill * 0.001,
+                                 BENCH_BLOCKS, BLOCK_CHANGES * 3, nBlocks / (double)BENCH_BLOCKS, nRebuild * 0.001,
+                                 nQuery));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
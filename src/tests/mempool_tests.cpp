@@ -0,0 +1,137 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "tx/txmempool.h"
+#include "tx/cointransfertx.h"
+#include "tx/dextx.h"
+#include "persistence/txdb.h"
+#include "commons/random.h"
+#include "commons/util/time.h"
+
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const int32_t POOL_HEIGHT  = 100;
+static const uint32_t FUEL_RATE   = 100;
+static const uint32_t BENCH_ROUNDS = 10;
+
+static CTxMemPoolEntry MakeEntry(uint32_t index) {
+    uint64_t fees = 10000 + GetRand(1000000);
+    CBaseCoinTransferTx tx(CRegID(POOL_HEIGHT, index), CRegID(POOL_HEIGHT, index + 1), POOL_HEIGHT, 1000000, fees,
+                           std::to_string(index));
+    return CTxMemPoolEntry(&tx, GetTime(), POOL_HEIGHT);
+}
+
+// the full scan of the pool done by the miner before the priority index
+static void ScanPriorityTx(CTxMemPool &pool, CTxMemCache &txCache, set<TxPriority> &txPriorities) {
+    for (const auto &item : pool.memPoolTxs) {
+        const CTxMemPoolEntry &entry = item.second;
+        CBaseTx *pBaseTx = entry.GetTransaction().get();
+        if (!pBaseTx->IsBlockRewardTx() && !txCache.HaveTx(pBaseTx->GetHash())) {
+            double feePerKb = double(std::get<1>(entry.GetFees()) - pBaseTx->GetFuel(POOL_HEIGHT + 1, FUEL_RATE)) /
+                              entry.GetTxSize() * 1000.0;
+            txPriorities.emplace(TxPriority(entry.GetPriority(), feePerKb, entry.GetTransaction()));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(mempool_tests)
+
+BOOST_AUTO_TEST_CASE(mempool_priority_index_test)
+{
+    CTxMemPool pool;
+    for (uint32_t i = 0; i < 200; i++) {
+        CTxMemPoolEntry entry = MakeEntry(i);
+        pool.InsertUnchecked(entry.GetTransaction()->GetHash(), entry);
+    }
+
+    // the index gives the order of the full scan
+    CTxMemCache txCache;
+    set<TxPriority> scanned;
+    ScanPriorityTx(pool, txCache, scanned);
+    vector<TxPriority> indexed;
+    pool.GetPriorityTxs(POOL_HEIGHT + 1, FUEL_RATE, indexed);
+    BOOST_CHECK_EQUAL(indexed.size(), scanned.size());
+    auto it = scanned.begin();
+    for (uint32_t i = 0; i < indexed.size() && it != scanned.end(); i++, it++)
+        BOOST_CHECK(indexed[i].baseTx->GetHash() == it->baseTx->GetHash());
+
+    // the removed txs leave the index
+    list<std::shared_ptr<CBaseTx>> removed;
+    pool.Remove(indexed.back().baseTx.get(), removed);
+    pool.RemoveConfirmed(indexed.front().baseTx->GetHash());
+    BOOST_CHECK_EQUAL(removed.size(), 1U);
+    vector<TxPriority> remaining;
+    pool.GetPriorityTxs(POOL_HEIGHT + 1, FUEL_RATE, remaining);
+    BOOST_CHECK_EQUAL(remaining.size(), indexed.size() - 2);
+    BOOST_CHECK_EQUAL(pool.Size(), remaining.size());
+    BOOST_CHECK(remaining.front().baseTx->GetHash() == indexed[1].baseTx->GetHash());
+    BOOST_CHECK(remaining.back().baseTx->GetHash() == indexed[indexed.size() - 2].baseTx->GetHash());
+}
+
+BOOST_AUTO_TEST_CASE(mempool_priority_bench)
+{
+    for (uint32_t poolSize : {1000, 10000, 50000}) {
+        vector<CTxMemPoolEntry> entries;
+        entries.reserve(poolSize);
+        for (uint32_t i = 0; i < poolSize; i++)
+            entries.push_back(MakeEntry(i));
+
+        CTxMemPool pool;
+        int64_t nStart = GetTimeMicros();
+        for (const auto &entry : entries)
+            pool.InsertUnchecked(entry.GetTransaction()->GetHash(), entry);
+        int64_t nInsert = GetTimeMicros() - nStart;
+
+        CTxMemCache txCache;
+        nStart = GetTimeMicros();
+        for (uint32_t i = 0; i < BENCH_ROUNDS; i++) {
+            set<TxPriority> txPriorities;
+            ScanPriorityTx(pool, txCache, txPriorities);
+            BOOST_CHECK_EQUAL(txPriorities.size(), poolSize);
+        }
+        int64_t nScan = GetTimeMicros() - nStart;
+
+        nStart = GetTimeMicros();
+        for (uint32_t i = 0; i < BENCH_ROUNDS; i++) {
+            vector<TxPriority> txPriorities;
+            pool.GetPriorityTxs(POOL_HEIGHT + 1, FUEL_RATE, txPriorities);
+            BOOST_CHECK_EQUAL(txPriorities.size(), poolSize);
+        }
+        int64_t nIndex = GetTimeMicros() - nStart;
+
+        BOOST_TEST_MESSAGE(strprintf("mempool priority bench: pool=%u, index insert=%.3fus/tx, full scan=%.2fms, "
+                                     "index=%.2fms", poolSize, nInsert / (double)poolSize, nScan * 0.001 / BENCH_ROUNDS,
+                                     nIndex * 0.001 / BENCH_ROUNDS));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(mempool_carry_over_test) {
+    CBaseCoinTransferTx transferTx(CRegID(POOL_HEIGHT, 1), CRegID(POOL_HEIGHT, 2), POOL_HEIGHT, 1000000, 10000, "");
+    CTxMemPoolExecLog execLog;
+    execLog.height = POOL_HEIGHT;
+    BOOST_CHECK(CTxMemPool::CanCarryOver(transferTx, execLog, POOL_HEIGHT + 1));
+
+    // the regid generated for the sender is the height and index of the tx
+    CTxMemPoolExecLog regidLog;
+    regidLog.height = POOL_HEIGHT;
+    CDbOpLog regidOpLog;
+    regidOpLog.Set(CRegID(POOL_HEIGHT, 0).GetRegIdRaw(), CKeyID());
+    regidLog.redoLogMap.AddOpLog(dbk::REGID_KEYID, regidOpLog);
+    BOOST_CHECK(!CTxMemPool::CanCarryOver(transferTx, regidLog, POOL_HEIGHT + 1));
+
+    // the orders record the height they were executed at
+    dex::CDEXBuyLimitOrderTx orderTx;
+    BOOST_CHECK(!CTxMemPool::CanCarryOver(orderTx, execLog, POOL_HEIGHT + 1));
+
+    int32_t forkHeight = SysCfg().GetFeatureForkHeight();
+    if (forkHeight > 0) {
+        execLog.height = forkHeight - 1;
+        BOOST_CHECK(!CTxMemPool::CanCarryOver(transferTx, execLog, forkHeight));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
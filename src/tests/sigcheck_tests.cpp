@@ -0,0 +1,217 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "sigcache.h"
+#include "commons/util/time.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const uint32_t SIGS_PER_BLOCK = 1000;
+static const uint32_t BENCH_BLOCKS   = 10;
+static const uint32_t HOT_KEYS       = 2000;   // the account, miner and delegate keys verified over and over
+static const uint32_t BENCH_VERIFIES = 20000;
+
+struct FSigCheckTests {
+    FSigCheckTests() {
+        ECC_Start();
+        pVerifyHandle = std::make_shared<ECCVerifyHandle>();
+    }
+    ~FSigCheckTests() {
+        pVerifyHandle.reset();
+        ECC_Stop();
+    }
+
+    void MakeBlockChecks(vector<CSigCheck> &checks, uint32_t count) {
+        vector<CKey> keys(16);
+        for (auto &key : keys)
+            key.MakeNewKey();
+
+        checks.clear();
+        for (uint32_t i = 0; i < count; i++) {
+            const CKey &key = keys[i % keys.size()];
+            uint256 sigHash = GetRandHash();
+            vector<unsigned char> vchSig;
+            BOOST_CHECK(key.Sign(sigHash, vchSig));
+            checks.emplace_back(sigHash, key.GetPubKey(), vchSig);
+        }
+    }
+
+    std::shared_ptr<ECCVerifyHandle> pVerifyHandle;
+};
+
+BOOST_FIXTURE_TEST_SUITE(sigcheck_tests, FSigCheckTests)
+
+BOOST_AUTO_TEST_CASE(sigcheck_queue_caches_valid_only)
+{
+    vector<CSigCheck> checks;
+    MakeBlockChecks(checks, 100);
+    checks[7].vchSig[10] ^= 0x01; // corrupt one signature
+
+    CSignatureCache cache;
+    CSigCheckQueue queue;
+    queue.Start(3);
+    queue.Verify(checks, cache);
+    queue.Stop();
+
+    for (uint32_t i = 0; i < checks.size(); i++) {
+        const CSigCheck &check = checks[i];
+        BOOST_CHECK_EQUAL(cache.Get(check.sigHash, check.vchSig, check.pubKey), i != 7);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sigcache_bounded_by_bytes)
+{
+    vector<CSigCheck> checks;
+    MakeBlockChecks(checks, 2000);
+
+    // room for ~32 entries per shard and generation
+    const uint64_t nMaxBytes = SIG_CACHE_ENTRY_BYTES * CSignatureCache::SHARD_COUNT * 2 * 32;
+    CSignatureCache cache;
+    cache.SetMaxSize(nMaxBytes);
+    for (const auto &check : checks)
+        cache.Set(check.sigHash, check.vchSig, check.pubKey);
+
+    CSignatureCacheStats stats;
+    cache.GetStats(stats);
+    BOOST_CHECK(stats.bytes <= nMaxBytes);
+    BOOST_CHECK(stats.evictions > 0);
+    BOOST_CHECK_EQUAL(stats.entries + stats.evictions, checks.size());
+
+    // the latest entry always lives in the current generation
+    const CSigCheck &last = checks.back();
+    BOOST_CHECK(cache.Get(last.sigHash, last.vchSig, last.pubKey));
+    cache.GetStats(stats);
+    BOOST_CHECK_EQUAL(stats.hits, 1U);
+
+    cache.SetMaxSize(0);
+    const CSigCheck &first = checks.front();
+    cache.Set(first.sigHash, first.vchSig, first.pubKey);
+    cache.GetStats(stats);
+    BOOST_CHECK_EQUAL(stats.entries + stats.evictions, checks.size());
+}
+
+BOOST_AUTO_TEST_CASE(sigcheck_queue_bench)
+{
+    vector<vector<CSigCheck>> blocks(BENCH_BLOCKS);
+    for (auto &checks : blocks)
+        MakeBlockChecks(checks, SIGS_PER_BLOCK);
+
+    for (int32_t nThreads : {1, 2, 4, 8}) {
+        CSignatureCache cache;
+        CSigCheckQueue queue;
+        queue.Start(nThreads - 1);
+
+        int64_t nStart = GetTimeMicros();
+        for (const auto &checks : blocks)
+            queue.Verify(checks, cache);
+        int64_t nElapsed = std::max<int64_t>(GetTimeMicros() - nStart, 1);
+        queue.Stop();
+
+        BOOST_TEST_MESSAGE(strprintf("sigcheck bench: threads=%d, blocks=%u, sigs/block=%u, %.2f blocks/sec",
+                                     nThreads, BENCH_BLOCKS, SIGS_PER_BLOCK, BENCH_BLOCKS * 1000000.0 / nElapsed));
+
+        const CSigCheck &last = blocks.back().back();
+        BOOST_CHECK(cache.Get(last.sigHash, last.vchSig, last.pubKey));
+    }
+}
+
+// the least recently used key of a full shard is evicted, a lookup makes a key the most recently used one
+BOOST_AUTO_TEST_CASE(pubkeycache_lru)
+{
+    // three keys of one shard
+    vector<CPubKey> pubKeys;
+    while (pubKeys.size() < 3) {
+        CKey key;
+        key.MakeNewKey();
+        CPubKey pubKey = key.GetPubKey();
+        if (pubKeys.empty() || pubKey[pubKey.size() - 1] % CPubKeyCache::SHARD_COUNT ==
+                                   pubKeys[0][pubKeys[0].size() - 1] % CPubKeyCache::SHARD_COUNT)
+            pubKeys.push_back(pubKey);
+    }
+
+    // room for 2 keys per shard
+    CPubKeyCache cache;
+    cache.SetMaxSize(PUBKEY_CACHE_ENTRY_BYTES * CPubKeyCache::SHARD_COUNT * 2);
+
+    secp256k1_pubkey parsedKey;
+    memset(&parsedKey, 0, sizeof(parsedKey));
+    for (uint32_t i = 0; i < 2; i++) {
+        parsedKey.data[0] = i;
+        cache.Add(pubKeys[i], parsedKey);
+    }
+    BOOST_CHECK(cache.Get(pubKeys[0], parsedKey));
+    BOOST_CHECK_EQUAL(parsedKey.data[0], 0);
+
+    cache.Add(pubKeys[2], parsedKey);
+    BOOST_CHECK(cache.Get(pubKeys[0], parsedKey));
+    BOOST_CHECK(!cache.Get(pubKeys[1], parsedKey));
+    BOOST_CHECK(cache.Get(pubKeys[2], parsedKey));
+
+    CPubKeyCacheStats stats;
+    cache.GetStats(stats);
+    BOOST_CHECK_EQUAL(stats.entries, 2U);
+    BOOST_CHECK_EQUAL(stats.evictions, 1U);
+    BOOST_CHECK_EQUAL(stats.hits, 3U);
+    BOOST_CHECK_EQUAL(stats.misses, 1U);
+
+    cache.SetMaxSize(0);
+    cache.Add(pubKeys[1], parsedKey);
+    cache.GetStats(stats);
+    BOOST_CHECK_EQUAL(stats.entries, 0U);
+}
+
+// a signature verified with a parsed key of the cache is the same as with the key parsed again
+BOOST_AUTO_TEST_CASE(pubkeycache_verify)
+{
+    vector<CSigCheck> checks;
+    MakeBlockChecks(checks, 64);
+    checks[5].vchSig[10] ^= 0x01;
+
+    for (uint32_t round = 0; round < 2; round++) {
+        for (uint32_t i = 0; i < checks.size(); i++)
+            BOOST_CHECK_EQUAL(checks[i].pubKey.Verify(checks[i].sigHash, checks[i].vchSig), i != 5);
+    }
+
+    secp256k1_pubkey parsedKey;
+    BOOST_CHECK(pubKeyCache.Get(checks[0].pubKey, parsedKey));
+}
+
+BOOST_AUTO_TEST_CASE(pubkeycache_verify_bench)
+{
+    vector<CSigCheck> checks;
+    checks.reserve(HOT_KEYS);
+    for (uint32_t i = 0; i < HOT_KEYS; i++) {
+        CKey key;
+        key.MakeNewKey();
+        uint256 sigHash = GetRandHash();
+        vector<unsigned char> vchSig;
+        BOOST_CHECK(key.Sign(sigHash, vchSig));
+        checks.emplace_back(sigHash, key.GetPubKey(), vchSig);
+    }
+
+    double opsPerSec[2];
+    for (int32_t cached = 0; cached < 2; cached++) {
+        pubKeyCache.SetMaxSize(cached ? DEFAULT_PUBKEY_CACHE_SIZE << 20 : 0);
+        for (const auto &check : checks)  // warm up the cache
+            BOOST_CHECK(check.pubKey.Verify(check.sigHash, check.vchSig));
+
+        int64_t nStart = GetTimeMicros();
+        for (uint32_t i = 0; i < BENCH_VERIFIES; i++) {
+            const CSigCheck &check = checks[(i * 7919) % HOT_KEYS];
+            BOOST_CHECK(check.pubKey.Verify(check.sigHash, check.vchSig));
+        }
+        opsPerSec[cached] = BENCH_VERIFIES * 1000000.0 / std::max<int64_t>(GetTimeMicros() - nStart, 1);
+    }
+    pubKeyCache.SetMaxSize(DEFAULT_PUBKEY_CACHE_SIZE << 20);
+
+    BOOST_TEST_MESSAGE(strprintf("pubkeycache verify bench: keys=%u, verifies=%u, parsed=%.0f verifies/sec, "
+                                 "cached=%.0f verifies/sec", HOT_KEYS, BENCH_VERIFIES, opsPerSec[0], opsPerSec[1]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
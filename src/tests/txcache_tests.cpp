@@ -0,0 +1,174 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "persistence/txdb.h"
+#include "persistence/memcachesnapshot.h"
+#include "commons/random.h"
+#include "commons/util/time.h"
+
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const int32_t CACHE_HEIGHT   = 500;
+static const uint32_t TXS_PER_BLOCK = 2000;  // 1M cached txids in total
+static const int32_t BENCH_BLOCKS   = 100;
+
+static CBlockSummary MakeBlockSummary(int32_t height, uint32_t txCount) {
+    CBlockSummary summary;
+    summary.height = height;
+    summary.txids.reserve(txCount);
+    for (uint32_t i = 0; i < txCount; i++)
+        summary.txids.push_back(GetRandHash());
+    return summary;
+}
+
+BOOST_AUTO_TEST_SUITE(txcache_tests)
+
+BOOST_AUTO_TEST_CASE(txcache_ring_expiry)
+{
+    vector<CBlockSummary> blocks;
+    for (int32_t height = 0; height < 5; height++)
+        blocks.push_back(MakeBlockSummary(height, 3));
+
+    CTxMemCache base;
+    base.SetCacheHeight(3);
+    for (int32_t height = 0; height < 4; height++)
+        base.AddBlockTx(blocks[height]);
+    BOOST_CHECK_EQUAL(base.GetSize(), 12U);
+    BOOST_CHECK(base.HaveTx(blocks[0].txids[0]));
+
+    // connect block 4 and expire block 1 in a child view, block 0 is replaced in the ring
+    CTxMemCache child(&base);
+    child.SetCacheHeight(3);
+    child.AddBlockTx(blocks[4]);
+    child.RemoveBlockTx(1);
+    BOOST_CHECK(child.HaveTx(blocks[4].txids[0]));
+    BOOST_CHECK(!child.HaveTx(blocks[1].txids[1]));
+    BOOST_CHECK(child.HaveTx(blocks[2].txids[2]));
+    BOOST_CHECK(!base.HaveTx(blocks[4].txids[0]));
+    BOOST_CHECK(base.HaveTx(blocks[1].txids[1]));
+
+    child.Flush();
+    BOOST_CHECK_EQUAL(child.GetSize(), 0U);
+    BOOST_CHECK_EQUAL(base.GetSize(), 9U);
+    BOOST_CHECK(!base.HaveTx(blocks[0].txids[0]));
+    BOOST_CHECK(!base.HaveTx(blocks[1].txids[0]));
+    for (int32_t height = 2; height < 5; height++) {
+        for (const auto &txid : blocks[height].txids)
+            BOOST_CHECK(base.HaveTx(txid));
+    }
+
+    // disconnect block 4 and replace it at the same height
+    CBlockSummary forkBlock = MakeBlockSummary(4, 2);
+    CTxMemCache forkChild(&base);
+    forkChild.SetCacheHeight(3);
+    forkChild.RemoveBlockTx(4);
+    forkChild.AddBlockTx(forkBlock);
+    BOOST_CHECK(!forkChild.HaveTx(blocks[4].txids[0]));
+    BOOST_CHECK(forkChild.HaveTx(forkBlock.txids[0]));
+    forkChild.Flush();
+    BOOST_CHECK(!base.HaveTx(blocks[4].txids[0]));
+    BOOST_CHECK(base.HaveTx(forkBlock.txids[1]));
+    BOOST_CHECK_EQUAL(base.GetSize(), 8U);
+}
+
+BOOST_AUTO_TEST_CASE(txcache_bench)
+{
+    vector<CBlockSummary> blocks;
+    blocks.reserve(CACHE_HEIGHT + BENCH_BLOCKS);
+    for (int32_t height = 0; height < CACHE_HEIGHT + BENCH_BLOCKS; height++)
+        blocks.push_back(MakeBlockSummary(height, TXS_PER_BLOCK));
+
+    CTxMemCache base;
+    base.SetCacheHeight(CACHE_HEIGHT);
+    int64_t nStart = GetTimeMicros();
+    for (int32_t height = 0; height < CACHE_HEIGHT; height++)
+        base.AddBlockTx(blocks[height]);
+    int64_t nLoad = GetTimeMicros() - nStart;
+    BOOST_CHECK_EQUAL(base.GetSize(), (uint64_t)CACHE_HEIGHT * TXS_PER_BLOCK);
+
+    // lookups of cached txids and of unknown txids
+    uint32_t nFound = 0;
+    nStart = GetTimeMicros();
+    for (int32_t height = 0; height < CACHE_HEIGHT; height += 10) {
+        for (const auto &txid : blocks[height].txids)
+            nFound += base.HaveTx(txid);
+    }
+    for (const auto &txid : blocks[CACHE_HEIGHT].txids)
+        nFound += base.HaveTx(txid);
+    int64_t nLookup = GetTimeMicros() - nStart;
+    BOOST_CHECK_EQUAL(nFound, (uint32_t)CACHE_HEIGHT / 10 * TXS_PER_BLOCK);
+
+    // connect blocks as ConnectBlock() does: add the new block, expire the oldest one and flush
+    nStart = GetTimeMicros();
+    for (int32_t height = CACHE_HEIGHT; height < CACHE_HEIGHT + BENCH_BLOCKS; height++) {
+        CTxMemCache child(&base);
+        child.SetCacheHeight(CACHE_HEIGHT);
+        child.AddBlockTx(blocks[height]);
+        child.RemoveBlockTx(height - CACHE_HEIGHT);
+        child.Flush();
+    }
+    int64_t nConnect = std::max<int64_t>(GetTimeMicros() - nStart, 1);
+    BOOST_CHECK_EQUAL(base.GetSize(), (uint64_t)CACHE_HEIGHT * TXS_PER_BLOCK);
+    BOOST_CHECK(!base.HaveTx(blocks[BENCH_BLOCKS - 1].txids[0]));
+    BOOST_CHECK(base.HaveTx(blocks[CACHE_HEIGHT + BENCH_BLOCKS - 1].txids[0]));
+
+    BOOST_TEST_MESSAGE(strprintf("txcache bench: txids=%u, load=%.2fms, lookup=%.3fus/tx, connect+flush=%.3fms/block",
+                                 base.GetSize(), nLoad * 0.001, nLookup / (double)(CACHE_HEIGHT / 10 + 1) / TXS_PER_BLOCK,
+                                 nConnect * 0.001 / BENCH_BLOCKS));
+}
+
+// the txids of the cache are restored from the snapshot instead of the blocks, as the startup does
+BOOST_AUTO_TEST_CASE(txcache_snapshot)
+{
+    vector<CBlockSummary> blocks;
+    blocks.reserve(CACHE_HEIGHT + 10);
+    for (int32_t height = 0; height < CACHE_HEIGHT + 10; height++)
+        blocks.push_back(MakeBlockSummary(height, TXS_PER_BLOCK / 10));
+
+    CTxMemCache base;
+    base.SetCacheHeight(CACHE_HEIGHT);
+    for (const auto &block : blocks) {
+        base.AddBlockTx(block);
+        if (block.height >= CACHE_HEIGHT)
+            base.RemoveBlockTx(block.height - CACHE_HEIGHT);
+    }
+
+    int64_t nStart = GetTimeMicros();
+    CMemCacheSnapshot snapshot;
+    snapshot.tipHeight = blocks.back().height;
+    base.GetBlockTxids(snapshot.tipHeight - CACHE_HEIGHT + 1, snapshot.blockTxids);
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << snapshot;
+    int64_t nWrite = GetTimeMicros() - nStart;
+    BOOST_CHECK_EQUAL(snapshot.blockTxids.size(), (size_t)CACHE_HEIGHT);
+    uint64_t nBytes = ss.size();
+
+    nStart = GetTimeMicros();
+    CMemCacheSnapshot loaded;
+    ss >> loaded;
+    CTxMemCache restored;
+    restored.SetCacheHeight(CACHE_HEIGHT);
+    restored.AddBlockTxids(loaded.blockTxids);
+    int64_t nLoad = GetTimeMicros() - nStart;
+
+    BOOST_CHECK_EQUAL(restored.GetSize(), base.GetSize());
+    BOOST_CHECK(!restored.HaveTx(blocks[9].txids[0]));
+    for (int32_t height = 10; height < CACHE_HEIGHT + 10; height++)
+        BOOST_CHECK(restored.HaveTx(blocks[height].txids.back()));
+
+    // a block connected after the snapshot is added on top of it
+    CBlockSummary block = MakeBlockSummary(CACHE_HEIGHT + 10, 3);
+    restored.AddBlockTx(block);
+    restored.RemoveBlockTx(10);
+    BOOST_CHECK(restored.HaveTx(block.txids[0]));
+    BOOST_CHECK(!restored.HaveTx(blocks[10].txids[0]));
+
+    BOOST_TEST_MESSAGE(strprintf("txcache snapshot: txids=%u, bytes=%u, write=%.2fms, load=%.2fms", base.GetSize(),
+                                 nBytes, nWrite * 0.001, nLoad * 0.001));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
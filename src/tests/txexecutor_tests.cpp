@@ -0,0 +1,189 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "tx/txexecutor.h"
+#include "tx/blockrewardtx.h"
+#include "tx/cointransfertx.h"
+#include "persistence/block.h"
+#include "persistence/blockundo.h"
+#include "persistence/cachewrapper.h"
+#include "crypto/hash.h"
+#include "commons/util/time.h"
+#include "main.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static const int32_t BLOCK_HEIGHT  = 1000;
+static const uint32_t FUEL_RATE    = 100;
+static const uint32_t BLOCK_TIME   = 1570000000;
+static const uint32_t ACCOUNT_NUM  = 2400;
+static const uint32_t HOT_ACCOUNT  = 2000;  // the first of the 11 hot accounts
+static const uint64_t INIT_BALANCE = 1000 * COIN;
+static const int32_t EXEC_THREADS  = 4;
+
+static CKeyID MakeKeyId(uint32_t index) { return CKeyID(Hash160(std::to_string(index))); }
+
+static void InitAccounts(CCacheWrapper &cw, uint64_t balance) {
+    for (uint32_t i = 0; i < ACCOUNT_NUM; i++) {
+        CAccount account(MakeKeyId(i));
+        account.regid = CRegID(1, i + 1);
+        account.OperateBalance(SYMB::WICC, BalanceOpType::ADD_FREE, balance);
+        BOOST_REQUIRE(cw.accountCache.SaveAccount(account));
+    }
+}
+
+static void AddTransfer(CBlock &block, uint32_t from, uint32_t to, uint64_t amount) {
+    block.vptx.push_back(std::make_shared<CCoinTransferTx>(CRegID(1, from + 1), CRegID(1, to + 1), BLOCK_HEIGHT,
+                                                           SYMB::WICC, amount, SYMB::WICC, 10000,
+                                                           std::to_string(block.vptx.size())));
+}
+
+// a run of transfers between disjoint accounts, then a run among a few hot accounts conflicting with each other
+static void MakeBlock(CBlock &block, uint32_t independentTxs, uint32_t hotTxs) {
+    block.vptx.push_back(std::make_shared<CBlockRewardTx>());
+    for (uint32_t i = 0; i < independentTxs; i++)
+        AddTransfer(block, 2 * i, 2 * i + 1, COIN);
+    for (uint32_t i = 0; i < hotTxs; i++)
+        AddTransfer(block, HOT_ACCOUNT + i % 7, HOT_ACCOUNT + (i * 5 + 3) % 11, COIN);
+}
+
+struct CReplayResult {
+    CBlockUndo blockUndo;
+    CValidationState state;
+    int32_t failedIndex = 0;
+    uint32_t reexecuted = 0;
+    int64_t micros      = 0;
+};
+
+static void ReplayBlock(CBlock &block, CCacheWrapper &cw, int32_t nThreads, CReplayResult &result) {
+    int64_t nStart = GetTimeMicros();
+    CTxParallelExecutor executor(block, BLOCK_HEIGHT, FUEL_RATE, BLOCK_TIME, BLOCK_TIME, cw, nThreads);
+    for (int32_t index = 1; index < (int32_t)block.vptx.size(); index++) {
+        block.vptx[index]->nFuelRate = FUEL_RATE;
+        if (!executor.ExecuteTx(index, result.blockUndo, result.state)) {
+            result.failedIndex = index;
+            break;
+        }
+    }
+    result.reexecuted = executor.GetReexecutedCount();
+    result.micros     = GetTimeMicros() - nStart;
+}
+
+template <typename T>
+static string Serialize(const T &obj) {
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << obj;
+    return ss.str();
+}
+
+// the state, undo logs and receipts of the parallel replay must be the same bytes as the serial ones
+static void CheckSameResult(const CBlock &block, CCacheWrapper &serialCw, const CReplayResult &serial,
+                            CCacheWrapper &parallelCw, const CReplayResult &parallel) {
+    BOOST_CHECK_EQUAL(parallel.failedIndex, serial.failedIndex);
+    BOOST_CHECK_EQUAL(parallel.state.GetRejectReason(), serial.state.GetRejectReason());
+    BOOST_CHECK(Serialize(parallel.blockUndo) == Serialize(serial.blockUndo));
+
+    for (uint32_t i = 0; i < ACCOUNT_NUM; i++) {
+        CAccount serialAccount, parallelAccount;
+        BOOST_CHECK(serialCw.accountCache.GetAccount(MakeKeyId(i), serialAccount));
+        BOOST_CHECK(parallelCw.accountCache.GetAccount(MakeKeyId(i), parallelAccount));
+        BOOST_CHECK(Serialize(parallelAccount) == Serialize(serialAccount));
+    }
+
+    for (const auto &pBaseTx : block.vptx) {
+        vector<CReceipt> serialReceipts, parallelReceipts;
+        BOOST_CHECK_EQUAL(serialCw.txReceiptCache.GetTxReceipts(pBaseTx->GetHash(), serialReceipts),
+                          parallelCw.txReceiptCache.GetTxReceipts(pBaseTx->GetHash(), parallelReceipts));
+        BOOST_CHECK(Serialize(parallelReceipts) == Serialize(serialReceipts));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(txexecutor_tests)
+
+BOOST_AUTO_TEST_CASE(txexecutor_replay_test)
+{
+    CCacheWrapper base;
+    InitAccounts(base, INIT_BALANCE);
+
+    CBlock block;
+    MakeBlock(block, 1000, 200);
+
+    CCacheWrapper serialCw(&base);
+    CReplayResult serial;
+    ReplayBlock(block, serialCw, 1, serial);
+    BOOST_CHECK_EQUAL(serial.failedIndex, 0);
+    BOOST_CHECK_EQUAL(serial.blockUndo.vtxundo.size(), block.vptx.size() - 1);
+
+    CCacheWrapper parallelCw(&base);
+    CReplayResult parallel;
+    ReplayBlock(block, parallelCw, EXEC_THREADS, parallel);
+    CheckSameResult(block, serialCw, serial, parallelCw, parallel);
+
+    // only the hot accounts' txs after their first one are executed again
+    BOOST_CHECK(parallel.reexecuted > 0 && parallel.reexecuted < 200);
+
+    BOOST_TEST_MESSAGE(strprintf("txexecutor replay: txs=%u, serial=%.2fms, parallel(%d threads)=%.2fms, "
+                                 "re-executed=%u", block.vptx.size() - 1, serial.micros * 0.001, EXEC_THREADS,
+                                 parallel.micros * 0.001, parallel.reexecuted));
+}
+
+BOOST_AUTO_TEST_CASE(txexecutor_replay_failed_tx_test)
+{
+    // the hot accounts run out of coins, the speculation of the failing tx saw the balance before the
+    // earlier transfers and succeeded, its re-execution must fail as the serial one does
+    CCacheWrapper base;
+    InitAccounts(base, 3 * COIN);
+
+    CBlock block;
+    MakeBlock(block, 20, 40);
+
+    CCacheWrapper serialCw(&base);
+    CReplayResult serial;
+    ReplayBlock(block, serialCw, 1, serial);
+    BOOST_CHECK(serial.failedIndex > 20);
+
+    CCacheWrapper parallelCw(&base);
+    CReplayResult parallel;
+    ReplayBlock(block, parallelCw, EXEC_THREADS, parallel);
+    CheckSameResult(block, serialCw, serial, parallelCw, parallel);
+}
+
+BOOST_AUTO_TEST_CASE(txexecutor_global_sysparam_read_test)
+{
+    // the workers all miss the same miner fee key of the global sysparam cache, it is in the db only
+    BOOST_REQUIRE(pCdMan != nullptr);
+    const TokenSymbol symbol = "WXTEST";
+    const uint64_t minerFee  = 12345;
+    BOOST_REQUIRE(pCdMan->pSysParamCache->SetMinerFee(BCOIN_TRANSFER_TX, symbol, minerFee));
+    BOOST_REQUIRE(pCdMan->pSysParamCache->Flush());
+
+    for (uint32_t round = 0; round < 200; round++) {
+        std::recursive_mutex baseReadMutex;
+        std::atomic<uint32_t> nFound(0);
+        vector<std::thread> workers;
+        for (int32_t i = 0; i < EXEC_THREADS; i++) {
+            workers.emplace_back([&]() {
+                CDBBaseReadLock::pMutex = &baseReadMutex;
+                uint64_t fee = 0;
+                if (GetTxMinFee(BCOIN_TRANSFER_TX, BLOCK_HEIGHT, symbol, fee) && fee == minerFee)
+                    nFound++;
+                CDBBaseReadLock::pMutex = nullptr;
+            });
+        }
+        for (auto &worker : workers)
+            worker.join();
+
+        BOOST_CHECK_EQUAL(nFound.load(), (uint32_t)EXEC_THREADS);
+        // forget the read fee, the next round misses it again
+        pCdMan->pSysParamCache->Flush();
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,161 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "persistence/contractdb.h"
+#include "persistence/dbaccess.h"
+#include "crypto/hash.h"
+#include "vm/wasm/wasm_interface.hpp"
+#include "vm/wasm/wasm_module_cache.hpp"
+
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+// the smallest valid modules: the bare header, and the header with an empty type section
+static const vector<uint8_t> EMPTY_MODULE = {0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00};
+static const vector<uint8_t> TYPE_MODULE  = {0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00};
+
+static const uint64_t FAKE_MODULE_SIZE = 100;
+
+class CFakeModule : public wasm::wasm_instantiated_module_interface {
+public:
+    void apply(wasm::wasm_context_interface *pContext) override {}
+    size_t get_memory_size() override { return FAKE_MODULE_SIZE; }
+};
+
+static uint256 MakeCodeHash(uint32_t index) {
+    string code = "code-" + std::to_string(index);
+    return Hash(code.begin(), code.end());
+}
+
+struct FWasmModuleCacheTests {
+    FWasmModuleCacheTests() {
+        root_dir = "/tmp/coind_unit_test";
+        if (!boost::filesystem::exists(root_dir))
+            BOOST_CHECK_NO_THROW(boost::filesystem::create_directory(root_dir));
+
+        db_dir = root_dir / "wasm_module_cache_tests";
+        BOOST_CHECK_MESSAGE(!boost::filesystem::exists(db_dir), "must remove dir " + db_dir.string() + " first");
+        BOOST_CHECK_NO_THROW(boost::filesystem::create_directory(db_dir));
+    }
+    ~FWasmModuleCacheTests() {
+        BOOST_CHECK_NO_THROW(boost::filesystem::remove_all(db_dir));
+    }
+
+    boost::filesystem::path root_dir;
+    boost::filesystem::path db_dir;
+};
+
+BOOST_FIXTURE_TEST_SUITE(wasm_module_cache_tests, FWasmModuleCacheTests)
+
+BOOST_AUTO_TEST_CASE(wasm_contract_code_hash_test) {
+    auto pDBAccess = make_shared<CDBAccess>(db_dir, DBNameType::CONTRACT, false, true);
+    CRegID regid(100, 1);
+    CUniversalContract contract(VMType::WASM_VM, true, "wasm code", "", "");
+    uint256 codeHash = Hash(contract.code.begin(), contract.code.end());
+    {
+        CContractDBCache contractCache(pDBAccess.get());
+        BOOST_CHECK(contractCache.SaveContract(regid, contract));
+
+        uint256 savedHash;
+        BOOST_CHECK(contractCache.contractCodeHashCache.GetData(regid, savedHash));
+        BOOST_CHECK(savedHash == codeHash);
+        contractCache.Flush();
+    }
+
+    CContractDBCache contractCache(pDBAccess.get());
+    uint256 readHash;
+    BOOST_CHECK(contractCache.GetContractCodeHash(regid, readHash));
+    BOOST_CHECK(readHash == codeHash);
+    BOOST_CHECK(!contractCache.GetContractCodeHash(CRegID(100, 2), readHash));
+
+    // the upgraded code replaces the hash
+    CUniversalContract upgraded(VMType::WASM_VM, true, "upgraded wasm code", "", "");
+    BOOST_CHECK(contractCache.SaveContract(regid, upgraded));
+    BOOST_CHECK(contractCache.GetContractCodeHash(regid, readHash));
+    BOOST_CHECK(readHash == Hash(upgraded.code.begin(), upgraded.code.end()));
+}
+
+BOOST_AUTO_TEST_CASE(wasm_contract_code_hash_fallback_test) {
+    auto pDBAccess = make_shared<CDBAccess>(db_dir, DBNameType::CONTRACT, false, true);
+    CRegID regid(100, 1);
+    CUniversalContract contract(VMType::WASM_VM, true, "wasm code", "", "");
+    {
+        // a contract saved before its code hash was
+        CContractDBCache contractCache(pDBAccess.get());
+        BOOST_CHECK(contractCache.contractCache.SetData(regid, contract));
+        contractCache.Flush();
+    }
+
+    CContractDBCache contractCache(pDBAccess.get());
+    uint256 readHash;
+    BOOST_CHECK(!contractCache.contractCodeHashCache.GetData(regid, readHash));
+    BOOST_CHECK(contractCache.GetContractCodeHash(regid, readHash));
+    BOOST_CHECK(readHash == Hash(contract.code.begin(), contract.code.end()));
+}
+
+BOOST_AUTO_TEST_CASE(wasm_instantiation_cache_lru_test) {
+    wasm::wasm_instantiation_cache cache;
+    cache.set_max_size(3 * FAKE_MODULE_SIZE);
+    for (uint32_t i = 1; i <= 3; i++)
+        cache.add(MakeCodeHash(i), make_shared<CFakeModule>());
+
+    // the lookups of contains() neither count nor make the module the most recently used
+    BOOST_CHECK(cache.contains(MakeCodeHash(2)));
+    BOOST_CHECK(cache.get(MakeCodeHash(1)) != nullptr);
+    BOOST_CHECK(cache.get(MakeCodeHash(4)) == nullptr);
+
+    cache.add(MakeCodeHash(4), make_shared<CFakeModule>());
+    BOOST_CHECK(cache.contains(MakeCodeHash(1)));
+    BOOST_CHECK(!cache.contains(MakeCodeHash(2)));
+    BOOST_CHECK(cache.contains(MakeCodeHash(3)));
+    BOOST_CHECK(cache.contains(MakeCodeHash(4)));
+
+    wasm::wasm_module_cache_stats stats;
+    cache.get_stats(stats);
+    BOOST_CHECK_EQUAL(stats.entries, 3U);
+    BOOST_CHECK_EQUAL(stats.bytes, 3 * FAKE_MODULE_SIZE);
+    BOOST_CHECK_EQUAL(stats.hits, 1U);
+    BOOST_CHECK_EQUAL(stats.misses, 1U);
+    BOOST_CHECK_EQUAL(stats.evictions, 1U);
+
+    // a smaller budget keeps the most recently used
+    cache.set_max_size(FAKE_MODULE_SIZE);
+    BOOST_CHECK(cache.contains(MakeCodeHash(4)));
+    cache.get_stats(stats);
+    BOOST_CHECK_EQUAL(stats.entries, 1U);
+    BOOST_CHECK_EQUAL(stats.evictions, 3U);
+}
+
+BOOST_AUTO_TEST_CASE(wasm_instantiate_test) {
+    wasm::wasm_interface wasmif;
+    wasmif.initialize(wasm::vm_type::eos_vm);
+    wasm_code_cache_free();
+
+    wasm::wasm_module_cache_stats before;
+    wasm_code_cache_get_stats(before);
+
+    uint256 emptyHash = Hash(EMPTY_MODULE.begin(), EMPTY_MODULE.end());
+    uint256 typeHash  = Hash(TYPE_MODULE.begin(), TYPE_MODULE.end());
+    BOOST_CHECK(wasmif.instantiate(emptyHash, EMPTY_MODULE));
+    BOOST_CHECK(wasmif.instantiate(emptyHash, EMPTY_MODULE));
+    BOOST_CHECK(wasmif.instantiate(typeHash, TYPE_MODULE));
+
+    vector<uint8_t> badCode = {0x00, 0x61, 0x73, 0x6d, 0x02};
+    BOOST_CHECK(!wasmif.instantiate(Hash(badCode.begin(), badCode.end()), badCode));
+
+    // the setcode instantiations are not contract calls
+    wasm::wasm_module_cache_stats stats;
+    wasm_code_cache_get_stats(stats);
+    BOOST_CHECK_EQUAL(stats.entries, 2U);
+    BOOST_CHECK_EQUAL(stats.hits, before.hits);
+    BOOST_CHECK_EQUAL(stats.misses, before.misses);
+
+    wasm_code_cache_free();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
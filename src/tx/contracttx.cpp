@@ -178,8 +178,7 @@ bool CLuaContractInvokeTx::CheckTx(CTxExecuteContext &context) {
         return state.DoS(100, ERRORMSG("CLuaContractInvokeTx::CheckTx, read account failed, tx_uid=%s",
                         txUid.ToDebugString()), REJECT_INVALID, "bad-getaccount");
 
-    CUniversalContract contract;
-    if (!cw.contractCache.GetContract(app_uid.get<CRegID>(), contract))
+    if (!cw.contractCache.HaveContract(app_uid.get<CRegID>()))
         return state.DoS(100, ERRORMSG("CLuaContractInvokeTx::CheckTx, read script failed, regId=%s",
                         app_uid.get<CRegID>().ToString()), REJECT_INVALID, "bad-read-script");
 
@@ -230,8 +229,8 @@ bool CLuaContractInvokeTx::ExecuteTx(CTxExecuteContext &context) {
         return state.DoS(100, ERRORMSG("CLuaContractInvokeTx::ExecuteTx, save account error, kyeId=%s",
                         desAccount.keyid.ToString()), UPDATE_ACCOUNT_FAIL, "bad-save-account");
 
-    CUniversalContract contract;
-    if (!cw.contractCache.GetContract(app_uid.get<CRegID>(), contract))
+    std::shared_ptr<const CUniversalContract> spContract;
+    if (!cw.contractCache.GetContract(app_uid.get<CRegID>(), spContract))
         return state.DoS(100, ERRORMSG("CLuaContractInvokeTx::ExecuteTx, read script failed, regId=%s",
                         app_uid.get<CRegID>().ToString()), READ_ACCOUNT_FAIL, "bad-read-script");
 
@@ -248,7 +247,7 @@ bool CLuaContractInvokeTx::ExecuteTx(CTxExecuteContext &context) {
     luaContext.transfer_amount   = coin_amount;
     luaContext.p_tx_user_account = &srcAccount;
     luaContext.p_app_account     = &desAccount;
-    luaContext.p_contract        = &contract;
+    luaContext.p_contract        = spContract.get();
     luaContext.p_arguments       = &arguments;
 
     int64_t llTime = GetTimeMillis();
@@ -466,8 +465,7 @@ bool CUniversalContractInvokeTx::CheckTx(CTxExecuteContext &context) {
         }
     }
 
-    CUniversalContract contract;
-    if (!cw.contractCache.GetContract(app_uid.get<CRegID>(), contract))
+    if (!cw.contractCache.HaveContract(app_uid.get<CRegID>()))
         return state.DoS(100, ERRORMSG("CUniversalContractInvokeTx::CheckTx, read script failed, regId=%s",
                         app_uid.get<CRegID>().ToString()), REJECT_INVALID, "bad-read-script");
 
@@ -524,8 +522,8 @@ bool CUniversalContractInvokeTx::ExecuteTx(CTxExecuteContext &context) {
         return state.DoS(100, ERRORMSG("CUniversalContractInvokeTx::ExecuteTx, save account error, kyeId=%s",
                         desAccount.keyid.ToString()), UPDATE_ACCOUNT_FAIL, "bad-save-account");
 
-    CUniversalContract contract;
-    if (!cw.contractCache.GetContract(app_uid.get<CRegID>(), contract))
+    std::shared_ptr<const CUniversalContract> spContract;
+    if (!cw.contractCache.GetContract(app_uid.get<CRegID>(), spContract))
         return state.DoS(100, ERRORMSG("CUniversalContractInvokeTx::ExecuteTx, read script failed, regId=%s",
                         app_uid.get<CRegID>().ToString()), READ_ACCOUNT_FAIL, "bad-read-script");
 
@@ -542,7 +540,7 @@ bool CUniversalContractInvokeTx::ExecuteTx(CTxExecuteContext &context) {
     luaContext.transfer_amount   = coin_amount;
     luaContext.p_tx_user_account = &srcAccount;
     luaContext.p_app_account     = &desAccount;
-    luaContext.p_contract        = &contract;
+    luaContext.p_contract        = spContract.get();
     luaContext.p_arguments       = &arguments;
 
     int64_t llTime = GetTimeMillis();
@@ -298,13 +298,7 @@ Object CMulsigTx::ToJson(const CAccountDBCache &accountCache) const {
     return result;
 }
 
-bool CMulsigTx::GetInvolvedKeyIds(CCacheWrapper &cw, set<CKeyID> &keyIds) {
-    CKeyID keyId;
-    for (const auto &item : signaturePairs) {
-        if (!cw.accountCache.GetKeyId(CUserID(item.regid), keyId))
-            return false;
-        keyIds.insert(keyId);
-    }
-
-    return true;
+void CMulsigTx::GetInvolvedUserIds(vector<CUserID> &uids) const {
+    for (const auto &item : signaturePairs)
+        uids.push_back(CUserID(item.regid));
 }
\ No newline at end of file
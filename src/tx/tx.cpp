@@ -40,8 +40,12 @@ string GetTxType(const TxType txType) {
 }
 
 bool GetTxMinFee(const TxType nTxType, int height, const TokenSymbol &symbol, uint64_t &feeOut) {
-    if (pCdMan->pSysParamCache->GetMinerFee(nTxType, symbol, feeOut))
-        return true ;
+    {
+        // a miss adds the fee to the map of the global cache, serialized against the parallel tx executors
+        CDBBaseReadLock baseLock;
+        if (pCdMan->pSysParamCache->GetMinerFee(nTxType, symbol, feeOut))
+            return true ;
+    }
 
     const auto &iter = kTxFeeTable.find(nTxType);
     if (iter != kTxFeeTable.end()) {
@@ -141,7 +145,9 @@ string CBaseTx::ToString(CAccountDBCache &accountCache) {
 }
 
 bool CBaseTx::GetInvolvedKeyIds(CCacheWrapper &cw, set<CKeyID> &keyIds) {
-    return AddInvolvedKeyIds({txUid}, cw, keyIds);
+    vector<CUserID> uids;
+    GetInvolvedUserIds(uids);
+    return AddInvolvedKeyIds(uids, cw, keyIds);
 }
 
 bool CBaseTx::AddInvolvedKeyIds(vector<CUserID> uids, CCacheWrapper &cw, set<CKeyID> &keyIds) {
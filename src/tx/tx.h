@@ -159,6 +159,8 @@ public:
     virtual Object ToJson(const CAccountDBCache &accountCache) const;
 
     virtual bool GetInvolvedKeyIds(CCacheWrapper &cw, set<CKeyID> &keyIds);
+    // the user ids involved in the tx, without resolving them in the account db
+    virtual void GetInvolvedUserIds(vector<CUserID> &uids) const { uids.push_back(txUid); }
 
     virtual bool CheckTx(CTxExecuteContext &context)   = 0;
     virtual bool ExecuteTx(CTxExecuteContext &context) = 0;
@@ -0,0 +1,144 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "txexecutor.h"
+#include "main.h"
+#include "persistence/block.h"
+#include "persistence/blockundo.h"
+#include "persistence/cachewrapper.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+struct CTxParallelExecutor::CTxSpeculation {
+    std::shared_ptr<CCacheWrapper> spCw;
+    CTxUndo txUndo;
+    CDBAccessSet accessSet;
+    CValidationState state;
+    bool executed = false;
+};
+
+CTxParallelExecutor::CTxParallelExecutor(CBlock &blockIn, int32_t heightIn, uint32_t fuelRateIn, uint32_t blockTimeIn,
+                                         uint32_t prevBlockTimeIn, CCacheWrapper &cwIn, int32_t nThreadsIn)
+    : block(blockIn), height(heightIn), fuelRate(fuelRateIn), blockTime(blockTimeIn), prevBlockTime(prevBlockTimeIn),
+      cw(cwIn), nThreads(std::min(nThreadsIn, MAX_PARALLEL_EXEC_THREADS)) {}
+
+CTxParallelExecutor::~CTxParallelExecutor() {}
+
+bool CTxParallelExecutor::IsParallelTx(const CBaseTx &tx) {
+    switch (tx.nTxType) {
+        case BCOIN_TRANSFER_TX:
+        case UCOIN_TRANSFER_TX:
+        case DEX_LIMIT_BUY_ORDER_TX:
+        case DEX_LIMIT_SELL_ORDER_TX:
+        case DEX_MARKET_BUY_ORDER_TX:
+        case DEX_MARKET_SELL_ORDER_TX:
+        case DEX_CANCEL_ORDER_TX:
+        case DEX_ORDER_TX:
+        case DEX_OPERATOR_ORDER_TX:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool CTxParallelExecutor::ExecuteTx(int32_t index, CBlockUndo &blockUndo, CValidationState &state) {
+    if (nThreads > 1 && index >= scanEnd) {
+        int32_t end = index;
+        while (end < (int32_t)block.vptx.size() && IsParallelTx(*block.vptx[end]))
+            end++;
+
+        scanEnd = std::max(end, index + 1);
+        if (end - index >= (int32_t)MIN_PARALLEL_EXEC_TXS)
+            Speculate(index, end);
+    }
+
+    if (index >= runBegin && index < runEnd)
+        return CommitTx(index, blockUndo, state);
+
+    std::shared_ptr<CBaseTx> &pBaseTx = block.vptx[index];
+    CTxUndoOpLogger opLogger(cw, pBaseTx->GetHash(), blockUndo);
+    CTxExecuteContext context(height, index, fuelRate, blockTime, prevBlockTime, &cw, &state);
+    return pBaseTx->ExecuteTx(context);
+}
+
+void CTxParallelExecutor::RunTx(int32_t index, CTxSpeculation &spec) {
+    std::shared_ptr<CBaseTx> &pBaseTx = block.vptx[index];
+    spec.spCw  = std::make_shared<CCacheWrapper>(&cw);
+    spec.state = CValidationState();
+    spec.txUndo.Clear();
+    spec.txUndo.SetTxID(pBaseTx->GetHash());
+    spec.accessSet.Clear();
+
+    spec.txUndo.dbOpLogMap.SetAccessSet(&spec.accessSet);
+    spec.spCw->SetDbOpLogMap(&spec.txUndo.dbOpLogMap);
+
+    CTxExecuteContext context(height, index, fuelRate, blockTime, prevBlockTime, spec.spCw.get(), &spec.state);
+    spec.executed = pBaseTx->ExecuteTx(context);
+
+    spec.spCw->SetDbOpLogMap(nullptr);
+    spec.txUndo.dbOpLogMap.SetAccessSet(nullptr);
+}
+
+void CTxParallelExecutor::Speculate(int32_t begin, int32_t end) {
+    runBegin = begin;
+    runEnd   = end;
+    committedWrites.Clear();
+    specs.clear();
+    for (int32_t i = begin; i < end; i++) {
+        block.vptx[i]->nFuelRate = fuelRate;
+        specs.push_back(std::make_shared<CTxSpeculation>());
+    }
+
+    std::recursive_mutex baseReadMutex;
+    std::atomic<int32_t> nNextTx(begin);
+    auto worker = [&]() {
+        CDBBaseReadLock::pMutex = &baseReadMutex;
+        int32_t i;
+        while ((i = nNextTx.fetch_add(1)) < end) {
+            try {
+                RunTx(i, *specs[i - begin]);
+            } catch (...) {
+                // executed again when committed, the exception is thrown there unless it came from a conflict
+                specs[i - begin]->executed = false;
+            }
+        }
+        CDBBaseReadLock::pMutex = nullptr;
+    };
+
+    // the calling thread takes part as well
+    std::vector<std::thread> workers;
+    int32_t nWorkers = std::min(nThreads, end - begin) - 1;
+    for (int32_t i = 0; i < nWorkers; i++)
+        workers.emplace_back(worker);
+
+    worker();
+    for (auto &thread : workers)
+        thread.join();
+
+    nSpeculated += end - begin;
+}
+
+bool CTxParallelExecutor::CommitTx(int32_t index, CBlockUndo &blockUndo, CValidationState &state) {
+    CTxSpeculation &spec = *specs[index - runBegin];
+    if (!spec.executed || spec.accessSet.HasReadConflict(committedWrites)) {
+        // the speculation is stale or failed, run the tx on the current state of cw
+        RunTx(index, spec);
+        nReexecuted++;
+    }
+
+    // a failed tx is committed too, the block is rejected anyway but cw is left as by the serial execution
+    spec.spCw->Flush();
+    blockUndo.vtxundo.push_back(spec.txUndo);
+    committedWrites.MergeWrites(spec.accessSet);
+
+    bool executed = spec.executed;
+    if (!executed)
+        state = spec.state;
+
+    specs[index - runBegin].reset();
+    return executed;
+}
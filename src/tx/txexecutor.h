@@ -0,0 +1,80 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef TX_EXECUTOR_H
+#define TX_EXECUTOR_H
+
+#include "persistence/leveldbwrapper.h"
+
+#include <memory>
+#include <vector>
+
+class CBaseTx;
+class CBlock;
+class CBlockUndo;
+class CCacheWrapper;
+class CValidationState;
+
+/** -parallelexec default: number of threads executing the independent txs of a block, 0 or 1 = serial */
+static const int32_t DEFAULT_PARALLEL_EXEC_THREADS = 0;
+/** Maximum number of parallel tx execution threads */
+static const int32_t MAX_PARALLEL_EXEC_THREADS = 16;
+/** Min number of consecutive parallel txs worth starting the worker threads for */
+static const uint32_t MIN_PARALLEL_EXEC_TXS = 4;
+
+/**
+ * Executes the txs of a block in block order into cw, as the serial ExecuteTx() calls of ConnectBlock() do.
+ * The runs of consecutive coin transfer and DEX order txs are first executed speculatively on worker
+ * threads, each tx in its own child view of cw recording the keys it reads and writes. They are then
+ * committed in block order: a tx whose speculation read a key written by a tx committed before it in
+ * the run is executed again on the current state, so the state, the undo logs and the receipts are the
+ * same as the serial ones. The other txs are executed serially between the runs.
+ */
+class CTxParallelExecutor {
+public:
+    CTxParallelExecutor(CBlock &blockIn, int32_t heightIn, uint32_t fuelRateIn, uint32_t blockTimeIn,
+                        uint32_t prevBlockTimeIn, CCacheWrapper &cwIn, int32_t nThreadsIn);
+    ~CTxParallelExecutor();
+
+    /** Execute the tx at index, the txs must be executed by index order from 1 */
+    bool ExecuteTx(int32_t index, CBlockUndo &blockUndo, CValidationState &state);
+
+    /**
+     * The tx types touching only the caches tracked by CDBAccessSet and no global state: their ExecuteTx()
+     * reads the caches through context.pCw only, whose reads falling through to the shared caches take
+     * CDBBaseReadLock. A global cache read on a worker thread, as GetTxMinFee() of the global sysparam
+     * cache, must take the lock as well.
+     */
+    static bool IsParallelTx(const CBaseTx &tx);
+
+    uint32_t GetSpeculatedCount() const { return nSpeculated; }
+    uint32_t GetReexecutedCount() const { return nReexecuted; }
+
+private:
+    struct CTxSpeculation;
+
+    void Speculate(int32_t begin, int32_t end);
+    void RunTx(int32_t index, CTxSpeculation &spec);
+    bool CommitTx(int32_t index, CBlockUndo &blockUndo, CValidationState &state);
+
+    CBlock &block;
+    int32_t height;
+    uint32_t fuelRate;
+    uint32_t blockTime;
+    uint32_t prevBlockTime;
+    CCacheWrapper &cw;
+    int32_t nThreads;
+
+    //! the speculated run of txs [runBegin, runEnd) and the keys written by its committed txs
+    std::vector<std::shared_ptr<CTxSpeculation>> specs;
+    int32_t runBegin = 0;
+    int32_t runEnd   = 0;
+    int32_t scanEnd  = 0;
+    CDBAccessSet committedWrites;
+
+    uint32_t nSpeculated = 0;
+    uint32_t nReexecuted = 0;
+};
+
+#endif  // TX_EXECUTOR_H
@@ -10,6 +10,9 @@
 #include "tx/tx.h"
 #include "miner/miner.h"
 
+#include <algorithm>
+#include <iterator>
+
 using namespace std;
 
 CTxMemPoolEntry::CTxMemPoolEntry() {
@@ -18,9 +21,11 @@ CTxMemPoolEntry::CTxMemPoolEntry() {
 
     nTime   = 0;
     height = 0;
+    nSequence = 0;
 }
 
-CTxMemPoolEntry::CTxMemPoolEntry(CBaseTx *pBaseTx, int64_t time, uint32_t height) : nTime(time), height(height) {
+CTxMemPoolEntry::CTxMemPoolEntry(CBaseTx *pBaseTx, int64_t time, uint32_t height)
+    : nTime(time), height(height), nSequence(0) {
     pTx       = pBaseTx->GetNewInstance();
     nFees     = pTx->GetFees();
     nTxSize   = ::GetSerializeSize(*pTx, SER_NETWORK, PROTOCOL_VERSION);
@@ -35,6 +40,9 @@ CTxMemPoolEntry::CTxMemPoolEntry(const CTxMemPoolEntry &other) {
 
     this->nTime  = other.nTime;
     this->height = other.height;
+
+    this->nSequence = other.nSequence;
+    this->spExecLog = other.spExecLog;
 }
 
 CTxMemPool::CTxMemPool() {
@@ -42,6 +50,8 @@ CTxMemPool::CTxMemPool() {
     // accepting transactions becomes O(N^2) where N is the number
     // of transactions in the pool
     fSanityCheck         = false;
+    fUnknownWrites       = false;
+    nNextSequence        = 0;
 }
 
 void CTxMemPool::Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &removed, bool fRecursive) {
@@ -50,25 +60,106 @@ void CTxMemPool::Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &remov
     uint256 txid = pBaseTx->GetHash();
     if (memPoolTxs.count(txid)) {
         removed.push_front(std::shared_ptr<CBaseTx>(memPoolTxs[txid].GetTransaction()));
+        AddRemovedWrites(memPoolTxs[txid]);
+        RemoveFromPriorityIndex(txid);
         memPoolTxs.erase(txid);
         EraseTransaction(txid);
     }
 }
 
+void CTxMemPool::RemoveConfirmed(const uint256 &txid) {
+    LOCK(cs);
+    auto it = memPoolTxs.find(txid);
+    if (it == memPoolTxs.end())
+        return;
+
+    AddRemovedWrites(it->second);
+    memPoolTxs.erase(it);
+    RemoveFromPriorityIndex(txid);
+}
+
+void CTxMemPool::AddRemovedWrites(const CTxMemPoolEntry &entry) {
+    // the values the tx wrote to the mempool cache are gone with it
+    if (entry.GetExecLog())
+        changedKeys.MergeWrites(entry.GetExecLog()->accessSet);
+    else
+        fUnknownWrites = true;
+}
+
 bool CTxMemPool::AddUnchecked(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state) {
     // Add to memory pool without checking anything.
     // Used by main.cpp AcceptToMemoryPool(), which DOES
     // all the appropriate checks.
     LOCK(cs);
     {
-        if (!CheckTxInMemPool(txid, entry, state))
+        auto spExecLog = std::make_shared<CTxMemPoolExecLog>();
+        if (!CheckTxInMemPool(txid, entry, state, true, spExecLog.get()))
             return false;
 
-        memPoolTxs.insert(make_pair(txid, entry));
+        InsertUnchecked(txid, entry, spExecLog);
     }
     return true;
 }
 
+void CTxMemPool::InsertUnchecked(const uint256 &txid, const CTxMemPoolEntry &entry,
+                                 const std::shared_ptr<CTxMemPoolExecLog> &spExecLog) {
+    LOCK(cs);
+    auto ret = memPoolTxs.insert(make_pair(txid, entry));
+    if (ret.second) {
+        ret.first->second.SetExecLog(nNextSequence++, spExecLog);
+        AddToPriorityIndex(txid, ret.first->second);
+    }
+}
+
+static inline bool IsFuelRateDependent(const CBaseTx &tx) {
+    return tx.nRunStep != 0 || tx.nTxType == LCONTRACT_DEPLOY_TX || tx.nTxType == WASM_CONTRACT_TX;
+}
+
+void CTxMemPool::AddToPriorityIndex(const uint256 &txid, const CTxMemPoolEntry &entry) {
+    const auto &spTx = entry.GetTransaction();
+    if (spTx->IsBlockRewardTx())
+        return;
+
+    if (IsFuelRateDependent(*spTx)) {
+        fuelRateTxs[txid] = spTx;
+        return;
+    }
+
+    // no fuel, the fee per KB never changes
+    double feePerKb = double(std::get<1>(entry.GetFees())) / entry.GetTxSize() * 1000.0;
+    auto ret = priorityIndex.emplace(entry.GetPriority(), feePerKb, spTx);
+    if (ret.second)
+        priorityIndexIts[txid] = ret.first;
+}
+
+void CTxMemPool::RemoveFromPriorityIndex(const uint256 &txid) {
+    auto it = priorityIndexIts.find(txid);
+    if (it != priorityIndexIts.end()) {
+        priorityIndex.erase(it->second);
+        priorityIndexIts.erase(it);
+        return;
+    }
+
+    fuelRateTxs.erase(txid);
+}
+
+void CTxMemPool::GetPriorityTxs(int32_t height, uint32_t fuelRate, vector<TxPriority> &txPriorities) {
+    LOCK(cs);
+
+    set<TxPriority> fuelRatePriorities;
+    for (const auto &item : fuelRateTxs) {
+        const CTxMemPoolEntry &entry = memPoolTxs.find(item.first)->second;
+        uint64_t fee    = std::get<1>(entry.GetFees());
+        double feePerKb = double(fee - item.second->GetFuel(height, fuelRate)) / entry.GetTxSize() * 1000.0;
+        fuelRatePriorities.emplace(entry.GetPriority(), feePerKb, item.second);
+    }
+
+    txPriorities.clear();
+    txPriorities.reserve(priorityIndex.size() + fuelRatePriorities.size());
+    std::merge(priorityIndex.begin(), priorityIndex.end(), fuelRatePriorities.begin(), fuelRatePriorities.end(),
+               std::back_inserter(txPriorities));
+}
+
 void CTxMemPool::QueryHash(vector<uint256> &txids) {
     LOCK(cs);
 
@@ -80,7 +171,7 @@ void CTxMemPool::QueryHash(vector<uint256> &txids) {
 }
 
 bool CTxMemPool::CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &memPoolEntry, CValidationState &state,
-                                  bool bExecute) {
+                                  bool bExecute, CTxMemPoolExecLog *pExecLog) {
     // is it within valid height
     static int validHeight = SysCfg().GetTxCacheHeight();
     if (!memPoolEntry.GetTransaction()->IsValidHeight(chainActive.Height(), validHeight))
@@ -92,22 +183,33 @@ bool CTxMemPool::CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &me
         return state.Invalid(ERRORMSG("CheckTxInMemPool() : txid: %s has been confirmed", txid.GetHex()), REJECT_INVALID,
                              "tx-duplicate-confirmed");
 
-    auto spCW = std::make_shared<CCacheWrapper>(cw.get());
-
     if (bExecute) {
+        // the tx is executed on cw directly and rolled back if it fails
+        CCacheSavepoint savepoint(*cw);
+        if (pExecLog != nullptr) {
+            savepoint.GetDbOpLogMap().SetAccessSet(&pExecLog->accessSet);
+            savepoint.GetDbOpLogMap().SetRedoLogMap(&pExecLog->redoLogMap);
+        }
+
         CBlockIndex *pTip =  chainActive.Tip();
         uint32_t fuelRate  = GetElementForBurn(pTip);
         uint32_t blockTime = pTip->GetBlockTime();
         uint32_t prevBlockTime = pTip->pprev != nullptr ? pTip->pprev->GetBlockTime() : pTip->GetBlockTime();
-        CTxExecuteContext context(chainActive.Height(), 0, fuelRate, blockTime, prevBlockTime, spCW.get(), &state, transaction_status_type::validating);
+        CTxExecuteContext context(chainActive.Height(), 0, fuelRate, blockTime, prevBlockTime, cw.get(), &state, transaction_status_type::validating);
         if (!memPoolEntry.GetTransaction()->ExecuteTx(context)) {
+            savepoint.Rollback();
             pCdMan->pLogCache->SetExecuteFail(chainActive.Height(), memPoolEntry.GetTransaction()->GetHash(),
                                               state.GetRejectCode(), state.GetRejectReason());
             return false;
         }
-    }
 
-    spCW->Flush();
+        if (pExecLog != nullptr) {
+            // the logs are applied from the last one, the last value written to a key must come first
+            for (auto &item : pExecLog->redoLogMap.GetMap())
+                std::reverse(item.second.begin(), item.second.end());
+            pExecLog->height = context.height;
+        }
+    }
 
     return true;
 }
@@ -116,26 +218,119 @@ void CTxMemPool::SetMemPoolCache() {
     cw.reset(new CCacheWrapper(pCdMan));
 }
 
+void CTxMemPool::AddBlockWrites(const CDBAccessSet &writes) {
+    LOCK(cs);
+    changedKeys.MergeWrites(writes);
+}
+
 void CTxMemPool::ReScanMemPoolTx() {
+    int64_t nStart = GetTimeMicros();
     cw.reset(new CCacheWrapper(pCdMan));
 
     LOCK(cs);
+    // the txs are executed on the new cache in the order they were executed on the old one
+    vector<map<uint256, CTxMemPoolEntry>::iterator> iterTxs;
+    iterTxs.reserve(memPoolTxs.size());
+    for (auto iterTx = memPoolTxs.begin(); iterTx != memPoolTxs.end(); ++iterTx)
+        iterTxs.push_back(iterTx);
+
+    std::sort(iterTxs.begin(), iterTxs.end(), [](const map<uint256, CTxMemPoolEntry>::iterator &a,
+                                                 const map<uint256, CTxMemPoolEntry>::iterator &b) {
+        return a->second.GetSequence() < b->second.GetSequence();
+    });
+
+    // the keys whose values may differ from the ones read by the txs on the old cache: the keys changed by
+    // the blocks, and the keys written by the txs removed or executed again, before or after the change.
+    // The txs after a tx of unknown writes are all executed again.
+    CDBAccessSet changed;
+    changed.MergeWrites(changedKeys);
+    changedKeys.Clear();
+    bool fUnknown  = fUnknownWrites;
+    fUnknownWrites = false;
+
+    uint32_t carried = 0, reexecuted = 0, removed = 0;
+    uint64_t sequence = 0;
     CValidationState state;
-    for (map<uint256, CTxMemPoolEntry>::iterator iterTx = memPoolTxs.begin(); iterTx != memPoolTxs.end();) {
-        if (!CheckTxInMemPool(iterTx->first, iterTx->second, state, true)) {
-            uint256 txid = iterTx->first;
-            iterTx       = memPoolTxs.erase(iterTx++);
+    for (auto iterTx : iterTxs) {
+        const uint256 txid                          = iterTx->first;
+        CTxMemPoolEntry &entry                      = iterTx->second;
+        std::shared_ptr<CTxMemPoolExecLog> spExecLog = entry.GetExecLog();
+        bool valid;
+        if (spExecLog && !fUnknown && CanCarryOver(*entry.GetTransaction(), *spExecLog, chainActive.Height()) &&
+            !spExecLog->accessSet.HasReadConflict(changed)) {
+            valid = CheckTxInMemPool(txid, entry, state, false);
+            if (valid) {
+                cw->ApplyOpLogs(spExecLog->redoLogMap);
+                carried++;
+            } else {
+                changed.MergeWrites(spExecLog->accessSet);
+            }
+        } else {
+            if (spExecLog)
+                changed.MergeWrites(spExecLog->accessSet);
+            else
+                fUnknown = true;
+
+            spExecLog = std::make_shared<CTxMemPoolExecLog>();
+            valid     = CheckTxInMemPool(txid, entry, state, true, spExecLog.get());
+            if (valid)
+                changed.MergeWrites(spExecLog->accessSet);
+            reexecuted++;
+        }
+
+        if (!valid) {
+            RemoveFromPriorityIndex(txid);
+            memPoolTxs.erase(iterTx);
             EraseTransaction(txid);
+            removed++;
             continue;
         }
-        ++iterTx;
+        entry.SetExecLog(sequence++, spExecLog);
     }
+    nNextSequence = sequence;
+
+    int64_t nTime = GetTimeMicros() - nStart;
+    revalidateStats.count++;
+    revalidateStats.total_micros += nTime;
+    revalidateStats.last_micros     = nTime;
+    revalidateStats.last_carried    = carried;
+    revalidateStats.last_reexecuted = reexecuted;
+    revalidateStats.last_removed    = removed;
+    LogPrint(BCLog::DEBUG, "ReScanMemPoolTx() : %.2fms, carried=%u, re-executed=%u, removed=%u\n", nTime * 0.001,
+             carried, reexecuted, removed);
+}
+
+/**
+ * Only the coin transfers are carried over: their execution depends on the chain state through the keys
+ * they read, and on the height only by the regid generated for a sender without one (the height and index
+ * of the tx) and by the fork version. The DEX orders record their height in the order (tx_cord), the
+ * other txs may burn fuel at the fuel rate of the tip or check the height, they are always executed again.
+ */
+bool CTxMemPool::CanCarryOver(const CBaseTx &tx, const CTxMemPoolExecLog &execLog, int32_t height) {
+    if (tx.nTxType != BCOIN_TRANSFER_TX && tx.nTxType != UCOIN_TRANSFER_TX)
+        return false;
+
+    // the sender's new regid is written to the regid index
+    if (execLog.redoLogMap.GetDbOpLogsPtr(dbk::REGID_KEYID) != nullptr)
+        return false;
+
+    return GetFeatureForkVersion(execLog.height) == GetFeatureForkVersion(height);
+}
+
+CTxMemPoolRevalidateStats CTxMemPool::GetRevalidateStats() const {
+    LOCK(cs);
+    return revalidateStats;
 }
 
 void CTxMemPool::Clear() {
     LOCK(cs);
 
     memPoolTxs.clear();
+    priorityIndex.clear();
+    priorityIndexIts.clear();
+    fuelRateTxs.clear();
+    changedKeys.Clear();
+    fUnknownWrites = false;
     cw.reset(new CCacheWrapper(pCdMan));
 }
 
@@ -10,10 +10,14 @@
 #include "entities/account.h"
 #include "persistence/cachewrapper.h"
 #include "sync.h"
+#include "tx/tx.h"
 
+#include <cmath>
 #include <list>
 #include <map>
 #include <memory>
+#include <set>
+#include <vector>
 
 using namespace std;
 
@@ -21,6 +25,47 @@ class CValidationState;
 class CBaseTx;
 class uint256;
 
+struct TxPriority {
+    double priority;
+    double feePerKb;
+    std::shared_ptr<CBaseTx> baseTx;
+
+    TxPriority(const double priorityIn, const double feePerKbIn, const std::shared_ptr<CBaseTx> &baseTxIn)
+        : priority(priorityIn), feePerKb(feePerKbIn), baseTx(baseTxIn) {}
+
+    bool operator<(const TxPriority &other) const {
+        if (fabs(this->priority - other.priority) <= 1000) {
+            if (fabs(this->feePerKb < other.feePerKb) <= 1e-8) {
+                return this->baseTx->GetHash() < other.baseTx->GetHash();
+            } else {
+                return this->feePerKb < other.feePerKb;
+            }
+        } else {
+            return this->priority < other.priority;
+        }
+    }
+};
+
+/*
+ * The keys read and written by the execution of a tx on the mempool cache, and the new values it wrote.
+ * The tx is carried over the blocks which changed none of the keys it read by writing the values again,
+ * if its values do not depend on the height either, see CTxMemPool::CanCarryOver().
+ */
+struct CTxMemPoolExecLog {
+    CDBAccessSet accessSet;
+    CDBOpLogMap redoLogMap;
+    int32_t height = 0;     // the height the tx was executed at
+};
+
+struct CTxMemPoolRevalidateStats {
+    uint64_t count        = 0;    // the revalidations of the pool after the chain tip changed
+    uint64_t total_micros = 0;
+    uint64_t last_micros  = 0;
+    uint32_t last_carried    = 0;    // the txs of the last revalidation carried over without execution
+    uint32_t last_reexecuted = 0;    // the txs executed again
+    uint32_t last_removed    = 0;    // the txs found invalid and removed
+};
+
 /*
  * CTxMemPool stores these:
  */
@@ -34,6 +79,9 @@ private:
     int64_t nTime;     // Local time when entering the mempool
     uint32_t height;  // Chain height when entering the mempool
 
+    uint64_t nSequence;                             // the order of execution on the mempool cache
+    std::shared_ptr<CTxMemPoolExecLog> spExecLog;    // null if the tx is always executed again
+
 public:
     CTxMemPoolEntry(CBaseTx *ptx, int64_t time, uint32_t height);
     CTxMemPoolEntry();
@@ -47,6 +95,13 @@ public:
 
     inline int64_t GetTime() const { return nTime; }
     inline uint32_t GetHeight() const { return height; }
+
+    inline uint64_t GetSequence() const { return nSequence; }
+    inline const std::shared_ptr<CTxMemPoolExecLog> &GetExecLog() const { return spExecLog; }
+    void SetExecLog(uint64_t sequence, const std::shared_ptr<CTxMemPoolExecLog> &spExecLogIn) {
+        nSequence = sequence;
+        spExecLog = spExecLogIn;
+    }
 };
 
 /*
@@ -71,20 +126,52 @@ public:
 public:
     void SetSanityCheck(bool fSanityCheckIn) { fSanityCheck = fSanityCheckIn; }
     bool AddUnchecked(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state);
+    // add the entry without executing the tx, the entry must have passed CheckTxInMemPool()
+    void InsertUnchecked(const uint256 &txid, const CTxMemPoolEntry &entry,
+                         const std::shared_ptr<CTxMemPoolExecLog> &spExecLog = nullptr);
     void Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &removed, bool fRecursive = false);
+    // remove the tx confirmed in a block
+    void RemoveConfirmed(const uint256 &txid);
+    // the txs to pack into the block at the height, sorted by priority and fee per KB from low to high
+    void GetPriorityTxs(int32_t height, uint32_t fuelRate, vector<TxPriority> &txPriorities);
     void QueryHash(vector<uint256> &txids);
     bool CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state,
-                          bool bExecute = true);
+                          bool bExecute = true, CTxMemPoolExecLog *pExecLog = nullptr);
     void SetMemPoolCache();
+    // add the keys flushed to the global caches by a connected or disconnected block
+    void AddBlockWrites(const CDBAccessSet &writes);
+    // revalidate the txs on a new cache after the chain tip changed, only the txs which read the keys
+    // changed by the blocks or by the txs executed again before them are executed again
     void ReScanMemPoolTx();
+    // true if the redo logs of the tx executed at execLog.height are the values its execution at height writes
+    static bool CanCarryOver(const CBaseTx &tx, const CTxMemPoolExecLog &execLog, int32_t height);
+    CTxMemPoolRevalidateStats GetRevalidateStats() const;
     void Clear();
 
     uint64_t Size();
     bool Exists(const uint256 txid);
     std::shared_ptr<CBaseTx> Lookup(const uint256 txid) const;
 
+private:
+    void AddToPriorityIndex(const uint256 &txid, const CTxMemPoolEntry &entry);
+    void RemoveFromPriorityIndex(const uint256 &txid);
+    void AddRemovedWrites(const CTxMemPoolEntry &entry);
+
 private:
     bool fSanityCheck; // Normally false, true if -checkmempool or -regtest
+
+    // The priority index of the txs, kept by AddUnchecked() and the removals so that the miner does not
+    // rescan the pool. The fuel of the txs run by the VM changes with the fuel rate of each block, their
+    // fee per KB is computed in GetPriorityTxs().
+    set<TxPriority> priorityIndex;
+    map<uint256, set<TxPriority>::iterator> priorityIndexIts;
+    map<uint256, std::shared_ptr<CBaseTx>> fuelRateTxs;
+
+    // the keys changed since the last revalidation, by the blocks and by the removal of the txs
+    CDBAccessSet changedKeys;
+    bool fUnknownWrites;    // a tx executed without an exec log was removed
+    uint64_t nNextSequence;
+    CTxMemPoolRevalidateStats revalidateStats;
 };
 
 
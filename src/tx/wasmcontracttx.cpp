@@ -85,12 +85,12 @@ void CWasmContractTx::validate_contracts(CTxExecuteContext& context) {
                       "contract '%s' does not exist",
                       contract_name.to_string())
 
-        CUniversalContract contract_store;
+        std::shared_ptr<const CUniversalContract> contract_store;
         CHAIN_ASSERT( database.contractCache.GetContract(contract.regid, contract_store),
                       wasm_chain::account_access_exception,
                       "cannot get contract with nickid '%s'",
                       contract_name.to_string())
-        CHAIN_ASSERT( contract_store.code.size() > 0 && contract_store.abi.size() > 0,
+        CHAIN_ASSERT( contract_store->code.size() > 0 && contract_store->abi.size() > 0,
                       wasm_chain::account_access_exception,
                       "contract '%s' abi or code  does not exist",
                       contract_name.to_string())
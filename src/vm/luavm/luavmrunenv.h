@@ -36,7 +36,7 @@ public:
     uint64_t transfer_amount       = 0;  // amount of tx user transfer to contract account
     CAccount* p_tx_user_account    = nullptr;
     CAccount* p_app_account        = nullptr;
-    CUniversalContract* p_contract = nullptr;
+    const CUniversalContract* p_contract = nullptr;
     string* p_arguments            = nullptr;
 };
 
@@ -103,15 +103,22 @@ namespace wasm {
     std::vector <uint8_t> wasm_context::get_code(const uint64_t& account) {
 
         vector <uint8_t>   code;
-        CUniversalContract contract;
+        std::shared_ptr<const CUniversalContract> contract;
         CAccount contract_account ;
         if(database.accountCache.GetAccount(CNickID(account), contract_account)
             && database.contractCache.GetContract(contract_account.regid, contract)) {
-            code = vector <uint8_t>(contract.code.begin(), contract.code.end());
+            code = vector <uint8_t>(contract->code.begin(), contract->code.end());
         }
         return code;
     }
 
+    bool wasm_context::get_code_hash(const uint64_t& account, uint256& code_hash) {
+
+        CAccount contract_account;
+        return database.accountCache.GetAccount(CNickID(account), contract_account)
+            && database.contractCache.GetContractCodeHash(contract_account.regid, code_hash);
+    }
+
     // std::string wasm_context::get_abi(uint64_t account) {
     //     CUniversalContract contract;
     //     CAccount contract_account ;
@@ -174,9 +181,9 @@ namespace wasm {
                 (*native)(*this);
             } else {
 
-                vector <uint8_t> code = get_code(_receiver);
-                if (code.size() > 0) {
-                    wasmif.execute(code, this);
+                uint256 code_hash;
+                if (get_code_hash(_receiver, code_hash)) {
+                    wasmif.execute(code_hash, [&]() { return get_code(_receiver); }, this);
                 }
             }
         }  catch (wasm_chain::exception &e) {
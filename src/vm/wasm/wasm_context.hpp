@@ -43,6 +43,7 @@ namespace wasm {
         void                  execute_one(inline_transaction_trace &trace);
         bool                  has_permission_from_inline_transaction(const permission &p);
         std::vector <uint8_t> get_code(const uint64_t& account);
+        bool                  get_code_hash(const uint64_t& account, uint256& code_hash);
 // Console methods:
     public:
         void                      reset_console();
@@ -37,9 +37,9 @@ namespace wasm {
     using backend_validate_t = backend<wasm::wasm_context_interface, vm::interpreter>;
     using rhf_t              = eosio::vm::registered_host_functions<wasm_context_interface>;
 
-    std::optional<std::map <code_version_t, std::shared_ptr<wasm_instantiated_module_interface>>>& get_wasm_instantiation_cache(){
-        static std::optional<std::map <code_version_t, std::shared_ptr<wasm_instantiated_module_interface>>> wasm_instantiation_cache;
-        return wasm_instantiation_cache;
+    wasm_instantiation_cache& get_wasm_instantiation_cache(){
+        static wasm_instantiation_cache instantiation_cache;
+        return instantiation_cache;
     }
 
     std::shared_ptr <wasm_runtime_interface>& get_runtime_interface(){
@@ -55,30 +55,34 @@ namespace wasm {
         get_runtime_interface()->immediately_exit_currently_running_module();
     }
 
-    std::shared_ptr <wasm_instantiated_module_interface> get_instantiated_backend(const vector <uint8_t> &code) {
+    std::shared_ptr <wasm_instantiated_module_interface> get_instantiated_backend(const code_version_t &code_hash,
+                                                                                 const vector <uint8_t> &code) {
 
-        try {
-            if(!get_wasm_instantiation_cache().has_value()){
-                 get_wasm_instantiation_cache() = std::map <code_version_t, std::shared_ptr<wasm_instantiated_module_interface>>{};
-            }
-
-            auto code_id = Hash(code.begin(), code.end());
-            auto it = get_wasm_instantiation_cache()->find(code_id);
-            if (it == get_wasm_instantiation_cache()->end()) {
-                get_wasm_instantiation_cache().value()[code_id] = get_runtime_interface()->instantiate_module((const char*)code.data(), code.size());
-                return get_wasm_instantiation_cache().value()[code_id];
-            }
-            return it->second;
-        } catch (...) {
-            throw;
-        }
+        auto pInstantiated_module = get_runtime_interface()->instantiate_module((const char*)code.data(), code.size());
+        get_wasm_instantiation_cache().add(code_hash, pInstantiated_module);
+        return pInstantiated_module;
 
     }
 
     void wasm_interface::execute(const vector <uint8_t> &code, wasm_context_interface *pWasmContext) {
 
+        execute(Hash(code.begin(), code.end()), [&]() { return code; }, pWasmContext);
+
+    }
+
+    void wasm_interface::execute(const uint256 &code_hash, const std::function<vector <uint8_t>()> &get_code,
+                                 wasm_context_interface *pWasmContext) {
+
         pWasmContext->pause_billing_timer();
-        auto pInstantiated_module = get_instantiated_backend(code);
+        auto pInstantiated_module = get_wasm_instantiation_cache().get(code_hash);
+        if (!pInstantiated_module) {
+            auto code = get_code();
+            if (code.size() == 0) {
+                pWasmContext->resume_billing_timer();
+                return;
+            }
+            pInstantiated_module = get_instantiated_backend(code_hash, code);
+        }
         pWasmContext->resume_billing_timer();
 
         //system_clock::time_point start = system_clock::now();
@@ -89,6 +93,20 @@ namespace wasm {
 
     }
 
+    bool wasm_interface::instantiate(const uint256 &code_hash, const vector <uint8_t> &code) {
+
+        if (get_wasm_instantiation_cache().contains(code_hash))
+            return true;
+
+        try {
+            get_instantiated_backend(code_hash, code);
+            return true;
+        } catch (...) {
+            return false;
+        }
+
+    }
+
     void wasm_interface::validate(const vector <uint8_t> &code) {
 
         try {
@@ -989,5 +1007,13 @@ namespace wasm {
 
 extern  void wasm_code_cache_free() {
      //free heap before shut down
-     wasm::get_wasm_instantiation_cache().reset();
+     wasm::get_wasm_instantiation_cache().clear();
+}
+
+extern void wasm_code_cache_set_max_size(uint64_t max_bytes) {
+     wasm::get_wasm_instantiation_cache().set_max_size(max_bytes);
+}
+
+extern void wasm_code_cache_get_stats(wasm::wasm_module_cache_stats &stats) {
+     wasm::get_wasm_instantiation_cache().get_stats(stats);
 }
@@ -1,11 +1,12 @@
 #pragma once
 
+#include <functional>
 #include <vector>
 #include <map>
+#include "commons/uint256.h"
 #include "wasm/wasm_context_interface.hpp"
 #include "wasm/wasm_runtime.hpp"
-
-void wasm_code_cache_free();
+#include "wasm/wasm_module_cache.hpp"
 
 namespace wasm {
 
@@ -24,6 +25,11 @@ namespace wasm {
     public:
         void initialize(vm_type vm);
         void execute(const vector <uint8_t>& code, wasm_context_interface *pWasmContext);
+        // get_code is only called when the module of code_hash is not instantiated yet
+        void execute(const uint256& code_hash, const std::function<vector <uint8_t>()>& get_code,
+                     wasm_context_interface *pWasmContext);
+        // instantiate the code ahead of its first call, returns false if the code does not instantiate
+        bool instantiate(const uint256& code_hash, const vector <uint8_t>& code);
         void validate(const vector <uint8_t>& code);
         void exit();
 
@@ -0,0 +1,70 @@
+#include "wasm/wasm_module_cache.hpp"
+#include "wasm/wasm_runtime.hpp"
+
+namespace wasm {
+
+    std::shared_ptr<wasm_instantiated_module_interface> wasm_instantiation_cache::get(const code_version_t& code_hash) {
+        std::unique_lock<std::mutex> lock(mtx);
+        auto it = entries.find(code_hash);
+        if (it == entries.end()) {
+            ++misses;
+            return nullptr;
+        }
+
+        lru_list.splice(lru_list.begin(), lru_list, it->second);
+        ++hits;
+        return it->second->module;
+    }
+
+    bool wasm_instantiation_cache::contains(const code_version_t& code_hash) {
+        std::unique_lock<std::mutex> lock(mtx);
+        return entries.count(code_hash) > 0;
+    }
+
+    void wasm_instantiation_cache::add(const code_version_t& code_hash,
+                                       const std::shared_ptr<wasm_instantiated_module_interface>& module) {
+        size_t size = module->get_memory_size();
+
+        std::unique_lock<std::mutex> lock(mtx);
+        if (entries.count(code_hash))
+            return;
+
+        lru_list.push_front({code_hash, module, size});
+        entries[code_hash] = lru_list.begin();
+        bytes += size;
+        evict();
+    }
+
+    void wasm_instantiation_cache::set_max_size(uint64_t max_bytes_in) {
+        std::unique_lock<std::mutex> lock(mtx);
+        max_bytes = max_bytes_in;
+        evict();
+    }
+
+    void wasm_instantiation_cache::get_stats(wasm_module_cache_stats& stats) {
+        std::unique_lock<std::mutex> lock(mtx);
+        stats.entries   = entries.size();
+        stats.bytes     = bytes;
+        stats.max_bytes = max_bytes;
+        stats.hits      = hits;
+        stats.misses    = misses;
+        stats.evictions = evictions;
+    }
+
+    void wasm_instantiation_cache::clear() {
+        std::unique_lock<std::mutex> lock(mtx);
+        lru_list.clear();
+        entries.clear();
+        bytes = 0;
+    }
+
+    // an evicted module still running stays alive until its call drops it
+    void wasm_instantiation_cache::evict() {
+        while (bytes > max_bytes && !lru_list.empty()) {
+            bytes -= lru_list.back().size;
+            entries.erase(lru_list.back().code_hash);
+            lru_list.pop_back();
+            ++evictions;
+        }
+    }
+}
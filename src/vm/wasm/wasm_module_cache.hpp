@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "commons/uint256.h"
+
+namespace wasm {
+
+    class wasm_instantiated_module_interface;
+
+    /** -wasmmodulecache default, in megabytes */
+    static const int64_t default_wasm_module_cache_size = 64;
+
+    struct wasm_module_cache_stats {
+        uint64_t entries   = 0;
+        uint64_t bytes     = 0;
+        uint64_t max_bytes = 0;
+        uint64_t hits      = 0;  //!< calls running an instantiated module
+        uint64_t misses    = 0;  //!< calls reading and instantiating the code
+        uint64_t evictions = 0;
+    };
+
+    /**
+     * LRU of the instantiated modules keyed by code hash, bounded by the memory the modules hold
+     */
+    class wasm_instantiation_cache {
+    public:
+        using code_version_t = uint256;
+
+        // the module of a contract call, counted as a hit or a miss
+        std::shared_ptr<wasm_instantiated_module_interface> get(const code_version_t& code_hash);
+        // true if the module is cached, neither counted nor made the most recently used
+        bool contains(const code_version_t& code_hash);
+        void add(const code_version_t& code_hash, const std::shared_ptr<wasm_instantiated_module_interface>& module);
+
+        void set_max_size(uint64_t max_bytes_in);
+        void get_stats(wasm_module_cache_stats& stats);
+        void clear();
+
+    private:
+        struct entry_t {
+            code_version_t                                       code_hash;
+            std::shared_ptr<wasm_instantiated_module_interface>  module;
+            size_t                                               size;
+        };
+
+        std::mutex                                              mtx;
+        std::list<entry_t>                                      lru_list;  //!< most recently used first
+        std::map<code_version_t, std::list<entry_t>::iterator>  entries;
+        uint64_t bytes     = 0;
+        uint64_t max_bytes = (uint64_t)default_wasm_module_cache_size << 20;
+        uint64_t hits      = 0;
+        uint64_t misses    = 0;
+        uint64_t evictions = 0;
+
+        void evict();
+    };
+}
+
+void wasm_code_cache_free();
+void wasm_code_cache_set_max_size(uint64_t max_bytes);
+void wasm_code_cache_get_stats(wasm::wasm_module_cache_stats &stats);
@@ -6,6 +6,7 @@
 #include "wasm/datastream.hpp"
 #include "wasm/types/asset.hpp"
 #include "persistence/cachewrapper.h"
+#include "crypto/hash.h"
 #include "wasm/wasm_log.hpp"
 #include "wasm/wasm_native_contract_abi.hpp"
 #include "wasm/abi_def.hpp"
@@ -57,6 +58,14 @@ namespace wasm {
                       wasm_chain::account_access_exception,
                       "save account '%s' error",
                       wasm::name(contract_name).to_string())
+
+        // instantiate the code now so its first call runs from the cache, the code is not rejected here
+        // since deploying code which does not instantiate has always been valid
+        context.pause_billing_timer();
+        if (!context.wasmif.instantiate(Hash(code.begin(), code.end()), vector<uint8_t>(code.begin(), code.end())))
+            LogPrint(BCLog::WASM, "wasmio_native_setcode, contract '%s' code does not instantiate\n",
+                     wasm::name(contract_name).to_string());
+        context.resume_billing_timer();
     }
     
     void wasmio_bank_native_transfer(wasm_context &context) {
@@ -62,6 +62,11 @@ namespace wasm {
             _runtime->_bkend = nullptr;
         }
 
+        size_t get_memory_size() override {
+            auto &allocator = _instantiated_module->get_module().allocator;
+            return allocator._size + allocator._code_size;
+        }
+
     private:
         wasm_vm_runtime <Impl> *    _runtime;
         std::shared_ptr <backend_t> _instantiated_module;
@@ -8,6 +8,8 @@ namespace wasm {
     class wasm_instantiated_module_interface {
        public:
           virtual void apply(wasm_context_interface* context) = 0;
+          // memory held by the parsed module and its compiled code
+          virtual size_t get_memory_size() = 0;
           virtual ~wasm_instantiated_module_interface();
     };
 
@@ -110,66 +110,147 @@ void CWallet::SetBestChain(const CBlockLocator &loc) {
     bestBlock = loc;
 }
 
+void CWalletRegIdFilter::AddKeys(const set<CKeyID> &keyIds) {
+    LOCK(cs_filter);
+    pendingKeyIds.insert(keyIds.begin(), keyIds.end());
+}
+
+void CWalletRegIdFilter::EraseKey(const CKeyID &keyId) {
+    LOCK(cs_filter);
+    pendingKeyIds.erase(keyId);
+    auto it = keyRegIds.find(keyId);
+    if (it != keyRegIds.end()) {
+        regIds.erase(it->second);
+        keyRegIds.erase(it);
+    }
+}
+
+void CWalletRegIdFilter::Clear() {
+    LOCK(cs_filter);
+    regIds.clear();
+    keyRegIds.clear();
+    pendingKeyIds.clear();
+}
+
+bool CWalletRegIdFilter::HaveRegId(const CRegID &regId) const {
+    LOCK(cs_filter);
+    return regIds.count(regId) > 0;
+}
+
+void CWalletRegIdFilter::Update(const CAccountDBCache &accountCache, const set<CKeyID> &keyIds) {
+    LOCK(cs_filter);
+    auto resolve = [&](const CKeyID &keyId) {
+        CRegID regId;
+        accountCache.GetRegId(keyId, regId);
+
+        CRegID &keyRegId = keyRegIds[keyId];
+        if (!keyRegId.IsEmpty())
+            regIds.erase(keyRegId);
+        keyRegId = regId;
+        if (!regId.IsEmpty())
+            regIds.insert(regId);
+    };
+
+    for (const auto &keyId : pendingKeyIds)
+        resolve(keyId);
+    pendingKeyIds.clear();
+
+    for (const auto &keyId : keyIds) {
+        if (keyRegIds.count(keyId))
+            resolve(keyId);
+    }
+}
+
 void CWallet::SyncTransaction(const uint256 &hash, CBaseTx *pTx, const CBlock *pBlock) {
     assert(pTx != nullptr || pBlock != nullptr);
 
     if (hash.IsNull() && pTx == nullptr) {  // this is block Sync
-        uint256 blockhash         = pBlock->GetHash();
-        auto GenesisBlockProgress = [&]() {};
+        uint256 blockhash = pBlock->GetHash();
+        CWalletSyncBlock syncBlock;
+        {
+            LOCK(cs_main);
+            if (SysCfg().GetGenesisBlockHash() == blockhash)
+                return;
 
-        auto ConnectBlockProgress = [&]() {
-            CAccountTx netTx(this, blockhash, pBlock->GetHeight());
-            for (const auto &sptx : pBlock->vptx) {
-                uint256 txid = sptx->GetHash();
-                // confirm the tx is mine
-                if (IsMine(sptx.get())) {
-                    netTx.AddTx(txid, sptx.get());
-                }
-                if (unconfirmedTx.count(txid) > 0) {
-                    CWalletDB(strWalletFile).EraseUnconfirmedTx(txid);
-                    unconfirmedTx.erase(txid);
-                }
-            }
-            if (netTx.GetTxSize() > 0) {          // write to disk
-                mapInBlockTx[blockhash] = netTx;  // add to map
-                netTx.WriteToDisk();
-            }
-        };
+            // Connect or disconnect, decided at the chain state of the block
+            syncBlock.fConnect = mapBlockIndex.count(blockhash) && chainActive.Contains(mapBlockIndex[blockhash]);
 
-        auto DisConnectBlockProgress = [&]() {
+            // the wallet keys used by their pubkey or keyid in the block may have been registered by it
+            set<CKeyID> keyIds;
+            vector<CUserID> uids;
             for (const auto &sptx : pBlock->vptx) {
-                if (sptx->IsBlockRewardTx()) {
-                    continue;
-                }
-                if (IsMine(sptx.get())) {
-                    unconfirmedTx[sptx.get()->GetHash()] = sptx.get()->GetNewInstance();
-                    CWalletDB(strWalletFile).WriteUnconfirmedTx(sptx.get()->GetHash(), unconfirmedTx[sptx.get()->GetHash()]);
+                uids.clear();
+                sptx->GetInvolvedUserIds(uids);
+                for (const auto &uid : uids) {
+                    CKeyID keyId;
+                    if (uid.is<CKeyID>())
+                        keyId = uid.get<CKeyID>();
+                    else if (uid.is<CPubKey>())
+                        keyId = uid.get<CPubKey>().GetKeyId();
+                    else
+                        continue;
+                    if (HaveKey(keyId))
+                        keyIds.insert(keyId);
                 }
             }
-            if (mapInBlockTx.count(blockhash)) {
-                CWalletDB(strWalletFile).EraseBlockTx(blockhash);
-                mapInBlockTx.erase(blockhash);
-            }
-        };
+            regIdFilter.Update(*pCdMan->pAccountCache, keyIds);
 
-        auto IsConnect = [&]() {  // Connect or disconnect
-            return mapBlockIndex.count(blockhash) && chainActive.Contains(mapBlockIndex[blockhash]);
-        };
+            syncBlock.spBlock = std::make_shared<const CBlock>(*pBlock);
+            syncQueue.Push(syncBlock);
+        }
 
-        {
-            LOCK2(cs_main, cs_wallet);
-            // GenesisBlock progress
-            if (SysCfg().GetGenesisBlockHash() == blockhash) {
-                GenesisBlockProgress();
-            } else if (IsConnect()) {
-                // connect block
-                ConnectBlockProgress();
-            } else {
-                // disconnect block
-                DisConnectBlockProgress();
+        if (!fSyncInBackground)
+            SyncQueuedBlocks();
+    }
+}
+
+void CWallet::SyncQueuedBlocks() {
+    LOCK(cs_walletSync);
+    CWalletSyncBlock syncBlock;
+    while (syncQueue.Pop(&syncBlock, std::chrono::milliseconds(0)))
+        SyncBlock(syncBlock);
+}
+
+void CWallet::SyncBlock(const CWalletSyncBlock &syncBlock) {
+    const CBlock &block = *syncBlock.spBlock;
+    uint256 blockhash   = block.GetHash();
+
+    LOCK(cs_wallet);
+    CWalletDB walletdb(strWalletFile);
+    walletdb.TxnBegin();
+    if (syncBlock.fConnect) {
+        CAccountTx netTx(this, blockhash, block.GetHeight());
+        for (const auto &sptx : block.vptx) {
+            uint256 txid = sptx->GetHash();
+            // confirm the tx is mine
+            if (IsMine(sptx.get())) {
+                netTx.AddTx(txid, sptx.get());
+            }
+            if (unconfirmedTx.count(txid) > 0) {
+                walletdb.EraseUnconfirmedTx(txid);
+                unconfirmedTx.erase(txid);
+            }
+        }
+        if (netTx.GetTxSize() > 0) {          // write to disk
+            mapInBlockTx[blockhash] = netTx;  // add to map
+            walletdb.WriteBlockTx(blockhash, netTx);
+        }
+    } else {
+        for (const auto &sptx : block.vptx) {
+            if (sptx->IsBlockRewardTx()) {
+                continue;
             }
+            if (IsMine(sptx.get())) {
+                unconfirmedTx[sptx->GetHash()] = sptx->GetNewInstance();
+                walletdb.WriteUnconfirmedTx(sptx->GetHash(), unconfirmedTx[sptx->GetHash()]);
+            }
+        }
+        if (mapInBlockTx.count(blockhash)) {
+            walletdb.EraseBlockTx(blockhash);
+            mapInBlockTx.erase(blockhash);
         }
     }
+    walletdb.TxnCommit();
 }
 
 void CWallet::EraseTransaction(const uint256 &hash) {
@@ -247,7 +328,12 @@ std::tuple<bool, string> CWallet::CommitTx(CBaseTx *pTx) {
 
 DBErrors CWallet::LoadWallet(bool fFirstRunRet) {
     // fFirstRunRet = false;
-    return CWalletDB(strWalletFile, "cr+").LoadWallet(this);
+    DBErrors ret = CWalletDB(strWalletFile, "cr+").LoadWallet(this);
+
+    set<CKeyID> keyIds;
+    GetKeys(keyIds);
+    regIdFilter.AddKeys(keyIds);
+    return ret;
 }
 
 int64_t CWallet::GetFreeCoins(TokenSymbol coinCymbol, bool isConfirmed) const {
@@ -464,16 +550,22 @@ uint256 CWallet::GetCheckSum() const {
     return ss.GetHash();
 }
 
-bool CWallet::IsMine(CBaseTx *pTx) const {
-    auto spCW = std::make_shared<CCacheWrapper>(pCdMan);
+bool CWallet::IsMine(const CUserID &uid) const {
+    if (uid.is<CRegID>())
+        return regIdFilter.HaveRegId(uid.get<CRegID>());
+    else if (uid.is<CKeyID>())
+        return HaveKey(uid.get<CKeyID>());
+    else if (uid.is<CPubKey>())
+        return HaveKey(uid.get<CPubKey>().GetKeyId());
 
-    set<CKeyID> keyIds;
-    if (!pTx->GetInvolvedKeyIds(*spCW, keyIds)) {
-        return false;
-    }
+    return false;
+}
 
-    for (auto &keyid : keyIds) {
-        if (HaveKey(keyid) > 0) {
+bool CWallet::IsMine(CBaseTx *pTx) const {
+    vector<CUserID> uids;
+    pTx->GetInvolvedUserIds(uids);
+    for (const auto &uid : uids) {
+        if (IsMine(uid)) {
             return true;
         }
     }
@@ -499,6 +591,7 @@ bool CWallet::CleanAll() {
             CWalletDB(strWalletFile).EraseKeyStoreValue(item.first);
         });
         mapKeys.clear();
+        regIdFilter.Clear();
     } else {
         return ERRORMSG("wallet is encrypted hence clear data forbidden!");
     }
@@ -564,6 +657,7 @@ bool CWallet::AddKey(const CKeyID &KeyId, const CKeyCombi &keyCombi) {
     if (!CWalletDB(strWalletFile).WriteKeyStoreValue(KeyId, keyCombi, nWalletVersion))
         return false;
 
+    regIdFilter.AddKeys({KeyId});
     return CCryptoKeyStore::AddKeyCombi(KeyId, keyCombi);
 }
 
@@ -581,6 +675,7 @@ bool CWallet::RemoveKey(const CKey &key) {
     if (!IsEncrypted()) { //unencrypted or unlocked
         CWalletDB(strWalletFile).EraseKeyStoreValue(keyId);
         mapKeys.erase(keyId);
+        regIdFilter.EraseKey(keyId);
     } else {
         return ERRORMSG("wallet is being locked hence no key removal!");
     }
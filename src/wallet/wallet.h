@@ -15,6 +15,7 @@
 #include <utility>
 #include <vector>
 #include <memory>
+#include <atomic>
 
 #include "crypter.h"
 #include "entities/key.h"
@@ -23,6 +24,7 @@
 #include "walletdb.h"
 #include "main.h"
 #include "commons/serialize.h"
+#include "commons/messagequeue.h"
 #include "tx/cointransfertx.h"
 #include "tx/blockrewardtx.h"
 #include "tx/contracttx.h"
@@ -34,6 +36,33 @@ enum WalletFeature {
     FEATURE_WALLETCRYPT = 10000,  // wallet encryption
 };
 
+/**
+ * The regids of the wallet keys, so that the block sync matches the regids of the txs without an account db
+ * lookup per tx. The keys are resolved to their regids in the account db when they are added and when a block
+ * has a tx of them with a pubkey or keyid, which is how an account gets registered.
+ */
+class CWalletRegIdFilter {
+private:
+    mutable CCriticalSection cs_filter;
+    set<CRegID> regIds;
+    map<CKeyID, CRegID> keyRegIds;  // an empty regid for the keys not registered yet
+    set<CKeyID> pendingKeyIds;      // the keys not resolved yet
+
+public:
+    void AddKeys(const set<CKeyID> &keyIds);
+    void EraseKey(const CKeyID &keyId);
+    void Clear();
+    bool HaveRegId(const CRegID &regId) const;
+    // resolve the pending keys and the given ones in the account db
+    void Update(const CAccountDBCache &accountCache, const set<CKeyID> &keyIds);
+};
+
+/** A block copied for the wallet sync, with the chain state it was connected or disconnected at */
+struct CWalletSyncBlock {
+    std::shared_ptr<const CBlock> spBlock;
+    bool fConnect = false;
+};
+
 /** A CWallet is an extension of a keystore, which also maintains a set of transactions and balances,
  * and provides the ability to create new transactions.
  */
@@ -45,6 +74,16 @@ private:
 
     static bool StartUp(string &strWalletFile);
 
+    CWalletRegIdFilter regIdFilter;
+    MsgQueue<CWalletSyncBlock> syncQueue;
+    CCriticalSection cs_walletSync;  // held while a queued block is synced, locked before cs_wallet
+
+    // write the wallet txs of the block to the wallet db in one db txn
+    void SyncBlock(const CWalletSyncBlock &syncBlock);
+    bool IsMine(const CUserID &uid) const;
+
+    friend void ThreadWalletSync(CWallet *pWallet);
+
     int32_t nWalletVersion;
     CBlockLocator  bestBlock;
     uint256 GetCheckSum() const;
@@ -58,6 +97,8 @@ public:
     map<uint256, CAccountTx> mapInBlockTx;
     map<uint256, std::shared_ptr<CBaseTx> > unconfirmedTx;
     mutable CCriticalSection cs_wallet;
+    // the blocks are synced by ThreadWalletSync() instead of the thread connecting them
+    std::atomic<bool> fSyncInBackground{false};
 
     typedef std::map<uint32_t, CMasterKey> MasterKeyMap;
     MasterKeyMap mapMasterKeys;
@@ -114,6 +155,8 @@ public:
     bool LoadMinVersion(int32_t nVersion);
 
     void SyncTransaction(const uint256 &hash, CBaseTx *pTx, const CBlock* pblock);
+    // sync the blocks left in the queue in the calling thread
+    void SyncQueuedBlocks();
     void EraseTransaction(const uint256 &hash);
     void ResendWalletTransactions();
 
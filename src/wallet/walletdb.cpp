@@ -418,6 +418,25 @@ void ThreadRelayTx(CWallet* pWallet) {
     }
 }
 
+void ThreadWalletSync(CWallet* pWallet) {
+    RenameThread("coin-walletsync");
+    pWallet->fSyncInBackground = true;
+    try {
+        while (true) {
+            boost::this_thread::interruption_point();
+            LOCK(pWallet->cs_walletSync);
+            CWalletSyncBlock syncBlock;
+            if (pWallet->syncQueue.Pop(&syncBlock))
+                pWallet->SyncBlock(syncBlock);
+        }
+    } catch (const boost::thread_interrupted&) {
+        // the blocks connected from now on are synced by the thread connecting them
+        pWallet->fSyncInBackground = false;
+        pWallet->SyncQueuedBlocks();
+        throw;
+    }
+}
+
 bool BackupWallet(const CWallet& wallet, const string& strDest) {
     while (true) {
         {
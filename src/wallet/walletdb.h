@@ -74,4 +74,5 @@ bool BackupWallet(const CWallet& wallet, const string& strDest);
 extern void ThreadFlushWalletDB(const string& strFile);
 
 extern void ThreadRelayTx(CWallet* pWallet);
+extern void ThreadWalletSync(CWallet* pWallet);
 #endif  // COIN_WALLETDB_H